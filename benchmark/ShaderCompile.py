@@ -0,0 +1,29 @@
+import subprocess
+import concurrent.futures
+import sys
+from pathlib import Path
+
+#src and dst absolute paths
+src = sys.argv[1]
+dst = sys.argv[2]
+
+#make output directory
+Path(dst).mkdir(parents=True, exist_ok=True)
+
+#shader compile function
+def compile_shader(src_name, dst_name):
+    try:
+        result = subprocess.run(["glslangValidator", "-V", "-g", "--target-env", "vulkan1.3", src + src_name, "-o", dst + dst_name], capture_output=True, check=True, text=True)
+        print(result.stdout)
+    except subprocess.CalledProcessError as e:
+        print(f"Shader validation failed:\n {e.stderr}\n {e.stdout}\n Source path: {src + src_name}\n Destination Path: {dst + dst_name}\n")
+
+#then compile shaders
+pool = concurrent.futures.ThreadPoolExecutor(max_workers=5)
+pool.submit(compile_shader, "Bench.vert",   "Bench_vert.spv")
+pool.submit(compile_shader, "Bench.frag",   "Bench_frag.spv")
+pool.submit(compile_shader, "Bench.rgen",   "Bench_rgen.spv")
+pool.submit(compile_shader, "Bench.rmiss",  "Bench_rmiss.spv")
+pool.submit(compile_shader, "Bench.rchit",  "Bench_chit.spv")
+
+pool.shutdown(wait=True)
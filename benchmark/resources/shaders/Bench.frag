@@ -0,0 +1,18 @@
+#version 460
+
+layout(location = 0) out vec4 color;
+
+layout(location = 0) in vec3 normal;
+
+//set per material instance
+layout(push_constant) uniform MaterialParameters
+{
+    vec4 baseColor;
+} parameters;
+
+void main()
+{
+    //simple directional light; shading cost isn't what's being measured
+    const float lighting = max(dot(normalize(normal), normalize(vec3(0.5, 0.5, 1.0))), 0.0) * 0.8 + 0.2;
+    color = vec4(parameters.baseColor.rgb * lighting, 1.0);
+}
@@ -0,0 +1,136 @@
+#include "TLSFAllocator.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+
+//CPU only churn benchmark for the TLSF allocator behind FragmentableBuffer. Simulates model data and material data being added and removed at random,
+//reporting throughput and fragmentation over time. Usage: PaperRendererAllocatorBench [operation count] [seed]
+
+struct ChurnWorkload
+{
+    std::string name;
+    uint64_t bufferSize = 0;
+    uint64_t minAllocationSize = 0;
+    uint64_t maxAllocationSize = 0;
+    float fillRatio = 0.0f; //fraction of the buffer filled before churn starts, and that churn hovers around
+};
+
+struct ChurnSample
+{
+    uint64_t operations = 0;
+    double opsPerSecond = 0.0;
+    double usedRatio = 0.0;
+    double fragmentation = 0.0; //1 - (largest free block / total free); 0 means all free space is contiguous
+    uint64_t failedAllocations = 0; //allocations that only would've fit after a compaction
+};
+
+double getFragmentation(const PaperRenderer::TLSFAllocator& allocator)
+{
+    return allocator.getFreeSize() ? 1.0 - ((double)allocator.getLargestFreeBlock() / (double)allocator.getFreeSize()) : 0.0;
+}
+
+std::vector<ChurnSample> runChurn(const ChurnWorkload& workload, const uint64_t operationCount, const uint32_t sampleCount, const uint64_t seed)
+{
+    PaperRenderer::TLSFAllocator allocator(workload.bufferSize, 8);
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(workload.minAllocationSize, workload.maxAllocationSize);
+
+    std::vector<uint64_t> liveOffsets = {};
+    const uint64_t targetUsage = (uint64_t)(workload.bufferSize * workload.fillRatio);
+
+    //fill
+    while(allocator.getUsedSize() < targetUsage)
+    {
+        const uint64_t offset = allocator.allocate(sizeDistribution(rng));
+        if(offset == UINT64_MAX) break;
+        liveOffsets.push_back(offset);
+    }
+
+    //churn; removes and adds are balanced around the target usage
+    std::vector<ChurnSample> samples = {};
+    const uint64_t sampleInterval = std::max(operationCount / sampleCount, (uint64_t)1);
+    uint64_t failedAllocations = 0;
+    auto intervalStart = std::chrono::high_resolution_clock::now();
+
+    for(uint64_t i = 1; i <= operationCount; i++)
+    {
+        const bool remove = liveOffsets.size() && (allocator.getUsedSize() >= targetUsage || rng() % 4 == 0);
+        if(remove)
+        {
+            const uint64_t index = rng() % liveOffsets.size();
+            allocator.free(liveOffsets[index]);
+            liveOffsets[index] = liveOffsets.back();
+            liveOffsets.pop_back();
+        }
+        else
+        {
+            const uint64_t size = sizeDistribution(rng);
+            const uint64_t offset = allocator.allocate(size);
+            if(offset != UINT64_MAX)
+            {
+                liveOffsets.push_back(offset);
+            }
+            else if(allocator.getFreeSize() >= size)
+            {
+                failedAllocations++;
+            }
+        }
+
+        //sample
+        if(i % sampleInterval == 0)
+        {
+            const auto now = std::chrono::high_resolution_clock::now();
+            const double seconds = std::chrono::duration<double>(now - intervalStart).count();
+
+            samples.push_back({
+                .operations = i,
+                .opsPerSecond = seconds > 0.0 ? sampleInterval / seconds : 0.0,
+                .usedRatio = (double)allocator.getUsedSize() / (double)allocator.getSize(),
+                .fragmentation = getFragmentation(allocator),
+                .failedAllocations = failedAllocations
+            });
+
+            //sampling isn't part of the measured throughput
+            intervalStart = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    return samples;
+}
+
+int main(int argc, char** argv)
+{
+    const uint64_t operationCount = argc > 1 ? std::stoull(argv[1]) : 10000000;
+    const uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 0;
+    constexpr uint32_t sampleCount = 10;
+
+    //sizes roughly match the renderer's model data (per model, scaling with LODs and material slots) and per instance material data. Mixed
+    //size material data at 90% usage is the worst case, and settles around 0.6 fragmentation with no compactions needed (see TLSFAllocator.h)
+    const std::vector<ChurnWorkload> workloads = {
+        { .name = "Model Data", .bufferSize = 268435456, .minAllocationSize = 256, .maxAllocationSize = 65536, .fillRatio = 0.75f },
+        { .name = "Material Data", .bufferSize = 16777216, .minAllocationSize = 16, .maxAllocationSize = 1024, .fillRatio = 0.75f },
+        { .name = "Mixed Size Material Data", .bufferSize = 16777216, .minAllocationSize = 8, .maxAllocationSize = 16384, .fillRatio = 0.9f }
+    };
+
+    for(const ChurnWorkload& workload : workloads)
+    {
+        std::cout << "----------" << workload.name << "----------" << std::endl;
+        std::cout << std::setw(12) << "Operations" << std::setw(16) << "Mops/s" << std::setw(12) << "Used" << std::setw(16) << "Fragmentation" << std::setw(20) << "Compactions Needed" << std::endl;
+
+        for(const ChurnSample& sample : runChurn(workload, operationCount, sampleCount, seed))
+        {
+            std::cout << std::fixed << std::setprecision(3)
+                << std::setw(12) << sample.operations
+                << std::setw(16) << sample.opsPerSecond / 1000000.0
+                << std::setw(12) << sample.usedRatio
+                << std::setw(16) << sample.fragmentation
+                << std::setw(20) << sample.failedAllocations << std::endl;
+        }
+    }
+
+    return 0;
+}
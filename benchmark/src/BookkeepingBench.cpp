@@ -0,0 +1,370 @@
+#include "MicroBench.h"
+#include "FragmentableRange.h"
+#include "InstanceBookkeeping.h"
+
+#include <random>
+#include <set>
+#include <memory>
+
+//CPU only microbenchmarks for the bookkeeping done when instances and their data are added to and removed from the renderer, render passes and mesh groups.
+//These drive the same Vulkan-free structures and helpers the engine uses (FragmentableRange, SwapRemoveList, MeshInstanceCounter, RenderTree, the queued
+//instance list and render tree helpers, packLODMaterialData) with mock instances, models and materials in place of Vulkan backed ones, scaling from 1k to 1M
+//instances. Usage: PaperRendererBookkeepingBench [--filter substring]
+//[--min-time seconds] [--max-arg n] [--json path]
+
+using namespace PaperRenderer;
+
+constexpr int64_t minInstances = 1000;
+constexpr int64_t maxInstances = 1000000;
+
+//----------MOCK ENGINE OBJECTS----------//
+
+struct MockMesh {};
+
+struct MockLOD
+{
+    std::vector<MockMesh> materialMeshes;
+};
+
+//stands in for ModelGeometryData, and a Model's LODs
+struct MockGeometry
+{
+    std::vector<MockLOD> lods;
+};
+
+struct MockMaterial {};
+
+struct MockMaterialInstance
+{
+    MockMaterial* baseMaterial;
+};
+
+struct MockMeshGroup;
+
+//stands in for a ModelInstance's self references
+struct MockInstance
+{
+    MockGeometry const* geometry = NULL;
+    uint32_t rendererSelfIndex = UINT32_MAX;
+    uint32_t renderPassSelfIndex = UINT32_MAX;
+    std::unordered_map<MockMesh const*, MockMeshGroup*> meshGroupReferences;
+    std::vector<uint8_t> renderPassInstanceData;
+};
+
+//stands in for a CommonMeshGroup; buffer addresses are made up
+struct MockMeshGroup
+{
+    MeshInstanceCounter<MockInstance, MockGeometry, MockMesh> meshInstances;
+    uint64_t drawCommandsAddress = 0x10000000;
+    uint64_t matricesAddress = 0x20000000;
+    bool rebuild = true;
+
+    void addInstanceMesh(MockInstance& instance, const MockMesh& mesh)
+    {
+        if(meshInstances.addInstanceMesh(&instance, instance.geometry, &mesh)) rebuild = true;
+    }
+
+    void removeInstanceMeshes(MockInstance& instance)
+    {
+        meshInstances.removeInstanceMeshes(&instance, instance.geometry);
+    }
+};
+
+struct MockScene
+{
+    static constexpr uint32_t lodCount = 3;
+    static constexpr uint32_t meshesPerLOD = 4;
+    static constexpr uint32_t materialCount = 8;
+    static constexpr uint32_t instancesPerMaterial = 4;
+    static constexpr uint32_t geometryCount = 64;
+
+    std::vector<MockGeometry> geometries;
+    std::vector<MockMaterial> materials;
+    std::vector<MockMaterialInstance> materialInstances;
+
+    MockScene()
+        :geometries(geometryCount),
+        materials(materialCount)
+    {
+        for(MockGeometry& geometry : geometries)
+        {
+            geometry.lods.resize(lodCount);
+            for(MockLOD& lod : geometry.lods) lod.materialMeshes.resize(meshesPerLOD);
+        }
+
+        for(MockMaterial& material : materials)
+        {
+            for(uint32_t i = 0; i < instancesPerMaterial; i++) materialInstances.push_back({ &material });
+        }
+    }
+};
+
+std::vector<std::unique_ptr<MockInstance>> createInstances(const MockScene& scene, const int64_t count)
+{
+    std::vector<std::unique_ptr<MockInstance>> instances(count);
+    for(int64_t i = 0; i < count; i++)
+    {
+        instances[i] = std::make_unique<MockInstance>();
+        instances[i]->geometry = &scene.geometries[i % scene.geometries.size()];
+    }
+
+    return instances;
+}
+
+//----------FRAGMENTABLE BUFFER----------//
+
+//steady state newWrite/removeFromRange with N live allocations of per instance material data sizes
+void fragmentableRangeWriteRemove(MicroBench::State& state)
+{
+    const int64_t allocationCount = state.range();
+    FragmentableRange range(allocationCount * 2048, 8);
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<uint64_t> sizeDistribution(16, 1024);
+
+    std::vector<std::pair<uint64_t, uint64_t>> liveAllocations(allocationCount);
+    for(auto& [location, size] : liveAllocations)
+    {
+        RangeCompaction compaction = {};
+        size = sizeDistribution(rng);
+        location = range.allocate(size, compaction);
+    }
+
+    for(auto _ : state)
+    {
+        auto& [location, size] = liveAllocations[rng() % liveAllocations.size()];
+        range.free(location);
+
+        RangeCompaction compaction = {};
+        size = sizeDistribution(rng);
+        location = range.allocate(size, compaction);
+        MicroBench::doNotOptimize(location);
+    }
+
+    state.setItemsProcessed(state.iterations());
+}
+MICRO_BENCHMARK(fragmentableRangeWriteRemove).range(minInstances, maxInstances);
+
+//compacts N allocations with every other one freed, then relocates every remaining allocation through the results like the engine's compaction callbacks
+void fragmentableRangeCompact(MicroBench::State& state)
+{
+    const int64_t allocationCount = state.range();
+    FragmentableRange fragmented(allocationCount * 256, 8);
+    std::vector<uint64_t> liveLocations = {};
+
+    for(int64_t i = 0; i < allocationCount; i++)
+    {
+        RangeCompaction compaction = {};
+        uint64_t size = 64 + (i % 4) * 32;
+        const uint64_t location = fragmented.allocate(size, compaction);
+
+        if(i % 2) fragmented.free(location);
+        else liveLocations.push_back(location);
+    }
+
+    for(auto _ : state)
+    {
+        state.pauseTiming();
+        FragmentableRange range = fragmented;
+        state.resumeTiming();
+
+        const RangeCompaction compaction = range.compact();
+        uint64_t relocated = 0;
+        for(const uint64_t location : liveLocations)
+        {
+            relocated += FragmentableRange::getCompactedLocation(compaction.results, location);
+        }
+        MicroBench::doNotOptimize(relocated + compaction.copies.size());
+    }
+
+    state.setItemsProcessed(state.iterations() * allocationCount);
+}
+MICRO_BENCHMARK(fragmentableRangeCompact).range(minInstances, maxInstances);
+
+//----------RENDER ENGINE----------//
+
+//RenderEngine::addObject/removeObject: self indexed instance list plus the queue of instances whose data needs uploading, with N resident instances
+void renderEngineAddRemoveObject(MicroBench::State& state)
+{
+    const MockScene scene;
+    std::vector<std::unique_ptr<MockInstance>> instances = createInstances(scene, state.range());
+    SwapRemoveList<MockInstance*> renderingModelInstances;
+    std::set<MockInstance*> toUpdateModelInstances;
+
+    const auto getSelfIndex = [](MockInstance* object) -> uint32_t& { return object->rendererSelfIndex; };
+    const auto addObject = [&](MockInstance* object) { addQueuedInstance(renderingModelInstances, toUpdateModelInstances, object, getSelfIndex); };
+    const auto removeObject = [&](MockInstance* object) { removeQueuedInstance(renderingModelInstances, toUpdateModelInstances, object, getSelfIndex); };
+
+    for(std::unique_ptr<MockInstance>& instance : instances) addObject(instance.get());
+    toUpdateModelInstances.clear();
+
+    std::mt19937_64 rng(0);
+    for(auto _ : state)
+    {
+        MockInstance* instance = instances[rng() % instances.size()].get();
+        removeObject(instance);
+        addObject(instance);
+    }
+
+    state.setItemsProcessed(state.iterations());
+}
+MICRO_BENCHMARK(renderEngineAddRemoveObject).range(minInstances, maxInstances);
+
+//----------RENDER PASS----------//
+
+struct MockRenderPass
+{
+    RenderTree<MockMaterial, MockMaterialInstance, MockMeshGroup> renderTree;
+    SwapRemoveList<MockInstance*> renderPassInstances;
+    std::set<MockInstance*> toUpdateInstances;
+
+    //RenderPass::addInstance's unsorted path; materials are picked per slot
+    void addInstance(MockInstance& instance, const std::vector<MockMaterialInstance*>& slotMaterials)
+    {
+        addRenderTreeInstance(instance, instance.geometry->lods, instance.meshGroupReferences, [&](uint32_t, uint32_t matIndex) -> MockMeshGroup& {
+            MockMaterialInstance* materialInstance = slotMaterials[matIndex];
+            return getRenderTreeGroup(renderTree, materialInstance->baseMaterial, materialInstance);
+        });
+        addQueuedInstance(renderPassInstances, toUpdateInstances, &instance, getSelfIndex);
+    }
+
+    void removeInstance(MockInstance& instance)
+    {
+        removeRenderTreeInstance(instance, instance.meshGroupReferences);
+        removeQueuedInstance(renderPassInstances, toUpdateInstances, &instance, getSelfIndex);
+    }
+
+    static uint32_t& getSelfIndex(MockInstance* instance) { return instance->renderPassSelfIndex; }
+};
+
+std::vector<MockMaterialInstance*> getSlotMaterials(MockScene& scene, const uint64_t seed)
+{
+    std::vector<MockMaterialInstance*> slotMaterials(MockScene::meshesPerLOD);
+    for(uint32_t i = 0; i < slotMaterials.size(); i++)
+    {
+        slotMaterials[i] = &scene.materialInstances[(seed + i * 7) % scene.materialInstances.size()];
+    }
+
+    return slotMaterials;
+}
+
+//RenderPass::addInstance/removeInstance through the render tree and mesh groups, with N resident instances
+void renderPassAddRemoveInstance(MicroBench::State& state)
+{
+    MockScene scene;
+    std::vector<std::unique_ptr<MockInstance>> instances = createInstances(scene, state.range());
+    MockRenderPass renderPass;
+
+    for(uint64_t i = 0; i < instances.size(); i++) renderPass.addInstance(*instances[i], getSlotMaterials(scene, i));
+    renderPass.toUpdateInstances.clear();
+
+    std::mt19937_64 rng(0);
+    for(auto _ : state)
+    {
+        state.pauseTiming();
+        const uint64_t index = rng() % instances.size();
+        const std::vector<MockMaterialInstance*> slotMaterials = getSlotMaterials(scene, index);
+        state.resumeTiming();
+
+        renderPass.removeInstance(*instances[index]);
+        renderPass.addInstance(*instances[index], slotMaterials);
+    }
+
+    state.setItemsProcessed(state.iterations());
+}
+MICRO_BENCHMARK(renderPassAddRemoveInstance).range(minInstances, maxInstances);
+
+//----------COMMON MESH GROUP----------//
+
+//CommonMeshGroup::addInstanceMesh/removeInstanceMeshes on a single group holding N instances spread over the scene's geometries
+void commonMeshGroupAddInstanceMesh(MicroBench::State& state)
+{
+    const MockScene scene;
+    std::vector<std::unique_ptr<MockInstance>> instances = createInstances(scene, state.range());
+    MockMeshGroup meshGroup;
+
+    for(std::unique_ptr<MockInstance>& instance : instances)
+    {
+        meshGroup.meshInstances.addInstanceMesh(instance.get(), instance->geometry, &instance->geometry->lods[0].materialMeshes[0]);
+    }
+    meshGroup.meshInstances.layout();
+
+    std::mt19937_64 rng(0);
+    for(auto _ : state)
+    {
+        MockInstance* instance = instances[rng() % instances.size()].get();
+        meshGroup.meshInstances.removeInstanceMeshes(instance, instance->geometry);
+        meshGroup.rebuild |= meshGroup.meshInstances.addInstanceMesh(instance, instance->geometry, &instance->geometry->lods[0].materialMeshes[0]);
+    }
+
+    state.setItemsProcessed(state.iterations());
+}
+MICRO_BENCHMARK(commonMeshGroupAddInstanceMesh).range(minInstances, maxInstances);
+
+//CommonMeshGroup rebuild layout over N unique geometries (instances with unique geometry each get their own draw command)
+void commonMeshGroupLayout(MicroBench::State& state)
+{
+    const int64_t geometryCount = state.range();
+    std::vector<MockGeometry> geometries(geometryCount, { .lods = { { .materialMeshes = std::vector<MockMesh>(1) } } });
+    std::vector<MockInstance> instances(geometryCount);
+    MockMeshGroup meshGroup;
+
+    for(int64_t i = 0; i < geometryCount; i++)
+    {
+        meshGroup.meshInstances.addInstanceMesh(&instances[i], &geometries[i], &geometries[i].lods[0].materialMeshes[0]);
+    }
+
+    for(auto _ : state)
+    {
+        const auto layout = meshGroup.meshInstances.layout();
+        MicroBench::doNotOptimize(layout.matricesCount);
+    }
+
+    state.setItemsProcessed(state.iterations() * geometryCount);
+}
+MICRO_BENCHMARK(commonMeshGroupLayout).range(minInstances, maxInstances);
+
+//----------MODEL INSTANCE----------//
+
+//ModelInstance::setRenderPassInstanceData for N instances, as done when a render pass uploads queued instances
+void modelInstanceSetRenderPassInstanceData(MicroBench::State& state)
+{
+    MockScene scene;
+    std::vector<std::unique_ptr<MockInstance>> instances = createInstances(scene, state.range());
+    MockRenderPass renderPass;
+
+    for(uint64_t i = 0; i < instances.size(); i++) renderPass.addInstance(*instances[i], getSlotMaterials(scene, i));
+    for(auto& [material, materialInstances] : renderPass.renderTree)
+    {
+        for(auto& [materialInstance, meshGroup] : materialInstances) meshGroup.meshInstances.layout();
+    }
+
+    for(auto _ : state)
+    {
+        for(std::unique_ptr<MockInstance>& instance : instances)
+        {
+            const std::vector<MockLOD>& lods = instance->geometry->lods;
+            packLODMaterialData(instance->renderPassInstanceData, lods.size(),
+                [&](uint32_t lodIndex) { return (uint32_t)lods[lodIndex].materialMeshes.size(); },
+                [&](uint32_t lodIndex, uint32_t matIndex) {
+                    MockMesh const* lodMeshPtr = &lods[lodIndex].materialMeshes[matIndex];
+                    MockMeshGroup const* meshGroupPtr = instance->meshGroupReferences.at(lodMeshPtr);
+                    const auto& meshInstancesData = meshGroupPtr->meshInstances.getMeshInstancesData(instance->geometry, lodMeshPtr);
+
+                    return MaterialMeshGroup{
+                        .drawCommandAddress = meshGroupPtr->drawCommandsAddress + meshInstancesData.drawCommandIndex * 24,
+                        .matricesBufferAddress = meshGroupPtr->matricesAddress + meshInstancesData.matricesStartIndex * 48
+                    };
+                }
+            );
+        }
+        MicroBench::doNotOptimize(instances.back()->renderPassInstanceData.size());
+    }
+
+    state.setItemsProcessed(state.iterations() * instances.size());
+}
+MICRO_BENCHMARK(modelInstanceSetRenderPassInstanceData).range(minInstances, maxInstances);
+
+int main(int argc, char** argv)
+{
+    return MicroBench::runBenchmarks(argc, argv);
+}
@@ -0,0 +1,260 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Minimal Google Benchmark style harness for CPU only microbenchmarks, so the suite doesn't need an external dependency. Benchmarks are functions taking a State,
+//doing their setup, then running the measured operation in a `for(auto _ : state)` loop. Iteration counts are calibrated until a run takes at least the minimum time.
+//Each benchmark runs once per argument in its range, and reports time per iteration, items per second, and the scaling exponent fitted across the range.
+
+namespace MicroBench
+{
+    using Clock = std::chrono::steady_clock;
+
+    //----------STATE----------//
+
+    class State
+    {
+    private:
+        const int64_t argument;
+        const uint64_t maxIterations;
+        Clock::time_point start = {};
+        Clock::duration elapsed = {};
+        bool timing = false;
+        int64_t itemsProcessed = 0;
+
+    public:
+        State(const int64_t argument, const uint64_t maxIterations)
+            :argument(argument),
+            maxIterations(maxIterations)
+        {
+        }
+
+        //marked so the unused loop variable in for(auto _ : state) doesn't warn
+        struct [[maybe_unused]] Value
+        {
+        };
+
+        struct Iterator
+        {
+            State* state;
+            uint64_t remaining;
+
+            bool operator!=(const Iterator&)
+            {
+                if(remaining) return true;
+
+                state->pauseTiming();
+                return false;
+            }
+            void operator++() { remaining--; }
+            Value operator*() const { return {}; }
+        };
+
+        Iterator begin() { resumeTiming(); return { this, maxIterations }; }
+        Iterator end() { return { this, 0 }; }
+
+        //excludes per iteration setup from the measured time
+        void pauseTiming()
+        {
+            if(timing) elapsed += Clock::now() - start;
+            timing = false;
+        }
+
+        void resumeTiming()
+        {
+            start = Clock::now();
+            timing = true;
+        }
+
+        int64_t range() const { return argument; }
+        uint64_t iterations() const { return maxIterations; }
+        void setItemsProcessed(const int64_t items) { itemsProcessed = items; }
+        int64_t getItemsProcessed() const { return itemsProcessed; }
+        double getSeconds() const { return std::chrono::duration<double>(elapsed).count(); }
+    };
+
+    //keeps a value from being optimized out
+    inline volatile uint64_t sink = 0;
+    inline void doNotOptimize(const uint64_t value) { sink = sink ^ value; }
+
+    //----------REGISTRATION----------//
+
+    class Benchmark
+    {
+    private:
+        std::string name;
+        std::function<void(State&)> function;
+        std::vector<int64_t> arguments = { 0 };
+
+    public:
+        Benchmark(const std::string& name, const std::function<void(State&)>& function)
+            :name(name),
+            function(function)
+        {
+        }
+
+        //start, start * multiplier, ... up to and including limit
+        Benchmark& range(const int64_t start, const int64_t limit, const int64_t multiplier = 10)
+        {
+            arguments.clear();
+            for(int64_t argument = start; argument < limit; argument *= multiplier)
+            {
+                arguments.push_back(argument);
+            }
+            arguments.push_back(limit);
+
+            return *this;
+        }
+
+        const std::string& getName() const { return name; }
+        const std::function<void(State&)>& getFunction() const { return function; }
+        const std::vector<int64_t>& getArguments() const { return arguments; }
+    };
+
+    inline std::vector<Benchmark>& getBenchmarks()
+    {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    inline Benchmark& registerBenchmark(const std::string& name, const std::function<void(State&)>& function)
+    {
+        return getBenchmarks().emplace_back(name, function);
+    }
+
+    #define MICRO_BENCHMARK(function) static MicroBench::Benchmark& function##Registration = MicroBench::registerBenchmark(#function, function)
+
+    //----------RUNNER----------//
+
+    struct Result
+    {
+        std::string name;
+        int64_t argument = 0;
+        uint64_t iterations = 0;
+        double nsPerIteration = 0.0;
+        double itemsPerSecond = 0.0;
+    };
+
+    inline Result runBenchmark(const Benchmark& benchmark, const int64_t argument, const double minTime)
+    {
+        //grow the iteration count until the measured time is long enough to trust
+        uint64_t iterations = 1;
+        while(true)
+        {
+            State state(argument, iterations);
+            benchmark.getFunction()(state);
+
+            const double seconds = state.getSeconds();
+            if(seconds >= minTime || iterations >= 1000000000)
+            {
+                return {
+                    .name = benchmark.getName(),
+                    .argument = argument,
+                    .iterations = iterations,
+                    .nsPerIteration = seconds * 1e9 / (double)iterations,
+                    .itemsPerSecond = seconds > 0.0 ? (double)state.getItemsProcessed() / seconds : 0.0
+                };
+            }
+
+            //aim a bit past the minimum time, but never grow by more than 10x per step
+            const double multiplier = seconds > 0.0 ? std::min(std::max(minTime * 1.4 / seconds, 2.0), 10.0) : 10.0;
+            iterations = (uint64_t)std::ceil(iterations * multiplier);
+        }
+    }
+
+    //least squares slope of log(time) against log(argument); 1 is linear, 0 is constant
+    inline double getScalingExponent(const std::vector<Result>& results)
+    {
+        if(results.size() < 2) return 0.0;
+
+        double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+        for(const Result& result : results)
+        {
+            const double x = std::log((double)std::max(result.argument, (int64_t)1));
+            const double y = std::log(std::max(result.nsPerIteration, 1e-9));
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+        }
+
+        const double n = (double)results.size();
+        const double denominator = n * sumXX - sumX * sumX;
+        return denominator != 0.0 ? (n * sumXY - sumX * sumY) / denominator : 0.0;
+    }
+
+    //usage: [--filter substring] [--min-time seconds] [--max-arg n] [--json path]
+    inline int runBenchmarks(int argc, char** argv)
+    {
+        std::string filter = "";
+        double minTime = 0.25;
+        int64_t maxArgument = INT64_MAX;
+        std::string jsonPath = "";
+
+        for(int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string option = argv[i];
+            if(option == "--filter") filter = argv[i + 1];
+            else if(option == "--min-time") minTime = std::stod(argv[i + 1]);
+            else if(option == "--max-arg") maxArgument = std::stoll(argv[i + 1]);
+            else if(option == "--json") jsonPath = argv[i + 1];
+            else
+            {
+                std::cerr << "Unknown option " << option << std::endl;
+                return 1;
+            }
+        }
+
+        std::cout << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(10) << "N" << std::setw(14) << "Iterations"
+            << std::setw(16) << "ns/iteration" << std::setw(16) << "Mitems/s" << std::endl;
+
+        std::vector<std::vector<Result>> allResults = {};
+        for(const Benchmark& benchmark : getBenchmarks())
+        {
+            if(filter.size() && benchmark.getName().find(filter) == std::string::npos) continue;
+
+            std::vector<Result>& results = allResults.emplace_back();
+            for(const int64_t argument : benchmark.getArguments())
+            {
+                if(argument > maxArgument) continue;
+
+                const Result& result = results.emplace_back(runBenchmark(benchmark, argument, minTime));
+                std::cout << std::left << std::setw(44) << result.name << std::right << std::setw(10) << result.argument << std::setw(14) << result.iterations
+                    << std::fixed << std::setprecision(2) << std::setw(16) << result.nsPerIteration << std::setw(16) << result.itemsPerSecond / 1000000.0 << std::endl;
+            }
+
+            if(results.size() > 1)
+            {
+                std::cout << std::left << std::setw(44) << (benchmark.getName() + " scaling") << std::right << std::setw(10) << "O(N^"
+                    << std::fixed << std::setprecision(2) << getScalingExponent(results) << ")" << std::endl;
+            }
+        }
+
+        if(jsonPath.size())
+        {
+            std::ofstream json(jsonPath);
+            json << "{\n    \"benchmarks\": [\n";
+            bool first = true;
+            for(const std::vector<Result>& results : allResults)
+            {
+                for(const Result& result : results)
+                {
+                    json << (first ? "" : ",\n") << "        { \"name\": \"" << result.name << "\", \"n\": " << result.argument << ", \"iterations\": " << result.iterations
+                        << ", \"nsPerIteration\": " << result.nsPerIteration << ", \"itemsPerSecond\": " << result.itemsPerSecond
+                        << ", \"scalingExponent\": " << getScalingExponent(results) << " }";
+                    first = false;
+                }
+            }
+            json << "\n    ]\n}\n";
+        }
+
+        return 0;
+    }
+}
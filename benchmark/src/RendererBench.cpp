@@ -0,0 +1,851 @@
+#include "PaperRenderer.h"
+#include "gtc/constants.hpp"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//Headless renderer benchmark. Generates a synthetic scene, renders a fixed number of frames to a VK_EXT_headless_surface swapchain, and writes
+//CPU timings, GPU timings and memory usage as JSON. Runs on software ICDs (e.g. lavapipe through VK_ICD_FILENAMES) so it can be tracked in CI.
+//Usage: PaperRendererBench [--models=N] [--instances=N] [--lods=N] [--materials=N] [--sorted=F] [--animated=F] [--rt=F] [--frames=N] [--warmup=N]
+//                          [--width=N] [--height=N] [--seed=N] [--output=path] (fractions are in [0, 1]; output "-" writes to stdout)
+
+struct BenchConfig
+{
+    uint32_t modelCount = 16;
+    uint32_t instanceCount = 1000;
+    uint32_t lodCount = 3;
+    uint32_t materialCount = 8;
+    float sortedFraction = 0.1f;
+    float animatedFraction = 0.1f;
+    float rtFraction = 0.5f; //ignored if the device has no RT support
+    uint32_t frameCount = 300;
+    uint32_t warmupFrameCount = 30; //not measured; lets buffers reach their steady state sizes
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint64_t seed = 0;
+    std::string outputPath = "PaperRendererBench.json";
+};
+
+BenchConfig parseArguments(int argc, char** argv)
+{
+    BenchConfig config = {};
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        const size_t separator = argument.find('=');
+        if(argument.rfind("--", 0) != 0 || separator == std::string::npos)
+        {
+            throw std::runtime_error("Bad argument " + argument + "; arguments are in the form --name=value");
+        }
+
+        const std::string name = argument.substr(2, separator - 2);
+        const std::string value = argument.substr(separator + 1);
+        if(name == "models") config.modelCount = std::max((uint32_t)std::stoul(value), (uint32_t)1);
+        else if(name == "instances") config.instanceCount = std::stoul(value);
+        else if(name == "lods") config.lodCount = std::clamp((uint32_t)std::stoul(value), (uint32_t)1, (uint32_t)8);
+        else if(name == "materials") config.materialCount = std::max((uint32_t)std::stoul(value), (uint32_t)1);
+        else if(name == "sorted") config.sortedFraction = std::clamp(std::stof(value), 0.0f, 1.0f);
+        else if(name == "animated") config.animatedFraction = std::clamp(std::stof(value), 0.0f, 1.0f);
+        else if(name == "rt") config.rtFraction = std::clamp(std::stof(value), 0.0f, 1.0f);
+        else if(name == "frames") config.frameCount = std::max((uint32_t)std::stoul(value), (uint32_t)1);
+        else if(name == "warmup") config.warmupFrameCount = std::stoul(value);
+        else if(name == "width") config.width = std::max((uint32_t)std::stoul(value), (uint32_t)1);
+        else if(name == "height") config.height = std::max((uint32_t)std::stoul(value), (uint32_t)1);
+        else if(name == "seed") config.seed = std::stoull(value);
+        else if(name == "output") config.outputPath = value;
+        else throw std::runtime_error("Unknown argument " + argument);
+    }
+
+    return config;
+}
+
+std::vector<uint32_t> readFromFile(const std::string& location)
+{
+    std::ifstream file(location, std::ios::binary | std::ios::ate);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Couldn't open file " + location);
+    }
+
+    std::vector<uint32_t> buffer(((size_t)file.tellg() + 3) / 4);
+    file.seekg(0, file.beg);
+    file.read((char*)buffer.data(), buffer.size() * 4);
+
+    return buffer;
+}
+
+//----------SYNTHETIC SCENE----------//
+
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+//UV sphere; every model gets a slightly different radius so no two share geometry (identical content would share one VBO and BLAS)
+PaperRenderer::MaterialMeshInfo createSphereMesh(const float radius, const uint32_t rings)
+{
+    const uint32_t segments = rings * 2;
+
+    std::vector<Vertex> vertices;
+    vertices.reserve((rings + 1) * (segments + 1));
+    for(uint32_t ring = 0; ring <= rings; ring++)
+    {
+        const float phi = glm::pi<float>() * (float)ring / (float)rings;
+        for(uint32_t segment = 0; segment <= segments; segment++)
+        {
+            const float theta = glm::two_pi<float>() * (float)segment / (float)segments;
+            const glm::vec3 normal = glm::vec3(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+            vertices.push_back({ .position = normal * radius, .normal = normal });
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(rings * segments * 6);
+    for(uint32_t ring = 0; ring < rings; ring++)
+    {
+        for(uint32_t segment = 0; segment < segments; segment++)
+        {
+            const uint32_t current = ring * (segments + 1) + segment;
+            const uint32_t below = current + segments + 1;
+            indices.insert(indices.end(), { current, below, current + 1, current + 1, below, below + 1 });
+        }
+    }
+
+    PaperRenderer::MaterialMeshInfo meshInfo = {
+        .vertexStride = sizeof(Vertex),
+        .verticesData = std::vector<char>(vertices.size() * sizeof(Vertex)),
+        .indexType = VK_INDEX_TYPE_UINT32,
+        .indicesData = std::vector<char>(indices.size() * sizeof(uint32_t)),
+        .opaque = true
+    };
+    memcpy(meshInfo.verticesData.data(), vertices.data(), meshInfo.verticesData.size());
+    memcpy(meshInfo.indicesData.data(), indices.data(), meshInfo.indicesData.size());
+
+    return meshInfo;
+}
+
+//LOD n has half the rings of LOD n - 1
+PaperRenderer::ModelCreateInfo createModelInfo(const uint32_t modelIndex, const BenchConfig& config, const bool createBLAS)
+{
+    const float radius = 0.5f + 0.001f * modelIndex;
+    const uint32_t baseRings = 8 + (modelIndex % 8) * 4;
+
+    PaperRenderer::ModelCreateInfo modelInfo = {
+        .createBLAS = createBLAS,
+        .blasFlags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR,
+        .modelName = "Bench Model " + std::to_string(modelIndex),
+        .bounds = { .posX = radius, .negX = -radius, .posY = radius, .negY = -radius, .posZ = radius, .negZ = -radius }
+    };
+    for(uint32_t lod = 0; lod < config.lodCount; lod++)
+    {
+        PaperRenderer::ModelLODInfo lodInfo = {};
+        lodInfo.lodData[0] = createSphereMesh(radius, std::max(baseRings >> lod, (uint32_t)3));
+        modelInfo.LODs.push_back(std::move(lodInfo));
+    }
+
+    return modelInfo;
+}
+
+//----------MATERIALS----------//
+
+class BenchMaterial
+{
+private:
+    PaperRenderer::Material material;
+
+    void bind(VkCommandBuffer cmdBuffer, const PaperRenderer::Camera& camera) const
+    {
+        //camera matrices binding (set 0)
+        const PaperRenderer::DescriptorBinding cameraBinding = {
+            .bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .pipelineLayout = material.getRasterPipeline().getLayout(),
+            .descriptorSetIndex = 0,
+            .dynamicOffsets = { camera.getUBODynamicOffset() }
+        };
+        camera.getUBODescriptor().bindDescriptorSet(cmdBuffer, cameraBinding);
+    }
+
+public:
+    BenchMaterial(PaperRenderer::RenderEngine& renderer, const std::vector<uint32_t>& vertShader, const std::vector<uint32_t>& fragShader, VkFormat colorFormat, VkFormat depthFormat)
+        :material(renderer, {
+            .shaders = {
+                { .stage = VK_SHADER_STAGE_VERTEX_BIT, .shaderData = vertShader },
+                { .stage = VK_SHADER_STAGE_FRAGMENT_BIT, .shaderData = fragShader }
+            },
+            .descriptorSets = {
+                { 0, renderer.getDefaultDescriptorSetLayout(PaperRenderer::DefaultDescriptors::CAMERA_MATRICES) },
+                { 1, renderer.getDefaultDescriptorSetLayout(PaperRenderer::DefaultDescriptors::INDIRECT_DRAW_MATRICES) }
+            },
+            .pcRanges = { { .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .offset = 0, .size = sizeof(glm::vec4) } },
+            .properties = {
+                .vertexAttributes = {
+                    { .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, position) },
+                    { .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, normal) }
+                },
+                .vertexDescriptions = {
+                    { .binding = 0, .stride = sizeof(Vertex), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX }
+                },
+                .colorAttachments = {
+                    {
+                        .blendEnable = VK_FALSE,
+                        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+                    }
+                },
+                .colorAttachmentFormats = { colorFormat },
+                .depthAttachmentFormat = depthFormat,
+                .rasterInfo = {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                    .pNext = NULL,
+                    .flags = 0,
+                    .depthClampEnable = VK_FALSE,
+                    .rasterizerDiscardEnable = VK_FALSE,
+                    .polygonMode = VK_POLYGON_MODE_FILL,
+                    .cullMode = VK_CULL_MODE_NONE, //generated winding isn't guaranteed to match the projection
+                    .frontFace = VK_FRONT_FACE_CLOCKWISE,
+                    .depthBiasEnable = VK_FALSE,
+                    .depthBiasConstantFactor = 0.0f,
+                    .depthBiasClamp = 0.0f,
+                    .depthBiasSlopeFactor = 0.0f,
+                    .lineWidth = 1.0f
+                }
+            }
+        }, [this](VkCommandBuffer cmdBuffer, const PaperRenderer::Camera& camera) { bind(cmdBuffer, camera); })
+    {
+    }
+
+    PaperRenderer::Material& getMaterial() { return material; }
+};
+
+class BenchMaterialInstance
+{
+private:
+    const glm::vec4 baseColor;
+    PaperRenderer::MaterialInstance materialInstance;
+
+    void bind(VkCommandBuffer cmdBuffer) const
+    {
+        vkCmdPushConstants(cmdBuffer, materialInstance.getBaseMaterial().getRasterPipeline().getLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(glm::vec4), &baseColor);
+    }
+
+public:
+    BenchMaterialInstance(PaperRenderer::RenderEngine& renderer, BenchMaterial& baseMaterial, const glm::vec4& baseColor)
+        :baseColor(baseColor),
+        materialInstance(renderer, baseMaterial.getMaterial(), [this](VkCommandBuffer cmdBuffer) { bind(cmdBuffer); })
+    {
+    }
+
+    PaperRenderer::MaterialInstance& getMaterialInstance() { return materialInstance; }
+};
+
+//----------RENDER TARGETS----------//
+
+struct RenderTarget
+{
+    PaperRenderer::Image image;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageView view = VK_NULL_HANDLE;
+};
+
+RenderTarget createRenderTarget(PaperRenderer::RenderEngine& renderer, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImageLayout layout)
+{
+    const VkExtent2D extent = renderer.getSwapchain().getExtent();
+    PaperRenderer::Image image(renderer, {
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = { extent.width, extent.height, 1 },
+        .maxMipLevels = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .usage = usage,
+        .imageAspect = aspect,
+        .desiredLayout = layout
+    });
+    VkImageView view = image.getNewImageView(aspect, VK_IMAGE_VIEW_TYPE_2D, format);
+
+    return { std::move(image), format, view };
+}
+
+VkFormat getDepthFormat(PaperRenderer::RenderEngine& renderer)
+{
+    //D16 is always supported as a depth attachment
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(renderer.getDevice().getGPU(), VK_FORMAT_D32_SFLOAT, &properties);
+    return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT ? VK_FORMAT_D32_SFLOAT : VK_FORMAT_D16_UNORM;
+}
+
+//----------RESULTS----------//
+
+//per frame totals of a time statistic (a statistic can be recorded several times per frame)
+struct FrameTimings
+{
+    std::vector<double> frameTotals = {};
+    uint64_t sampleCount = 0;
+};
+
+struct BenchResults
+{
+    std::map<std::string, FrameTimings> timings = {};
+    std::array<PaperRenderer::MemoryCategoryUsage, PaperRenderer::MEMORY_CATEGORY_COUNT> peakMemoryUsage = {};
+    std::map<std::string, PaperRenderer::AllocationStatistic> allocations = {}; //totals over the measured frames, empty unless allocation tracking is compiled in
+    double measuredSeconds = 0.0;
+    double setupSeconds = 0.0;
+};
+
+void recordFrameResults(PaperRenderer::RenderEngine& renderer, BenchResults& results)
+{
+    const PaperRenderer::Statistics& statistics = renderer.getStatisticsTracker().getStatistics();
+
+    std::map<std::string, double> frameTotals;
+    for(const PaperRenderer::TimeStatistic& statistic : statistics.timeStatistics)
+    {
+        frameTotals[statistic.name] += statistic.getTime();
+        results.timings[statistic.name].sampleCount++;
+    }
+    for(const auto& [name, total] : frameTotals)
+    {
+        results.timings[name].frameTotals.push_back(total);
+    }
+
+    for(uint32_t i = 0; i < PaperRenderer::MEMORY_CATEGORY_COUNT; i++)
+    {
+        results.peakMemoryUsage[i].bytes = std::max(results.peakMemoryUsage[i].bytes, statistics.memoryUsage[i].bytes);
+        results.peakMemoryUsage[i].allocationCount = std::max(results.peakMemoryUsage[i].allocationCount, statistics.memoryUsage[i].allocationCount);
+    }
+
+    //"Untimed" includes the bench's own bookkeeping above
+    for(const PaperRenderer::AllocationStatistic& allocation : statistics.allocations)
+    {
+        PaperRenderer::AllocationStatistic& total = results.allocations[allocation.scope];
+        total.count += allocation.count;
+        total.bytes += allocation.bytes;
+    }
+}
+
+bool writeResults(PaperRenderer::RenderEngine& renderer, const BenchConfig& config, const BenchResults& results, const uint32_t rtInstanceCount)
+{
+    std::ofstream file;
+    if(config.outputPath != "-")
+    {
+        file.open(config.outputPath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open()) return false;
+    }
+    std::ostream& out = config.outputPath != "-" ? file : std::cout;
+
+    const auto writeString = [&](const std::string& string)
+    {
+        out << '"';
+        for(const char character : string)
+        {
+            if(character == '"' || character == '\\') out << '\\';
+            out << character;
+        }
+        out << '"';
+    };
+    const auto toMilliseconds = [](double seconds) { return seconds * 1000.0; };
+
+    //sorted copy is used for percentiles; times are in milliseconds
+    const auto writeTimings = [&](const std::string& name, const FrameTimings& timings)
+    {
+        std::vector<double> sorted = timings.frameTotals;
+        std::sort(sorted.begin(), sorted.end());
+        const auto percentile = [&](double p) { return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)]; };
+        double total = 0.0;
+        for(double time : sorted) total += time;
+
+        writeString(name);
+        out << ":{\"frames\":" << sorted.size()
+            << ",\"samples\":" << timings.sampleCount
+            << ",\"mean\":" << toMilliseconds(total / sorted.size())
+            << ",\"p50\":" << toMilliseconds(percentile(0.5))
+            << ",\"p95\":" << toMilliseconds(percentile(0.95))
+            << ",\"max\":" << toMilliseconds(sorted.back()) << "}";
+    };
+
+    const PaperRenderer::Statistics& statistics = renderer.getStatisticsTracker().getStatistics();
+    const PaperRenderer::AggregateStatistic frameTime = renderer.getStatisticsTracker().getFrameTimeAggregate();
+    const PaperRenderer::DeviceFeaturesAndProperties& device = renderer.getDevice().getGPUFeaturesAndProperties();
+
+    out << std::fixed << std::setprecision(6);
+    out << "{\n\"device\":{\"name\":";
+    writeString(device.gpuProperties.properties.deviceName);
+    out << ",\"apiVersion\":" << device.gpuProperties.properties.apiVersion
+        << ",\"driverVersion\":" << device.gpuProperties.properties.driverVersion
+        << ",\"rtSupport\":" << (device.rtSupport ? "true" : "false") << "},\n";
+
+    out << "\"config\":{\"models\":" << config.modelCount
+        << ",\"instances\":" << config.instanceCount
+        << ",\"lods\":" << config.lodCount
+        << ",\"materials\":" << config.materialCount
+        << ",\"sortedFraction\":" << config.sortedFraction
+        << ",\"animatedFraction\":" << config.animatedFraction
+        << ",\"rtFraction\":" << config.rtFraction
+        << ",\"rtInstances\":" << rtInstanceCount
+        << ",\"frames\":" << config.frameCount
+        << ",\"warmupFrames\":" << config.warmupFrameCount
+        << ",\"width\":" << config.width
+        << ",\"height\":" << config.height
+        << ",\"seed\":" << config.seed << "},\n";
+
+    out << "\"setupTime\":" << toMilliseconds(results.setupSeconds) << ",\n";
+    out << "\"frameTime\":{\"frames\":" << frameTime.sampleCount
+        << ",\"fps\":" << (results.measuredSeconds > 0.0 ? config.frameCount / results.measuredSeconds : 0.0)
+        << ",\"mean\":" << toMilliseconds(frameTime.mean)
+        << ",\"p50\":" << toMilliseconds(frameTime.p50)
+        << ",\"p95\":" << toMilliseconds(frameTime.p95)
+        << ",\"p99\":" << toMilliseconds(frameTime.p99)
+        << ",\"max\":" << toMilliseconds(frameTime.max)
+        << ",\"hitches\":" << frameTime.hitchCount << "},\n";
+
+    //GPU timings are the statistics GPUProfiler inserted with a " (GPU)" suffix; empty if the device has no timestamp support
+    const std::string gpuSuffix = " (GPU)";
+    const auto isGPU = [&](const std::string& name) { return name.size() > gpuSuffix.size() && name.compare(name.size() - gpuSuffix.size(), gpuSuffix.size(), gpuSuffix) == 0; };
+    for(const bool gpu : { false, true })
+    {
+        out << (gpu ? "\"gpuTimings\":{" : "\"cpuTimings\":{");
+        bool first = true;
+        for(const auto& [name, timings] : results.timings)
+        {
+            if(isGPU(name) != gpu) continue;
+
+            out << (first ? "\n" : ",\n");
+            writeTimings(gpu ? name.substr(0, name.size() - gpuSuffix.size()) : name, timings);
+            first = false;
+        }
+        out << "\n},\n";
+    }
+
+    out << "\"memory\":{";
+    for(uint32_t i = 0; i < PaperRenderer::MEMORY_CATEGORY_COUNT; i++)
+    {
+        out << (i ? ",\n" : "\n");
+        writeString(PaperRenderer::getMemoryCategoryName((PaperRenderer::MemoryCategory)i));
+        out << ":{\"bytes\":" << statistics.memoryUsage[i].bytes
+            << ",\"allocations\":" << statistics.memoryUsage[i].allocationCount
+            << ",\"peakBytes\":" << results.peakMemoryUsage[i].bytes
+            << ",\"peakAllocations\":" << results.peakMemoryUsage[i].allocationCount << "}";
+    }
+    out << "\n},\n";
+
+    out << "\"heapBudgets\":[";
+    for(uint32_t i = 0; i < statistics.heapBudgets.size(); i++)
+    {
+        const PaperRenderer::MemoryHeapBudget& budget = statistics.heapBudgets[i];
+        out << (i ? ",\n" : "\n")
+            << "{\"heap\":" << budget.heapIndex
+            << ",\"deviceLocal\":" << (budget.deviceLocal ? "true" : "false")
+            << ",\"usage\":" << budget.usage
+            << ",\"budget\":" << budget.budget
+            << ",\"allocationBytes\":" << budget.allocationBytes << "}";
+    }
+    out << "\n],\n";
+
+    out << "\"objectCounters\":{";
+    bool first = true;
+    for(const auto& [name, count] : std::map<std::string, uint64_t>(statistics.objectCounters.begin(), statistics.objectCounters.end()))
+    {
+        out << (first ? "\n" : ",\n");
+        writeString(name);
+        out << ":" << count;
+        first = false;
+    }
+    out << "\n}";
+
+    //heap allocations per measured frame by timer scope
+    if(PaperRenderer::allocationTrackingEnabled)
+    {
+        const double frameCount = config.frameCount;
+        out << ",\n\"allocationsPerFrame\":{";
+        first = true;
+        for(const auto& [name, allocation] : results.allocations)
+        {
+            out << (first ? "\n" : ",\n");
+            writeString(name);
+            out << ":{\"count\":" << allocation.count / frameCount << ",\"bytes\":" << allocation.bytes / frameCount << "}";
+            first = false;
+        }
+        out << "\n}";
+    }
+    out << "\n}\n";
+
+    return out.good();
+}
+
+//----------MAIN----------//
+
+int main(int argc, char** argv)
+{
+    const BenchConfig config = parseArguments(argc, argv);
+
+    //only warnings and errors are logged; stdout may be the JSON output
+    const auto logCallbackFunction = [](PaperRenderer::RenderEngine& renderer, const PaperRenderer::LogEvent& event) {
+        if(event.type == PaperRenderer::LogType::WARNING) std::cerr << "PAPER RENDERER WARNING: " << event.text << std::endl;
+        if(event.type == PaperRenderer::LogType::CRITICAL_ERROR) std::cerr << "PAPER RENDERER ERROR: " << event.text << std::endl;
+    };
+
+    //----------RENDERER INITIALIZATION----------//
+
+    PaperRenderer::RenderEngine renderer({
+        .logEventCallbackFunction = logCallbackFunction,
+        .rasterPreprocessSpirv = readFromFile(PAPER_BENCH_CORE_SHADER_DIR "IndirectDrawBuild.spv"),
+        .rtPreprocessSpirv = readFromFile(PAPER_BENCH_CORE_SHADER_DIR "TLASInstBuild.spv"),
+        .deviceInstanceInfo = {
+            .appName = "PaperRenderer Benchmark",
+            .engineName = "PaperRenderer",
+            .headless = true
+        },
+        .windowState = {
+            .windowName = "PaperRenderer Benchmark",
+            .resX = config.width,
+            .resY = config.height,
+            .presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR,
+            .imageUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+        }
+    });
+
+    const auto setupStart = std::chrono::steady_clock::now();
+    const bool rtEnabled = renderer.getDevice().getGPUFeaturesAndProperties().rtSupport && config.rtFraction > 0.0f;
+
+    //render targets; the color target is blitted to the swapchain each frame
+    RenderTarget colorTarget = createRenderTarget(renderer, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    RenderTarget depthTarget = createRenderTarget(renderer, getDepthFormat(renderer), VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+
+    //camera orbits the instance grid
+    const uint32_t gridSide = (uint32_t)std::ceil(std::sqrt((double)std::max(config.instanceCount, (uint32_t)1)));
+    const float gridSpacing = 3.0f;
+    const float orbitRadius = gridSide * gridSpacing * 0.6f + 5.0f;
+    PaperRenderer::Camera camera(renderer, {
+        .projection = PaperRenderer::PerspectiveCamera{ .yFov = 75.0f },
+        .transformation = glm::lookAt(glm::vec3(orbitRadius, 0.0f, orbitRadius * 0.5f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+        .clipNear = 0.1f,
+        .clipFar = orbitRadius * 4.0f
+    });
+
+    //materials
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+    const std::vector<uint32_t> vertShader = readFromFile(PAPER_BENCH_SHADER_DIR "Bench_vert.spv");
+    const std::vector<uint32_t> fragShader = readFromFile(PAPER_BENCH_SHADER_DIR "Bench_frag.spv");
+    BenchMaterial baseMaterial(renderer, vertShader, fragShader, colorTarget.format, depthTarget.format);
+
+    std::vector<std::unique_ptr<BenchMaterialInstance>> materialInstances;
+    materialInstances.reserve(config.materialCount);
+    for(uint32_t i = 0; i < config.materialCount; i++)
+    {
+        const glm::vec4 baseColor = glm::vec4(unitDistribution(rng), unitDistribution(rng), unitDistribution(rng), 1.0f);
+        materialInstances.push_back(std::make_unique<BenchMaterialInstance>(renderer, baseMaterial, baseColor));
+    }
+
+    //render pass
+    PaperRenderer::RenderPass renderPass(renderer, materialInstances[0]->getMaterialInstance());
+
+    //ray tracing; only acceleration structures are built, nothing is traced
+    std::unique_ptr<PaperRenderer::RayTraceRender> rtRender = NULL;
+    std::unique_ptr<PaperRenderer::TLAS> tlas = NULL;
+    const PaperRenderer::ShaderHitGroup hitGroup = {
+        .chitShaderData = rtEnabled ? readFromFile(PAPER_BENCH_SHADER_DIR "Bench_chit.spv") : std::vector<uint32_t>()
+    };
+    if(rtEnabled)
+    {
+        rtRender = std::make_unique<PaperRenderer::RayTraceRender>(
+            renderer,
+            readFromFile(PAPER_BENCH_SHADER_DIR "Bench_rgen.spv"),
+            std::vector<std::vector<uint32_t>>({ readFromFile(PAPER_BENCH_SHADER_DIR "Bench_rmiss.spv") }),
+            std::vector<std::vector<uint32_t>>(),
+            std::unordered_map<uint32_t, VkDescriptorSetLayout>(),
+            PaperRenderer::RTPipelineProperties(),
+            std::vector<VkPushConstantRange>()
+        );
+        tlas = rtRender->addNewTLAS();
+    }
+
+    //models
+    std::vector<PaperRenderer::Model> models;
+    models.reserve(config.modelCount);
+    for(uint32_t i = 0; i < config.modelCount; i++)
+    {
+        models.emplace_back(renderer, createModelInfo(i, config, rtEnabled));
+    }
+
+    //instances, laid out in a grid
+    std::vector<PaperRenderer::ModelInstance> instances;
+    std::vector<PaperRenderer::ModelInstance*> animatedInstances;
+    instances.reserve(config.instanceCount);
+    uint32_t rtInstanceCount = 0;
+    for(uint32_t i = 0; i < config.instanceCount; i++)
+    {
+        PaperRenderer::ModelInstance& instance = instances.emplace_back(models[rng() % models.size()], false);
+        instance.setTransformation({
+            .position = glm::vec3(((float)(i % gridSide) - gridSide * 0.5f) * gridSpacing, ((float)(i / gridSide) - gridSide * 0.5f) * gridSpacing, 0.0f),
+            .scale = glm::vec3(1.0f),
+            .rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f)
+        });
+
+        //same material for every LOD
+        PaperRenderer::MaterialInstance* materialInstance = &materialInstances[rng() % materialInstances.size()]->getMaterialInstance();
+        renderPass.addInstance(instance, std::vector<std::unordered_map<uint32_t, PaperRenderer::MaterialInstance*>>(config.lodCount, { { 0, materialInstance } }), unitDistribution(rng) < config.sortedFraction);
+
+        if(rtEnabled && unitDistribution(rng) < config.rtFraction)
+        {
+            rtRender->addInstance({ { tlas.get(), { .instancePtr = &instance, .hitGroup = &hitGroup, .customIndex = i } } });
+            rtInstanceCount++;
+        }
+        if(unitDistribution(rng) < config.animatedFraction)
+        {
+            animatedInstances.push_back(&instance);
+        }
+    }
+
+    BenchResults results = {};
+    results.setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+
+    //----------RENDER LOOP----------//
+
+    std::array<uint64_t, 2> finalSemaphoreValues = { 0, 0 };
+    std::array<VkSemaphore, 2> renderingSemaphores = {
+        renderer.getDevice().getCommands().getTimelineSemaphore(finalSemaphoreValues[0]),
+        renderer.getDevice().getCommands().getTimelineSemaphore(finalSemaphoreValues[1])
+    };
+    std::vector<VkSemaphore> presentationSemaphores(renderer.getSwapchain().getImageCount());
+    for(VkSemaphore& semaphore : presentationSemaphores)
+    {
+        semaphore = renderer.getDevice().getCommands().getSemaphore();
+    }
+
+    auto measureStart = std::chrono::steady_clock::now();
+    for(uint32_t frame = 0; frame < config.warmupFrameCount + config.frameCount; frame++)
+    {
+        //start measuring
+        if(frame == config.warmupFrameCount)
+        {
+            renderer.getStatisticsTracker().enableAggregation({ .windowSize = config.frameCount });
+            measureStart = std::chrono::steady_clock::now();
+        }
+
+        //wait for the last frame using this buffer index
+        const uint32_t bufferIndex = renderer.getBufferIndex();
+        const uint32_t otherBufferIndex = !bufferIndex;
+        const VkSemaphore renderingSemaphore = renderingSemaphores[bufferIndex];
+        uint64_t semaphoreValue = finalSemaphoreValues[bufferIndex];
+
+        const VkSemaphoreWaitInfo beginWaitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &renderingSemaphore,
+            .pValues = &semaphoreValue
+        };
+        vkWaitSemaphores(renderer.getDevice().getDevice(), &beginWaitInfo, UINT64_MAX);
+
+        //each submission waits on the last one in this frame
+        const auto nextSyncInfo = [&](VkPipelineStageFlags2 waitStage, VkPipelineStageFlags2 signalStage)
+        {
+            const PaperRenderer::SynchronizationInfo syncInfo = {
+                .timelineWaitPairs = { { renderingSemaphore, waitStage, semaphoreValue } },
+                .timelineSignalPairs = { { renderingSemaphore, signalStage, semaphoreValue + 1 } }
+            };
+            semaphoreValue++;
+
+            return syncInfo;
+        };
+
+        //animate (transforms are uploaded by beginFrame)
+        {
+            PaperRenderer::Timer timer(renderer, "Bench Animate Instances", PaperRenderer::REGULAR);
+
+            const glm::quat rotation = glm::angleAxis(frame * 0.05f, glm::vec3(0.0f, 0.0f, 1.0f));
+            for(PaperRenderer::ModelInstance* instance : animatedInstances)
+            {
+                PaperRenderer::ModelTransformation transformation = instance->getTransformation();
+                transformation.rotation = rotation;
+                instance->setTransformation(transformation);
+            }
+        }
+
+        //begin frame (also waits for the other buffer index's frame on the GPU)
+        std::vector<PaperRenderer::StagingBufferTransfer> beginFrameTransfers = {};
+        PaperRenderer::SynchronizationInfo transferSyncInfo = nextSyncInfo(VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+        transferSyncInfo.timelineWaitPairs.push_back({ renderingSemaphores[otherBufferIndex], VK_PIPELINE_STAGE_2_TRANSFER_BIT, finalSemaphoreValues[otherBufferIndex] });
+        const VkSemaphore swapchainSemaphore = renderer.beginFrame(beginFrameTransfers, transferSyncInfo);
+
+        //camera
+        const float orbitAngle = frame * 0.01f;
+        const glm::vec3 cameraPosition = glm::vec3(cos(orbitAngle) * orbitRadius, sin(orbitAngle) * orbitRadius, orbitRadius * 0.5f);
+        camera.updateView(glm::lookAt(cameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+        camera.updateUBO();
+
+        //acceleration structures
+        if(rtEnabled)
+        {
+            renderer.getAsBuilder().submitQueuedOps(nextSyncInfo(VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR));
+            rtRender->updateTLAS(*tlas, VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
+                nextSyncInfo(VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT));
+        }
+
+        //raster
+        const auto imageBarrier = [](VkImage image, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout)
+        {
+            return VkImageMemoryBarrier2{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .pNext = NULL,
+                .srcStageMask = srcStage,
+                .srcAccessMask = srcAccess,
+                .dstStageMask = dstStage,
+                .dstAccessMask = dstAccess,
+                .oldLayout = oldLayout,
+                .newLayout = newLayout,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = image,
+                .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+            };
+        };
+        const auto dependencyInfo = [](const VkImageMemoryBarrier2* barriers, uint32_t count)
+        {
+            return VkDependencyInfo{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = NULL,
+                .dependencyFlags = 0,
+                .imageMemoryBarrierCount = count,
+                .pImageMemoryBarriers = barriers
+            };
+        };
+
+        const VkImageMemoryBarrier2 preRenderBarrier = imageBarrier(colorTarget.image.getImage(),
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        const VkImageMemoryBarrier2 postRenderBarrier = imageBarrier(colorTarget.image.getImage(),
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        const VkDependencyInfo preRenderDependency = dependencyInfo(&preRenderBarrier, 1);
+        const VkDependencyInfo postRenderDependency = dependencyInfo(&postRenderBarrier, 1);
+
+        const VkRenderingAttachmentInfo colorAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = NULL,
+            .imageView = colorTarget.view,
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = { 0.1f, 0.1f, 0.1f, 1.0f }
+        };
+        const VkRenderingAttachmentInfo depthAttachment = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = NULL,
+            .imageView = depthTarget.view,
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .clearValue = { 1.0f, 0 }
+        };
+
+        const VkExtent2D extent = renderer.getSwapchain().getExtent();
+        const PaperRenderer::RenderPassInfo renderPassInfo = {
+            .camera = camera,
+            .colorAttachments = { colorAttachment },
+            .depthAttachment = &depthAttachment,
+            .viewports = { { 0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f } },
+            .scissors = { { { 0, 0 }, extent } },
+            .renderArea = { { 0, 0 }, extent },
+            .preRenderBarriers = &preRenderDependency,
+            .postRenderBarriers = &postRenderDependency,
+            .sortMode = PaperRenderer::RenderPassSortMode::BACK_FIRST
+        };
+        renderPass.render(renderPassInfo, nextSyncInfo(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT));
+
+        //blit to the swapchain and transition it for presentation
+        const VkSemaphore presentationSemaphore = presentationSemaphores[renderer.getSwapchain().getSwapchainImageIndex()];
+        {
+            const VkCommandBufferBeginInfo commandInfo = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .pNext = NULL,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                .pInheritanceInfo = NULL
+            };
+
+            PaperRenderer::CommandBuffer cmdBuffer(renderer.getDevice().getCommands(), PaperRenderer::GRAPHICS);
+            vkBeginCommandBuffer(cmdBuffer, &commandInfo);
+
+            const VkImageMemoryBarrier2 preBlitBarrier = imageBarrier(renderer.getSwapchain().getCurrentImage(),
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            const VkDependencyInfo preBlitDependency = dependencyInfo(&preBlitBarrier, 1);
+            vkCmdPipelineBarrier2(cmdBuffer, &preBlitDependency);
+
+            const VkImageBlit region = {
+                .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+                .srcOffsets = { { 0, 0, 0 }, { (int32_t)extent.width, (int32_t)extent.height, 1 } },
+                .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+                .dstOffsets = { { 0, 0, 0 }, { (int32_t)extent.width, (int32_t)extent.height, 1 } }
+            };
+            vkCmdBlitImage(cmdBuffer, colorTarget.image.getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, renderer.getSwapchain().getCurrentImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
+
+            const VkImageMemoryBarrier2 presentBarrier = imageBarrier(renderer.getSwapchain().getCurrentImage(),
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, VK_ACCESS_2_NONE,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+            const VkDependencyInfo presentDependency = dependencyInfo(&presentBarrier, 1);
+            vkCmdPipelineBarrier2(cmdBuffer, &presentDependency);
+
+            vkEndCommandBuffer(cmdBuffer);
+
+            PaperRenderer::SynchronizationInfo presentSyncInfo = nextSyncInfo(VK_PIPELINE_STAGE_2_BLIT_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+            presentSyncInfo.binaryWaitPairs = { { swapchainSemaphore, VK_PIPELINE_STAGE_2_BLIT_BIT } };
+            presentSyncInfo.binarySignalPairs = { { presentationSemaphore, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT } };
+            renderer.getDevice().getCommands().submitToQueue(PaperRenderer::GRAPHICS, presentSyncInfo, { cmdBuffer });
+        }
+
+        //end frame
+        finalSemaphoreValues[bufferIndex] = semaphoreValue;
+        renderer.endFrame({ presentationSemaphore });
+
+        //statistics of this frame were merged by endFrame()
+        if(frame >= config.warmupFrameCount)
+        {
+            recordFrameResults(renderer, results);
+        }
+    }
+
+    renderer.getDevice().getCommands().flushSubmissions();
+    vkDeviceWaitIdle(renderer.getDevice().getDevice());
+    results.measuredSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+
+    //----------RESULTS----------//
+
+    const bool written = writeResults(renderer, config, results, rtInstanceCount);
+    if(!written)
+    {
+        std::cerr << "Failed to write results to " << config.outputPath << std::endl;
+    }
+
+    //----------CLEANUP----------//
+
+    instances.clear();
+    for(uint32_t i = 0; i < renderingSemaphores.size(); i++)
+    {
+        renderer.getDevice().getCommands().recycleTimelineSemaphore(renderingSemaphores[i], finalSemaphoreValues[i]);
+    }
+    for(VkSemaphore semaphore : presentationSemaphores)
+    {
+        renderer.getDevice().getCommands().recycleSemaphore(semaphore);
+    }
+    vkDestroyImageView(renderer.getDevice().getDevice(), colorTarget.view, nullptr);
+    vkDestroyImageView(renderer.getDevice().getDevice(), depthTarget.view, nullptr);
+
+    return written ? 0 : 1;
+}
@@ -12,7 +12,7 @@
 
 struct InstanceDescription
 {
-    uint modelDataOffset;
+    uint modelDataHandle;
 };
 
 layout(scalar, set = 3, binding = 0) readonly buffer InstanceDescriptions
@@ -83,10 +83,11 @@ HitInfo getHitInfo()
     //get instance description
     InstanceDescription instanceDescription = instanceDescriptions.descriptions[gl_InstanceID];
 
-    //get model data
-    Model model = InputModel(inputData.modelDataReference + instanceDescription.modelDataOffset).model;
-    ModelLOD modelLOD0 = ModelLODs(inputData.modelDataReference + instanceDescription.modelDataOffset + model.lodsOffset).LODs[0];
-    ModelLODMeshGroup modelMeshGroup = ModelLODMeshGroups(inputData.modelDataReference + instanceDescription.modelDataOffset + modelLOD0.meshGroupOffset).groups[gl_GeometryIndexEXT];
+    //get model data; the handle is resolved through the table since the data moves when the model data buffer is compacted
+    const uint modelDataOffset = ModelDataTable(inputData.modelDataTablePtr).offsets[instanceDescription.modelDataHandle];
+    Model model = InputModel(inputData.modelDataReference + modelDataOffset).model;
+    ModelLOD modelLOD0 = ModelLODs(inputData.modelDataReference + modelDataOffset + model.lodsOffset).LODs[0];
+    ModelLODMeshGroup modelMeshGroup = ModelLODMeshGroups(inputData.modelDataReference + modelDataOffset + modelLOD0.meshGroupOffset).groups[gl_GeometryIndexEXT];
     
     //indices
     uint ind0;
@@ -23,6 +23,7 @@ layout(set = 2, binding = 0) uniform InputData
 {
     uint64_t tlasAddress;
     uint64_t modelDataReference;
+    uint64_t modelDataTablePtr;
     uint64_t frameNumber;
     uint recursionDepth;
     uint aoSamples;
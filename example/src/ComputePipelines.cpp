@@ -32,15 +32,24 @@ PaperRenderer::Queue& AnimationPipeline::animateInstances(const std::vector<Pape
         .pInheritanceInfo = NULL
     };
     vkBeginCommandBuffer(cmdBuffer, &cmdBufferBeginInfo);
+
+    PaperRenderer::SynchronizationInfo animationSyncInfo = syncInfo;
     
     // Invoke pipeline for each instance
     for(PaperRenderer::ModelInstance* instance : instances)
     {
+        // Unique geometry shares the parent's VBO until written to, so get a writable copy. The copy is done on the GPU, so wait on it before writing
+        const PaperRenderer::ModelGeometryData& outGeometryData = instance->getWritableGeometryData();
+        for(const PaperRenderer::TimelineSemaphorePair& submission : outGeometryData.getVBOOwnerSubmissions())
+        {
+            animationSyncInfo.timelineWaitPairs.push_back({ submission.semaphore, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, submission.value });
+        }
+
         const InstanceAnimationInfo instanceAnimationInfo = {
-            .inVboAddress = instance->getGeometryData().getParentModel().getGeometryData().getVBO().getBufferDeviceAddress(),
-            .outVboAddress = instance->getGeometryData().getVBO().getBufferDeviceAddress(),
+            .inVboAddress = instance->getParentModel().getGeometryData().getVBO().getBufferDeviceAddress(),
+            .outVboAddress = outGeometryData.getVBO().getBufferDeviceAddress(),
             .instancePosition = instance->getTransformation().position,
-            .vertexCount = (uint32_t)(instance->getGeometryData().getVBO().getSize() / sizeof(Vertex)), // Sloppy but works
+            .vertexCount = (uint32_t)(outGeometryData.getVBO().getSize() / sizeof(Vertex)), // Sloppy but works
             .seed = (uint32_t)(glfwGetTime() * 10000.0)
         };
 
@@ -59,5 +68,5 @@ PaperRenderer::Queue& AnimationPipeline::animateInstances(const std::vector<Pape
 
     vkEndCommandBuffer(cmdBuffer);
 
-    return renderer.getDevice().getCommands().submitToQueue(PaperRenderer::QueueType::COMPUTE, syncInfo, { cmdBuffer });
+    return renderer.getDevice().getCommands().submitToQueue(PaperRenderer::QueueType::COMPUTE, animationSyncInfo, { cmdBuffer });
 }
@@ -268,6 +268,7 @@ void ExampleRayTracing::updateUBO()
     const RayTraceInfo rtInfo = {
         .tlasAddress = primaryTLAS->getAsDeviceAddress(),
         .modelDataReference = renderer.getModelDataBuffer().getBufferDeviceAddress(),
+        .modelDataTablePtr = renderer.getModelDataTableBuffer().getBufferDeviceAddress(),
         .frameNumber = renderer.getFramesRenderedCount(),
         .recursionDepth = rayRecursionDepth,
         .aoSamples = 1,
@@ -44,13 +44,14 @@ private:
     {
         uint64_t tlasAddress;
         uint64_t modelDataReference;
+        uint64_t modelDataTablePtr;
         uint64_t frameNumber;
         uint32_t recursionDepth;
         uint32_t aoSamples;
         float aoRadius;
         uint32_t shadowSamples;
         uint32_t reflectionSamples;
-        float padding[4];
+        float padding[2];
     };
     PaperRenderer::Buffer rtInfoUBO;
     
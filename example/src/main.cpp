@@ -870,26 +870,21 @@ int main()
         //get opposite buffer index (i didnt even know this was legal until i tried it)
         const uint32_t otherBufferIndex = !renderer.getBufferIndex();
 
-        //specify extra transfers to be sent on the same queue submission when frame begins
-        std::vector<PaperRenderer::StagingBufferTransfer> beginFrameTransfers = {};
+        //specify extra transfers to be sent on the same queue submission when frame begins; frame memory isn't released until the next frame begins
+        std::pmr::vector<PaperRenderer::StagingBufferTransfer> beginFrameTransfers(renderer.getFrameMemory().getResource());
         if(!guiContext.raster)
         {
+            const DefaultShaderHitGroupDefinition newData = {
+                .albedo = glm::vec3(guiContext.adjustableMaterial->getParameters().baseColor),
+                .emissive = glm::vec3(guiContext.adjustableMaterial->getParameters().emission) * guiContext.adjustableMaterial->getParameters().emission.w,
+                .metallic = guiContext.adjustableMaterial->getParameters().metallic,
+                .roughness = guiContext.adjustableMaterial->getParameters().roughness,
+                .transmission = glm::vec3(0.0f),
+                .ior = 1.45f
+            };
             beginFrameTransfers.push_back({
                 .dstOffset = adjustableMaterialIndex * sizeof(DefaultShaderHitGroupDefinition),
-                .data = [&] {
-                    const DefaultShaderHitGroupDefinition newData = {
-                        .albedo = glm::vec3(guiContext.adjustableMaterial->getParameters().baseColor),
-                        .emissive = glm::vec3(guiContext.adjustableMaterial->getParameters().emission) * guiContext.adjustableMaterial->getParameters().emission.w,
-                        .metallic = guiContext.adjustableMaterial->getParameters().metallic,
-                        .roughness = guiContext.adjustableMaterial->getParameters().roughness,
-                        .transmission = glm::vec3(0.0f),
-                        .ior = 1.45f
-                    };
-                    std::vector<uint8_t> transferData(sizeof(DefaultShaderHitGroupDefinition));
-                    memcpy(transferData.data(), &newData, sizeof(DefaultShaderHitGroupDefinition));
-
-                    return transferData;
-                } (),
+                .dataView = renderer.getFrameMemory().copy(&newData, sizeof(DefaultShaderHitGroupDefinition)),
                 .dstBuffer = &ShaderHitGroupDefinitionsBuffer
             });
         }
@@ -914,7 +909,9 @@ int main()
             returnData.reserve(modelInstances["Suzanne"].size());
             for(PaperRenderer::ModelInstance& instance : modelInstances["Suzanne"])
             {
-                instance.queueBLAS(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR);
+                //the animation displaces vertices from the rest pose by at most 0.06 units, and by far less than that between frames, so a
+                //conservative per frame estimate relative to the roughly 2 unit model is used; refits then hold up until the refit limit
+                instance.queueBLAS(VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR, 0.005f);
                 returnData.push_back(&instance);
             }
             return returnData;
@@ -991,13 +988,13 @@ int main()
     rainDrops.clear();
 
     //destroy some stuff
-    for(VkSemaphore semaphore : renderingSemaphores)
+    for(uint32_t i = 0; i < renderingSemaphores.size(); i++)
     {
-        vkDestroySemaphore(renderer.getDevice().getDevice(), semaphore, nullptr);
+        renderer.getDevice().getCommands().recycleTimelineSemaphore(renderingSemaphores[i], finalSemaphoreValues[i]);
     };
     for(VkSemaphore semaphore : presentationSemaphores)
     {
-        vkDestroySemaphore(renderer.getDevice().getDevice(), semaphore, nullptr);
+        renderer.getDevice().getCommands().recycleSemaphore(semaphore);
     };
     vkDestroyImageView(renderer.getDevice().getDevice(), hdrBuffer.view, nullptr);
     vkDestroyImageView(renderer.getDevice().getDevice(), depthBuffer.view, nullptr);
@@ -65,8 +65,8 @@ struct ModelInstance
     vec3 position;
     vec3 scale;
     vec4 qRotation;
-    uint selfModelDataOffset;   // Reference to self's model data (0xFFFFFFFF if it doesn't exist)
-    uint parentModelDataOffset; // Reference to parent model's data (should always be exist and be valid)
+    uint selfModelDataHandle;   // Handle to self's model data (0xFFFFFFFF if it doesn't exist)
+    uint parentModelDataHandle; // Handle to parent model's data (should always be exist and be valid)
 };
 
 layout(scalar, set = 1, binding = 0) readonly buffer InputInstances
@@ -74,8 +74,20 @@ layout(scalar, set = 1, binding = 0) readonly buffer InputInstances
     ModelInstance modelInstances[];
 } inputInstances;
 
+//model data handles index this table for the model data's current offset, so compactions only need to rewrite moved entries
+layout(scalar, buffer_reference) readonly buffer ModelDataTable
+{
+    uint offsets[];
+};
+
 //----------FUNCTIONS----------//
 
+uint getModelDataOffset(ModelInstance modelInstance, uint64_t modelDataTablePtr)
+{
+    const uint handle = modelInstance.selfModelDataHandle == 0xFFFFFFFF ? modelInstance.parentModelDataHandle : modelInstance.selfModelDataHandle;
+    return ModelDataTable(modelDataTablePtr).offsets[handle];
+}
+
 mat3x4 getModelMatrix(ModelInstance modelInstance)
 {
     //rotation
@@ -33,6 +33,27 @@ namespace PaperRenderer
                 .descriptorCount = 1,
                 .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
                 .pImmutableSamplers = NULL
+            },
+            {
+                .binding = 2,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = NULL
+            },
+            {
+                .binding = 3,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = NULL
+            },
+            {
+                .binding = 4,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .pImmutableSamplers = NULL
             }
         }),
         computeShader(renderer, {
@@ -47,25 +68,19 @@ namespace PaperRenderer
         renderer(renderer)
     {
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "TLASInstanceBuildPipeline constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "TLASInstanceBuildPipeline constructor finished");
     }
 
     TLASInstanceBuildPipeline::~TLASInstanceBuildPipeline()
     {        
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "TLASInstanceBuildPipeline destructor initialized"
-        });
+        renderer.getLogger().recordLog(INFO, "TLASInstanceBuildPipeline destructor initialized");
     }
 
     void TLASInstanceBuildPipeline::submit(VkCommandBuffer cmdBuffer, const TLAS& tlas, const uint32_t count) const
     {
         //descriptor bindings
-        const std::vector<SetBinding> descriptorBindings = {
+        const SetBinding descriptorBindings[] = {
             { //set 0 (UBO input data)
                 .set =  tlas.uboDescriptor,
                 .binding = {
@@ -96,6 +111,7 @@ namespace PaperRenderer
         };
 
         //dispatch
+        GPUTimer gpuTimer(renderer, cmdBuffer, COMPUTE, "TLAS Instance Build", REGULAR);
         computeShader.dispatch(cmdBuffer, descriptorBindings, glm::uvec3((count / 128) + 1, 1, 1));
     }
 
@@ -136,8 +152,11 @@ namespace PaperRenderer
         return vkGetAccelerationStructureDeviceAddressKHR(renderer.getDevice().getDevice(), &info);
     }
 
-    AS::AsBuildData AS::getAsData(const VkAccelerationStructureTypeKHR type, const VkBuildAccelerationStructureFlagsKHR flags, const VkBuildAccelerationStructureModeKHR mode)
+    AS::AsBuildData AS::getAsData(const VkAccelerationStructureTypeKHR type, const VkBuildAccelerationStructureFlagsKHR flags, const VkBuildAccelerationStructureModeKHR requestedMode)
     {
+        //a structure that doesn't exist yet can't be updated
+        const VkBuildAccelerationStructureModeKHR mode = accelerationStructure ? requestedMode : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+
         //delete AS in destruction queue
         for(VkAccelerationStructureKHR structure : asDestructionQueue[renderer.getBufferIndex()])
         {
@@ -152,8 +171,8 @@ namespace PaperRenderer
             accelerationStructure = VK_NULL_HANDLE;
         }
 
-        //get compaction flag
-        const bool compact = flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR ? true : false;
+        //get compaction flag; updates keep the existing (possibly already compacted) structure
+        const bool compact = flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR && mode != VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR ? true : false;
 
         //get geometry data
         std::unique_ptr<AsGeometryBuildData> geometryBuildData = getGeometryData();
@@ -184,6 +203,13 @@ namespace PaperRenderer
             &buildGeoInfo,
             geometryBuildData->primitiveCounts.data(),
             &buildSizeInfo);
+
+        //updates are done in place
+        if(mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR)
+        {
+            buildGeoInfo.dstAccelerationStructure = accelerationStructure;
+            return { std::move(geometryBuildData), buildGeoInfo, buildSizeInfo, compact };
+        }
         
         //update buffer if needed
         if(asBuffer.getSize() < buildSizeInfo.accelerationStructureSize)
@@ -191,7 +217,8 @@ namespace PaperRenderer
             const BufferInfo bufferInfo = {
                 .size = buildSizeInfo.accelerationStructureSize,
                 .usageFlags = VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-                .allocationFlags = 0
+                .allocationFlags = 0,
+                .category = MEMORY_ACCELERATION_STRUCTURE
             };
             asBuffer = Buffer(renderer, bufferInfo);
         }
@@ -207,6 +234,7 @@ namespace PaperRenderer
             .type = buildGeoInfo.type
         };
         vkCreateAccelerationStructureKHR(renderer.getDevice().getDevice(), &accelerationStructureInfo, nullptr, &accelerationStructure);
+        DescriptorAllocator::notifyHandleCreated();
 
         //update dstAccelerationStructure variable
         buildGeoInfo.dstAccelerationStructure = accelerationStructure;
@@ -270,13 +298,14 @@ namespace PaperRenderer
         }
     }
 
-    Buffer AS::compactStructure(VkCommandBuffer cmdBuffer, const VkAccelerationStructureTypeKHR type, const VkDeviceSize newSize)
+    AS::RetiredStructure AS::compactStructure(VkCommandBuffer cmdBuffer, const VkAccelerationStructureTypeKHR type, const VkDeviceSize newSize)
     {
         //create new buffer
         const BufferInfo bufferInfo = {
             .size = newSize,
             .usageFlags = VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_ACCELERATION_STRUCTURE
         };
         Buffer newBuffer(renderer, bufferInfo);
 
@@ -294,6 +323,7 @@ namespace PaperRenderer
             .type = type
         };
         vkCreateAccelerationStructureKHR(renderer.getDevice().getDevice(), &accelStructureInfo, nullptr, &accelerationStructure);
+        DescriptorAllocator::notifyHandleCreated();
 
         //copy
         const VkCopyAccelerationStructureInfoKHR copyInfo = {
@@ -305,14 +335,14 @@ namespace PaperRenderer
         };
         vkCmdCopyAccelerationStructureKHR(cmdBuffer, &copyInfo);
 
-        //queue destruction of old
-        asDestructionQueue[renderer.getBufferIndex()].push_front(oldStructure);
-
-        //set new buffer
-        Buffer oldBuffer = std::move(asBuffer);
+        //set new buffer; old structure and buffer are handed to the caller for deferred destruction
+        RetiredStructure retiredStructure = {
+            .structure = oldStructure,
+            .buffer = std::move(asBuffer)
+        };
         asBuffer = std::move(newBuffer);
 
-        return oldBuffer;
+        return retiredStructure;
     }
 
     void AS::assignResourceOwner(Queue &queue)
@@ -330,6 +360,7 @@ namespace PaperRenderer
 
     BLAS::~BLAS()
     {
+        renderer.getAsBuilder().removeBLAS(this);
     }
 
     std::unique_ptr<AS::AsGeometryBuildData> BLAS::getGeometryData() const
@@ -400,22 +431,19 @@ namespace PaperRenderer
         preprocessUniformBuffer(renderer, {
             .size = sizeof(TLASInstanceBuildPipeline::UBOInputData),
             .usageFlags = VK_BUFFER_USAGE_2_UNIFORM_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
-            .allocationFlags = 0
-        }),
-        scratchBuffer(renderer, {
-            .size = 0,
-            .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_ACCELERATION_STRUCTURE
         }),
         instancesBuffer(renderer, {
             .size = 0,
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT |
-                VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+                VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT_KHR,
             .allocationFlags = 0
         }),
         transferSemaphore(renderer.getDevice().getCommands().getTimelineSemaphore(transferSemaphoreValue)),
         uboDescriptor(renderer, renderer.getTLASPreprocessPipeline().getUboDescriptorLayout()),
-        ioDescriptor(renderer, renderer.getTLASPreprocessPipeline().getIODescriptorLayout()),
+        ioDescriptor(renderer, renderer.getTLASPreprocessPipeline().getIODescriptorLayout(), true),
         instanceDescriptionsDescriptor(renderer, renderer.getDefaultDescriptorSetLayout(TLAS_INSTANCE_DESCRIPTIONS)),
         rtRender(rtRender)
     {
@@ -437,8 +465,8 @@ namespace PaperRenderer
 
     TLAS::~TLAS()
     {
-        //destroy semaphore
-        vkDestroySemaphore(renderer.getDevice().getDevice(), transferSemaphore, nullptr);
+        //recycle semaphore
+        renderer.getDevice().getCommands().recycleTimelineSemaphore(transferSemaphore, transferSemaphoreValue);
 
         //remove reference
         rtRender.tlasData.erase(this);
@@ -507,6 +535,15 @@ namespace PaperRenderer
                 renderer.getDevice().getGPUFeaturesAndProperties().gpuProperties.properties.limits.minStorageBufferOffsetAlignment
             );
 
+            //culled tl instance descriptions
+            const VkDeviceSize newTLInstanceDescriptionsSize = newInstanceDescriptionsSize;
+
+            //build range (VkAccelerationStructureBuildRangeInfoKHR) holding the culled instance count
+            const VkDeviceSize newBuildRangeSize = Device::getAlignment(
+                sizeof(VkAccelerationStructureBuildRangeInfoKHR),
+                renderer.getDevice().getGPUFeaturesAndProperties().gpuProperties.properties.limits.minStorageBufferOffsetAlignment
+            );
+
             //create copy of old offsets and ranges for data copy
             InstancesBufferSizes oldInstancesBufferSizes = instancesBufferSizes;
 
@@ -517,15 +554,21 @@ namespace PaperRenderer
                 .instanceDescriptionsOffset = newInstancesSize,
                 .instanceDescriptionsRange = newInstanceDescriptionsSize,
                 .tlInstancesOffset = newInstancesSize + newInstanceDescriptionsSize,
-                .tlInstancesRange = newTLInstancesSize
+                .tlInstancesRange = newTLInstancesSize,
+                .tlInstanceDescriptionsOffset = newInstancesSize + newInstanceDescriptionsSize + newTLInstancesSize,
+                .tlInstanceDescriptionsRange = newTLInstanceDescriptionsSize,
+                .buildRangeOffset = newInstancesSize + newInstanceDescriptionsSize + newTLInstancesSize + newTLInstanceDescriptionsSize,
+                .buildRangeRange = newBuildRangeSize
             };
 
             //buffer
             const BufferInfo instancesBufferInfo = {
                 .size = instancesBufferSizes.totalSize(),
                 .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT |
-                    VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-                .allocationFlags = 0
+                    VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                    VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT_KHR,
+                .allocationFlags = 0,
+                .category = MEMORY_ACCELERATION_STRUCTURE
             };
             Buffer newInstancesBuffer(renderer, instancesBufferInfo);
 
@@ -574,38 +617,14 @@ namespace PaperRenderer
 
             //----------UPDATE DESCRIPTOR SETS----------//
 
-            //io
-            ioDescriptor.updateDescriptorSet({
-                .bufferWrites = {
-                    { //binding 0: input objects
-                        .infos = { {
-                            .buffer = instancesBuffer.getBuffer(),
-                            .offset = instancesBufferSizes.instancesOffset,
-                            .range = instancesBufferSizes.instancesRange
-                        } },
-                        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                        .binding = 0
-                    },
-                    { //binding 1: output objects
-                        .infos = { {
-                            .buffer = instancesBuffer.getBuffer(),
-                            .offset = instancesBufferSizes.tlInstancesOffset,
-                            .range = instancesBufferSizes.tlInstancesRange
-                        } },
-                        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                        .binding = 1
-                    }
-                }
-            });
-
-            //instance descriptions 
+            //instance descriptions; culled and compacted alongside the TLAS instances so they can be indexed with gl_InstanceID
             instanceDescriptionsDescriptor.updateDescriptorSet({
                 .bufferWrites = {
                     { //binding 0: model instances
                         .infos = { {
                             .buffer = instancesBuffer.getBuffer(),
-                            .offset = instancesBufferSizes.instanceDescriptionsOffset,
-                            .range = instancesBufferSizes.instanceDescriptionsRange
+                            .offset = instancesBufferSizes.tlInstanceDescriptionsOffset,
+                            .range = instancesBufferSizes.tlInstanceDescriptionsRange
                         } },
                         .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                         .binding = 0
@@ -617,22 +636,108 @@ namespace PaperRenderer
 
     void TLAS::buildStructure(VkCommandBuffer cmdBuffer, AsBuildData& data, const CompactionQuery compactionQuery, const VkDeviceAddress scratchAddress)
     {
+        const bool indirectBuild = renderer.getDevice().getGPUFeaturesAndProperties().asIndirectBuild;
+
+        //reset culled instance count. direct builds use the full instance count, so the TL instances are cleared to leave culled slots as inactive (null reference) instances
+        vkCmdFillBuffer(cmdBuffer, instancesBuffer.getBuffer(), instancesBufferSizes.buildRangeOffset, sizeof(VkAccelerationStructureBuildRangeInfoKHR), 0);
+        if(!indirectBuild)
+        {
+            vkCmdFillBuffer(cmdBuffer, instancesBuffer.getBuffer(), instancesBufferSizes.tlInstancesOffset, instancesBufferSizes.tlInstancesRange, 0);
+        }
+
+        //clear memory barrier
+        const VkBufferMemoryBarrier2 clearMemBarrier = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = NULL,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = instancesBuffer.getBuffer(),
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        const VkDependencyInfo clearDependencyInfo = {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext = NULL,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers = &clearMemBarrier
+        };
+
+        vkCmdPipelineBarrier2(cmdBuffer, &clearDependencyInfo);
+
+        //the IO set is allocated per build from the frame's transient pools, so a set still bound by a previous frame's commands is never rewritten
+        ioDescriptor = ResourceDescriptor(renderer, renderer.getTLASPreprocessPipeline().getIODescriptorLayout(), true);
+        ioDescriptor.updateDescriptorSet({
+            .bufferWrites = {
+                { //binding 0: input objects
+                    .infos = { {
+                        .buffer = instancesBuffer.getBuffer(),
+                        .offset = instancesBufferSizes.instancesOffset,
+                        .range = instancesBufferSizes.instancesRange
+                    } },
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .binding = 0
+                },
+                { //binding 1: output objects
+                    .infos = { {
+                        .buffer = instancesBuffer.getBuffer(),
+                        .offset = instancesBufferSizes.tlInstancesOffset,
+                        .range = instancesBufferSizes.tlInstancesRange
+                    } },
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .binding = 1
+                },
+                { //binding 2: input instance descriptions
+                    .infos = { {
+                        .buffer = instancesBuffer.getBuffer(),
+                        .offset = instancesBufferSizes.instanceDescriptionsOffset,
+                        .range = instancesBufferSizes.instanceDescriptionsRange
+                    } },
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .binding = 2
+                },
+                { //binding 3: output instance descriptions
+                    .infos = { {
+                        .buffer = instancesBuffer.getBuffer(),
+                        .offset = instancesBufferSizes.tlInstanceDescriptionsOffset,
+                        .range = instancesBufferSizes.tlInstanceDescriptionsRange
+                    } },
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .binding = 3
+                },
+                { //binding 4: build range
+                    .infos = { {
+                        .buffer = instancesBuffer.getBuffer(),
+                        .offset = instancesBufferSizes.buildRangeOffset,
+                        .range = instancesBufferSizes.buildRangeRange
+                    } },
+                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .binding = 4
+                }
+            }
+        });
+
         //submit
         renderer.tlasInstanceBuildPipeline.submit(cmdBuffer, *this, rtRender.tlasData[this].instanceDatas.size());
 
-        //TLAS instance data memory barrier
+        //TLAS instance data and build range memory barrier
         const VkBufferMemoryBarrier2 tlasInstanceMemBarrier = {
             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
             .pNext = NULL,
             .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
             .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
             .dstStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .buffer = instancesBuffer.getBuffer(),
             .offset = instancesBufferSizes.tlInstancesOffset,
-            .size = instancesBufferSizes.tlInstancesRange
+            .size = VK_WHOLE_SIZE
         };
 
         const VkDependencyInfo tlasInstanceDependencyInfo = {
@@ -645,14 +750,26 @@ namespace PaperRenderer
 
         vkCmdPipelineBarrier2(cmdBuffer, &tlasInstanceDependencyInfo);
 
-        //call super function
-        AS::buildStructure(cmdBuffer, data, compactionQuery, scratchAddress);
+        //build with the culled instance count if supported, otherwise call super function
+        if(indirectBuild)
+        {
+            data.buildGeoInfo.scratchData.deviceAddress = scratchAddress;
+
+            const VkDeviceAddress buildRangeAddress = instancesBuffer.getBufferDeviceAddress() + instancesBufferSizes.buildRangeOffset;
+            const uint32_t buildRangeStride = sizeof(VkAccelerationStructureBuildRangeInfoKHR);
+            const uint32_t* maxPrimitiveCounts = data.geometryBuildData->primitiveCounts.data();
+            vkCmdBuildAccelerationStructuresIndirectKHR(cmdBuffer, 1, &data.buildGeoInfo, &buildRangeAddress, &buildRangeStride, &maxPrimitiveCounts);
+        }
+        else
+        {
+            AS::buildStructure(cmdBuffer, data, compactionQuery, scratchAddress);
+        }
     }
 
     void TLAS::assignResourceOwner(Queue &queue)
     {
-        scratchBuffer.addOwner(queue);
         renderer.instancesDataBuffer.addOwner(queue);
+        renderer.modelDataTableBuffer.addOwner(queue);
         instancesBuffer.addOwner(queue);
 
         AS::assignResourceOwner(queue);
@@ -669,8 +786,7 @@ namespace PaperRenderer
         verifyInstancesBuffer(rtRender.tlasData[this].instanceDatas.size());
 
         //staging buffer transfer group
-        std::vector<StagingBufferTransfer> stagingBufferTransfers = {};
-        stagingBufferTransfers.reserve(3); //3 transfers occur as of writing this
+        std::pmr::vector<StagingBufferTransfer> stagingBufferTransfers(renderer.getFrameMemory().getResource());
 
         //queue instance data
         for(const AccelerationStructureInstanceData& instance : rtRender.tlasData[this].toUpdateInstances)
@@ -685,37 +801,27 @@ namespace PaperRenderer
                 if(blasPtr)
                 {
                     //queue transfer of instance data
+                    const AccelerationStructureInstance instanceShaderData = {
+                        .blasReference = blasPtr->getASBufferAddress(),
+                        .modelInstanceIndex = instance.instancePtr->rendererSelfIndex,
+                        .customIndex = instance.customIndex,
+                        .mask = instance.mask,
+                        .recordOffset = rtRender.getPipeline().getShaderBindingTableData().materialShaderGroupOffsets.at(instance.instancePtr->rtRenderSelfReferences[&rtRender][this].material),
+                        .flags = instance.flags
+                    };
                     stagingBufferTransfers.push_back({
                         .dstOffset = instancesBufferSizes.instancesOffset + (sizeof(AccelerationStructureInstance) * instance.instancePtr->rtRenderSelfReferences[&rtRender][this].selfIndex),
-                        .data = [&] {
-                            const AccelerationStructureInstance instanceShaderData = {
-                                .blasReference = blasPtr->getASBufferAddress(),
-                                .modelInstanceIndex = instance.instancePtr->rendererSelfIndex,
-                                .customIndex = instance.customIndex,
-                                .mask = instance.mask,
-                                .recordOffset = rtRender.getPipeline().getShaderBindingTableData().materialShaderGroupOffsets.at(instance.instancePtr->rtRenderSelfReferences[&rtRender][this].material),
-                                .flags = instance.flags
-                            };
-                            std::vector<uint8_t> transferData(sizeof(AccelerationStructureInstance));
-                            memcpy(transferData.data(), &instanceShaderData, sizeof(AccelerationStructureInstance));
-
-                            return transferData;
-                        } (),
+                        .dataView = renderer.getFrameMemory().copy(&instanceShaderData, sizeof(AccelerationStructureInstance)),
                         .dstBuffer = &instancesBuffer
                     });
 
                     //queue transfer of description data
+                    const InstanceDescription descriptionShaderData = {
+                        .modelDataHandle = instance.instancePtr->getGeometryData().getShaderDataReference().handle
+                    };
                     stagingBufferTransfers.push_back({
                         .dstOffset = instancesBufferSizes.instanceDescriptionsOffset + (sizeof(InstanceDescription) * instance.instancePtr->rtRenderSelfReferences[&rtRender][this].selfIndex),
-                        .data = [&] {
-                            const InstanceDescription descriptionShaderData = {
-                                .modelDataOffset = (uint32_t)instance.instancePtr->getGeometryData().getShaderDataReference().shaderDataLocation
-                            };
-                            std::vector<uint8_t> transferData(sizeof(InstanceDescription));
-                            memcpy(transferData.data(), &descriptionShaderData, sizeof(InstanceDescription));
-
-                            return transferData;
-                        } (),
+                        .dataView = renderer.getFrameMemory().copy(&descriptionShaderData, sizeof(InstanceDescription)),
                         .dstBuffer = &instancesBuffer
                     });
                 }
@@ -735,42 +841,33 @@ namespace PaperRenderer
 
         //----------TLAS BUILD----------//
 
-        //set build data
-        AsBuildData buildData = getAsData(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, flags, mode);
-
-        //get scratch buffer size
-        const VkDeviceSize requiredScratchSize = mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR ? buildData.buildSizeInfo.buildScratchSize : buildData.buildSizeInfo.updateScratchSize;
-        
-        //rebuild scratch buffer if needed
-        if(scratchBuffer.getSize() < requiredScratchSize)
-        {
-            const BufferInfo bufferInfo = {
-                .size = requiredScratchSize,
-                .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-                .allocationFlags = 0
-            };
-            scratchBuffer = Buffer(renderer, bufferInfo);
-        }
+        //set build data; culling changes the instance count between builds, which an update can't handle
+        AsBuildData buildData = getAsData(VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR, flags, cullInfo.enabled() ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR : mode);
 
         //build TLAS; note that compaction is ignored for TLAS
         if(rtRender.tlasData[this].instanceDatas.size())
         {
+            //reserve scratch memory from the builder's shared pool
+            const VkDeviceSize requiredScratchSize = buildData.buildGeoInfo.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR ? buildData.buildSizeInfo.buildScratchSize : buildData.buildSizeInfo.updateScratchSize;
+            const VkDeviceAddress scratchAddress = renderer.getAsBuilder().reserveScratch(requiredScratchSize, syncInfo);
+
             //queue update of preprocess UBO data
+            const TLASInstanceBuildPipeline::UBOInputData uboInputData = {
+                .modelDataPtr = renderer.modelDataBuffer.getBuffer().getBufferDeviceAddress(),
+                .objectCount = (uint32_t)rtRender.tlasData[this].instanceDatas.size(),
+                .includeMask = cullInfo.includeMask,
+                .cullOrigin = cullInfo.origin,
+                .cullRadius = cullInfo.radius,
+                .modelDataTablePtr = renderer.modelDataTableBuffer.getBufferDeviceAddress()
+            };
             stagingBufferTransfers.push_back({
                 .dstOffset = 0,
-                .data = [&] {
-                    const TLASInstanceBuildPipeline::UBOInputData uboInputData = {
-                        .objectCount = (uint32_t)rtRender.tlasData[this].instanceDatas.size()
-                    };
-                    std::vector<uint8_t> transferData(sizeof(TLASInstanceBuildPipeline::UBOInputData));
-                    memcpy(transferData.data(), &uboInputData, sizeof(TLASInstanceBuildPipeline::UBOInputData));
-
-                    return transferData;
-                } (),
+                .dataView = renderer.getFrameMemory().copy(&uboInputData, sizeof(TLASInstanceBuildPipeline::UBOInputData)),
                 .dstBuffer = &preprocessUniformBuffer
             });
             
-            buildStructure(cmdBuffer, buildData, {}, scratchBuffer.getBufferDeviceAddress());
+            GPUTimer gpuTimer(renderer, cmdBuffer, COMPUTE, "TLAS Build", REGULAR);
+            buildStructure(cmdBuffer, buildData, {}, scratchAddress);
         }
 
         //end command buffer and submit
@@ -802,26 +899,44 @@ namespace PaperRenderer
 
     AccelerationStructureBuilder::AccelerationStructureBuilder(RenderEngine& renderer)
         :scratchBuffer(renderer, {
-            .size = scratchBufferSize,
+            .size = 0,
             .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
             .allocationFlags = 0
         }),
+        builderSemaphore(renderer.getDevice().getCommands().getTimelineSemaphore(builderSemaphoreValue)),
         renderer(renderer)
     {
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "AccelerationStructureBuilder constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "AccelerationStructureBuilder constructor finished");
     }
 
     AccelerationStructureBuilder::~AccelerationStructureBuilder()
     {
+        //wait for outstanding builds and compactions before releasing anything they reference
+        renderer.getDevice().getCommands().flushSubmissions();
+        const VkSemaphoreWaitInfo waitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .semaphoreCount = 1,
+            .pSemaphores = &builderSemaphore,
+            .pValues = &builderSemaphoreValue
+        };
+        vkWaitSemaphores(renderer.getDevice().getDevice(), &waitInfo, UINT64_MAX);
+
+        //release deferred resources
+        releaseRetiredStructures(builderSemaphoreValue);
+        for(const PendingCompaction& pendingCompaction : pendingCompactions)
+        {
+            vkDestroyQueryPool(renderer.getDevice().getDevice(), pendingCompaction.queryPool, nullptr);
+        }
+        pendingCompactions.clear();
+
+        //recycle semaphore
+        renderer.getDevice().getCommands().recycleTimelineSemaphore(builderSemaphore, builderSemaphoreValue);
+
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "AccelerationStructureBuilder destructor initialized"
-        });
+        renderer.getLogger().recordLog(INFO, "AccelerationStructureBuilder destructor initialized");
     }
 
     std::unordered_map<BLAS*, VkDeviceSize> AccelerationStructureBuilder::getCompactions()
@@ -833,7 +948,7 @@ namespace PaperRenderer
         VkDeviceSize compactionIndex = 0;
         for(const BLASBuildOp& op : blasQueue)
         {
-            if(op.flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR)
+            if(op.flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR && op.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
             {
                 returnData[op.accelerationStructure] = compactionIndex;
                 compactionIndex++;
@@ -846,20 +961,270 @@ namespace PaperRenderer
     void AccelerationStructureBuilder::queueBLAS(const BLASBuildOp &op)
     {
         std::lock_guard guard(builderMutex);
-        blasQueue.insert(op);
+
+        //merge with an op already queued for the same structure; a rebuild takes precedence over an update
+        auto it = blasQueue.find(op);
+        if(it != blasQueue.end())
+        {
+            BLASBuildOp mergedOp = op;
+            if(it->mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR) mergedOp.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+            mergedOp.deformation += it->deformation;
+
+            blasQueue.erase(it);
+            blasQueue.insert(mergedOp);
+        }
+        else
+        {
+            blasQueue.insert(op);
+        }
+    }
+
+    void AccelerationStructureBuilder::resolveBuildModes()
+    {
+        std::set<BLASBuildOp> resolvedQueue;
+        for(BLASBuildOp op : blasQueue)
+        {
+            BLAS& blas = *op.accelerationStructure;
+
+            //refit if possible, otherwise rebuild. refits can only be done on structures built with the same flags, which must allow updates
+            if(op.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR)
+            {
+                const bool canRefit = blas.getAccelerationStructure() && blas.builtFlags == op.flags && (op.flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR);
+                const bool degraded = blas.refitCount >= maxRefits || blas.accumulatedDeformation + op.deformation > maxRefitDeformation;
+                if(!canRefit || degraded) op.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+            }
+
+            //track deformation since the last rebuild
+            if(op.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
+            {
+                blas.builtFlags = op.flags;
+                blas.refitCount = 0;
+                blas.accumulatedDeformation = 0.0f;
+            }
+            else
+            {
+                blas.refitCount++;
+                blas.accumulatedDeformation += op.deformation;
+            }
+
+            resolvedQueue.insert(op);
+        }
+
+        blasQueue = std::move(resolvedQueue);
+    }
+
+    void AccelerationStructureBuilder::removeBLAS(BLAS* blas)
+    {
+        std::lock_guard guard(builderMutex);
+
+        //remove from build queue
+        blasQueue.erase({ .accelerationStructure = blas });
+
+        //remove from any pending compactions
+        for(PendingCompaction& pendingCompaction : pendingCompactions)
+        {
+            pendingCompaction.compactions.erase(blas);
+        }
+    }
+
+    void AccelerationStructureBuilder::releaseRetiredStructures(const uint64_t completedValue)
+    {
+        //hand off in order once the builder is done with them; an entry that isn't ready holds back the ones behind it
+        while(deferredReleases.size() && deferredReleases.front().releaseValue <= completedValue)
+        {
+            AS::RetiredStructure& retiredStructure = deferredReleases.front().retiredStructure;
+
+            //TLASes built before a compaction keep the old structure's address until they're updated, and can be traced on any queue, so
+            //the structure and its buffer are destroyed behind everything submitted so far on every queue rather than the builder's timeline
+            for(const auto& [queueType, queuesInFamily] : renderer.getDevice().getQueues())
+            {
+                for(Queue* queue : queuesInFamily.queues)
+                {
+                    retiredStructure.buffer.addOwner(*queue);
+                }
+            }
+
+            if(retiredStructure.structure)
+            {
+                renderer.getDevice().getCommands().deferDestruction(retiredStructure.buffer.getOwnerSubmissions(), [device = renderer.getDevice().getDevice(), structure = retiredStructure.structure] {
+                    vkDestroyAccelerationStructureKHR(device, structure, nullptr);
+                });
+            }
+            deferredReleases.pop_front(); //buffer destruction is deferred on the same owners
+        }
+    }
+
+    void AccelerationStructureBuilder::recordCompactions(VkCommandBuffer cmdBuffer, const uint64_t completedValue, std::vector<BLAS*>& compactedStructures)
+    {
+        while(pendingCompactions.size() && pendingCompactions.front().semaphoreValue <= completedValue)
+        {
+            PendingCompaction& pendingCompaction = pendingCompactions.front();
+
+            //read back query results and perform compactions; the submission that wrote them has completed so this never waits
+            for(auto& [blas, index] : pendingCompaction.compactions)
+            {
+                VkDeviceSize compactedSize = 0;
+                const VkResult queryResult = vkGetQueryPoolResults(
+                    renderer.getDevice().getDevice(),
+                    pendingCompaction.queryPool,
+                    (uint32_t)index,
+                    1,
+                    sizeof(VkDeviceSize),
+                    &compactedSize,
+                    sizeof(VkDeviceSize),
+                    VK_QUERY_RESULT_64_BIT
+                );
+
+                //skip structures whose query was never written (i.e. the build was rejected)
+                if(queryResult != VK_SUCCESS || !compactedSize) continue;
+
+                deferredReleases.push_back({
+                    .retiredStructure = blas->compactStructure(cmdBuffer, VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, compactedSize),
+                    .releaseValue = builderSemaphoreValue + 1 //released once this submission completes
+                });
+                compactedStructures.push_back(blas);
+            }
+
+            //destroy query pool
+            vkDestroyQueryPool(renderer.getDevice().getDevice(), pendingCompaction.queryPool, nullptr);
+            pendingCompactions.pop_front();
+        }
+    }
+
+    void AccelerationStructureBuilder::queueInstanceUpdates(const BLAS& blas)
+    {
+        //compaction or a rebuild can move the structure to a new address, so TLAS instances referencing it need their data re-sent
+        std::lock_guard sharedGuard(renderer.sharedGeometryMutex);
+
+        //a BLAS may be shared by all geometry with identical content
+        for(ModelGeometryData* geometryData : blas.getModelGeometryData().resources->users)
+        {
+            for(ModelInstance* instance : geometryData->getParentModel().childInstances)
+            {
+                if(&instance->getGeometryData() != geometryData) continue;
+
+                for(auto& [rtRender, tlasReferences] : instance->rtRenderSelfReferences)
+                {
+                    std::lock_guard guard(rtRender->rtRenderMutex);
+                    for(auto& [tlas, data] : tlasReferences)
+                    {
+                        rtRender->tlasData[tlas].toUpdateInstances.insert(rtRender->tlasData[tlas].instanceDatas[data.selfIndex]);
+                    }
+                }
+            }
+        }
+    }
+
+    VkDeviceSize AccelerationStructureBuilder::getScratchSize() const
+    {
+        //buffer is over-allocated by one alignment so its base can be aligned
+        const VkDeviceSize alignment = renderer.getDevice().getGPUFeaturesAndProperties().asProperties.minAccelerationStructureScratchOffsetAlignment;
+        return scratchBuffer.getSize() > alignment ? scratchBuffer.getSize() - alignment : 0;
+    }
+
+    VkDeviceAddress AccelerationStructureBuilder::getScratchAddress() const
+    {
+        const VkDeviceSize alignment = renderer.getDevice().getGPUFeaturesAndProperties().asProperties.minAccelerationStructureScratchOffsetAlignment;
+        return Device::getAlignment(scratchBuffer.getBufferDeviceAddress(), alignment);
+    }
+
+    void AccelerationStructureBuilder::verifyScratchBuffer(const VkDeviceSize requiredSize)
+    {
+        const VkDeviceSize alignment = renderer.getDevice().getGPUFeaturesAndProperties().asProperties.minAccelerationStructureScratchOffsetAlignment;
+
+        //track the peak of consecutive low usage submissions for shrinking
+        if(requiredSize * 4 < getScratchSize())
+        {
+            scratchLowUsageCount++;
+            scratchPeakSize = std::max(scratchPeakSize, requiredSize);
+        }
+        else
+        {
+            scratchLowUsageCount = 0;
+            scratchPeakSize = 0;
+        }
+
+        //grow if too small, or shrink to the recent peak if usage has stayed low
+        bool resize = false;
+        VkDeviceSize newSize = 0;
+        if(requiredSize > getScratchSize())
+        {
+            newSize = Device::getAlignment((VkDeviceSize)(requiredSize * scratchOverhead), alignment);
+            resize = true;
+        }
+        else if(scratchLowUsageCount >= scratchShrinkSubmissions)
+        {
+            newSize = Device::getAlignment((VkDeviceSize)(scratchPeakSize * scratchOverhead), alignment);
+            resize = newSize < getScratchSize();
+        }
+        
+        if(resize)
+        {
+            Timer timer(renderer, "Resize AS Scratch Buffer", IRREGULAR);
+
+            //old buffer may still be in use by submitted builds; release it once they complete
+            deferredReleases.push_back({
+                .retiredStructure = {
+                    .structure = VK_NULL_HANDLE,
+                    .buffer = std::move(scratchBuffer)
+                },
+                .releaseValue = builderSemaphoreValue
+            });
+
+            const BufferInfo bufferInfo = {
+                .size = newSize ? newSize + alignment : 0, //free entirely if nothing has been built in a while
+                .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
+                .allocationFlags = 0,
+                .category = MEMORY_AS_SCRATCH
+            };
+            scratchBuffer = Buffer(renderer, bufferInfo);
+
+            //reset usage tracking
+            scratchPeakSize = 0;
+            scratchLowUsageCount = 0;
+        }
+    }
+
+    VkDeviceAddress AccelerationStructureBuilder::reserveScratch(const VkDeviceSize requiredSize, SynchronizationInfo& syncInfo)
+    {
+        //lock builder mutex
+        std::lock_guard guard(builderMutex);
+
+        verifyScratchBuffer(requiredSize);
+
+        //scratch is shared, so wait on the last builder submission and signal the next value
+        syncInfo.timelineWaitPairs.push_back({ builderSemaphore, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, builderSemaphoreValue });
+        syncInfo.timelineSignalPairs.push_back({ builderSemaphore, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, builderSemaphoreValue + 1 });
+        builderSemaphoreValue++;
+
+        return getScratchAddress();
     }
 
     Queue& AccelerationStructureBuilder::submitQueuedOps(const SynchronizationInfo& syncInfo)
     {
         Timer timer(renderer, "Submit Queued BLAS Ops", REGULAR);
 
-        //----------AS BUILDS----------//
-
         //lock builder mutex
         std::lock_guard guard(builderMutex);
 
-        //return queue
-        Queue* returnQueue = NULL;
+        //get completed submissions and release anything they were keeping alive
+        uint64_t completedValue = 0;
+        vkGetSemaphoreCounterValue(renderer.getDevice().getDevice(), builderSemaphore, &completedValue);
+        releaseRetiredStructures(completedValue);
+
+        //decide between refitting and rebuilding
+        resolveBuildModes();
+
+        //queued rebuilds invalidate any compaction queries still pending for the same structure
+        for(const BLASBuildOp& op : blasQueue)
+        {
+            if(op.mode != VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR) continue;
+
+            for(PendingCompaction& pendingCompaction : pendingCompactions)
+            {
+                pendingCompaction.compactions.erase(op.accelerationStructure);
+            }
+        }
         
         //get BLAS' that are to be compacted
         std::unordered_map<BLAS*, VkDeviceSize> compactions = getCompactions();
@@ -890,27 +1255,78 @@ namespace PaperRenderer
         };
         vkBeginCommandBuffer(cmdBuffer, &cmdBufferInfo);
 
-        //builds and updates (batch them to avoid stupidly large scratch buffer) TODO batch queue submits because microsoft's weird queue submit time limit
-        VkDeviceSize scratchOffset = 0;
+        //----------AS COMPACTION----------//
+
+        //compact structures built by earlier submissions whose sizes are now available
+        std::vector<BLAS*> compactedStructures;
+        GPUTimer compactionGPUTimer(renderer, cmdBuffer, COMPUTE, "BLAS Compactions", IRREGULAR);
+        recordCompactions(cmdBuffer, completedValue, compactedStructures);
+        compactionGPUTimer.release();
+
+        //refits below may update a structure that was just compacted, so they need to wait on the copies
+        if(compactedStructures.size())
+        {
+            const VkMemoryBarrier2 compactionMemBarrier = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                .pNext = NULL,
+                .srcStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                .dstStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR
+            };
+
+            const VkDependencyInfo compactionDependencyInfo = {
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = NULL,
+                .dependencyFlags = 0,
+                .memoryBarrierCount = 1,
+                .pMemoryBarriers = &compactionMemBarrier
+            };
+
+            vkCmdPipelineBarrier2(cmdBuffer, &compactionDependencyInfo);
+        }
+
+        //----------AS BUILDS----------//
+
+        //get build data and scratch requirements
+        const VkDeviceSize scratchAlignment = renderer.getDevice().getGPUFeaturesAndProperties().asProperties.minAccelerationStructureScratchOffsetAlignment;
+        std::vector<std::pair<BLAS*, AS::AsBuildData>> buildDatas;
+        buildDatas.reserve(blasQueue.size());
+
+        VkDeviceSize largestScratchSize = 0;
+        VkDeviceSize totalScratchSize = 0;
+        std::vector<BLAS*> movedStructures;
         for(const BLASBuildOp& op : blasQueue)
         {
-            //get build data
+            const VkDeviceAddress oldAddress = op.accelerationStructure->getASBufferAddress();
             AS::AsBuildData buildData = op.accelerationStructure->getAsData(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, op.flags, op.mode);
-            const VkDeviceSize opRequiredScratchSize = op.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR ? buildData.buildSizeInfo.buildScratchSize : buildData.buildSizeInfo.updateScratchSize;
+            const VkDeviceSize opRequiredScratchSize = Device::getAlignment(buildData.buildGeoInfo.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR ? buildData.buildSizeInfo.buildScratchSize : buildData.buildSizeInfo.updateScratchSize, scratchAlignment);
 
-            //verify scratch offset + required scratch size isn't too large; insert mem barrier and reset offset if it is too large
-            if(scratchOffset + opRequiredScratchSize > scratchBuffer.getSize())
-            {
-                if(opRequiredScratchSize > scratchBuffer.getSize())
-                {
-                    //error handling for too big of a model
-                    renderer.getLogger().recordLog({
-                        .type = CRITICAL_ERROR,
-                        .text = "Tried to build a BLAS with a required scratch size of " + std::to_string(opRequiredScratchSize) + " which is larger than " + std::to_string(scratchBuffer.getSize())
-                    });
-                    continue;
-                }
+            largestScratchSize = std::max(largestScratchSize, opRequiredScratchSize);
+            totalScratchSize += opRequiredScratchSize;
+            buildDatas.push_back({ op.accelerationStructure, std::move(buildData) });
+
+            //structures given a new buffer (first builds included) need their TLAS instances updated
+            if(op.accelerationStructure->getASBufferAddress() != oldAddress) movedStructures.push_back(op.accelerationStructure);
+        }
+
+        //size scratch to fit the whole queue up to the batch limit, but always at least the largest single build
+        verifyScratchBuffer(std::max(largestScratchSize, std::min(totalScratchSize, scratchBatchSize)));
 
+        //builds and updates; split into batches separated by barriers when scratch memory runs out TODO batch queue submits because microsoft's weird queue submit time limit
+        GPUTimer buildGPUTimer(renderer, cmdBuffer, COMPUTE, "BLAS Builds", IRREGULAR);
+        VkDeviceSize scratchOffset = 0;
+        uint32_t rebuiltStructures = 0;
+        uint32_t refitStructures = 0;
+        uint32_t rebuiltPrimitives = 0;
+        uint32_t refitPrimitives = 0;
+        for(auto& [blas, buildData] : buildDatas)
+        {
+            const VkDeviceSize opRequiredScratchSize = Device::getAlignment(buildData.buildGeoInfo.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR ? buildData.buildSizeInfo.buildScratchSize : buildData.buildSizeInfo.updateScratchSize, scratchAlignment);
+
+            //insert mem barrier and reset offset if the current batch is out of scratch memory
+            if(scratchOffset + opRequiredScratchSize > getScratchSize())
+            {
                 //insert memory barrier
                 const VkBufferMemoryBarrier2 memBarrier = {
                     .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
@@ -918,7 +1334,7 @@ namespace PaperRenderer
                     .srcStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
                     .srcAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
                     .dstStageMask = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-                    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                    .dstAccessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                     .buffer = scratchBuffer.getBuffer(),
@@ -943,100 +1359,97 @@ namespace PaperRenderer
             //compaction query if applies
             AS::CompactionQuery compactionQuery = {
                 .pool = queryPool,
-                .compactionIndex = compactions.count(op.accelerationStructure) ? compactions[op.accelerationStructure] : 0
+                .compactionIndex = compactions.count(blas) ? compactions.at(blas) : 0
             };
 
             //build
-            op.accelerationStructure->buildStructure(cmdBuffer, buildData, compactionQuery, scratchBuffer.getBufferDeviceAddress() + scratchOffset);
+            blas->buildStructure(cmdBuffer, buildData, compactionQuery, getScratchAddress() + scratchOffset);
+
+            //statistics; primitive count is used as the cost since both build types scale with it
+            uint32_t primitiveCount = 0;
+            for(const uint32_t count : buildData.geometryBuildData->primitiveCounts)
+            {
+                primitiveCount += count;
+            }
+
+            if(buildData.buildGeoInfo.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
+            {
+                rebuiltStructures++;
+                rebuiltPrimitives += primitiveCount;
+            }
+            else
+            {
+                refitStructures++;
+                refitPrimitives += primitiveCount;
+            }
 
             //set scratch offset
-            scratchOffset += buildData.buildSizeInfo.buildScratchSize;
-            scratchOffset = renderer.getDevice().getAlignment(scratchOffset, renderer.getDevice().getGPUFeaturesAndProperties().asProperties.minAccelerationStructureScratchOffsetAlignment);
+            scratchOffset += opRequiredScratchSize;
         }
 
+        buildGPUTimer.release();
+
         //end command buffer and submit
         vkEndCommandBuffer(cmdBuffer);
 
-        SynchronizationInfo buildSyncInfo = {
-            .binaryWaitPairs = syncInfo.binaryWaitPairs,
-            .timelineWaitPairs = syncInfo.timelineWaitPairs,
-            .fence = VK_NULL_HANDLE
-        };
+        //wait on the last builder submission since scratch memory is shared (this also makes compaction copies see finished builds), and signal the next one
+        SynchronizationInfo buildSyncInfo = syncInfo;
+        buildSyncInfo.timelineWaitPairs.push_back({ builderSemaphore, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR, builderSemaphoreValue });
 
-        if(!queryPool)
+        //geometry detached from a shared VBO is filled by a GPU copy that builds reading it must wait on; only the latest value per queue is needed
+        std::unordered_map<VkSemaphore, uint64_t> vboSubmissions;
+        for(const auto& [blas, buildData] : buildDatas)
         {
-            buildSyncInfo.binarySignalPairs = syncInfo.binarySignalPairs;
-            buildSyncInfo.timelineSignalPairs = syncInfo.timelineSignalPairs;
-            buildSyncInfo.fence = syncInfo.fence;
+            for(const TimelineSemaphorePair& submission : blas->getModelGeometryData().getVBOOwnerSubmissions())
+            {
+                vboSubmissions[submission.semaphore] = std::max(vboSubmissions[submission.semaphore], submission.value);
+            }
         }
-
-        returnQueue = &renderer.getDevice().getCommands().submitToQueue(COMPUTE, buildSyncInfo, { cmdBuffer });
-
-        //----------AS COMPACTION----------//
-        
-        if(queryPool)
+        for(const auto& [semaphore, value] : vboSubmissions)
         {
-            //get query results and perform compaction
-            std::vector<VkDeviceSize> compactionResults(compactions.size());
-            vkGetQueryPoolResults(
-                renderer.getDevice().getDevice(),
-                queryPool,
-                0,
-                compactions.size(),
-                compactions.size() * sizeof(VkDeviceSize),
-                compactionResults.data(),
-                sizeof(VkDeviceSize),
-                VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT
-            );
+            buildSyncInfo.timelineWaitPairs.push_back({ semaphore, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, value });
+        }
+        buildSyncInfo.timelineSignalPairs.push_back({ builderSemaphore, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR, builderSemaphoreValue + 1 });
+        builderSemaphoreValue++;
 
-            //start new command buffer
-            CommandBuffer cmdBuffer(renderer.getDevice().getCommands(), COMPUTE);
+        Queue& returnQueue = renderer.getDevice().getCommands().submitToQueue(COMPUTE, buildSyncInfo, { cmdBuffer });
 
-            VkCommandBufferBeginInfo cmdBufferInfo = {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                .pNext = NULL,
-                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-                .pInheritanceInfo = NULL
-            };
-            vkBeginCommandBuffer(cmdBuffer, &cmdBufferInfo);
+        //rebuild and refit statistics
+        renderer.getStatisticsTracker().modifyObjectCounter("BLAS Rebuilds", rebuiltStructures);
+        renderer.getStatisticsTracker().modifyObjectCounter("BLAS Rebuild Primitives", rebuiltPrimitives);
+        renderer.getStatisticsTracker().modifyObjectCounter("BLAS Refits", refitStructures);
+        renderer.getStatisticsTracker().modifyObjectCounter("BLAS Refit Primitives", refitPrimitives);
 
-            //perform compactions
-            std::vector<Buffer> oldBuffers;
-            oldBuffers.reserve(compactions.size());
-            for(auto& [blas, index] : compactions)
-            {
-                oldBuffers.push_back(blas->compactStructure(cmdBuffer, VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, compactionResults[index]));
-            }
-
-            //end cmd buffer
-            vkEndCommandBuffer(cmdBuffer);
-
-            //submit
-            const SynchronizationInfo compactionSyncInfo = {
-                .binarySignalPairs = syncInfo.binarySignalPairs,
-                .timelineSignalPairs = syncInfo.timelineSignalPairs,
-                .fence = syncInfo.fence
-            };
-            returnQueue = &renderer.getDevice().getCommands().submitToQueue(COMPUTE, compactionSyncInfo, { cmdBuffer });
+        //queue compaction of this submission's structures for a later submission
+        if(queryPool)
+        {
+            pendingCompactions.push_back({
+                .queryPool = queryPool,
+                .compactions = compactions,
+                .semaphoreValue = builderSemaphoreValue
+            });
+        }
 
-            //destroy query pool
-            vkDestroyQueryPool(renderer.getDevice().getDevice(), queryPool, nullptr);
+        //compacted structures have moved, so any TLAS instances referencing them need updating
+        for(BLAS* blas : compactedStructures)
+        {
+            blas->assignResourceOwner(returnQueue);
+            queueInstanceUpdates(*blas);
+        }
 
-            //assign owners to old resources before they go out of scope (this essentially blocks this thread until compaction is completed)
-            for(Buffer& buffer : oldBuffers)
-            {
-                buffer.addOwner(*returnQueue);
-            }
+        for(BLAS* blas : movedStructures)
+        {
+            queueInstanceUpdates(*blas);
         }
 
         //assign owners and clear queue
         for(const BLASBuildOp& op : blasQueue)
         {
-            op.accelerationStructure->assignResourceOwner(*returnQueue);
+            op.accelerationStructure->assignResourceOwner(returnQueue);
         }
         blasQueue.clear();
 
         //return
-        return *returnQueue;
+        return returnQueue;
     }
 }
\ No newline at end of file
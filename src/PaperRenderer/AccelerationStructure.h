@@ -21,8 +21,13 @@ namespace PaperRenderer
 
         struct UBOInputData
         {
-            uint32_t objectCount;
-            float padding[15];
+            VkDeviceAddress modelDataPtr = 0;
+            uint32_t objectCount = 0;
+            uint32_t includeMask = 0xFF;
+            glm::vec3 cullOrigin = glm::vec3(0.0f);
+            float cullRadius = 0.0f;
+            VkDeviceAddress modelDataTablePtr = 0;
+            float padding[6];
         };
 
         void submit(VkCommandBuffer cmdBuffer, const TLAS& tlas, const uint32_t count) const;
@@ -60,7 +65,7 @@ namespace PaperRenderer
             VkAccelerationStructureBuildSizesInfoKHR buildSizeInfo = {};
             bool compact = false;
         };
-        AS::AsBuildData getAsData(const VkAccelerationStructureTypeKHR type, const VkBuildAccelerationStructureFlagsKHR flags, const VkBuildAccelerationStructureModeKHR mode);
+        AS::AsBuildData getAsData(const VkAccelerationStructureTypeKHR type, const VkBuildAccelerationStructureFlagsKHR flags, const VkBuildAccelerationStructureModeKHR requestedMode); //falls back to a build if there's nothing to update
 
         //build
         struct CompactionQuery
@@ -70,8 +75,13 @@ namespace PaperRenderer
         };
         virtual void buildStructure(VkCommandBuffer cmdBuffer, AsBuildData& data, const CompactionQuery compactionQuery, const VkDeviceAddress scratchAddress);
 
-        //compaction operation; returns old buffer which must stay in scope until completion
-        Buffer compactStructure(VkCommandBuffer cmdBuffer, const VkAccelerationStructureTypeKHR type, const VkDeviceSize newSize);
+        //compaction operation; returns the old structure and buffer, which must stay alive until the copy completes
+        struct RetiredStructure
+        {
+            VkAccelerationStructureKHR structure = VK_NULL_HANDLE;
+            Buffer buffer;
+        };
+        RetiredStructure compactStructure(VkCommandBuffer cmdBuffer, const VkAccelerationStructureTypeKHR type, const VkDeviceSize newSize);
 
         //resource ownership
         virtual void assignResourceOwner(Queue& queue);
@@ -98,6 +108,11 @@ namespace PaperRenderer
 
         class ModelGeometryData const* modelData;
 
+        //refit tracking; refits degrade BVH quality as geometry deforms, so rebuilds are scheduled by the builder
+        VkBuildAccelerationStructureFlagsKHR builtFlags = 0;
+        uint32_t refitCount = 0;
+        float accumulatedDeformation = 0.0f;
+
         friend class AccelerationStructureBuilder;
 
     public:
@@ -109,13 +124,22 @@ namespace PaperRenderer
         const ModelGeometryData& getModelGeometryData() const { return *modelData; }
     };
 
+    //TLAS instance culling, done on the GPU before the build so only relevant instances are included
+    struct TLASInstanceCullInfo
+    {
+        glm::vec3 origin = glm::vec3(0.0f); //usually the camera position
+        float radius = 0.0f; //instances with bounds entirely beyond this distance from origin are culled; 0 disables distance culling
+        uint8_t includeMask = 0xFF; //instances whose mask shares no bits with this are culled
+
+        bool enabled() const { return radius > 0.0f || includeMask != 0xFF; }
+    };
+
     //top level acceleration structure
     class TLAS : public AS
     {
     private:
         //buffers
         Buffer preprocessUniformBuffer;
-        Buffer scratchBuffer; //TLAS gets its own scratch buffer
         Buffer instancesBuffer;
 
         //sync
@@ -130,7 +154,7 @@ namespace PaperRenderer
             IO = 2,
         };
         ResourceDescriptor uboDescriptor;
-        ResourceDescriptor ioDescriptor;
+        ResourceDescriptor ioDescriptor; //transient; reallocated each build in buildStructure()
         ResourceDescriptor instanceDescriptionsDescriptor;
 
         //instances data offsets/sizes
@@ -142,18 +166,24 @@ namespace PaperRenderer
             VkDeviceSize instanceDescriptionsRange = 0;
             VkDeviceSize tlInstancesOffset = 0;
             VkDeviceSize tlInstancesRange = 0;
+            VkDeviceSize tlInstanceDescriptionsOffset = 0;
+            VkDeviceSize tlInstanceDescriptionsRange = 0;
+            VkDeviceSize buildRangeOffset = 0;
+            VkDeviceSize buildRangeRange = 0;
 
             VkDeviceSize totalSize()
             {
-                return instancesRange + instanceDescriptionsRange + tlInstancesRange;
+                return instancesRange + instanceDescriptionsRange + tlInstancesRange + tlInstanceDescriptionsRange + buildRangeRange;
             }
         } instancesBufferSizes = {};
 
         static constexpr float instancesOverhead = 1.5;
+        TLASInstanceCullInfo cullInfo = {};
 
+        //hit shaders resolve the model data's current offset through the model data table, so descriptions stay valid across compactions and moves
         struct InstanceDescription
         {
-            uint32_t modelDataOffset;
+            uint32_t modelDataHandle;
         };
 
         std::unique_ptr<AsGeometryBuildData> getGeometryData() const override;
@@ -175,6 +205,8 @@ namespace PaperRenderer
 
         //Updates the TLAS to the RayTraceRender instances according to the mode (either rebuild or update). Note that compaction is ignored for a TLAS
         Queue& updateTLAS(const VkBuildAccelerationStructureModeKHR mode, const VkBuildAccelerationStructureFlagsKHR flags, SynchronizationInfo syncInfo);
+        //Culling changes the instance count, so updates are turned into rebuilds while it's enabled
+        void setInstanceCulling(const TLASInstanceCullInfo& cullInfo) { this->cullInfo = cullInfo; }
 
         const Buffer& getInstancesBuffer() const { return instancesBuffer; }
         const InstancesBufferSizes& getInstancesBufferSizes() const { return instancesBufferSizes; }
@@ -187,6 +219,7 @@ namespace PaperRenderer
         BLAS* accelerationStructure;
         VkBuildAccelerationStructureModeKHR mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
         VkBuildAccelerationStructureFlagsKHR flags = 0;
+        float deformation = 0.0f; //estimated vertex movement since the last queued op, relative to the geometry's size; only used for updates
 
         bool operator<(const BLASBuildOp& other) const
         {
@@ -201,22 +234,67 @@ namespace PaperRenderer
         std::mutex builderMutex;
         std::set<BLASBuildOp> blasQueue;
 
-        //scratch buffer shared amongst BLAS builds
-        static constexpr VkDeviceSize scratchBufferSize = 268435456; // 2^26 bytes; ~256MiB
+        //scratch buffer shared amongst BLAS and TLAS builds; grows to fit demand and shrinks once demand stays low
+        static constexpr VkDeviceSize scratchBatchSize = 67108864; // 2^26 bytes; 64MiB soft limit before a batch of builds is split with barriers
+        static constexpr float scratchOverhead = 1.25f;
+        static constexpr uint32_t scratchShrinkSubmissions = 256; //consecutive low usage submissions before shrinking
         Buffer scratchBuffer;
+        VkDeviceSize scratchPeakSize = 0;
+        uint32_t scratchLowUsageCount = 0;
+
+        void verifyScratchBuffer(const VkDeviceSize requiredSize);
+        VkDeviceSize getScratchSize() const;
+        VkDeviceAddress getScratchAddress() const;
+        VkDeviceAddress reserveScratch(const VkDeviceSize requiredSize, SynchronizationInfo& syncInfo); //for builds submitted outside of submitQueuedOps(); appends the semaphore pairs that serialize scratch usage
+
+        //refit policy; updates are turned into rebuilds once either limit is reached
+        static constexpr uint32_t maxRefits = 64;
+        static constexpr float maxRefitDeformation = 1.0f;
+
+        void resolveBuildModes();
 
         //BLAS' that request compaction
         std::unordered_map<BLAS*, VkDeviceSize> getCompactions();
-        
+
+        //compactions are pipelined; sizes written by one submission are read back by a later one once builderSemaphore has passed its value
+        struct PendingCompaction
+        {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            std::unordered_map<BLAS*, VkDeviceSize> compactions = {};
+            uint64_t semaphoreValue = 0;
+        };
+        std::deque<PendingCompaction> pendingCompactions;
+
+        //old structures from compaction copies (and old scratch buffers); handed to deferred destruction once builderSemaphore reaches releaseValue
+        struct DeferredRelease
+        {
+            AS::RetiredStructure retiredStructure;
+            uint64_t releaseValue = 0;
+        };
+        std::deque<DeferredRelease> deferredReleases;
+
+        //signaled by every submitQueuedOps() submission
+        uint64_t builderSemaphoreValue = 0;
+        VkSemaphore builderSemaphore;
+
+        void releaseRetiredStructures(const uint64_t completedValue);
+        void recordCompactions(VkCommandBuffer cmdBuffer, const uint64_t completedValue, std::vector<BLAS*>& compactedStructures);
+        void queueInstanceUpdates(const BLAS& blas);
+        void removeBLAS(BLAS* blas); //called on BLAS destruction so no dangling references are kept
+
         class RenderEngine& renderer;
 
+        friend BLAS;
+        friend TLAS;
+
     public:
         AccelerationStructureBuilder(RenderEngine& renderer);
         ~AccelerationStructureBuilder();
         AccelerationStructureBuilder(const AccelerationStructureBuilder&) = delete;
         
-        void queueBLAS(const BLASBuildOp& op);
+        void queueBLAS(const BLASBuildOp& op); //ops queued for the same BLAS are merged. MODE_UPDATE ops are refits that may be promoted to rebuilds
 
-        Queue& submitQueuedOps(const SynchronizationInfo& syncInfo); //may block thread if compaction is used
+        //Submits queued builds and any compactions whose sizes became available since the last call. Never blocks on the GPU
+        Queue& submitQueuedOps(const SynchronizationInfo& syncInfo);
     };
 }
\ No newline at end of file
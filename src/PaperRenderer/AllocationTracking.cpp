@@ -0,0 +1,162 @@
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace PaperRenderer
+{
+    //----------ALLOCATION TRACKING----------//
+
+    thread_local StatisticName const* allocationScope = NULL; //innermost live Timer on the calling thread; set by Timer
+
+#ifdef PAPER_RENDERER_TRACK_ALLOCATIONS
+    namespace
+    {
+        //a thread's counts per scope; only the owning thread adds scopes, and counts are taken by whoever merges statistics
+        struct ScopeAllocations
+        {
+            std::atomic<uint64_t> id = 0; //0 while the slot is free; published after name
+            std::atomic<const char*> name = NULL;
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> bytes = 0;
+        };
+
+        struct ThreadAllocations
+        {
+            static constexpr uint32_t capacity = 256; //scopes a thread can record into; extra ones are counted as untracked
+            std::array<ScopeAllocations, capacity> scopes = {};
+        };
+
+        //tables are allocated with malloc so registering doesn't recurse into operator new, and are never freed since other threads read them
+        constexpr uint32_t maxAllocationThreads = 256;
+        std::array<std::atomic<ThreadAllocations*>, maxAllocationThreads> allocationThreads = {};
+        std::atomic<uint32_t> allocationThreadCount = 0;
+        std::atomic<uint64_t> untrackedCount = 0; //threads past maxAllocationThreads and scopes past a table's capacity
+        std::atomic<uint64_t> untrackedBytes = 0;
+        thread_local ThreadAllocations* threadAllocations = NULL;
+        thread_local bool threadUntracked = false;
+
+        constexpr StatisticName untimedScope = "Untimed";
+
+        void recordAllocation(const std::size_t size)
+        {
+            if(!threadAllocations && !threadUntracked)
+            {
+                const uint32_t threadIndex = allocationThreadCount.fetch_add(1, std::memory_order_relaxed);
+                if(threadIndex < maxAllocationThreads)
+                {
+                    void* memory = std::malloc(sizeof(ThreadAllocations));
+                    if(memory)
+                    {
+                        threadAllocations = ::new(memory) ThreadAllocations();
+                        allocationThreads[threadIndex].store(threadAllocations, std::memory_order_release);
+                    }
+                }
+                threadUntracked = !threadAllocations;
+            }
+
+            //open addressing on the scope's id
+            const StatisticName& scope = allocationScope ? *allocationScope : untimedScope;
+            if(threadAllocations)
+            {
+                for(uint32_t probe = 0; probe < ThreadAllocations::capacity; probe++)
+                {
+                    ScopeAllocations& slot = threadAllocations->scopes[(scope.id + probe) % ThreadAllocations::capacity];
+                    const uint64_t slotId = slot.id.load(std::memory_order_relaxed);
+                    if(!slotId)
+                    {
+                        slot.name.store(scope.name, std::memory_order_relaxed);
+                        slot.id.store(scope.id, std::memory_order_release);
+                    }
+                    else if(slotId != scope.id)
+                    {
+                        continue;
+                    }
+
+                    slot.count.fetch_add(1, std::memory_order_relaxed);
+                    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            untrackedCount.fetch_add(1, std::memory_order_relaxed);
+            untrackedBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+#endif
+
+    void StatisticsTracker::drainAllocations(bool discard)
+    {
+#ifdef PAPER_RENDERER_TRACK_ALLOCATIONS
+        //scopes are merged by name, since the same timer name recorded on several threads is one scope
+        const auto addAllocations = [&](const char* scope, const uint64_t count, const uint64_t bytes) {
+            if(discard || !count) return;
+
+            for(AllocationStatistic& allocationStatistic : statistics.allocations)
+            {
+                if(allocationStatistic.scope == scope || !strcmp(allocationStatistic.scope, scope))
+                {
+                    allocationStatistic.count += count;
+                    allocationStatistic.bytes += bytes;
+                    return;
+                }
+            }
+            statistics.allocations.push_back({ .scope = scope, .count = count, .bytes = bytes });
+        };
+
+        const uint32_t threadCount = std::min(allocationThreadCount.load(std::memory_order_acquire), maxAllocationThreads);
+        for(uint32_t threadIndex = 0; threadIndex < threadCount; threadIndex++)
+        {
+            ThreadAllocations* allocations = allocationThreads[threadIndex].load(std::memory_order_acquire);
+            if(!allocations) continue; //still being registered
+
+            for(ScopeAllocations& slot : allocations->scopes)
+            {
+                if(!slot.id.load(std::memory_order_acquire)) continue;
+
+                const uint64_t count = slot.count.exchange(0, std::memory_order_relaxed);
+                const uint64_t bytes = slot.bytes.exchange(0, std::memory_order_relaxed);
+                addAllocations(slot.name.load(std::memory_order_relaxed), count, bytes);
+            }
+        }
+
+        addAllocations("Untracked", untrackedCount.exchange(0, std::memory_order_relaxed), untrackedBytes.exchange(0, std::memory_order_relaxed));
+#endif
+    }
+}
+
+#ifdef PAPER_RENDERER_TRACK_ALLOCATIONS
+//replaces the global allocation functions so every heap allocation is counted. Over-aligned ones keep the standard library's, which don't use these
+void* operator new(std::size_t size)
+{
+    PaperRenderer::recordAllocation(size);
+    if(void* memory = std::malloc(size ? size : 1)) return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    PaperRenderer::recordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+#endif
@@ -8,24 +8,71 @@
 
 namespace PaperRenderer
 {
+    //----------QUEUE DEFINITIONS----------//
+
+    void Queue::idle()
+    {
+        //submissions on this queue may wait on pending work from other queues, so everything is flushed before waiting on its timeline
+        if(commands)
+        {
+            commands->waitForSubmissions({ commands->getLastSubmission(*this) });
+        }
+        else
+        {
+            const std::lock_guard guard(threadLock);
+            vkQueueWaitIdle(queue);
+        }
+    }
+
     //----------CMD BUFFER ALLOCATOR DEFINITIONS----------//
 
+    //assigned on a thread's first command buffer request; selects its affine command pools
+    static std::atomic<uint32_t> nextThreadSlot = 0;
+    static thread_local const uint32_t threadSlot = nextThreadSlot++;
+
     Commands::Commands(RenderEngine& renderer, std::unordered_map<QueueType, QueuesInFamily>* queuesPtr)
         :renderer(renderer),
         queuesPtr(queuesPtr)
     {
         createCommandPools();
 
+        //queues need to flush batched submissions before idling, and have a timeline for tracking their submissions
+        for(auto& [type, family] : *queuesPtr)
+        {
+            for(Queue* queue : family.queues)
+            {
+                if(!queue->commands) //queues can be shared between types
+                {
+                    uint64_t initialValue = 0;
+                    queue->commands = this;
+                    queue->submissionSemaphore = getTimelineSemaphore(initialValue);
+                    queue->submissionValue = initialValue;
+                }
+            }
+        }
+
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Commands constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "Commands constructor finished");
     }
 
     Commands::~Commands()
     {
-        for(std::unordered_map<PaperRenderer::QueueType, std::vector<PaperRenderer::Commands::CommandPoolData>>& frameCommandPool : commandPools)
+        flushSubmissions();
+
+        //finish deferred destructions
+        std::vector<TimelineSemaphorePair> remainingSubmissions = {};
+        for(const DeferredDestruction& destruction : deferredDestructions)
+        {
+            remainingSubmissions.insert(remainingSubmissions.end(), destruction.submissions.begin(), destruction.submissions.end());
+        }
+        waitForSubmissions(remainingSubmissions);
+        for(DeferredDestruction& destruction : deferredDestructions)
+        {
+            destruction.destroy();
+        }
+        deferredDestructions.clear();
+
+        for(std::unordered_map<PaperRenderer::QueueType, std::vector<PaperRenderer::CommandPoolData>>& frameCommandPool : commandPools)
         {
             for(auto& [type, pools] : frameCommandPool)
             {
@@ -44,16 +91,44 @@ namespace PaperRenderer
             }
         }
 
+        //destroy pooled sync objects
+        for(VkSemaphore semaphore : freeSemaphores)
+        {
+            vkDestroySemaphore(renderer.getDevice().getDevice(), semaphore, nullptr);
+        }
+        for(const std::vector<VkSemaphore>& retired : retiredSemaphores)
+        {
+            for(VkSemaphore semaphore : retired)
+            {
+                vkDestroySemaphore(renderer.getDevice().getDevice(), semaphore, nullptr);
+            }
+        }
+        for(const PooledTimelineSemaphore& pooled : freeTimelineSemaphores)
+        {
+            vkDestroySemaphore(renderer.getDevice().getDevice(), pooled.semaphore, nullptr);
+        }
+
+        //destroy queue timelines
+        for(auto& [type, family] : *queuesPtr)
+        {
+            for(Queue* queue : family.queues)
+            {
+                if(queue->commands == this)
+                {
+                    vkDestroySemaphore(renderer.getDevice().getDevice(), queue->submissionSemaphore, nullptr);
+                    queue->submissionSemaphore = VK_NULL_HANDLE;
+                    queue->commands = NULL;
+                }
+            }
+        }
+
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Commands destructor initialized"
-        });
+        renderer.getLogger().recordLog(INFO, "Commands destructor initialized");
     }
 
     void Commands::createCommandPools()
     {
-        for(std::unordered_map<PaperRenderer::QueueType, std::vector<PaperRenderer::Commands::CommandPoolData>>& queuePoolDatas : commandPools)
+        for(std::unordered_map<PaperRenderer::QueueType, std::vector<PaperRenderer::CommandPoolData>>& queuePoolDatas : commandPools)
         {
             //create 4 arrays of std::thread::hardware_concurrency length arrays of command pools (honestly presentation doesnt need that many pools but its ok)
             for(auto& [queueType, queues] : *queuesPtr)
@@ -82,10 +157,7 @@ namespace PaperRenderer
         //give warning if if there are locked command buffers present (from counter)
         if(lockedCmdBufferCount)
         {
-            renderer.getLogger().recordLog({
-                .type = WARNING,
-                .text = std::to_string(lockedCmdBufferCount) + " Locked command buffers present at time of resetting command pools. Imminent deadlock WILL occur"
-            });
+            renderer.getLogger().recordLog(WARNING, [&] { return std::to_string(lockedCmdBufferCount.load()) + " Locked command buffers present at time of resetting command pools. Imminent deadlock WILL occur"; });
         }
 
         //reset all pools
@@ -103,56 +175,47 @@ namespace PaperRenderer
         }
     }
 
-    Queue& Commands::submitToQueue(const QueueType queueType, const SynchronizationInfo &synchronizationInfo, const std::vector<VkCommandBuffer> &commandBuffers)
+    Queue& Commands::submitToQueue(const QueueType queueType, const SynchronizationInfo &synchronizationInfo, const SmallVector<VkCommandBuffer, 4> &commandBuffers)
     {
-        //find an "unlocked" queue with the specified type (also nested hell I know)
-        Queue* lockedQueue = NULL;
-        if(queuesPtr->count(queueType))
-        {
-            bool threadLocked = false;
-            while(!threadLocked)
-            {
-                for(Queue* queue : queuesPtr->at(queueType).queues)
-                {
-                    if(queue->threadLock.try_lock())
-                    {
-                        threadLocked = true;
-                        lockedQueue = queue;
-                        
-                        break;
-                    }
-                }
-            }
-        }
-        else
+        if(!queuesPtr->count(queueType))
         {
             throw std::runtime_error("No queues available for specified submission type");
         }
-        
-        //submit
-        if(lockedQueue)
+        else if(queuesPtr->at(queueType).queues.empty())
         {
-            submitToQueue(*lockedQueue, synchronizationInfo, commandBuffers);
+            throw std::runtime_error("Tried to submit to null queue");
         }
-        else
+
+        //prefer a queue that already has pending submissions so they coalesce into the same vkQueueSubmit2
+        Queue* selectedQueue = queuesPtr->at(queueType).queues.front();
         {
-            throw std::runtime_error("Tried to submit to null queue");
+            std::lock_guard guard(submissionMutex);
+            for(Queue* queue : queuesPtr->at(queueType).queues)
+            {
+                if(std::find(pendingQueues.begin(), pendingQueues.end(), queue) != pendingQueues.end())
+                {
+                    selectedQueue = queue;
+                    break;
+                }
+            }
         }
         
-        lockedQueue->threadLock.unlock();
+        //submit
+        submitToQueue(*selectedQueue, synchronizationInfo, commandBuffers);
 
-        return(*lockedQueue);
+        return *selectedQueue;
     }
 
-    void Commands::submitToQueue(Queue& queue, const SynchronizationInfo& synchronizationInfo, const std::vector<VkCommandBuffer>& commandBuffers)
+    void Commands::submitToQueue(Queue& queue, const SynchronizationInfo& synchronizationInfo, const SmallVector<VkCommandBuffer, 4>& commandBuffers)
     {
+        //submit infos are copied since the batch outlives the caller's data
+        PendingSubmission submission = {};
+
         //command buffers
-        std::vector<VkCommandBufferSubmitInfo> cmdBufferSubmitInfos = {};
-        cmdBufferSubmitInfos.reserve(commandBuffers.size());
         for(const VkCommandBuffer& cmdBuffer : commandBuffers)
         {
             //add to submit info
-            cmdBufferSubmitInfos.push_back({
+            submission.cmdBufferInfos.push_back({
                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
                 .pNext = NULL,
                 .commandBuffer = cmdBuffer,
@@ -160,15 +223,10 @@ namespace PaperRenderer
             });
         }
 
-        std::vector<VkSemaphoreSubmitInfo> semaphoreWaitInfos = {};
-        semaphoreWaitInfos.reserve(synchronizationInfo.binaryWaitPairs.size() + synchronizationInfo.timelineWaitPairs.size());
-        std::vector<VkSemaphoreSubmitInfo> semaphoreSignalInfos = {};
-        semaphoreSignalInfos.reserve(synchronizationInfo.binarySignalPairs.size() + synchronizationInfo.timelineSignalPairs.size());
-
         //binary wait semaphores
         for(const BinarySemaphorePair& pair : synchronizationInfo.binaryWaitPairs)
         {
-            semaphoreWaitInfos.push_back({
+            submission.waitInfos.push_back({
                 .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
                 .pNext = NULL,
                 .semaphore = pair.semaphore,
@@ -180,7 +238,7 @@ namespace PaperRenderer
         //binary signal semaphores
         for(const BinarySemaphorePair& pair : synchronizationInfo.binarySignalPairs)
         {
-            semaphoreSignalInfos.push_back({
+            submission.signalInfos.push_back({
                 .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
                 .pNext = NULL,
                 .semaphore = pair.semaphore,
@@ -192,7 +250,7 @@ namespace PaperRenderer
         //timeline wait semaphores
         for(const TimelineSemaphorePair& pair : synchronizationInfo.timelineWaitPairs)
         {
-            semaphoreWaitInfos.push_back({
+            submission.waitInfos.push_back({
                 .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
                 .pNext = NULL,
                 .semaphore = pair.semaphore,
@@ -205,7 +263,7 @@ namespace PaperRenderer
         //timeline signal semaphores
         for(const TimelineSemaphorePair& pair : synchronizationInfo.timelineSignalPairs)
         {
-            semaphoreSignalInfos.push_back({
+            submission.signalInfos.push_back({
                 .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
                 .pNext = NULL,
                 .semaphore = pair.semaphore,
@@ -214,27 +272,218 @@ namespace PaperRenderer
                 .deviceIndex = 0
             });
         }
-        
-        //fill in the submit info
-        const VkSubmitInfo2 submitInfo = {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+
+        std::lock_guard guard(submissionMutex);
+
+        //a binary semaphore's signal must be submitted before its wait, and the signal may still be pending
+        if(synchronizationInfo.binaryWaitPairs.size())
+        {
+            flushSubmissions();
+        }
+
+        //signal the queue's timeline; values are assigned under the lock so they increase in submission order
+        submission.signalInfos.push_back({
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = NULL,
+            .semaphore = queue.submissionSemaphore,
+            .value = queue.submissionValue + 1,
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .deviceIndex = 0
+        });
+        queue.submissionValue++;
+
+        //add to the queue's batch
+        std::vector<PendingSubmission>& queueSubmissions = pendingSubmissions[&queue];
+        if(queueSubmissions.empty())
+        {
+            pendingQueues.push_back(&queue);
+        }
+        queueSubmissions.push_back(std::move(submission));
+        renderer.getStatisticsTracker().modifyObjectCounter("Batched Queue Submissions", 1);
+
+        //fences are signaled per vkQueueSubmit2 and are likely waited on from the host, so everything pending is flushed with it
+        if(synchronizationInfo.fence)
+        {
+            //flushing removes a queue from pendingQueues
+            for(uint32_t i = 0; i < pendingQueues.size();)
+            {
+                if(pendingQueues[i] != &queue)
+                {
+                    flushQueue(*pendingQueues[i], VK_NULL_HANDLE);
+                }
+                else
+                {
+                    i++;
+                }
+            }
+            flushQueue(queue, synchronizationInfo.fence);
+        }
+        else if(queueSubmissions.size() >= maxBatchedSubmissions)
+        {
+            flushQueue(queue, VK_NULL_HANDLE);
+        }
+    }
+
+    void Commands::flushQueue(Queue& queue, const VkFence fence)
+    {
+        //submissionMutex must be held by the caller
+        const std::vector<PendingSubmission>& submissions = pendingSubmissions.at(&queue);
+
+        submitInfos.clear();
+        for(const PendingSubmission& submission : submissions)
+        {
+            submitInfos.push_back({
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                .pNext = NULL,
+                .flags = 0,
+                .waitSemaphoreInfoCount = (uint32_t)submission.waitInfos.size(),
+                .pWaitSemaphoreInfos = submission.waitInfos.data(),
+                .commandBufferInfoCount = (uint32_t)submission.cmdBufferInfos.size(),
+                .pCommandBufferInfos = submission.cmdBufferInfos.data(),
+                .signalSemaphoreInfoCount = (uint32_t)submission.signalInfos.size(),
+                .pSignalSemaphoreInfos = submission.signalInfos.data()
+            });
+        }
+
+        //submit; submissions keep their order within the batch, so same queue dependencies are unchanged
+        {
+            std::lock_guard guard(queue.threadLock);
+            vkQueueSubmit2(queue.queue, (uint32_t)submitInfos.size(), submitInfos.data(), fence);
+        }
+        renderer.getStatisticsTracker().modifyObjectCounter("Queue Submit Calls", 1);
+
+        //clear batch
+        pendingSubmissions.at(&queue).clear();
+        pendingQueues.erase(std::find(pendingQueues.begin(), pendingQueues.end(), &queue));
+    }
+
+    void Commands::flushSubmissions()
+    {
+        std::lock_guard guard(submissionMutex);
+
+        //queues are flushed in the order of their first pending submission
+        while(pendingQueues.size())
+        {
+            flushQueue(*pendingQueues.front(), VK_NULL_HANDLE);
+        }
+    }
+
+    TimelineSemaphorePair Commands::getLastSubmission(const Queue& queue) const
+    {
+        return {
+            .semaphore = queue.submissionSemaphore,
+            .stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .value = queue.submissionValue
+        };
+    }
+
+    void Commands::waitForSubmissions(const std::vector<TimelineSemaphorePair>& submissions)
+    {
+        if(submissions.empty())
+        {
+            return;
+        }
+
+        //submissions may still be batched
+        flushSubmissions();
+
+        std::vector<VkSemaphore> semaphores = {};
+        std::vector<uint64_t> values = {};
+        semaphores.reserve(submissions.size());
+        values.reserve(submissions.size());
+        for(const TimelineSemaphorePair& submission : submissions)
+        {
+            semaphores.push_back(submission.semaphore);
+            values.push_back(submission.value);
+        }
+
+        const VkSemaphoreWaitInfo waitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
             .pNext = NULL,
             .flags = 0,
-            .waitSemaphoreInfoCount = (uint32_t)semaphoreWaitInfos.size(),
-            .pWaitSemaphoreInfos = semaphoreWaitInfos.data(),
-            .commandBufferInfoCount = (uint32_t)cmdBufferSubmitInfos.size(),
-            .pCommandBufferInfos = cmdBufferSubmitInfos.data(),
-            .signalSemaphoreInfoCount = (uint32_t)semaphoreSignalInfos.size(),
-            .pSignalSemaphoreInfos = semaphoreSignalInfos.data()
+            .semaphoreCount = (uint32_t)semaphores.size(),
+            .pSemaphores = semaphores.data(),
+            .pValues = values.data()
         };
+        vkWaitSemaphores(renderer.getDevice().getDevice(), &waitInfo, UINT64_MAX);
+    }
 
-        //submit
-        std::lock_guard guard(queue.threadLock);
-        vkQueueSubmit2(queue.queue, 1, &submitInfo, synchronizationInfo.fence);
+    bool Commands::submissionsComplete(const std::vector<TimelineSemaphorePair>& submissions) const
+    {
+        for(const TimelineSemaphorePair& submission : submissions)
+        {
+            uint64_t counterValue = 0;
+            vkGetSemaphoreCounterValue(renderer.getDevice().getDevice(), submission.semaphore, &counterValue);
+            if(counterValue < submission.value)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Commands::deferDestruction(const std::vector<TimelineSemaphorePair>& submissions, std::function<void()>&& destroy)
+    {
+        if(submissionsComplete(submissions))
+        {
+            destroy();
+        }
+        else
+        {
+            std::lock_guard guard(destructionMutex);
+            deferredDestructions.push_back({
+                .submissions = submissions,
+                .destroy = std::move(destroy)
+            });
+            renderer.getStatisticsTracker().modifyObjectCounter("Deferred Destructions", 1);
+        }
+    }
+
+    void Commands::releaseDeferredDestructions()
+    {
+        //Timer
+        Timer timer(renderer, "Release Deferred Destructions", REGULAR);
+
+        //take completed destructions out of the queue first so destroy functions run without the lock
+        std::vector<std::function<void()>> completedDestructions = {};
+        {
+            std::lock_guard guard(destructionMutex);
+            for(auto destruction = deferredDestructions.begin(); destruction != deferredDestructions.end();)
+            {
+                if(submissionsComplete(destruction->submissions))
+                {
+                    completedDestructions.push_back(std::move(destruction->destroy));
+                    destruction = deferredDestructions.erase(destruction);
+                }
+                else
+                {
+                    destruction++;
+                }
+            }
+        }
+
+        for(const std::function<void()>& destroy : completedDestructions)
+        {
+            destroy();
+        }
     }
 
     VkSemaphore Commands::getSemaphore()
     {
+        //recycled
+        {
+            std::lock_guard guard(syncPoolMutex);
+            if(freeSemaphores.size())
+            {
+                const VkSemaphore semaphore = freeSemaphores.back();
+                freeSemaphores.pop_back();
+
+                return semaphore;
+            }
+        }
+
+        //new
         VkSemaphore semaphore;
 
         VkSemaphoreCreateInfo semaphoreInfo = {
@@ -244,19 +493,54 @@ namespace PaperRenderer
         };
 
         vkCreateSemaphore(renderer.getDevice().getDevice(), &semaphoreInfo, nullptr, &semaphore);
+        renderer.getStatisticsTracker().modifyObjectCounter("Sync Objects Created", 1);
 
         return semaphore;
     }
 
-    VkSemaphore Commands::getTimelineSemaphore(uint64_t initialValue)
+    VkSemaphore Commands::getTimelineSemaphore(uint64_t& value)
     {
+        //recycled; only once the previous user's final value has been reached, otherwise its pending signals could go backwards
+        {
+            std::lock_guard guard(syncPoolMutex);
+            for(auto pooled = freeTimelineSemaphores.begin(); pooled != freeTimelineSemaphores.end(); pooled++)
+            {
+                uint64_t counterValue = 0;
+                vkGetSemaphoreCounterValue(renderer.getDevice().getDevice(), pooled->semaphore, &counterValue);
+                if(counterValue >= pooled->value)
+                {
+                    const VkSemaphore semaphore = pooled->semaphore;
+                    freeTimelineSemaphores.erase(pooled);
+
+                    //the counter can't be lowered, so a larger requested value is signaled from the host
+                    if(value > counterValue)
+                    {
+                        const VkSemaphoreSignalInfo signalInfo = {
+                            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+                            .pNext = NULL,
+                            .semaphore = semaphore,
+                            .value = value
+                        };
+                        vkSignalSemaphore(renderer.getDevice().getDevice(), &signalInfo);
+                    }
+                    else
+                    {
+                        value = counterValue;
+                    }
+
+                    return semaphore;
+                }
+            }
+        }
+
+        //new
         VkSemaphore semaphore;
 
         const VkSemaphoreTypeCreateInfo semaphoreTypeInfo = {
             .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
             .pNext = NULL,
             .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
-            .initialValue = initialValue
+            .initialValue = value
         };
 
         const VkSemaphoreCreateInfo semaphoreInfo = {
@@ -266,6 +550,7 @@ namespace PaperRenderer
         };
 
         vkCreateSemaphore(renderer.getDevice().getDevice(), &semaphoreInfo, nullptr, &semaphore);
+        renderer.getStatisticsTracker().modifyObjectCounter("Sync Objects Created", 1);
 
         return semaphore;
     }
@@ -280,6 +565,7 @@ namespace PaperRenderer
         };
 
         vkCreateFence(renderer.getDevice().getDevice(), &fenceInfo, nullptr, &fence);
+        renderer.getStatisticsTracker().modifyObjectCounter("Sync Objects Created", 1);
 
         return fence;
     }
@@ -294,56 +580,86 @@ namespace PaperRenderer
         };
 
         vkCreateFence(renderer.getDevice().getDevice(), &fenceInfo, nullptr, &fence);
+        renderer.getStatisticsTracker().modifyObjectCounter("Sync Objects Created", 1);
 
         return fence;
     }
 
-    VkCommandBuffer Commands::getCommandBuffer(QueueType type)
+    void Commands::recycleSemaphore(VkSemaphore semaphore)
     {
-        //find a command pool to lock (similar to queue submit, just keep looping until one is available)
-        bool threadLocked = false;
-        CommandPoolData* lockedPool = NULL;
-        while(!threadLocked)
+        std::lock_guard guard(syncPoolMutex);
+        retiredSemaphores[renderer.getBufferIndex()].push_back(semaphore);
+    }
+
+    void Commands::recycleTimelineSemaphore(VkSemaphore semaphore, uint64_t finalValue)
+    {
+        std::lock_guard guard(syncPoolMutex);
+        freeTimelineSemaphores.push_back({
+            .semaphore = semaphore,
+            .value = finalValue
+        });
+    }
+
+    void Commands::releaseRetiredSemaphores()
+    {
+        //same assumption as resetCommandPools(); the last frame with this buffer index has completed
+        std::lock_guard guard(syncPoolMutex);
+        std::vector<VkSemaphore>& retired = retiredSemaphores[renderer.getBufferIndex()];
+        freeSemaphores.insert(freeSemaphores.end(), retired.begin(), retired.end());
+        retired.clear();
+    }
+
+    CommandPoolData& Commands::lockCommandPool(QueueType type)
+    {
+        std::vector<CommandPoolData>& pools = commandPools[renderer.getBufferIndex()].at(type);
+
+        //affine pool; only ever locked by another thread if there are more recording threads than pools
+        CommandPoolData& affinePool = pools[threadSlot % pools.size()];
+        if(affinePool.threadLock.try_lock())
+        {
+            return affinePool;
+        }
+
+        //contended; take any free pool, looping until one is available
+        renderer.getStatisticsTracker().modifyObjectCounter("Command Pool Contentions", 1);
+        Timer timer(renderer, "Command Pool Lock Wait", IRREGULAR);
+        while(true)
         {
-            for(CommandPoolData& pool : commandPools[renderer.getBufferIndex()][type])
+            for(CommandPoolData& pool : pools)
             {
                 if(pool.threadLock.try_lock())
                 {
-                    threadLocked = true;
-                    lockedPool = &pool;
-
-                    break;
+                    return pool;
                 }
             }
+            std::this_thread::yield();
         }
+    }
 
-        uint32_t& stackLocation = lockedPool->cmdBufferStackLocation;
+    VkCommandBuffer Commands::getCommandBuffer(CommandPoolData& pool)
+    {
+        //the pool is locked by this thread, so its buffers can be recycled without any further synchronization
+        uint32_t& stackLocation = pool.cmdBufferStackLocation;
 
         //allocate more command buffers if needed
-        if(!(stackLocation < lockedPool->cmdBuffers.size()))
+        if(!(stackLocation < pool.cmdBuffers.size()))
         {
             const uint32_t bufferCount = 64;
-            lockedPool->cmdBuffers.resize(lockedPool->cmdBuffers.size() + 64);
+            pool.cmdBuffers.resize(pool.cmdBuffers.size() + bufferCount);
 
             const VkCommandBufferAllocateInfo bufferInfo = {
                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
                 .pNext = NULL,
-                .commandPool = lockedPool->cmdPool,
+                .commandPool = pool.cmdPool,
                 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
                 .commandBufferCount = bufferCount
             };
 
-            VkResult result = vkAllocateCommandBuffers(renderer.getDevice().getDevice(), &bufferInfo, &lockedPool->cmdBuffers[stackLocation]);
+            vkAllocateCommandBuffers(renderer.getDevice().getDevice(), &bufferInfo, &pool.cmdBuffers[stackLocation]);
         }
 
         //get command buffer
-        VkCommandBuffer returnBuffer = lockedPool->cmdBuffers[stackLocation];
-
-        //keep track of command buffer's locked command pool
-        std::lock_guard guard(cmdBuffersLockedPoolMutex);
-        cmdBuffersLockedPool[returnBuffer] = lockedPool;
-
-        //increment locked counter (protected by mutex)
+        VkCommandBuffer returnBuffer = pool.cmdBuffers[stackLocation];
         lockedCmdBufferCount++;
 
         //increment stack
@@ -354,18 +670,10 @@ namespace PaperRenderer
         return returnBuffer;
     }
 
-    void Commands::unlockCommandBuffer(VkCommandBuffer cmdBuffer)
+    void Commands::unlockCommandPool(CommandPoolData& pool)
     {
-        //unlock the command pool used by the command buffer (if in map)
-        std::lock_guard guard(cmdBuffersLockedPoolMutex);
-        if(cmdBuffersLockedPool.count(cmdBuffer))
-        {
-            cmdBuffersLockedPool[cmdBuffer]->threadLock.unlock();
-            cmdBuffersLockedPool.erase(cmdBuffer);
-        }
-
-        //decrement locked counter (protected by mutex)
         lockedCmdBufferCount--;
+        pool.threadLock.unlock();
     }
 
     //----------COMMAND POOL DEFINITIONS----------//
@@ -382,10 +690,7 @@ namespace PaperRenderer
 
         if(!vkCreateCommandPool(renderer.getDevice().getDevice(), &commandPoolInfo, nullptr, &cmdPool))
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create command pool"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create command pool");
         }
     }
 
@@ -442,10 +747,7 @@ namespace PaperRenderer
             std::vector<VkCommandBuffer> newBuffers(bufferCount);
             if(!vkAllocateCommandBuffers(rendererPtr->getDevice().getDevice(), &bufferInfo, newBuffers.data()))
             {
-                rendererPtr->getLogger().recordLog({
-                    .type = CRITICAL_ERROR,
-                    .text = "Failed to allocate command buffers to pool"
-                });
+                rendererPtr->getLogger().recordLog(CRITICAL_ERROR, "Failed to allocate command buffers to pool");
             }
 
             cmdBuffers.insert(cmdBuffers.end(), newBuffers.begin(), newBuffers.end());
@@ -469,9 +771,10 @@ namespace PaperRenderer
     //----------COMMAND BUFFER DEFINITIONS----------//
 
     CommandBuffer::CommandBuffer(Commands& commands, const QueueType type)
-        :cmdBuffer(commands.getCommandBuffer(type)),
+        :lockedPool(&commands.lockCommandPool(type)),
         commands(&commands)
     {
+        cmdBuffer = commands.getCommandBuffer(*lockedPool);
     }
 
     CommandBuffer::CommandBuffer(CommandPool& pool)
@@ -482,17 +785,19 @@ namespace PaperRenderer
 
     CommandBuffer::~CommandBuffer()
     {
-        if(cmdBuffer && commands)
+        if(cmdBuffer && lockedPool)
         {
-            commands->unlockCommandBuffer(cmdBuffer);
+            commands->unlockCommandPool(*lockedPool);
         }
     }
 
     CommandBuffer::CommandBuffer(CommandBuffer&& other) noexcept
         :cmdBuffer(other.cmdBuffer),
+        lockedPool(other.lockedPool),
         commands(other.commands)
     {
         other.cmdBuffer = VK_NULL_HANDLE;
+        other.lockedPool = NULL;
     }
 
     CommandBuffer& CommandBuffer::operator=(CommandBuffer&& other) noexcept
@@ -500,8 +805,10 @@ namespace PaperRenderer
         if(this != &other)
         {
             cmdBuffer = other.cmdBuffer;
+            lockedPool = other.lockedPool;
             commands = other.commands;
             other.cmdBuffer = VK_NULL_HANDLE;
+            other.lockedPool = NULL;
         }
 
         return *this;
@@ -1,5 +1,6 @@
 #pragma once
 #include "volk.h"
+#include "SmallVector.h"
 
 #include <unordered_map>
 #include <vector>
@@ -8,6 +9,7 @@
 #include <atomic>
 #include <array>
 #include <thread>
+#include <functional>
 
 namespace PaperRenderer
 {
@@ -29,17 +31,20 @@ namespace PaperRenderer
     {
         VkQueue queue = VK_NULL_HANDLE;
         std::recursive_mutex threadLock;
+        class Commands* commands = NULL; //set by Commands; batched submissions are flushed before idling
 
-        void idle()
-        {
-            const std::lock_guard guard(threadLock);
-            vkQueueWaitIdle(queue);
-        }
+        //timeline signaled by every submission to this queue, with submissionValue being the value of the latest one
+        VkSemaphore submissionSemaphore = VK_NULL_HANDLE;
+        std::atomic<uint64_t> submissionValue = 0;
+
+        //waits for all work submitted to this queue so far without locking it
+        void idle();
     };
 
     struct QueuesInFamily
     {
         uint32_t queueFamilyIndex = 0xFFFFFFFF;
+        uint32_t timestampValidBits = 0; //0 if the family doesn't support timestamp queries
         std::vector<Queue*> queues;
     };
 
@@ -64,13 +69,13 @@ namespace PaperRenderer
         uint64_t value = 0;
     };
 
-    //generic parameters for synchronization in queues
+    //generic parameters for synchronization in queues; pairs are stored inline up to a few per list, so building one doesn't allocate
     struct SynchronizationInfo
     {
-        std::vector<BinarySemaphorePair> binaryWaitPairs = {};
-        std::vector<BinarySemaphorePair> binarySignalPairs = {};
-        std::vector<TimelineSemaphorePair> timelineWaitPairs = {};
-        std::vector<TimelineSemaphorePair> timelineSignalPairs = {};
+        SmallVector<BinarySemaphorePair, 4> binaryWaitPairs = {};
+        SmallVector<BinarySemaphorePair, 4> binarySignalPairs = {};
+        SmallVector<TimelineSemaphorePair, 8> timelineWaitPairs = {};
+        SmallVector<TimelineSemaphorePair, 8> timelineSignalPairs = {};
         VkFence fence = VK_NULL_HANDLE;
     };
 
@@ -101,11 +106,21 @@ namespace PaperRenderer
         void reset();
     };
 
+    // Frame command pool used by Commands. Locked by the thread recording into it until all of its command buffers are destroyed
+    struct CommandPoolData
+    {
+        VkCommandPool cmdPool = VK_NULL_HANDLE;
+        std::recursive_mutex threadLock = {};
+        std::deque<VkCommandBuffer> cmdBuffers = {};
+        uint32_t cmdBufferStackLocation = 0;
+    };
+
     // RAII command buffer wrapper; automatically unlocks command buffer at the end of its scope
     class CommandBuffer
     {
     private:
         VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+        CommandPoolData* lockedPool = NULL; //pool to unlock on destruction; null for custom pools
 
         class Commands* commands;
     public:
@@ -125,24 +140,53 @@ namespace PaperRenderer
     class Commands
     {
     private:
-        struct CommandPoolData
+        std::atomic<int64_t> lockedCmdBufferCount = 0;
+
+        //submission batching; submissions are recorded per queue and handed to the driver together as one vkQueueSubmit2
+        struct PendingSubmission
         {
-            VkCommandPool cmdPool = VK_NULL_HANDLE;
-            std::recursive_mutex threadLock = {};
-            std::deque<VkCommandBuffer> cmdBuffers = {};
-            uint32_t cmdBufferStackLocation = 0;
+            SmallVector<VkCommandBufferSubmitInfo, 4> cmdBufferInfos = {};
+            SmallVector<VkSemaphoreSubmitInfo, 8> waitInfos = {};
+            SmallVector<VkSemaphoreSubmitInfo, 9> signalInfos = {}; //includes the queue's own timeline signal
         };
-        std::mutex cmdBuffersLockedPoolMutex;
-        uint64_t lockedCmdBufferCount = 0; //protected by mutex
+        static constexpr uint32_t maxBatchedSubmissions = 64; //batches are flushed early once this many submissions are pending on a queue
+        std::unordered_map<Queue*, std::vector<PendingSubmission>> pendingSubmissions; //flushed batches are cleared rather than erased to keep their capacity
+        std::vector<Queue*> pendingQueues; //queues with pending submissions, in order of their first pending submission
+        std::vector<VkSubmitInfo2> submitInfos; //reused by flushQueue()
+        std::recursive_mutex submissionMutex;
+
+        void flushQueue(Queue& queue, const VkFence fence);
+
+        //semaphore pools; recycled semaphores are reused instead of destroyed so steady state rendering creates none
+        struct PooledTimelineSemaphore
+        {
+            VkSemaphore semaphore = VK_NULL_HANDLE;
+            uint64_t value = 0; //last value signaled by its previous user; reused once the counter reaches it
+        };
+        std::vector<VkSemaphore> freeSemaphores;
+        std::array<std::vector<VkSemaphore>, 2> retiredSemaphores; //binary semaphores have no host visible state, so they're reused once their frame has completed
+        std::vector<PooledTimelineSemaphore> freeTimelineSemaphores;
+        std::mutex syncPoolMutex;
+
+        //deferred destruction; destroy functions are called once all of their submissions have completed
+        struct DeferredDestruction
+        {
+            std::vector<TimelineSemaphorePair> submissions = {};
+            std::function<void()> destroy = NULL;
+        };
+        std::deque<DeferredDestruction> deferredDestructions;
+        std::mutex destructionMutex;
+
         std::unordered_map<QueueType, QueuesInFamily>* queuesPtr;
         std::array<std::unordered_map<QueueType, std::vector<CommandPoolData>>, 2> commandPools;
-        std::unordered_map<VkCommandBuffer, CommandPoolData*> cmdBuffersLockedPool;
         const uint32_t coreCount = std::thread::hardware_concurrency();
 
         void createCommandPools();
 
-        VkCommandBuffer getCommandBuffer(QueueType type);
-        void unlockCommandBuffer(VkCommandBuffer cmdBuffer);
+        //each recording thread has an affine pool per queue type, so pools are only contended with more recording threads than cores
+        CommandPoolData& lockCommandPool(QueueType type);
+        VkCommandBuffer getCommandBuffer(CommandPoolData& pool);
+        void unlockCommandPool(CommandPoolData& pool);
 
         class RenderEngine& renderer;
 
@@ -154,12 +198,38 @@ namespace PaperRenderer
         Commands(const Commands&) = delete;
 
         void resetCommandPools();
-        Queue& submitToQueue(const QueueType queueType, const SynchronizationInfo &synchronizationInfo, const std::vector<VkCommandBuffer> &commandBuffers);
-        void submitToQueue(Queue& queue, const SynchronizationInfo &synchronizationInfo, const std::vector<VkCommandBuffer> &commandBuffers);
 
+        //Submissions are batched and only reach the GPU on flushSubmissions(), which is called before presentation and whenever a queue is idled.
+        //Submissions with binary wait semaphores or a fence flush everything pending. Call flushSubmissions() before waiting on any submitted work from the host
+        Queue& submitToQueue(const QueueType queueType, const SynchronizationInfo &synchronizationInfo, const SmallVector<VkCommandBuffer, 4> &commandBuffers);
+        void submitToQueue(Queue& queue, const SynchronizationInfo &synchronizationInfo, const SmallVector<VkCommandBuffer, 4> &commandBuffers);
+        //thread safe
+        void flushSubmissions();
+
+        //returns the timeline point of the latest submission (batched or not) made to the queue
+        TimelineSemaphorePair getLastSubmission(const Queue& queue) const;
+        //flushes batched submissions and waits for the timeline points on the host. Thread safe
+        void waitForSubmissions(const std::vector<TimelineSemaphorePair>& submissions);
+        //never blocks; batched submissions aren't complete until flushed. Thread safe
+        bool submissionsComplete(const std::vector<TimelineSemaphorePair>& submissions) const;
+        //calls destroy once every submission has completed (immediately if there are none). Thread safe
+        void deferDestruction(const std::vector<TimelineSemaphorePair>& submissions, std::function<void()>&& destroy);
+        //called at the start of every frame; never blocks
+        void releaseDeferredDestructions();
+
+        //semaphores are taken from pools when possible; return them with the recycle functions instead of destroying them. All are thread safe
         VkSemaphore getSemaphore();
-        VkSemaphore getTimelineSemaphore(uint64_t initialValue);
+        //value is the minimum initial value, and is set to the semaphore's actual current value (recycled semaphores keep increasing)
+        VkSemaphore getTimelineSemaphore(uint64_t& value);
+        //fences aren't pooled; the renderer synchronizes with timeline semaphores and never creates any itself. Destroy them as usual
         VkFence getSignaledFence();
         VkFence getUnsignaledFence();
+
+        //binary semaphores must have their signal waited on within the current frame
+        void recycleSemaphore(VkSemaphore semaphore);
+        //finalValue is the last value that was or will be signaled
+        void recycleTimelineSemaphore(VkSemaphore semaphore, uint64_t finalValue);
+        //called at the start of every frame; makes binary semaphores retired in the same frame index available again
+        void releaseRetiredSemaphores();
     };
 }
\ No newline at end of file
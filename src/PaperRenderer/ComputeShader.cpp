@@ -14,12 +14,13 @@ namespace PaperRenderer
     }
 
     void ComputeShader::dispatch(const VkCommandBuffer& cmdBuffer,
-        const std::vector<SetBinding>& descriptorSetsBindings,
+        std::span<const SetBinding> descriptorSetsBindings,
         const glm::uvec3& workGroupSizes
     ) const
     {
         //bind pipeline
         vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getPipeline());
+        renderer.getDescriptorAllocator().bindDescriptorBuffer(cmdBuffer);
 
         //bind descriptors
         for(const SetBinding& setBinding : descriptorSetsBindings)
@@ -2,6 +2,8 @@
 #include "Pipeline.h"
 #include "Descriptor.h"
 
+#include <span>
+
 namespace PaperRenderer
 {
     class ComputeShader
@@ -20,7 +22,7 @@ namespace PaperRenderer
 
         //binds pipeline, writes descriptors, and does vkCmdDispatch on work group size
         void dispatch(const VkCommandBuffer& cmdBuffer,
-            const std::vector<SetBinding>& descriptorSetsBindings,
+            std::span<const SetBinding> descriptorSetsBindings,
             const glm::uvec3& workGroupSizes
         ) const;
     };
@@ -4,20 +4,149 @@
 #include <functional>
 #include <future>
 #include <array>
+#include <algorithm>
 
 namespace PaperRenderer
 {
+    static std::atomic<uint64_t> nextAllocatorID = 0;
+
+    //----------DESCRIPTOR WRITE HASHING----------//
+
+    static constexpr uint64_t writeHashSeed = 0xcbf29ce484222325ULL;
+
+    static uint64_t hashValue(const uint64_t value, const uint64_t hash)
+    {
+        return (hash ^ value) * 0x100000001b3ULL;
+    }
+
+    //handles are hashed rather than raw structs since some contain padding
+    static uint64_t hashWrite(const BuffersDescriptorWrites& write, uint64_t hash)
+    {
+        hash = hashValue(((uint64_t)write.type << 32) | write.binding, hash);
+        for(const VkDescriptorBufferInfo& info : write.infos)
+        {
+            hash = hashValue((uint64_t)info.buffer, hash);
+            hash = hashValue(info.offset, hash);
+            hash = hashValue(info.range, hash);
+        }
+
+        return hash;
+    }
+
+    static uint64_t hashWrite(const ImagesDescriptorWrites& write, uint64_t hash)
+    {
+        hash = hashValue(((uint64_t)write.type << 32) | write.binding, hash);
+        for(const VkDescriptorImageInfo& info : write.infos)
+        {
+            hash = hashValue((uint64_t)info.sampler, hash);
+            hash = hashValue((uint64_t)info.imageView, hash);
+            hash = hashValue(info.imageLayout, hash);
+        }
+
+        return hash;
+    }
+
+    static uint64_t hashWrite(const BufferViewsDescriptorWrites& write, uint64_t hash)
+    {
+        hash = hashValue(((uint64_t)write.type << 32) | write.binding, hash);
+        for(const VkBufferView& info : write.infos)
+        {
+            hash = hashValue((uint64_t)info, hash);
+        }
+
+        return hash;
+    }
+
+    static uint64_t hashWrite(const AccelerationStructureDescriptorWrites& write, uint64_t hash)
+    {
+        //the underlying structure is hashed since a TLAS recreates it when it grows
+        hash = hashValue(((uint64_t)VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR << 32) | write.binding, hash);
+        for(TLAS const* accelerationStructure : write.accelerationStructures)
+        {
+            hash = hashValue((uint64_t)accelerationStructure->getAccelerationStructure(), hash);
+        }
+
+        return hash;
+    }
+
+    static uint64_t hashWrites(const DescriptorWrites& writes, uint64_t hash)
+    {
+        for(const BuffersDescriptorWrites& write : writes.bufferWrites) hash = hashWrite(write, hash);
+        for(const ImagesDescriptorWrites& write : writes.imageWrites) hash = hashWrite(write, hash);
+        for(const BufferViewsDescriptorWrites& write : writes.bufferViewWrites) hash = hashWrite(write, hash);
+        for(const AccelerationStructureDescriptorWrites& write : writes.accelerationStructureWrites) hash = hashWrite(write, hash);
+
+        return hash;
+    }
+
+    //flattens the hashed contents of writes so cache hits can be verified exactly
+    static void appendWritesContent(const DescriptorWrites& writes, std::vector<uint64_t>& content)
+    {
+        for(const BuffersDescriptorWrites& write : writes.bufferWrites)
+        {
+            content.insert(content.end(), { ((uint64_t)write.type << 32) | write.binding, write.infos.size() });
+            for(const VkDescriptorBufferInfo& info : write.infos) content.insert(content.end(), { (uint64_t)info.buffer, info.offset, info.range });
+        }
+        for(const ImagesDescriptorWrites& write : writes.imageWrites)
+        {
+            content.insert(content.end(), { ((uint64_t)write.type << 32) | write.binding, write.infos.size() });
+            for(const VkDescriptorImageInfo& info : write.infos) content.insert(content.end(), { (uint64_t)info.sampler, (uint64_t)info.imageView, (uint64_t)info.imageLayout });
+        }
+        for(const BufferViewsDescriptorWrites& write : writes.bufferViewWrites)
+        {
+            content.insert(content.end(), { ((uint64_t)write.type << 32) | write.binding, write.infos.size() });
+            for(const VkBufferView& info : write.infos) content.push_back((uint64_t)info);
+        }
+        for(const AccelerationStructureDescriptorWrites& write : writes.accelerationStructureWrites)
+        {
+            content.insert(content.end(), { ((uint64_t)VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR << 32) | write.binding, write.accelerationStructures.size() });
+            for(TLAS const* accelerationStructure : write.accelerationStructures) content.push_back((uint64_t)accelerationStructure->getAccelerationStructure());
+        }
+    }
+
+    //filters out writes whose contents match the last write to their binding
+    static bool isRedundantWrite(std::unordered_map<uint32_t, uint64_t>* bindingWriteHashes, const uint32_t binding, const uint64_t writeHash, uint32_t& skippedWrites)
+    {
+        if(!bindingWriteHashes) return false;
+
+        auto [it, inserted] = bindingWriteHashes->try_emplace(binding, writeHash);
+        if(!inserted && it->second == writeHash)
+        {
+            skippedWrites++;
+            return true;
+        }
+        it->second = writeHash;
+
+        return false;
+    }
+
+    //----------DESCRIPTOR ALLOCATOR DEFINITIONS----------//
+
     DescriptorAllocator::DescriptorAllocator(RenderEngine& renderer)
-        :renderer(renderer)
+        :allocatorID(nextAllocatorID++),
+        useDescriptorBuffer(renderer.getDevice().getGPUFeaturesAndProperties().descriptorBuffer),
+        descriptorBuffer(renderer, {
+            .size = useDescriptorBuffer ? persistentBufferSize + transientBufferSize * 2 : 0,
+            .usageFlags = VK_BUFFER_USAGE_2_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_2_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
+            .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .category = MEMORY_DESCRIPTOR
+        }),
+        renderer(renderer)
     {
         //initialize one descriptor pool
-        descriptorPoolData.descriptorPools = { allocateDescriptorPool() };
+        descriptorPoolData.descriptorPools = { allocateDescriptorPool(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT) };
+
+        //descriptors are written straight into the descriptor buffer's persistent mapping
+        if(useDescriptorBuffer)
+        {
+            VmaAllocationInfo allocationInfo = {};
+            vmaGetAllocationInfo(renderer.getDevice().getAllocator(), descriptorBuffer.getAllocation(), &allocationInfo);
+            descriptorBufferMapping = (uint8_t*)allocationInfo.pMappedData;
+            freeBufferRanges[0] = persistentBufferSize;
+        }
 
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "DescriptorAllocator constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "DescriptorAllocator constructor finished");
     }
     
     DescriptorAllocator::~DescriptorAllocator()
@@ -28,20 +157,26 @@ namespace PaperRenderer
             vkDestroyDescriptorPool(renderer.getDevice().getDevice(), pool, nullptr);
         }
 
+        std::lock_guard transientGuard(transientRegistrationMutex);
+        for(ThreadTransientPools& threadPools : threadTransientPools)
+        {
+            for(TransientPoolData& framePools : threadPools.framePools)
+            {
+                for(VkDescriptorPool pool : framePools.descriptorPools)
+                {
+                    vkDestroyDescriptorPool(renderer.getDevice().getDevice(), pool, nullptr);
+                }
+            }
+        }
+
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "DescriptorAllocator destructor initialized"
-        });
+        renderer.getLogger().recordLog(INFO, "DescriptorAllocator destructor initialized");
     }
 
-    VkDescriptorPool DescriptorAllocator::allocateDescriptorPool() const
+    VkDescriptorPool DescriptorAllocator::allocateDescriptorPool(const VkDescriptorPoolCreateFlags flags) const
     {
         //log creation
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Allocating new descriptor pool"
-        });
+        renderer.getLogger().recordLog(INFO, "Allocating new descriptor pool");
 
         //funny enough NVIDIA doesnt care about the following pool sizes... NVIDIA gpus work completely fine without them
         const uint32_t descriptorCount = 1024;
@@ -99,7 +234,7 @@ namespace PaperRenderer
         const VkDescriptorPoolCreateInfo poolInfo = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
             .pNext = NULL,
-            .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+            .flags = flags,
             .maxSets = descriptorCount,
             .poolSizeCount = (uint32_t)(renderer.getDevice().getGPUFeaturesAndProperties().rtSupport ? poolSizes.size() : poolSizes.size() - 1),
             .pPoolSizes = poolSizes.data()
@@ -109,10 +244,7 @@ namespace PaperRenderer
         VkResult result = vkCreateDescriptorPool(renderer.getDevice().getDevice(), &poolInfo, nullptr, &returnPool);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create descriptor pool"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create descriptor pool");
         }
         
         return returnPool;
@@ -144,7 +276,7 @@ namespace PaperRenderer
             //verify another pool exists in vector
             if(descriptorPoolData.descriptorPools.size() <= descriptorPoolData.currentPoolIndex)
             {
-                descriptorPoolData.descriptorPools.push_back(allocateDescriptorPool());
+                descriptorPoolData.descriptorPools.push_back(allocateDescriptorPool(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT));
             }
 
             //recursive retry
@@ -155,14 +287,14 @@ namespace PaperRenderer
             allocatedSetPoolIndices[returnSet] = descriptorPoolData.currentPoolIndex;
         }
 
-        //unlock mutex
-        descriptorPoolData.threadLock.unlock();
-
         return returnSet;
     }
 
     void DescriptorAllocator::freeDescriptorSet(VkDescriptorSet set)
     {
+        //thread lock
+        std::lock_guard guard(descriptorPoolData.threadLock);
+
         //free
         vkFreeDescriptorSets(renderer.getDevice().getDevice(), descriptorPoolData.descriptorPools[allocatedSetPoolIndices[set]], 1, &set);
 
@@ -173,8 +305,143 @@ namespace PaperRenderer
         allocatedSetPoolIndices.erase(set);
     }
 
-    void DescriptorAllocator::updateDescriptorSet(VkDescriptorSet set, const DescriptorWrites& descriptorWritesInfo) const
+    DescriptorAllocator::ThreadTransientPools& DescriptorAllocator::getThreadTransientPools()
     {
+        //per-thread cache of registered pools; keyed by allocator ID so a destroyed allocator's entry can never be reused
+        thread_local std::unordered_map<uint64_t, ThreadTransientPools*> threadPools;
+
+        auto it = threadPools.find(allocatorID);
+        if(it != threadPools.end())
+        {
+            return *it->second;
+        }
+
+        //first allocation on this thread; register new pools
+        std::lock_guard guard(transientRegistrationMutex);
+        ThreadTransientPools& newPools = threadTransientPools.emplace_back();
+        threadPools[allocatorID] = &newPools;
+
+        return newPools;
+    }
+
+    VkDescriptorSet DescriptorAllocator::getTransientDescriptorSet(VkDescriptorSetLayout setLayout)
+    {
+        //only this thread allocates from its pools, so no lock is needed
+        TransientPoolData& poolData = getThreadTransientPools().framePools[renderer.getBufferIndex()];
+
+        while(true)
+        {
+            //verify a pool exists at the current index
+            if(poolData.descriptorPools.size() <= poolData.currentPoolIndex)
+            {
+                poolData.descriptorPools.push_back(allocateDescriptorPool(0));
+            }
+
+            const VkDescriptorSetAllocateInfo allocInfo = {
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .pNext = NULL,
+                .descriptorPool = poolData.descriptorPools[poolData.currentPoolIndex],
+                .descriptorSetCount = 1,
+                .pSetLayouts = &setLayout
+            };
+
+            VkDescriptorSet returnSet = VK_NULL_HANDLE;
+            VkResult result = vkAllocateDescriptorSets(renderer.getDevice().getDevice(), &allocInfo, &returnSet);
+
+            //linear allocation; move on to the next pool once the current one is full
+            if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+            {
+                poolData.currentPoolIndex++;
+                continue;
+            }
+
+            return returnSet;
+        }
+    }
+
+    void DescriptorAllocator::resetTransientPools()
+    {
+        //Timer
+        Timer timer(renderer, "Reset Transient Descriptor Pools", REGULAR);
+
+        //descriptor buffer region
+        if(useDescriptorBuffer)
+        {
+            resetTransientBufferRegion();
+        }
+
+        std::lock_guard guard(transientRegistrationMutex);
+        for(ThreadTransientPools& threadPools : threadTransientPools)
+        {
+            TransientPoolData& poolData = threadPools.framePools[renderer.getBufferIndex()];
+            for(uint32_t i = 0; i < std::min(poolData.currentPoolIndex + 1, (uint32_t)poolData.descriptorPools.size()); i++)
+            {
+                vkResetDescriptorPool(renderer.getDevice().getDevice(), poolData.descriptorPools[i], 0);
+            }
+            poolData.currentPoolIndex = 0;
+        }
+    }
+
+    VkDescriptorSet DescriptorAllocator::getCachedDescriptorSet(VkDescriptorSetLayout setLayout, const DescriptorWrites& writes)
+    {
+        const uint64_t key = hashWrites(writes, hashValue((uint64_t)setLayout, writeHashSeed));
+        std::vector<uint64_t> content = { (uint64_t)setLayout };
+        appendWritesContent(writes, content);
+
+        std::lock_guard guard(setCacheMutex);
+
+        //hit; the full contents are compared since different writes can share a hash. Hit rate can be derived from the hit and miss counters
+        auto [begin, end] = cachedSets.equal_range(key);
+        for(auto it = begin; it != end; it++)
+        {
+            if(it->second.content == content)
+            {
+                it->second.references++;
+                renderer.getStatisticsTracker().modifyObjectCounter("Descriptor Set Cache Hits", 1);
+
+                return it->second.set;
+            }
+        }
+
+        //miss; allocate and write a new set
+        const VkDescriptorSet set = getDescriptorSet(setLayout);
+        updateDescriptorSet(set, writes);
+
+        cachedSets.insert({ key, { .set = set, .references = 1, .content = std::move(content) } });
+        cachedSetKeys[set] = key;
+        renderer.getStatisticsTracker().modifyObjectCounter("Descriptor Set Cache Misses", 1);
+
+        return set;
+    }
+
+    void DescriptorAllocator::releaseCachedDescriptorSet(VkDescriptorSet set)
+    {
+        std::lock_guard guard(setCacheMutex);
+
+        auto keyIt = cachedSetKeys.find(set);
+        if(keyIt == cachedSetKeys.end())
+        {
+            renderer.getLogger().recordLog(WARNING, "Tried to release a descriptor set that isn't cached");
+
+            return;
+        }
+
+        //free once unreferenced
+        auto [begin, end] = cachedSets.equal_range(keyIt->second);
+        auto it = std::find_if(begin, end, [&](const auto& entry){ return entry.second.set == set; });
+        if(--it->second.references == 0)
+        {
+            freeDescriptorSet(set);
+            cachedSets.erase(it);
+            cachedSetKeys.erase(keyIt);
+        }
+    }
+
+    void DescriptorAllocator::updateDescriptorSet(VkDescriptorSet set, const DescriptorWrites& descriptorWritesInfo, std::unordered_map<uint32_t, uint64_t>* bindingWriteHashes) const
+    {
+        const uint64_t writeSeed = hashValue(handleGeneration.load(std::memory_order_relaxed), writeHashSeed);
+        uint32_t skippedWrites = 0;
+
         std::vector<VkWriteDescriptorSet> descriptorWrites;
         descriptorWrites.reserve(descriptorWritesInfo.bufferWrites.size() + descriptorWritesInfo.bufferViewWrites.size() + descriptorWritesInfo.imageWrites.size());
         std::vector<std::vector<VkAccelerationStructureKHR>> tlasReferences;
@@ -184,7 +451,7 @@ namespace PaperRenderer
 
         for(const BuffersDescriptorWrites& write : descriptorWritesInfo.bufferWrites)
         {
-            if(write.infos.size())
+            if(write.infos.size() && !isRedundantWrite(bindingWriteHashes, write.binding, hashWrite(write, writeSeed), skippedWrites))
             {
                 descriptorWrites.push_back({
                     .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -238,7 +505,7 @@ namespace PaperRenderer
 
         for(const AccelerationStructureDescriptorWrites& write : descriptorWritesInfo.accelerationStructureWrites)
         {
-            if(write.accelerationStructures.size())
+            if(write.accelerationStructures.size() && !isRedundantWrite(bindingWriteHashes, write.binding, hashWrite(write, writeSeed), skippedWrites))
             {
                 //get TLAS references
                 tlasReferences.emplace_back();
@@ -278,29 +545,502 @@ namespace PaperRenderer
         {
             vkUpdateDescriptorSets(renderer.getDevice().getDevice(), descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
         }
+
+        if(skippedWrites)
+        {
+            renderer.getStatisticsTracker().modifyObjectCounter("Descriptor Writes Skipped", skippedWrites);
+        }
+    }
+
+    //----------DESCRIPTOR BUFFER BACKEND DEFINITIONS----------//
+
+    void DescriptorAllocator::registerBufferLayout(VkDescriptorSetLayout setLayout, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        DescriptorBufferLayout bufferLayout = {};
+        vkGetDescriptorSetLayoutSizeEXT(renderer.getDevice().getDevice(), setLayout, &bufferLayout.size);
+
+        //dynamic offsets are ordered by binding number
+        std::vector<VkDescriptorSetLayoutBinding> sortedBindings = bindings;
+        std::sort(sortedBindings.begin(), sortedBindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+        for(const VkDescriptorSetLayoutBinding& binding : sortedBindings)
+        {
+            const bool dynamic = binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+            DescriptorBufferLayout::Binding& bufferBinding = bufferLayout.bindings[binding.binding];
+            bufferBinding.type = binding.descriptorType;
+            bufferBinding.count = binding.descriptorCount;
+            vkGetDescriptorSetLayoutBindingOffsetEXT(renderer.getDevice().getDevice(), setLayout, binding.binding, &bufferBinding.offset);
+
+            if(dynamic)
+            {
+                bufferBinding.type = binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                bufferBinding.dynamicIndex = bufferLayout.dynamicCount;
+                bufferLayout.dynamicCount += binding.descriptorCount;
+            }
+        }
+
+        std::lock_guard guard(bufferLayoutsMutex);
+        bufferLayouts[setLayout] = std::move(bufferLayout);
+    }
+
+    void DescriptorAllocator::unregisterBufferLayout(VkDescriptorSetLayout setLayout)
+    {
+        std::lock_guard guard(bufferLayoutsMutex);
+        bufferLayouts.erase(setLayout);
+    }
+
+    VkDeviceSize DescriptorAllocator::allocateBufferRange(const VkDeviceSize size, const bool transient)
+    {
+        //transient ranges are linearly allocated from the current frame's region
+        const uint32_t frameIndex = renderer.getBufferIndex();
+        if(transient)
+        {
+            const VkDeviceSize relativeOffset = transientBufferOffsets[frameIndex].fetch_add(size);
+            if(relativeOffset + size <= transientBufferSize)
+            {
+                return persistentBufferSize + transientBufferSize * frameIndex + relativeOffset;
+            }
+
+            //the region is grown on the frame's next reset; until then, overflow borrows persistent space that the reset returns
+            renderer.getStatisticsTracker().modifyObjectCounter("Descriptor Buffer Transient Overflows", 1);
+        }
+
+        //first fit from the persistent region
+        std::lock_guard guard(bufferRangesMutex);
+        for(auto it = freeBufferRanges.begin(); it != freeBufferRanges.end(); it++)
+        {
+            if(it->second >= size)
+            {
+                const VkDeviceSize offset = it->first;
+                const VkDeviceSize remainingSize = it->second - size;
+                freeBufferRanges.erase(it);
+                if(remainingSize) freeBufferRanges[offset + size] = remainingSize;
+
+                if(transient) transientOverflowRanges[frameIndex].push_back({ offset, size });
+
+                return offset;
+            }
+        }
+
+        renderer.getLogger().recordLog(CRITICAL_ERROR, "Ran out of persistent descriptor buffer memory");
+
+        return UINT64_MAX;
+    }
+
+    DescriptorBufferSet DescriptorAllocator::allocateBufferSet(VkDescriptorSetLayout setLayout, const bool transient)
+    {
+        DescriptorBufferSet returnSet = {};
+        {
+            std::lock_guard guard(bufferLayoutsMutex);
+            auto it = bufferLayouts.find(setLayout);
+            if(it == bufferLayouts.end())
+            {
+                renderer.getLogger().recordLog(CRITICAL_ERROR, "Descriptor set layout wasn't created with DescriptorSetLayout, so it can't be used with descriptor buffers");
+
+                return returnSet;
+            }
+            returnSet.layout = &it->second;
+        }
+
+        //sets with dynamic bindings live on the host until bound
+        if(returnSet.layout->dynamicCount)
+        {
+            returnSet.hostData.resize(returnSet.layout->size);
+            returnSet.dynamicBuffers.resize(returnSet.layout->dynamicCount);
+        }
+        else
+        {
+            returnSet.offset = allocateBufferRange(Device::getAlignment(returnSet.layout->size, renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties.descriptorBufferOffsetAlignment), transient);
+        }
+
+        return returnSet;
+    }
+
+    void DescriptorAllocator::freeBufferSet(const DescriptorBufferSet& set)
+    {
+        if(set.offset >= persistentBufferSize) return; //transient or never allocated
+
+        std::lock_guard guard(bufferRangesMutex);
+        freeBufferRange(set.offset, Device::getAlignment(set.layout->size, renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties.descriptorBufferOffsetAlignment));
+    }
+
+    void DescriptorAllocator::freeBufferRange(const VkDeviceSize offset, const VkDeviceSize size)
+    {
+        //insert and merge with neighbouring ranges
+        auto it = freeBufferRanges.emplace(offset, size).first;
+
+        auto next = std::next(it);
+        if(next != freeBufferRanges.end() && it->first + it->second == next->first)
+        {
+            it->second += next->second;
+            freeBufferRanges.erase(next);
+        }
+        if(it != freeBufferRanges.begin())
+        {
+            auto prev = std::prev(it);
+            if(prev->first + prev->second == it->first)
+            {
+                prev->second += it->second;
+                freeBufferRanges.erase(it);
+            }
+        }
+    }
+
+    void DescriptorAllocator::resetTransientBufferRegion()
+    {
+        const uint32_t frameIndex = renderer.getBufferIndex();
+
+        //persistent space lent to the frame is free again now that its work is complete
+        {
+            std::lock_guard guard(bufferRangesMutex);
+            for(const auto& [offset, size] : transientOverflowRanges[frameIndex])
+            {
+                freeBufferRange(offset, size);
+            }
+            transientOverflowRanges[frameIndex].clear();
+        }
+
+        //grow the transient regions to twice what the frame needed if it overflowed. The persistent region is carried over at the same offsets,
+        //and the old buffer is kept alive behind everything submitted so far since the other frame's commands may still reference it
+        const VkDeviceSize requiredSize = transientBufferOffsets[frameIndex].exchange(0);
+        if(requiredSize > transientBufferSize)
+        {
+            transientBufferSize = Device::getAlignment(requiredSize * 2, renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties.descriptorBufferOffsetAlignment);
+
+            Buffer newDescriptorBuffer(renderer, {
+                .size = persistentBufferSize + transientBufferSize * 2,
+                .usageFlags = VK_BUFFER_USAGE_2_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_2_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
+                .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+                .category = MEMORY_DESCRIPTOR
+            });
+
+            VmaAllocationInfo allocationInfo = {};
+            vmaGetAllocationInfo(renderer.getDevice().getAllocator(), newDescriptorBuffer.getAllocation(), &allocationInfo);
+            uint8_t* newMapping = (uint8_t*)allocationInfo.pMappedData;
+            memcpy(newMapping, descriptorBufferMapping, persistentBufferSize);
+            vmaFlushAllocation(renderer.getDevice().getAllocator(), newDescriptorBuffer.getAllocation(), 0, persistentBufferSize);
+
+            for(const auto& [queueType, queuesInFamily] : renderer.getDevice().getQueues())
+            {
+                for(Queue* queue : queuesInFamily.queues)
+                {
+                    descriptorBuffer.addOwner(*queue);
+                }
+            }
+            descriptorBuffer = std::move(newDescriptorBuffer);
+            descriptorBufferMapping = newMapping;
+
+            renderer.getLogger().recordLog(INFO, [&] { return "Grew transient descriptor buffer regions to " + std::to_string(transientBufferSize) + " bytes per frame"; });
+        }
+    }
+
+    VkDeviceSize DescriptorAllocator::getDescriptorSize(const VkDescriptorType type) const
+    {
+        const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties;
+        const bool robust = renderer.getDevice().getGPUFeaturesAndProperties().gpuFeatures.features.robustBufferAccess; //all supported features are enabled
+
+        switch(type)
+        {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                return properties.samplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                return properties.combinedImageSamplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                return properties.sampledImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                return properties.storageImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                return robust ? properties.robustUniformTexelBufferDescriptorSize : properties.uniformTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                return robust ? properties.robustStorageTexelBufferDescriptorSize : properties.storageTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                return robust ? properties.robustUniformBufferDescriptorSize : properties.uniformBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                return robust ? properties.robustStorageBufferDescriptorSize : properties.storageBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                return properties.inputAttachmentDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+                return properties.accelerationStructureDescriptorSize;
+            default:
+                return 0;
+        }
+    }
+
+    void DescriptorAllocator::getBufferDescriptor(void* dst, const VkDescriptorType type, const VkDeviceAddress address, const VkDeviceSize range) const
+    {
+        const VkDescriptorAddressInfoEXT addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+            .pNext = NULL,
+            .address = address,
+            .range = range,
+            .format = VK_FORMAT_UNDEFINED
+        };
+
+        VkDescriptorGetInfoEXT getInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+            .pNext = NULL,
+            .type = type
+        };
+        if(type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) getInfo.data.pUniformBuffer = address ? &addressInfo : NULL;
+        else getInfo.data.pStorageBuffer = address ? &addressInfo : NULL;
+
+        vkGetDescriptorEXT(renderer.getDevice().getDevice(), &getInfo, getDescriptorSize(type), dst);
+    }
+
+    void DescriptorAllocator::getImageDescriptor(void* dst, const VkDescriptorType type, const VkDescriptorImageInfo& info) const
+    {
+        VkDescriptorGetInfoEXT getInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+            .pNext = NULL,
+            .type = type
+        };
+        switch(type)
+        {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+                getInfo.data.pSampler = &info.sampler;
+                break;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                getInfo.data.pCombinedImageSampler = &info;
+                break;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                getInfo.data.pSampledImage = &info;
+                break;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                getInfo.data.pStorageImage = &info;
+                break;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                getInfo.data.pInputAttachmentImage = &info;
+                break;
+            default:
+                return;
+        }
+
+        vkGetDescriptorEXT(renderer.getDevice().getDevice(), &getInfo, getDescriptorSize(type), dst);
+    }
+
+    void DescriptorAllocator::updateBufferSet(DescriptorBufferSet& set, const DescriptorWrites& descriptorWritesInfo, std::unordered_map<uint32_t, uint64_t>* bindingWriteHashes) const
+    {
+        if(!set.layout || (set.offset == UINT64_MAX && set.hostData.empty())) return;
+
+        //descriptors are written straight into the buffer unless the set is kept on the host
+        uint8_t* setData = set.hostData.size() ? set.hostData.data() : descriptorBufferMapping + set.offset;
+        const uint64_t writeSeed = hashValue(handleGeneration.load(std::memory_order_relaxed), writeHashSeed);
+        uint32_t skippedWrites = 0;
+
+        const auto getBinding = [&](const uint32_t binding) -> DescriptorBufferLayout::Binding const*
+        {
+            auto it = set.layout->bindings.find(binding);
+            if(it == set.layout->bindings.end())
+            {
+                renderer.getLogger().recordLog(WARNING, [&] { return "Descriptor write to binding " + std::to_string(binding) + " which isn't in the set layout"; });
+
+                return NULL;
+            }
+            
+            return &it->second;
+        };
+
+        for(const BuffersDescriptorWrites& write : descriptorWritesInfo.bufferWrites)
+        {
+            if(!write.infos.size() || isRedundantWrite(bindingWriteHashes, write.binding, hashWrite(write, writeSeed), skippedWrites)) continue;
+
+            DescriptorBufferLayout::Binding const* binding = getBinding(write.binding);
+            if(!binding) continue;
+
+            for(uint32_t i = 0; i < write.infos.size() && i < binding->count; i++)
+            {
+                const VkDescriptorBufferInfo& info = write.infos[i];
+                if(info.range == VK_WHOLE_SIZE)
+                {
+                    renderer.getLogger().recordLog(WARNING, "VK_WHOLE_SIZE descriptor ranges aren't supported with descriptor buffers; use the buffer size instead");
+                }
+
+                //get address
+                VkDeviceAddress address = 0;
+                if(info.buffer)
+                {
+                    const VkBufferDeviceAddressInfo addressInfo = {
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                        .pNext = NULL,
+                        .buffer = info.buffer
+                    };
+                    address = vkGetBufferDeviceAddress(renderer.getDevice().getDevice(), &addressInfo) + info.offset;
+                }
+
+                const VkDeviceSize location = binding->offset + i * getDescriptorSize(binding->type);
+                getBufferDescriptor(setData + location, binding->type, address, info.range);
+
+                //keep dynamic buffer info so the descriptor can be re-written with offsets at bind time
+                if(binding->dynamicIndex != UINT32_MAX)
+                {
+                    set.dynamicBuffers[binding->dynamicIndex + i] = {
+                        .location = location,
+                        .type = binding->type,
+                        .address = address,
+                        .range = info.range
+                    };
+                }
+            }
+        }
+
+        for(const ImagesDescriptorWrites& write : descriptorWritesInfo.imageWrites)
+        {
+            if(!write.infos.size()) continue;
+
+            DescriptorBufferLayout::Binding const* binding = getBinding(write.binding);
+            if(!binding) continue;
+
+            const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties = renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties;
+            for(uint32_t i = 0; i < write.infos.size() && i < binding->count; i++)
+            {
+                //some implementations split arrays of combined image samplers into an image array followed by a sampler array
+                if(binding->type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && binding->count > 1 && !properties.combinedImageSamplerDescriptorSingleArray)
+                {
+                    getImageDescriptor(setData + binding->offset + i * properties.sampledImageDescriptorSize, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, write.infos[i]);
+                    getImageDescriptor(setData + binding->offset + binding->count * properties.sampledImageDescriptorSize + i * properties.samplerDescriptorSize, VK_DESCRIPTOR_TYPE_SAMPLER, write.infos[i]);
+                }
+                else
+                {
+                    getImageDescriptor(setData + binding->offset + i * getDescriptorSize(binding->type), binding->type, write.infos[i]);
+                }
+            }
+        }
+
+        for(const BufferViewsDescriptorWrites& write : descriptorWritesInfo.bufferViewWrites)
+        {
+            //texel buffers are described by address and format, neither of which can be retrieved from a view
+            if(write.infos.size())
+            {
+                renderer.getLogger().recordLog(WARNING, "Buffer view descriptor writes aren't supported with descriptor buffers");
+            }
+        }
+
+        for(const AccelerationStructureDescriptorWrites& write : descriptorWritesInfo.accelerationStructureWrites)
+        {
+            if(!write.accelerationStructures.size() || isRedundantWrite(bindingWriteHashes, write.binding, hashWrite(write, writeSeed), skippedWrites)) continue;
+
+            DescriptorBufferLayout::Binding const* binding = getBinding(write.binding);
+            if(!binding) continue;
+
+            for(uint32_t i = 0; i < write.accelerationStructures.size() && i < binding->count; i++)
+            {
+                const VkDescriptorGetInfoEXT getInfo = {
+                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+                    .pNext = NULL,
+                    .type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+                    .data = { .accelerationStructure = write.accelerationStructures[i]->getAsDeviceAddress() }
+                };
+                const VkDeviceSize descriptorSize = getDescriptorSize(VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR);
+                vkGetDescriptorEXT(renderer.getDevice().getDevice(), &getInfo, descriptorSize, setData + binding->offset + i * descriptorSize);
+            }
+        }
+
+        //flush if the memory isn't coherent
+        if(set.hostData.empty())
+        {
+            vmaFlushAllocation(renderer.getDevice().getAllocator(), descriptorBuffer.getAllocation(), set.offset, set.layout->size);
+        }
+
+        if(skippedWrites)
+        {
+            renderer.getStatisticsTracker().modifyObjectCounter("Descriptor Writes Skipped", skippedWrites);
+        }
+    }
+
+    void DescriptorAllocator::bindBufferSet(VkCommandBuffer cmdBuffer, const DescriptorBufferSet& set, const DescriptorBinding& binding)
+    {
+        if(!set.layout) return;
+
+        //copy host sets into this frame's transient region with dynamic offsets applied
+        VkDeviceSize offset = set.offset;
+        if(set.hostData.size())
+        {
+            offset = allocateBufferRange(Device::getAlignment(set.layout->size, renderer.getDevice().getGPUFeaturesAndProperties().descriptorBufferProperties.descriptorBufferOffsetAlignment), true);
+            if(offset == UINT64_MAX) return;
+
+            uint8_t* dst = descriptorBufferMapping + offset;
+            memcpy(dst, set.hostData.data(), set.hostData.size());
+            for(uint32_t i = 0; i < set.dynamicBuffers.size(); i++)
+            {
+                const DescriptorBufferSet::DynamicBuffer& dynamicBuffer = set.dynamicBuffers[i];
+                if(!dynamicBuffer.address) continue;
+
+                const VkDeviceSize dynamicOffset = i < binding.dynamicOffsets.size() ? binding.dynamicOffsets[i] : 0;
+                getBufferDescriptor(dst + dynamicBuffer.location, dynamicBuffer.type, dynamicBuffer.address + dynamicOffset, dynamicBuffer.range);
+            }
+
+            vmaFlushAllocation(renderer.getDevice().getAllocator(), descriptorBuffer.getAllocation(), offset, set.layout->size);
+        }
+        if(offset == UINT64_MAX) return;
+
+        //bind by offset; the descriptor buffer itself was bound with the pipeline
+        const uint32_t bufferIndex = 0;
+        vkCmdSetDescriptorBufferOffsetsEXT(cmdBuffer, binding.bindPoint, binding.pipelineLayout, binding.descriptorSetIndex, 1, &bufferIndex, &offset);
+    }
+
+    void DescriptorAllocator::bindDescriptorBuffer(VkCommandBuffer cmdBuffer) const
+    {
+        if(!useDescriptorBuffer) return;
+
+        const VkDescriptorBufferBindingInfoEXT bufferBindingInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+            .pNext = NULL,
+            .address = descriptorBuffer.getBufferDeviceAddress(),
+            .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        };
+        vkCmdBindDescriptorBuffersEXT(cmdBuffer, 1, &bufferBindingInfo);
     }
 
     //----------DESCRIPTOR WRAPPER DEFINITIONS----------//
 
-    ResourceDescriptor::ResourceDescriptor(RenderEngine& renderer, const VkDescriptorSetLayout& layout)
+    ResourceDescriptor::ResourceDescriptor(RenderEngine& renderer, const VkDescriptorSetLayout& layout, const bool transient)
+        :layout(layout),
+        transient(transient),
+        renderer(&renderer)
+    {
+        //transient sets are often replaced before they're used, so they're allocated lazily
+        if(!transient) allocateSet();
+    }
+
+    ResourceDescriptor::ResourceDescriptor(RenderEngine& renderer, const VkDescriptorSetLayout& layout, const DescriptorWrites& writes)
         :layout(layout),
-        set(renderer.getDescriptorAllocator().getDescriptorSet(layout)),
+        cached(true),
         renderer(&renderer)
     {
+        //descriptor buffer sets are cheap enough to allocate and write that sharing them isn't worthwhile
+        DescriptorAllocator& allocator = renderer.getDescriptorAllocator();
+        if(allocator.usesDescriptorBuffer())
+        {
+            bufferSet = allocator.allocateBufferSet(layout, false);
+            allocator.updateBufferSet(bufferSet, writes);
+        }
+        else
+        {
+            set = allocator.getCachedDescriptorSet(layout, writes);
+        }
     }
 
     ResourceDescriptor::~ResourceDescriptor()
     {
-        if(set) renderer->getDescriptorAllocator().freeDescriptorSet(set);
+        //transient sets are released when their pools are reset
+        if(bufferSet.layout && !transient) renderer->getDescriptorAllocator().freeBufferSet(bufferSet);
+        else if(set && cached) renderer->getDescriptorAllocator().releaseCachedDescriptorSet(set);
+        else if(set && !transient) renderer->getDescriptorAllocator().freeDescriptorSet(set);
     }
 
     ResourceDescriptor::ResourceDescriptor(ResourceDescriptor&& other) noexcept
         :layout(other.layout),
         set(other.set),
+        bufferSet(std::move(other.bufferSet)),
+        transient(other.transient),
+        cached(other.cached),
+        bindingWriteHashes(std::move(other.bindingWriteHashes)),
         renderer(other.renderer)
     {
         other.layout = VK_NULL_HANDLE;
         other.set = VK_NULL_HANDLE;
+        other.bufferSet = {};
     }
 
     ResourceDescriptor &ResourceDescriptor::operator=(ResourceDescriptor &&other) noexcept
@@ -309,22 +1049,58 @@ namespace PaperRenderer
         {
             layout = other.layout;
             set = other.set;
+            bufferSet = std::move(other.bufferSet);
+            transient = other.transient;
+            cached = other.cached;
+            bindingWriteHashes = std::move(other.bindingWriteHashes);
             renderer = other.renderer;
 
             other.layout = VK_NULL_HANDLE;
             other.set = VK_NULL_HANDLE;
+            other.bufferSet = {};
         }
 
         return *this;
     }
 
+    void ResourceDescriptor::allocateSet() const
+    {
+        DescriptorAllocator& allocator = renderer->getDescriptorAllocator();
+        if(allocator.usesDescriptorBuffer())
+        {
+            bufferSet = allocator.allocateBufferSet(layout, transient);
+        }
+        else
+        {
+            set = transient ? allocator.getTransientDescriptorSet(layout) : allocator.getDescriptorSet(layout);
+        }
+    }
+
     void ResourceDescriptor::updateDescriptorSet(const DescriptorWrites& writes) const
     {
-        renderer->getDescriptorAllocator().updateDescriptorSet(set, writes);
+        if(cached)
+        {
+            renderer->getLogger().recordLog(WARNING, "Tried to update a cached descriptor set, which is shared and immutable");
+
+            return;
+        }
+
+        if(!set && !bufferSet.layout) allocateSet();
+
+        if(bufferSet.layout) renderer->getDescriptorAllocator().updateBufferSet(bufferSet, writes, &bindingWriteHashes);
+        else renderer->getDescriptorAllocator().updateDescriptorSet(set, writes, &bindingWriteHashes);
     }
 
     void ResourceDescriptor::bindDescriptorSet(VkCommandBuffer cmdBuffer, const DescriptorBinding& binding) const
     {
+        if(!set && !bufferSet.layout) allocateSet();
+
+        if(bufferSet.layout)
+        {
+            renderer->getDescriptorAllocator().bindBufferSet(cmdBuffer, bufferSet, binding);
+            return;
+        }
+
         vkCmdBindDescriptorSets(
             cmdBuffer,
             binding.bindPoint,
@@ -340,26 +1116,40 @@ namespace PaperRenderer
     DescriptorSetLayout::DescriptorSetLayout(RenderEngine& renderer, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
         :renderer(&renderer)
     {
+        //descriptor buffers don't support dynamic descriptors; they're emulated by the allocator
+        const bool descriptorBuffer = renderer.getDescriptorAllocator().usesDescriptorBuffer();
+        std::vector<VkDescriptorSetLayoutBinding> layoutBindings = bindings;
+        if(descriptorBuffer)
+        {
+            for(VkDescriptorSetLayoutBinding& binding : layoutBindings)
+            {
+                if(binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                if(binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+        }
+
         const VkDescriptorSetLayoutCreateInfo descriptorLayoutInfo = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
             .pNext = NULL,
-            .flags = 0,
-            .bindingCount = (uint32_t)bindings.size(),
-            .pBindings = bindings.data()
+            .flags = descriptorBuffer ? (VkDescriptorSetLayoutCreateFlags)VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0,
+            .bindingCount = (uint32_t)layoutBindings.size(),
+            .pBindings = layoutBindings.data()
         };
         
         VkResult result = vkCreateDescriptorSetLayout(renderer.getDevice().getDevice(), &descriptorLayoutInfo, nullptr, &setLayout);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create descriptor set layout"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create descriptor set layout");
+        }
+        else if(descriptorBuffer)
+        {
+            renderer.getDescriptorAllocator().registerBufferLayout(setLayout, bindings);
         }
     }
 
     DescriptorSetLayout::~DescriptorSetLayout()
     {
+        if(setLayout && renderer->getDescriptorAllocator().usesDescriptorBuffer()) renderer->getDescriptorAllocator().unregisterBufferLayout(setLayout);
         if(setLayout) vkDestroyDescriptorSetLayout(renderer->getDevice().getDevice(), setLayout, nullptr);
     }
 
@@ -2,8 +2,12 @@
 #include "VulkanResources.h"
 
 #include <unordered_map>
+#include <map>
 #include <thread>
 #include <mutex>
+#include <deque>
+#include <array>
+#include <atomic>
 
 namespace PaperRenderer
 {
@@ -49,7 +53,42 @@ namespace PaperRenderer
         VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
         VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
         uint32_t descriptorSetIndex = 0;
-        std::vector<uint32_t> dynamicOffsets = {};
+        SmallVector<uint32_t, 4> dynamicOffsets = {};
+    };
+
+    //----------DESCRIPTOR BUFFER STRUCTS----------//
+
+    //set layout as laid out in a descriptor buffer
+    struct DescriptorBufferLayout
+    {
+        struct Binding
+        {
+            VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM; //dynamic types are stored as their non dynamic counterparts
+            uint32_t count = 0;
+            VkDeviceSize offset = 0; //relative to the start of the set
+            uint32_t dynamicIndex = UINT32_MAX; //index of the binding's first dynamic offset if it's a dynamic binding
+        };
+        std::unordered_map<uint32_t, Binding> bindings = {};
+        VkDeviceSize size = 0;
+        uint32_t dynamicCount = 0;
+    };
+
+    //set allocated from a descriptor buffer
+    struct DescriptorBufferSet
+    {
+        DescriptorBufferLayout const* layout = NULL;
+        VkDeviceSize offset = UINT64_MAX; //into the descriptor buffer
+        
+        //descriptor buffers don't have dynamic descriptors, so sets with dynamic bindings are kept on the host and copied into transient memory with the offsets applied when bound
+        struct DynamicBuffer
+        {
+            VkDeviceSize location = 0; //relative to the start of the set
+            VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+            VkDeviceAddress address = 0;
+            VkDeviceSize range = 0;
+        };
+        std::vector<uint8_t> hostData = {};
+        std::vector<DynamicBuffer> dynamicBuffers = {}; //ordered like dynamic offsets
     };
 
     //----------DESCRIPTOR ALLOCATOR DECLARATIONS----------//
@@ -65,20 +104,98 @@ namespace PaperRenderer
         };
         DescriptorPoolData descriptorPoolData = {}; //thread safe command pool wrapper
         std::unordered_map<VkDescriptorSet, uint32_t> allocatedSetPoolIndices = {};
+
+        //transient sets come from linear per-thread, per-frame pools that are reset wholesale instead of freeing sets one at a time
+        struct TransientPoolData
+        {
+            std::vector<VkDescriptorPool> descriptorPools = {};
+            uint32_t currentPoolIndex = 0;
+        };
+        struct ThreadTransientPools
+        {
+            std::array<TransientPoolData, 2> framePools = {}; //double buffered like command pools
+        };
+        std::deque<ThreadTransientPools> threadTransientPools = {}; //deque keeps references stable as threads register
+        std::mutex transientRegistrationMutex; //only locked on a thread's first transient allocation and on reset
+        const uint64_t allocatorID;
+
+        ThreadTransientPools& getThreadTransientPools();
+
+        //bumped whenever a buffer or acceleration structure handle is created, since it may reuse the handle of a destroyed one. It seeds the
+        //per-binding write hashes, so a write naming a reused handle is never mistaken for the last one
+        static inline std::atomic<uint64_t> handleGeneration = 0;
+
+        //content addressed set cache; identical layout and writes combinations share one set
+        struct CachedSet
+        {
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            uint32_t references = 0;
+            std::vector<uint64_t> content = {}; //layout and flattened writes; compared on a hash hit
+        };
+        std::unordered_multimap<uint64_t, CachedSet> cachedSets = {}; //keyed by content hash
+        std::unordered_map<VkDescriptorSet, uint64_t> cachedSetKeys = {};
+        std::mutex setCacheMutex;
+
+        //descriptor buffer backend (VK_EXT_descriptor_buffer); replaces pools when supported. The first region holds persistent sets, followed by a linear region for each frame
+        static constexpr VkDeviceSize persistentBufferSize = 4194304; //4MiB
+        VkDeviceSize transientBufferSize = 2097152; //per frame; grown on a frame's reset when it overflowed
+        const bool useDescriptorBuffer;
+        Buffer descriptorBuffer;
+        uint8_t* descriptorBufferMapping = NULL;
+        std::map<VkDeviceSize, VkDeviceSize> freeBufferRanges = {}; //offset, size; persistent region only
+        std::mutex bufferRangesMutex;
+        std::array<std::atomic<VkDeviceSize>, 2> transientBufferOffsets = {}; //keeps counting past the region size so overflow can be measured
+        std::array<std::vector<std::pair<VkDeviceSize, VkDeviceSize>>, 2> transientOverflowRanges = {}; //offset, size; persistent ranges lent to a frame that overflowed its region
+        std::unordered_map<VkDescriptorSetLayout, DescriptorBufferLayout> bufferLayouts = {};
+        std::mutex bufferLayoutsMutex;
+
+        VkDeviceSize allocateBufferRange(const VkDeviceSize size, const bool transient);
+        void freeBufferRange(const VkDeviceSize offset, const VkDeviceSize size); //bufferRangesMutex must be locked
+        void resetTransientBufferRegion();
+        VkDeviceSize getDescriptorSize(const VkDescriptorType type) const;
+        void getBufferDescriptor(void* dst, const VkDescriptorType type, const VkDeviceAddress address, const VkDeviceSize range) const;
+        void getImageDescriptor(void* dst, const VkDescriptorType type, const VkDescriptorImageInfo& info) const;
         
         class RenderEngine& renderer;
 
-        VkDescriptorPool allocateDescriptorPool() const;
+        VkDescriptorPool allocateDescriptorPool(const VkDescriptorPoolCreateFlags flags) const;
 
     public:
         DescriptorAllocator(class RenderEngine& renderer);
         ~DescriptorAllocator();
         DescriptorAllocator(const DescriptorAllocator&) = delete;
 
-        void updateDescriptorSet(VkDescriptorSet set, const DescriptorWrites& descriptorWritesInfo) const;
+        //bindingWriteHashes is an optional per-set cache of the last write to each binding; writes identical to the cached ones are skipped. Only buffer
+        //and acceleration structure writes are filtered, since image and texel buffer views are often created outside of the renderer
+        void updateDescriptorSet(VkDescriptorSet set, const DescriptorWrites& descriptorWritesInfo, std::unordered_map<uint32_t, uint64_t>* bindingWriteHashes = NULL) const;
         
         VkDescriptorSet getDescriptorSet(VkDescriptorSetLayout setLayout);
         void freeDescriptorSet(VkDescriptorSet set);
+
+        //Allocates a set that's only valid until the current frame's pools are reset. Doesn't lock after a thread's first call. Never free these sets
+        VkDescriptorSet getTransientDescriptorSet(VkDescriptorSetLayout setLayout);
+        //Resets the transient pools of the current frame index; done in RenderEngine::beginFrame() like command pools, so the frame's work must be complete
+        void resetTransientPools();
+
+        //Returns a shared set for the layout and writes, only allocating and writing one if no identical combination exists. The set must not be updated after. Thread safe
+        VkDescriptorSet getCachedDescriptorSet(VkDescriptorSetLayout setLayout, const DescriptorWrites& writes);
+        //Releases a reference to a set from getCachedDescriptorSet(); the set is freed once no references remain. Thread safe
+        void releaseCachedDescriptorSet(VkDescriptorSet set);
+
+        //called by Buffer and AS when they create a handle
+        static void notifyHandleCreated() { handleGeneration.fetch_add(1, std::memory_order_relaxed); }
+
+        //Descriptor buffer backend. Layouts are registered by DescriptorSetLayout
+        bool usesDescriptorBuffer() const { return useDescriptorBuffer; }
+        void registerBufferLayout(VkDescriptorSetLayout setLayout, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        void unregisterBufferLayout(VkDescriptorSetLayout setLayout);
+        //transient sets are allocated without locking and are valid for the current frame; they're never freed
+        DescriptorBufferSet allocateBufferSet(VkDescriptorSetLayout setLayout, const bool transient);
+        void freeBufferSet(const DescriptorBufferSet& set);
+        void updateBufferSet(DescriptorBufferSet& set, const DescriptorWrites& descriptorWritesInfo, std::unordered_map<uint32_t, uint64_t>* bindingWriteHashes = NULL) const;
+        //Binding the descriptor buffer invalidates every set offset, so it's bound once with each pipeline, before any of its sets. No-op without the descriptor buffer backend
+        void bindDescriptorBuffer(VkCommandBuffer cmdBuffer) const;
+        void bindBufferSet(VkCommandBuffer cmdBuffer, const DescriptorBufferSet& set, const DescriptorBinding& binding);
     };
 
     //----------RAII DESCRIPTOR WRAPPERS----------//
@@ -93,22 +210,31 @@ namespace PaperRenderer
     {
     private:
         VkDescriptorSetLayout layout;
-        VkDescriptorSet set;
+        mutable VkDescriptorSet set = VK_NULL_HANDLE;
+        mutable DescriptorBufferSet bufferSet = {}; //used instead of set with the descriptor buffer backend
+        bool transient = false;
+        bool cached = false;
+        mutable std::unordered_map<uint32_t, uint64_t> bindingWriteHashes = {}; //redundant write filtering; reset by handle creation, see DescriptorAllocator::handleGeneration
 
         class RenderEngine* renderer;
 
+        void allocateSet() const;
+
     public:
-        ResourceDescriptor(class RenderEngine& renderer, const VkDescriptorSetLayout& layout);
+        //transient descriptors are allocated from the current frame's linear pools on their first update or bind, and must not be used after that frame
+        ResourceDescriptor(class RenderEngine& renderer, const VkDescriptorSetLayout& layout, const bool transient=false);
+        //cached descriptors share an immutable set with every other descriptor of the same layout and writes; updateDescriptorSet() can't be used
+        ResourceDescriptor(class RenderEngine& renderer, const VkDescriptorSetLayout& layout, const DescriptorWrites& writes);
         ~ResourceDescriptor();
         ResourceDescriptor(const ResourceDescriptor&) = delete;
         ResourceDescriptor(ResourceDescriptor&& other) noexcept;
         ResourceDescriptor& operator=(ResourceDescriptor&& other) noexcept;
 
-        void updateDescriptorSet(const DescriptorWrites& writes) const;
+        void updateDescriptorSet(const DescriptorWrites& writes) const; //bindings whose contents match their last write are skipped
         void bindDescriptorSet(VkCommandBuffer cmdBuffer, const DescriptorBinding& binding) const;
 
         const VkDescriptorSetLayout& getLayout() const { return layout; }
-        const VkDescriptorSet& getDescriptorSet() const { return set; }
+        const VkDescriptorSet& getDescriptorSet() const { return set; } //VK_NULL_HANDLE with the descriptor buffer backend, or for transient descriptors that weren't used yet
     };
 
     class DescriptorSetLayout
@@ -8,16 +8,15 @@ namespace PaperRenderer
 {
     Device::Device(RenderEngine& renderer, const DeviceInstanceInfo& instanceInfo)
         :devicepNext(instanceInfo.devicepNext),
+        preferDescriptorBuffer(instanceInfo.preferDescriptorBuffer),
+        headless(instanceInfo.headless),
         renderer(renderer)
     {
         if(volkInitialize() != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to initialize Volk (vulkan function loader)"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to initialize Volk (vulkan function loader)");
         }
-        glfwInit();
+        if(!headless) glfwInit();
         createContext(instanceInfo);
         findGPU(instanceInfo.extraDeviceExtensions);
     }
@@ -31,10 +30,7 @@ namespace PaperRenderer
         vkDestroyInstance(instance, nullptr);
         
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Device destructor initialized"
-        });
+        renderer.getLogger().recordLog(INFO, "Device destructor initialized");
     }
 
     void Device::createContext(const DeviceInstanceInfo& instanceData)
@@ -47,13 +43,21 @@ namespace PaperRenderer
             VK_EXT_DEBUG_UTILS_EXTENSION_NAME
         };
 
-        //glfw extensions
-        unsigned int glfwExtensionCount = 0;
-        glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        std::vector<const char*> glfwExtensions(glfwExtensionCount);
-        for(int i = 0; i < glfwExtensionCount; i++)
+        //glfw extensions (or the headless surface, which needs no window system)
+        std::vector<const char*> glfwExtensions = {};
+        if(headless)
         {
-            glfwExtensions[i] = glfwGetRequiredInstanceExtensions(&glfwExtensionCount)[i];
+            glfwExtensions = { VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME };
+        }
+        else
+        {
+            unsigned int glfwExtensionCount = 0;
+            glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            glfwExtensions.resize(glfwExtensionCount);
+            for(int i = 0; i < glfwExtensionCount; i++)
+            {
+                glfwExtensions[i] = glfwGetRequiredInstanceExtensions(&glfwExtensionCount)[i];
+            }
         }
 
         //insert glfw and extra extensions
@@ -63,10 +67,7 @@ namespace PaperRenderer
         //log all extension names
         for(const char* extension : extensionNames)
         {
-            renderer.getLogger().recordLog({
-                .type = INFO,
-                .text = "Using instance extension: " + std::string(extension)
-            });
+            renderer.getLogger().recordLog(INFO, [&] { return "Using instance extension: " + std::string(extension); });
         }
         
         //layers
@@ -99,10 +100,7 @@ namespace PaperRenderer
         VkResult result = vkCreateInstance(&instanceInfo, nullptr, &instance);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create Vulkan instance"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create Vulkan instance");
         }
         volkLoadInstance(instance);
     }
@@ -121,9 +119,13 @@ namespace PaperRenderer
         for(VkPhysicalDevice physicalDevice : physicalDevices)
         {
             //get physical device properties
+            VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT,
+                .pNext = NULL
+            };
             VkPhysicalDeviceAccelerationStructurePropertiesKHR asProperties = {
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR,
-                .pNext = NULL
+                .pNext = &descriptorBufferProperties
             };
             VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtPipelineProperties = {
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR,
@@ -164,13 +166,19 @@ namespace PaperRenderer
             bool hasRayQuery = false;
             bool hasMaintFeatures = false;
             bool hasHostImageCopy = false;
+            bool hasDescriptorBuffer = false;
+            bool hasCalibratedTimestamps = false;
+            bool hasMemoryBudget = false;
             extensions.insert(extensions.end(), {
                 VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
                 VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
                 VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
                 VK_KHR_RAY_QUERY_EXTENSION_NAME,
                 VK_KHR_RAY_TRACING_MAINTENANCE_1_EXTENSION_NAME,
-                VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME
+                VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME,
+                VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME,
+                VK_KHR_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+                VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
             });
 
             //check extensions
@@ -196,6 +204,9 @@ namespace PaperRenderer
                 hasRayQuery = hasRayQuery || std::string(properties.extensionName).find(VK_KHR_RAY_QUERY_EXTENSION_NAME) != std::string::npos;
                 hasMaintFeatures = hasMaintFeatures || std::string(properties.extensionName).find(VK_KHR_RAY_TRACING_MAINTENANCE_1_EXTENSION_NAME) != std::string::npos;
                 hasHostImageCopy = hasHostImageCopy || std::string(properties.extensionName).find(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) != std::string::npos;
+                hasDescriptorBuffer = hasDescriptorBuffer || std::string(properties.extensionName).find(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) != std::string::npos;
+                hasCalibratedTimestamps = hasCalibratedTimestamps || std::string(properties.extensionName).find(VK_KHR_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) != std::string::npos;
+                hasMemoryBudget = hasMemoryBudget || std::string(properties.extensionName).find(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != std::string::npos;
             }
 
             const auto setGPUData = [&]()
@@ -212,8 +223,10 @@ namespace PaperRenderer
                     .gpuProperties = properties,
                     .asProperties = asProperties,
                     .rtPipelineProperties = rtPipelineProperties,
+                    .descriptorBufferProperties = descriptorBufferProperties,
                     .enabledExtensions = std::vector<const char*>(enabledExtensions.begin(), enabledExtensions.end()),
                     .rtSupport = hasDeferredOps && hasAccelStructure && hasRTPipeline && hasRayQuery && hasMaintFeatures,
+                    .descriptorBuffer = hasDescriptorBuffer && preferDescriptorBuffer, //feature support is checked on device creation
                     .reBAR = [physicalDevice] {
                         VkPhysicalDeviceMemoryProperties2 memoryProperties = {
                             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2
@@ -248,7 +261,9 @@ namespace PaperRenderer
                         
                         return reBAR;
                     } (),
-                    .hostImageCopy = hasHostImageCopy
+                    .hostImageCopy = hasHostImageCopy,
+                    .calibratedTimestamps = hasCalibratedTimestamps,
+                    .memoryBudget = hasMemoryBudget
                 };
             };
             
@@ -268,26 +283,17 @@ namespace PaperRenderer
         //log warning if requested extension sizes dont match
         if(featuresAndProperties.enabledExtensions.size() != extensions.size())
         {
-            renderer.getLogger().recordLog({
-                .type = WARNING,
-                .text = "Not all requested extensions were found"
-            });
+            renderer.getLogger().recordLog(WARNING, "Not all requested extensions were found");
         }
 
         //log error if no suitable GPU was found
         if(!deviceFound)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Couldn't find suitable GPU"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Couldn't find suitable GPU");
         }
 
         //record log
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = std::string("Using GPU: ") + featuresAndProperties.gpuProperties.properties.deviceName
-        });
+        renderer.getLogger().recordLog(INFO, [&] { return std::string("Using GPU: ") + featuresAndProperties.gpuProperties.properties.deviceName; });
     }
 
     void Device::findQueueFamilies(uint32_t& queueFamilyCount, std::vector<VkQueueFamilyProperties>& queueFamiliesProperties)
@@ -327,10 +333,7 @@ namespace PaperRenderer
         //now fill in any queues that need to be filled
         if(!queues.count(QueueType::GRAPHICS))
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "No suitable graphics queue family from selected GPU"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "No suitable graphics queue family from selected GPU");
             throw std::runtime_error("No suitable graphics queue family from selected GPU"); //error if no graphics
         }
         if(!queues.count(QueueType::COMPUTE))
@@ -355,6 +358,12 @@ namespace PaperRenderer
                 }
             }
         }
+
+        //GPU timers are only recorded on families that support timestamps
+        for(auto& [queueType, queuesInFamily] : queues)
+        {
+            queuesInFamily.timestampValidBits = queueFamiliesProperties.at(queuesInFamily.queueFamilyIndex).timestampValidBits;
+        }
     }
 
     void Device::createQueues(std::unordered_map<uint32_t, VkDeviceQueueCreateInfo>& queuesCreationInfo,
@@ -415,10 +424,7 @@ namespace PaperRenderer
             };
             
             //record log
-            renderer.getLogger().recordLog({
-                .type = INFO,
-                .text = queueTypeToString(queueType) + std::string("queue group using ") + std::to_string(queuesInFamily.queues.size()) + " Queues on queue family index " + std::to_string(queuesInFamily.queueFamilyIndex)
-            });
+            renderer.getLogger().recordLog(INFO, [&] { return queueTypeToString(queueType) + std::string("queue group using ") + std::to_string(queuesInFamily.queues.size()) + " Queues on queue family index " + std::to_string(queuesInFamily.queueFamilyIndex); });
         }
     }
 
@@ -427,11 +433,8 @@ namespace PaperRenderer
         //get renderer handle from pUserData
         RenderEngine& renderer = *((RenderEngine*)pUserData);
 
-        //get message
-        std::string debugMessage = std::to_string(pCallbackData->messageIdNumber) + pCallbackData->pMessageIdName + pCallbackData->pMessage;
-
         //get log type
-        LogType type;
+        LogType type = INFO;
         if(messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
         {
             type = INFO;
@@ -445,11 +448,8 @@ namespace PaperRenderer
             type = CRITICAL_ERROR;
         }
 
-        //log error
-        renderer.getLogger().recordLog({
-            .type = type,
-            .text = debugMessage
-        });
+        //log error; the message is only built if the log isn't filtered out
+        renderer.getLogger().recordLog(type, [&] { return std::to_string(pCallbackData->messageIdNumber) + pCallbackData->pMessageIdName + pCallbackData->pMessage; });
 
         return VK_FALSE;
     }
@@ -476,18 +476,12 @@ namespace PaperRenderer
         //----------LOGICAL DEVICE CREATION----------//
 
         //log RT support
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = featuresAndProperties.rtSupport ? "RT supported" : "RT not supported"
-        });
+        renderer.getLogger().recordLog(INFO, featuresAndProperties.rtSupport ? "RT supported" : "RT not supported");
 
         //log all extension names
         for(const char* extension : featuresAndProperties.enabledExtensions)
         {
-            renderer.getLogger().recordLog({
-                .type = INFO,
-                .text = "Using device extension: " + std::string(extension)
-            });
+            renderer.getLogger().recordLog(INFO, [&] { return "Using device extension: " + std::string(extension); });
         }
         
         //RT features
@@ -521,10 +515,17 @@ namespace PaperRenderer
             .rayTracingValidation = (VkBool32)featuresAndProperties.rtSupport
         };
 
+        //descriptor buffer features
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+            .pNext = &rtMaintFeatures,
+            .descriptorBuffer = (VkBool32)featuresAndProperties.descriptorBuffer
+        };
+
         //Core features
         VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features = {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
-            .pNext = &rtMaintFeatures,
+            .pNext = &descriptorBufferFeatures,
             .extendedDynamicState3RasterizationSamples = VK_TRUE
         };
 
@@ -537,6 +538,7 @@ namespace PaperRenderer
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = &vulkan11Features,
             .scalarBlockLayout = VK_TRUE,
+            .hostQueryReset = VK_TRUE,
             .timelineSemaphore = VK_TRUE,
             .bufferDeviceAddress = VK_TRUE
         };
@@ -564,6 +566,13 @@ namespace PaperRenderer
 
         vkGetPhysicalDeviceFeatures2(GPU, &features2);
 
+        //optional RT features
+        featuresAndProperties.asIndirectBuild = featuresAndProperties.rtSupport && accelerationFeatures.accelerationStructureIndirectBuild;
+
+        //optional descriptor buffer feature
+        featuresAndProperties.descriptorBuffer = featuresAndProperties.descriptorBuffer && descriptorBufferFeatures.descriptorBuffer;
+        renderer.getLogger().recordLog(INFO, featuresAndProperties.descriptorBuffer ? "Using descriptor buffers" : "Using descriptor pools");
+
         const VkDeviceCreateInfo deviceCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
             .pNext = &features2,
@@ -580,17 +589,11 @@ namespace PaperRenderer
         {
             if(result == VK_ERROR_EXTENSION_NOT_PRESENT)
             {
-                renderer.getLogger().recordLog({
-                    .type = WARNING,
-                    .text = "One or more device extensions aren't present"
-                });
+                renderer.getLogger().recordLog(WARNING, "One or more device extensions aren't present");
             }
             else
             {
-                renderer.getLogger().recordLog({
-                    .type = CRITICAL_ERROR,
-                    .text = "Device creation returned an error that's probably unrelated to missing extensions"
-                });
+                renderer.getLogger().recordLog(CRITICAL_ERROR, "Device creation returned an error that's probably unrelated to missing extensions");
             }
         }
 
@@ -608,10 +611,7 @@ namespace PaperRenderer
         result = vkCreateDebugUtilsMessengerEXT(instance, &debugUtilsMessengerInfo, nullptr, &debugUtilsMessenger);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = WARNING,
-                .text = "Failed to create debug messenger"
-            });
+            renderer.getLogger().recordLog(WARNING, "Failed to create debug messenger");
         }
 
         //volk
@@ -645,7 +645,8 @@ namespace PaperRenderer
             VMA_ALLOCATOR_CREATE_KHR_BIND_MEMORY2_BIT |
             VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT |
             VMA_ALLOCATOR_CREATE_KHR_MAINTENANCE4_BIT |
-            VMA_ALLOCATOR_CREATE_KHR_MAINTENANCE5_BIT;
+            VMA_ALLOCATOR_CREATE_KHR_MAINTENANCE5_BIT |
+            (featuresAndProperties.memoryBudget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0);
 
         const VmaAllocatorCreateInfo allocatorCreateInfo = {
             .flags = vmaFlags,
@@ -669,10 +670,7 @@ namespace PaperRenderer
         commands = std::make_unique<Commands>(renderer, &queues);
 
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Device creation finished"
-        });
+        renderer.getLogger().recordLog(INFO, "Device creation finished");
     }
 
     QueueFamiliesIndices Device::getQueueFamiliesIndices() const
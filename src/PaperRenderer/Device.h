@@ -25,6 +25,8 @@ namespace PaperRenderer
         std::vector<const char*> extraInstanceExtensions = {};
         std::vector<const char*> extraDeviceExtensions = {};
         void* devicepNext = NULL;
+        bool preferDescriptorBuffer = true; //ResourceDescriptor uses VK_EXT_descriptor_buffer instead of descriptor pools when supported
+        bool headless = false; //no window or GLFW; presents to a VK_EXT_headless_surface instead (benchmarks, CI on software ICDs)
     };
 
     struct DeviceFeaturesAndProperties
@@ -33,16 +35,23 @@ namespace PaperRenderer
         VkPhysicalDeviceProperties2 gpuProperties = {};
         VkPhysicalDeviceAccelerationStructurePropertiesKHR asProperties = {};
         VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtPipelineProperties = {};
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {};
         std::vector<const char*> enabledExtensions = {};
         bool rtSupport = false;
+        bool asIndirectBuild = false; //accelerationStructureIndirectBuild feature
+        bool descriptorBuffer = false; //descriptorBuffer feature; only set if preferred in DeviceInstanceInfo
         bool reBAR = false;
         bool hostImageCopy = false;
+        bool calibratedTimestamps = false; //used to place GPU timings on the CPU timeline in traces
+        bool memoryBudget = false; //VMA reports exact heap usage and budgets
     };
 
     class Device
     {
     private:
         void* devicepNext;
+        const bool preferDescriptorBuffer;
+        const bool headless;
         VkInstance instance = VK_NULL_HANDLE;
         VkPhysicalDevice GPU = VK_NULL_HANDLE;
         VkDevice device = VK_NULL_HANDLE;
@@ -83,6 +92,7 @@ namespace PaperRenderer
         const VkSurfaceKHR& getSurface() const { return surface; }
         const VkInstance& getInstance() const { return instance; }
         const VkPhysicalDevice& getGPU() const { return GPU; }
+        bool isHeadless() const { return headless; }
         const DeviceFeaturesAndProperties& getGPUFeaturesAndProperties() const { return featuresAndProperties; }
         std::unordered_map<QueueType, QueuesInFamily>& getQueues() { return queues; }
         Commands& getCommands() { return *commands; }
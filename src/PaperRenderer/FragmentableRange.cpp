@@ -0,0 +1,241 @@
+#include "FragmentableRange.h"
+
+#include <algorithm>
+
+namespace PaperRenderer
+{
+    //----------FRAGMENTABLE RANGE DEFINITIONS----------//
+
+    FragmentableRange::FragmentableRange(const uint64_t size, const uint64_t minAlignment)
+        :allocator(size, minAlignment),
+        minAlignment(minAlignment)
+    {
+    }
+
+    FragmentableRange::~FragmentableRange()
+    {
+    }
+
+    FragmentableRange::FragmentableRange(FragmentableRange&& other) noexcept
+        :allocator(std::move(other.allocator)),
+        failedWriteSize(other.failedWriteSize),
+        minAlignment(other.minAlignment),
+        pendingMoves(std::move(other.pendingMoves)),
+        pendingFrees(std::move(other.pendingFrees))
+    {
+        other.allocator = TLSFAllocator(0, other.minAlignment);
+        other.failedWriteSize = 0;
+        other.pendingMoves.clear();
+        other.pendingFrees.clear();
+    }
+
+    FragmentableRange& FragmentableRange::operator=(FragmentableRange&& other) noexcept
+    {
+        if(this != &other)
+        {
+            allocator = std::move(other.allocator);
+            failedWriteSize = other.failedWriteSize;
+            minAlignment = other.minAlignment;
+            pendingMoves = std::move(other.pendingMoves);
+            pendingFrees = std::move(other.pendingFrees);
+
+            other.allocator = TLSFAllocator(0, other.minAlignment);
+            other.failedWriteSize = 0;
+            other.pendingMoves.clear();
+            other.pendingFrees.clear();
+        }
+
+        return *this;
+    }
+
+    uint64_t FragmentableRange::allocate(uint64_t& size, RangeCompaction& compaction)
+    {
+        //pad size
+        size = minAlignment ? ((size + minAlignment - 1) / minAlignment) * minAlignment : size;
+
+        //allocate
+        uint64_t location = allocator.allocate(size);
+        if(location == UINT64_MAX)
+        {
+            //free space may be too fragmented for the allocation, in which case compaction makes room for it
+            if(allocator.getFreeSize() >= size)
+            {
+                compaction = compact();
+                if(compaction.compacted) location = allocator.allocate(size);
+            }
+
+            //otherwise there's no more available memory
+            if(location == UINT64_MAX)
+            {
+                failedWriteSize += size;
+            }
+        }
+
+        return location;
+    }
+
+    void FragmentableRange::free(const uint64_t offset)
+    {
+        for(auto move = pendingMoves.begin(); move != pendingMoves.end(); move++)
+        {
+            if(move->srcLocation == offset)
+            {
+                //the move's copy may still be writing to its new location
+                pendingFrees.push_back(move->dstLocation);
+                pendingMoves.erase(move);
+                break;
+            }
+        }
+
+        //the allocator knows the allocation's padded size and merges it with neighboring free space
+        allocator.free(offset);
+    }
+
+    RangeCompaction FragmentableRange::compact()
+    {
+        RangeCompaction compaction = {};
+
+        //compaction moves everything anyways
+        cancelDefragmentation();
+
+        //the allocator packs its allocations and returns the gaps that were between them, sorted by location
+        const uint64_t usedEnd = allocator.getUsedEnd();
+        const std::vector<TLSFRange> memoryFragments = allocator.compact();
+        compaction.compacted = memoryFragments.size();
+
+        //shift data into memory fragment gaps
+        uint64_t sizeReduction = 0;
+        for(uint32_t i = 0; i < memoryFragments.size(); i++)
+        {
+            //get current and next chunks
+            const TLSFRange chunk = memoryFragments[i];
+            const TLSFRange nextChunk = i < memoryFragments.size() - 1 ? memoryFragments[i + 1] : TLSFRange({ usedEnd, 0 });
+
+            //get important sizes
+            const uint64_t totalCopySize = nextChunk.offset - std::min(nextChunk.offset, (chunk.offset + chunk.size)); //copy the size of this chunks location + size all the way to the next chunks location
+            const uint64_t srcOffset = chunk.offset + chunk.size; //copy past the fragmentation gap
+            const uint64_t dstOffset = chunk.offset - sizeReduction; //copy into the gap
+
+            //increment size reduction
+            sizeReduction += chunk.size;
+
+            if(totalCopySize)
+            {
+                //copies can't be larger than the distance data moves, otherwise source and destination overlap
+                for(uint64_t copied = 0; copied < totalCopySize; copied += sizeReduction)
+                {
+                    compaction.copies.push_back({
+                        .srcOffset = srcOffset + copied,
+                        .dstOffset = dstOffset + copied,
+                        .size = std::min(totalCopySize - copied, sizeReduction)
+                    });
+                }
+
+                //create compaction result
+                compaction.results.push_back({
+                    .location = chunk.offset,
+                    .shiftSize = chunk.size,
+                    .totalShiftSize = sizeReduction
+                });
+            }
+        }
+
+        return compaction;
+    }
+
+    void FragmentableRange::copyAllocations(const FragmentableRange& other)
+    {
+        const uint64_t size = allocator.getSize();
+        allocator = other.allocator;
+        allocator.resize(size);
+    }
+
+    std::vector<RangeCopy> FragmentableRange::beginDefragmentation(const uint64_t maxMoveSize)
+    {
+        //start a new pass only once the last one is done, and if there's free space below the end of the used range
+        std::vector<RangeCopy> copies = {};
+        if(pendingMoves.size() || pendingFrees.size() || allocator.getUsedEnd() == allocator.getUsedSize())
+        {
+            return copies;
+        }
+
+        //move allocations from the end into the lowest fitting free space below them; the new locations act as shadow copies until published
+        for(const TLSFRange& allocationRange : allocator.getTrailingAllocations(maxMoveSize))
+        {
+            const uint64_t dstLocation = allocator.allocateBelow(allocationRange.size, allocationRange.offset);
+            if(dstLocation == UINT64_MAX) continue;
+
+            pendingMoves.push_back({
+                .srcLocation = allocationRange.offset,
+                .dstLocation = dstLocation,
+                .size = allocationRange.size
+            });
+            copies.push_back({
+                .srcOffset = allocationRange.offset,
+                .dstOffset = dstLocation,
+                .size = allocationRange.size
+            });
+        }
+
+        return copies;
+    }
+
+    std::vector<DefragmentationMove> FragmentableRange::publishDefragmentation()
+    {
+        for(const DefragmentationMove& move : pendingMoves)
+        {
+            pendingFrees.push_back(move.srcLocation);
+        }
+
+        std::vector<DefragmentationMove> moves = std::move(pendingMoves);
+        pendingMoves.clear();
+        std::sort(moves.begin(), moves.end(), [](const DefragmentationMove& a, const DefragmentationMove& b) { return a.srcLocation < b.srcLocation; });
+
+        return moves;
+    }
+
+    void FragmentableRange::releasePendingFrees()
+    {
+        for(const uint64_t location : pendingFrees)
+        {
+            allocator.free(location);
+        }
+        pendingFrees.clear();
+    }
+
+    void FragmentableRange::cancelDefragmentation()
+    {
+        //unpublished moves' old locations are still the valid ones
+        for(const DefragmentationMove& move : pendingMoves)
+        {
+            allocator.free(move.dstLocation);
+        }
+        pendingMoves.clear();
+
+        releasePendingFrees();
+    }
+
+    uint64_t FragmentableRange::getCompactedLocation(const std::vector<CompactionResult>& results, const uint64_t location)
+    {
+        //data is shifted by every result located before it
+        const auto nextResult = std::lower_bound(results.begin(), results.end(), location, [](const CompactionResult& result, const uint64_t location) { return result.location < location; });
+
+        return nextResult != results.begin() ? location - std::prev(nextResult)->totalShiftSize : location;
+    }
+
+    uint64_t FragmentableRange::getMovedLocation(const std::vector<DefragmentationMove>& moves, const uint64_t location)
+    {
+        //last move starting at or before the location
+        const auto nextMove = std::upper_bound(moves.begin(), moves.end(), location, [](const uint64_t location, const DefragmentationMove& move) { return location < move.srcLocation; });
+        if(nextMove != moves.begin())
+        {
+            const DefragmentationMove& move = *std::prev(nextMove);
+            if(location < move.srcLocation + move.size)
+            {
+                return move.dstLocation + (location - move.srcLocation);
+            }
+        }
+
+        return location;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "TLSFAllocator.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace PaperRenderer
+{
+    //----------FRAGMENTABLE RANGE DECLARATIONS----------//
+
+    /// @brief location represents the location where all data after is to be shifted down by shiftSize. totalShiftSize is the sum of this and all previous results' shiftSize
+    struct CompactionResult
+    {
+        uint64_t location;
+        uint64_t shiftSize;
+        uint64_t totalShiftSize;
+    };
+
+    /// @brief an allocation that was moved from srcLocation to dstLocation by incremental defragmentation
+    struct DefragmentationMove
+    {
+        uint64_t srcLocation;
+        uint64_t dstLocation;
+        uint64_t size;
+    };
+
+    struct RangeCopy
+    {
+        uint64_t srcOffset;
+        uint64_t dstOffset;
+        uint64_t size;
+    };
+
+    /// @brief what a compaction changed. copies must be performed in order, each finishing before the next starts, since ranges within them can overlap
+    struct RangeCompaction
+    {
+        std::vector<CompactionResult> results; //sorted
+        std::vector<RangeCopy> copies;
+        bool compacted = false; //false if there was no free space between allocations
+    };
+
+    // Offset bookkeeping behind FragmentableBuffer: alignment padding, sub-allocation, compaction and incremental defragmentation. Only tracks offsets
+    // and describes the copies that need to happen, so it has no Vulkan dependency and can be driven without a device.
+    //** NOT THREAD SAFE **
+    class FragmentableRange
+    {
+    private:
+        TLSFAllocator allocator;
+        uint64_t failedWriteSize = 0; //sum of writes that didn't fit
+        uint64_t minAlignment = 0;
+
+        std::vector<DefragmentationMove> pendingMoves; //moves whose copies haven't been published yet
+        std::vector<uint64_t> pendingFrees; //published moves' old locations
+
+    public:
+        FragmentableRange(const uint64_t size, const uint64_t minAlignment);
+        ~FragmentableRange();
+        FragmentableRange(const FragmentableRange&) = default;
+        FragmentableRange(FragmentableRange&& other) noexcept;
+        FragmentableRange& operator=(const FragmentableRange&) = default;
+        FragmentableRange& operator=(FragmentableRange&& other) noexcept;
+
+        //pads size to the minimum alignment and allocates it. If free space is too fragmented for the allocation, the range is compacted first, which is
+        //returned in compaction. Returns UINT64_MAX if there isn't enough free space
+        uint64_t allocate(uint64_t& size, RangeCompaction& compaction);
+        //offset must be one returned by allocate(). An allocation that's still being moved also loses its new location, which becomes a pending free
+        //since the move's copy may still be writing to it
+        void free(const uint64_t offset);
+        //moves all allocations down next to each other, cancelling any defragmentation in progress
+        RangeCompaction compact();
+        //takes on another range's allocations at the same offsets, with this range's size
+        void copyAllocations(const FragmentableRange& other);
+
+        //picks at most maxMoveSize bytes of allocations from the end of the range to move into free space below them; returns the copies to perform.
+        //Does nothing while moves or frees are still pending
+        std::vector<RangeCopy> beginDefragmentation(const uint64_t maxMoveSize);
+        //ends the moves from beginDefragmentation() once their copies completed, returning them sorted by srcLocation. Their old locations become pending frees
+        std::vector<DefragmentationMove> publishDefragmentation();
+        //frees published moves' old locations once nothing can still be reading them
+        void releasePendingFrees();
+        //frees unpublished moves' new locations and published moves' old ones
+        void cancelDefragmentation();
+
+        //returns where a location from before a compaction was moved to, given the compaction's sorted results. O(log n) in the number of results
+        static uint64_t getCompactedLocation(const std::vector<CompactionResult>& results, const uint64_t location);
+        //returns where a location was moved to, given sorted defragmentation moves. O(log n) in the number of moves
+        static uint64_t getMovedLocation(const std::vector<DefragmentationMove>& moves, const uint64_t location);
+
+        bool hasPendingMoves() const { return pendingMoves.size(); }
+        bool hasPendingFrees() const { return pendingFrees.size(); }
+        const TLSFAllocator& getAllocator() const { return allocator; }
+        uint64_t getStackLocation() const { return allocator.getUsedEnd(); }
+        uint64_t getDesiredLocation() const { return allocator.getUsedEnd() + failedWriteSize; }
+    };
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace PaperRenderer
+{
+    // Monotonic arena for memory that only lives for a frame, used through std::pmr containers. Allocating is a pointer bump, deallocating does nothing,
+    // and everything is released at once by reset(). Allocations that don't fit in the block go to the heap until the next reset(), which grows the
+    // block to cover them, so a steady workload stops allocating after a few frames.
+    //** NOT THREAD SAFE **; RenderEngine::getFrameMemory() hands each thread its own
+    class FrameMemory
+    {
+    private:
+        //heap memory used past the block; counted to size the next block
+        class OverflowResource : public std::pmr::memory_resource
+        {
+        public:
+            size_t overflowBytes = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                overflowBytes += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+            void do_deallocate(void* pointer, size_t bytes, size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+        };
+
+        std::vector<std::byte> block;
+        OverflowResource overflowResource;
+        std::optional<std::pmr::monotonic_buffer_resource> arena; //rebuilt over the new block when it grows; its address doesn't change
+
+    public:
+        FrameMemory(const size_t initialSize = 65536)
+            :block(initialSize)
+        {
+            arena.emplace(block.data(), block.size(), &overflowResource);
+        }
+        FrameMemory(const FrameMemory&) = delete;
+        FrameMemory& operator=(const FrameMemory&) = delete;
+
+        //invalidates everything allocated since the last reset
+        void reset()
+        {
+            arena->release();
+
+            if(overflowResource.overflowBytes)
+            {
+                arena.reset();
+                block = std::vector<std::byte>((block.size() + overflowResource.overflowBytes) * 2);
+                overflowResource.overflowBytes = 0;
+                arena.emplace(block.data(), block.size(), &overflowResource);
+            }
+        }
+
+        //copies data into the arena, for use as a StagingBufferTransfer::dataView
+        std::span<const uint8_t> copy(const void* data, const size_t size)
+        {
+            void* destination = arena->allocate(size, alignof(std::max_align_t));
+            memcpy(destination, data, size);
+
+            return std::span((const uint8_t*)destination, size);
+        }
+
+        std::pmr::memory_resource* getResource() { return &*arena; }
+        size_t getBlockSize() const { return block.size(); }
+    };
+}
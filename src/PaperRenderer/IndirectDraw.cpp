@@ -28,10 +28,10 @@ namespace PaperRenderer
     {
     }
 
-    std::vector<ModelInstance*> CommonMeshGroup::verifyBufferSize(std::vector<StagingBufferTransfer>& transferGroup)
+    std::pmr::vector<ModelInstance*> CommonMeshGroup::verifyBufferSize(std::pmr::vector<StagingBufferTransfer>& transferGroup)
     {
         //verify
-        std::vector<ModelInstance*> returnInstances;
+        std::pmr::vector<ModelInstance*> returnInstances(renderer.getFrameMemory().getResource());
         if(rebuild)
         {
             returnInstances = rebuildBuffer(transferGroup);
@@ -41,19 +41,20 @@ namespace PaperRenderer
         return returnInstances;
     }
 
-    std::vector<ModelInstance*> CommonMeshGroup::rebuildBuffer(std::vector<StagingBufferTransfer>& transferGroup)
+    std::pmr::vector<ModelInstance*> CommonMeshGroup::rebuildBuffer(std::pmr::vector<StagingBufferTransfer>& transferGroup)
     {
         //Timer
         Timer timer(renderer, "Rebuild Common Mesh Group Buffers", IRREGULAR);
 
-        //get new size
-        BufferSizeRequirements bufferSizeRequirements = getBuffersRequirements();
+        //get new size; model matrices, draw commands, and offsets/indices
+        const auto bufferSizeRequirements = meshInstances.layout();
 
         //rebuild buffers
         const BufferInfo matricesBufferInfo = {
             .size = bufferSizeRequirements.matricesCount * sizeof(ShaderOutputObject),
             .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_MESH_GROUP
         };
         modelMatricesBuffer = Buffer(renderer, matricesBufferInfo);
 
@@ -61,7 +62,8 @@ namespace PaperRenderer
             .size = bufferSizeRequirements.drawCommandCount * sizeof(DrawCommand),
             .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | 
                 VK_BUFFER_USAGE_2_INDIRECT_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_MESH_GROUP
         };
         drawCommandsBuffer = Buffer(renderer, drawCommandsBufferInfo);
 
@@ -75,7 +77,7 @@ namespace PaperRenderer
                     .infos = { {
                         .buffer = modelMatricesBuffer.getBuffer(),
                         .offset = 0,
-                        .range = VK_WHOLE_SIZE
+                        .range = modelMatricesBuffer.getSize()
                     } },
                     .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                     .binding = 0,
@@ -84,9 +86,9 @@ namespace PaperRenderer
         });
 
         //get instances to update
-        std::vector<ModelInstance*> modifiedInstances;
-        modifiedInstances.reserve(instanceMeshes.size());
-        for(auto& [instance, meshes] : instanceMeshes)
+        std::pmr::vector<ModelInstance*> modifiedInstances(renderer.getFrameMemory().getResource());
+        modifiedInstances.reserve(meshInstances.getInstanceMeshes().size());
+        for(const auto& [instance, meshes] : meshInstances.getInstanceMeshes())
         {
             modifiedInstances.push_back(instance);
         }
@@ -94,60 +96,25 @@ namespace PaperRenderer
         return modifiedInstances;
     }
 
-    CommonMeshGroup::BufferSizeRequirements CommonMeshGroup::getBuffersRequirements()
+    void CommonMeshGroup::setDrawCommandData(std::pmr::vector<StagingBufferTransfer>& transferGroup)
     {
-        BufferSizeRequirements sizeRequirements = {};
-
-        //model matrices, draw commands, and offsets/indices
-        uint32_t meshIndex = 0;
-        for(auto& [instance, meshesData] : geometryMeshesData)
-        {
-            for(auto& [mesh, meshInstancesData] : meshesData)
-            {
-                //get new instance count
-                const uint32_t instanceCount = std::max((uint32_t)(meshInstancesData.instanceCount - 1) * 2, (uint32_t)1);
-
-                //set mesh data
-                meshInstancesData.drawCommandIndex = meshIndex;
-                meshInstancesData.lastRebuildInstanceCount = instanceCount;
-                meshInstancesData.matricesStartIndex = sizeRequirements.matricesCount;
-
-                //increment size requirements
-                sizeRequirements.matricesCount += instanceCount;
-                sizeRequirements.drawCommandCount++;
-
-                //increment mesh counter
-                meshIndex++;
-            }
-        }
-
-        return sizeRequirements;
-    }
-
-    void CommonMeshGroup::setDrawCommandData(std::vector<StagingBufferTransfer>& transferGroup)
-    {
-        for(auto& [instance, meshesData] : geometryMeshesData)
+        for(const auto& [geometry, meshesData] : meshInstances.getGeometryMeshesData())
         {
             for(const auto& [mesh, meshInstancesData] : meshesData)
             {
                 //stage command data transfer
+                const DrawCommand command = {
+                    .command = {
+                        .indexCount = mesh->indicesSize / mesh->indexStride,
+                        .instanceCount = 0,
+                        .firstIndex = 0,
+                        .vertexOffset = 0,
+                        .firstInstance = meshInstancesData.matricesStartIndex
+                    }
+                };
                 transferGroup.push_back({
                     .dstOffset = sizeof(DrawCommand) * meshInstancesData.drawCommandIndex,
-                    .data = [&] {
-                        const DrawCommand command = {
-                            .command = {
-                                .indexCount = mesh->indicesSize / mesh->indexStride,
-                                .instanceCount = 0,
-                                .firstIndex = 0,
-                                .vertexOffset = 0,
-                                .firstInstance = meshInstancesData.matricesStartIndex
-                            }
-                        };
-                        std::vector<uint8_t> transferData(sizeof(DrawCommand));
-                        memcpy(transferData.data(), &command, sizeof(DrawCommand));
-
-                        return transferData;
-                    } (),
+                    .dataView = renderer.getFrameMemory().copy(&command, sizeof(DrawCommand)),
                     .dstBuffer = &drawCommandsBuffer
                 });
             }
@@ -156,52 +123,23 @@ namespace PaperRenderer
 
     void CommonMeshGroup::addInstanceMesh(ModelInstance& instance, const LODMesh& instanceMeshData)
     {
-        if(!geometryMeshesData[&instance.getGeometryData()].count(&instanceMeshData))
-        {
-            rebuild = true;
-        }
-
-        geometryMeshesData[&instance.getGeometryData()][&instanceMeshData].instanceCount++;
-
-        if(geometryMeshesData[&instance.getGeometryData()][&instanceMeshData].instanceCount > geometryMeshesData[&instance.getGeometryData()][&instanceMeshData].lastRebuildInstanceCount) rebuild = true;
-        
-        //add instance mesh references
-        instanceMeshes[&instance].push_back(&instanceMeshData);
+        //new meshes, or ones that outgrew their space, need the buffers rebuilt
+        if(meshInstances.addInstanceMesh(&instance, &instance.getGeometryData(), &instanceMeshData)) rebuild = true;
     }
 
     void CommonMeshGroup::removeInstanceMeshes(ModelInstance& instance)
     {
-        //use instance pointer if using unique geometry; otherwise NULL index
-        ModelInstance const* instancePtr = instance.uniqueGeometryData ? &instance : NULL;
-
-        if(instanceMeshes.count(&instance))
-        {
-            for(LODMesh const* meshData : instanceMeshes[&instance])
-            {
-                geometryMeshesData[&instance.getGeometryData()][meshData].instanceCount--;
-
-                //remove if 0 instances
-                if(geometryMeshesData[&instance.getGeometryData()][meshData].instanceCount < 1)
-                {
-                    geometryMeshesData[&instance.getGeometryData()].erase(meshData);
-                }
-            }
-
-            //remove instance mesh references
-            instanceMeshes.erase(&instance);
-        }
+        meshInstances.removeInstanceMeshes(&instance, &instance.getGeometryData());
     }
 
     void CommonMeshGroup::rereferenceInstance(ModelInstance* oldInstance, ModelInstance* newInstance)
     {
-        instanceMeshes[newInstance] = std::move(instanceMeshes.at(oldInstance));
-        instanceMeshes.erase(oldInstance);
+        meshInstances.rereferenceInstance(oldInstance, newInstance);
     }
 
     void CommonMeshGroup::rereferenceModelData(ModelGeometryData const* oldModelData, ModelGeometryData const* newModelData)
     {
-        geometryMeshesData[newModelData] = std::move(geometryMeshesData[oldModelData]);
-        geometryMeshesData.erase(oldModelData);
+        meshInstances.rereferenceGeometry(oldModelData, newModelData);
     }
 
     void CommonMeshGroup::draw(const VkCommandBuffer &cmdBuffer) const
@@ -220,7 +158,7 @@ namespace PaperRenderer
         }
 
         //submit draw calls
-        for(const auto& [geometryPtr, meshesData] : geometryMeshesData)
+        for(const auto& [geometryPtr, meshesData] : meshInstances.getGeometryMeshesData())
         {
             for(const auto& [mesh, meshData] : meshesData)
             {
@@ -245,7 +183,7 @@ namespace PaperRenderer
     {
         //clear instance count
         const uint32_t drawCountDefaultValue = 0;
-        for(const auto& [geometryPtr, meshesData] : geometryMeshesData)
+        for(const auto& [geometryPtr, meshesData] : meshInstances.getGeometryMeshesData())
         {
             for(const auto& [mesh, meshData] : meshesData)
             {
@@ -1,6 +1,7 @@
 #pragma once
 #include "Descriptor.h"
 #include "StagingBuffer.h"
+#include "InstanceBookkeeping.h"
 
 #include <unordered_map>
 #include <list>
@@ -31,34 +32,13 @@ namespace PaperRenderer
             uint32_t padding;
         };
 
-        struct MeshInstancesData
-        {
-            uint32_t lastRebuildInstanceCount = 0; //includes extra overhead
-            uint32_t instanceCount = 0;
-            uint32_t drawCommandIndex = 0;
-            uint32_t matricesStartIndex = 0;
-        };
-
         //buffers and allocation
         Buffer modelMatricesBuffer;
         Buffer drawCommandsBuffer;
 
-        struct BufferSizeRequirements
-        {
-            uint32_t drawCommandCount = 0;
-            uint32_t matricesCount = 0;
-
-            void operator +=(BufferSizeRequirements sizeRequirements)
-            {
-                drawCommandCount += sizeRequirements.drawCommandCount;
-                matricesCount += sizeRequirements.matricesCount;
-            }
-        };
-
         //buffer helper functions
-        std::vector<class ModelInstance*> rebuildBuffer(std::vector<StagingBufferTransfer>& transferGroup);
-        BufferSizeRequirements getBuffersRequirements();
-        void setDrawCommandData(std::vector<StagingBufferTransfer>& transferGroup);
+        std::pmr::vector<class ModelInstance*> rebuildBuffer(std::pmr::vector<StagingBufferTransfer>& transferGroup);
+        void setDrawCommandData(std::pmr::vector<StagingBufferTransfer>& transferGroup);
 
         //descriptors
         const ResourceDescriptor descriptorSet;
@@ -66,8 +46,7 @@ namespace PaperRenderer
         //other
         uint32_t drawCommandCount = 0;
         bool rebuild = true;
-        std::unordered_map<class ModelGeometryData const*, std::unordered_map<struct LODMesh const*, MeshInstancesData>> geometryMeshesData = {};
-        std::unordered_map<class ModelInstance*, std::vector<struct LODMesh const*>> instanceMeshes;
+        MeshInstanceCounter<class ModelInstance, class ModelGeometryData, struct LODMesh> meshInstances;
 
         //references
         class RenderEngine& renderer;
@@ -79,7 +58,8 @@ namespace PaperRenderer
         ~CommonMeshGroup();
         CommonMeshGroup(const CommonMeshGroup&) = delete;
 
-        std::vector<class ModelInstance*> verifyBufferSize(std::vector<StagingBufferTransfer>& transferGroup);
+        //returned instances and queued transfer data are in the renderer's frame memory
+        std::pmr::vector<class ModelInstance*> verifyBufferSize(std::pmr::vector<StagingBufferTransfer>& transferGroup);
 
         void addInstanceMesh(ModelInstance& instance, const LODMesh& instanceMeshData);
         void removeInstanceMeshes(class ModelInstance& instance);
@@ -93,7 +73,7 @@ namespace PaperRenderer
         //const Buffer& getModelMatricesBuffer() { return *modelMatricesBuffer; }
         const Buffer& getDrawCommandsBuffer() const { return drawCommandsBuffer; }
         const Buffer& getModelMatricesBuffer() const { return modelMatricesBuffer; }
-        const std::unordered_map<class ModelGeometryData const*, std::unordered_map<struct LODMesh const*, MeshInstancesData>>& getInstanceMeshesData() const { return geometryMeshesData; }
+        const MeshInstanceCounter<class ModelInstance, class ModelGeometryData, struct LODMesh>& getMeshInstances() const { return meshInstances; }
         
     };
 }
\ No newline at end of file
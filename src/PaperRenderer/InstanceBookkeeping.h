@@ -0,0 +1,294 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <utility>
+
+namespace PaperRenderer
+{
+    // CPU side bookkeeping shared by the renderer, render passes and mesh groups when instances are added and removed. Templated over the types
+    // it references so it has no Vulkan dependency, and can be driven without a device.
+
+    //----------SWAP REMOVE LIST DECLARATIONS----------//
+
+    // Unordered list where elements know their own index, so removal is O(1) by moving the last element into the removed slot.
+    //** NOT THREAD SAFE **
+    template<typename T>
+    class SwapRemoveList
+    {
+    private:
+        std::vector<T> elements;
+
+    public:
+        //returns the new element's index
+        uint32_t add(const T& element)
+        {
+            elements.push_back(element);
+            return elements.size() - 1;
+        }
+
+        //returns the element that was moved into index, or NULL if the last element was removed. Its stored index must be updated by the caller
+        T* remove(const uint32_t index)
+        {
+            if(index + 1 < elements.size())
+            {
+                elements[index] = std::move(elements.back());
+                elements.pop_back();
+                return &elements[index];
+            }
+
+            elements.pop_back();
+            return NULL;
+        }
+
+        void clear() { elements.clear(); }
+        void reserve(const size_t size) { elements.reserve(size); }
+
+        T& at(const uint32_t index) { return elements.at(index); }
+        const T& at(const uint32_t index) const { return elements.at(index); }
+        T& operator[](const uint32_t index) { return elements[index]; }
+        const T& operator[](const uint32_t index) const { return elements[index]; }
+        size_t size() const { return elements.size(); }
+        auto begin() { return elements.begin(); }
+        auto end() { return elements.end(); }
+        auto begin() const { return elements.begin(); }
+        auto end() const { return elements.end(); }
+        const std::vector<T>& getElements() const { return elements; }
+    };
+
+    //----------QUEUED INSTANCE LIST HELPERS----------//
+
+    // Used by RenderEngine::addObject/removeObject and RenderPass::addInstance/removeInstance for their self indexed instance lists. getSelfIndex(instance)
+    // returns a reference to the index the instance stores for the list, and instances whose index changes are queued for a data upload
+
+    template<typename T, typename GetSelfIndexFn>
+    void addQueuedInstance(SwapRemoveList<T*>& list, std::set<T*>& toUpdate, T* instance, GetSelfIndexFn&& getSelfIndex)
+    {
+        getSelfIndex(instance) = list.add(instance);
+        toUpdate.insert(instance);
+    }
+
+    //returns the instance that was moved into the removed one's place, or NULL if the last instance was removed
+    template<typename T, typename GetSelfIndexFn>
+    T* removeQueuedInstance(SwapRemoveList<T*>& list, std::set<T*>& toUpdate, T* instance, GetSelfIndexFn&& getSelfIndex)
+    {
+        const uint32_t selfIndex = getSelfIndex(instance);
+
+        //new reference for the last element, which is moved into the removed one's place
+        T* movedInstance = NULL;
+        if(T** movedElement = list.remove(selfIndex))
+        {
+            movedInstance = *movedElement;
+            getSelfIndex(movedInstance) = selfIndex;
+            toUpdate.insert(movedInstance);
+        }
+
+        toUpdate.erase(instance);
+        getSelfIndex(instance) = UINT32_MAX;
+
+        return movedInstance;
+    }
+
+    //----------MESH INSTANCE COUNTER DECLARATIONS----------//
+
+    // Counts instances per (geometry, mesh) pair within a mesh group, and lays out the group's draw commands and matrices from those counts.
+    //** NOT THREAD SAFE **
+    template<typename InstanceT, typename GeometryT, typename MeshT>
+    class MeshInstanceCounter
+    {
+    public:
+        struct MeshInstancesData
+        {
+            uint32_t lastRebuildInstanceCount = 0; //includes extra overhead
+            uint32_t instanceCount = 0;
+            uint32_t drawCommandIndex = 0;
+            uint32_t matricesStartIndex = 0;
+        };
+
+        struct Layout
+        {
+            uint32_t drawCommandCount = 0;
+            uint32_t matricesCount = 0;
+        };
+
+    private:
+        std::unordered_map<GeometryT const*, std::unordered_map<MeshT const*, MeshInstancesData>> geometryMeshesData = {};
+        std::unordered_map<InstanceT*, std::vector<MeshT const*>> instanceMeshes = {};
+
+    public:
+        //returns true if the mesh is new or outgrew its space from the last layout, meaning the group needs to be rebuilt
+        bool addInstanceMesh(InstanceT* instance, GeometryT const* geometry, MeshT const* mesh)
+        {
+            const auto [meshData, inserted] = geometryMeshesData[geometry].try_emplace(mesh);
+            meshData->second.instanceCount++;
+
+            //add instance mesh references
+            instanceMeshes[instance].push_back(mesh);
+
+            return inserted || meshData->second.instanceCount > meshData->second.lastRebuildInstanceCount;
+        }
+
+        void removeInstanceMeshes(InstanceT* instance, GeometryT const* geometry)
+        {
+            const auto instanceIt = instanceMeshes.find(instance);
+            if(instanceIt == instanceMeshes.end()) return;
+
+            const auto geometryIt = geometryMeshesData.find(geometry);
+            if(geometryIt != geometryMeshesData.end())
+            {
+                for(MeshT const* mesh : instanceIt->second)
+                {
+                    //remove if 0 instances
+                    const auto meshIt = geometryIt->second.find(mesh);
+                    if(meshIt != geometryIt->second.end() && --meshIt->second.instanceCount < 1)
+                    {
+                        geometryIt->second.erase(meshIt);
+                    }
+                }
+
+                if(geometryIt->second.empty()) geometryMeshesData.erase(geometryIt);
+            }
+
+            //remove instance mesh references
+            instanceMeshes.erase(instanceIt);
+        }
+
+        void rereferenceInstance(InstanceT* oldInstance, InstanceT* newInstance)
+        {
+            auto node = instanceMeshes.extract(oldInstance);
+            if(node.empty()) return;
+
+            node.key() = newInstance;
+            instanceMeshes.insert(std::move(node));
+        }
+
+        void rereferenceGeometry(GeometryT const* oldGeometry, GeometryT const* newGeometry)
+        {
+            auto node = geometryMeshesData.extract(oldGeometry);
+            if(node.empty()) return;
+
+            node.key() = newGeometry;
+            geometryMeshesData.insert(std::move(node));
+        }
+
+        //gives each mesh a draw command and a range of matrices with room for its instance count to double before the next layout
+        Layout layout()
+        {
+            Layout layout = {};
+            for(auto& [geometry, meshesData] : geometryMeshesData)
+            {
+                for(auto& [mesh, meshInstancesData] : meshesData)
+                {
+                    const uint32_t instanceCount = std::max((uint32_t)(meshInstancesData.instanceCount - 1) * 2, (uint32_t)1);
+
+                    meshInstancesData.drawCommandIndex = layout.drawCommandCount;
+                    meshInstancesData.lastRebuildInstanceCount = instanceCount;
+                    meshInstancesData.matricesStartIndex = layout.matricesCount;
+
+                    layout.matricesCount += instanceCount;
+                    layout.drawCommandCount++;
+                }
+            }
+
+            return layout;
+        }
+
+        const MeshInstancesData& getMeshInstancesData(GeometryT const* geometry, MeshT const* mesh) const { return geometryMeshesData.at(geometry).at(mesh); }
+        const std::unordered_map<GeometryT const*, std::unordered_map<MeshT const*, MeshInstancesData>>& getGeometryMeshesData() const { return geometryMeshesData; }
+        const std::unordered_map<InstanceT*, std::vector<MeshT const*>>& getInstanceMeshes() const { return instanceMeshes; }
+    };
+
+    //----------RENDER TREE HELPERS----------//
+
+    template<typename MaterialT, typename MaterialInstanceT, typename GroupT>
+    using RenderTree = std::unordered_map<MaterialT*, std::unordered_map<MaterialInstanceT*, GroupT>>;
+
+    //returns the group for a material instance, constructing it from groupArgs if it doesn't exist yet. One lookup per level
+    template<typename MaterialT, typename MaterialInstanceT, typename GroupT, typename... GroupArgs>
+    GroupT& getRenderTreeGroup(RenderTree<MaterialT, MaterialInstanceT, GroupT>& renderTree, MaterialT* material, MaterialInstanceT* materialInstance, GroupArgs&&... groupArgs)
+    {
+        return renderTree[material].try_emplace(materialInstance, std::forward<GroupArgs>(groupArgs)...).first->second;
+    }
+
+    //adds every mesh of an instance's LODs to a mesh group and references the group by mesh. getGroup(lodIndex, matIndex) returns the group for the mesh's
+    //material, usually from getRenderTreeGroup(), and GroupT::addInstanceMesh(instance, mesh) is called on it
+    template<typename InstanceT, typename LODT, typename MeshT, typename GroupT, typename GetGroupFn>
+    void addRenderTreeInstance(InstanceT& instance, const std::vector<LODT>& lods, std::unordered_map<MeshT const*, GroupT*>& meshGroupReferences, GetGroupFn&& getGroup)
+    {
+        for(uint32_t lodIndex = 0; lodIndex < lods.size(); lodIndex++)
+        {
+            for(uint32_t matIndex = 0; matIndex < lods[lodIndex].materialMeshes.size(); matIndex++)
+            {
+                const MeshT& mesh = lods[lodIndex].materialMeshes[matIndex];
+
+                GroupT& group = getGroup(lodIndex, matIndex);
+                group.addInstanceMesh(instance, mesh);
+                meshGroupReferences[&mesh] = &group;
+            }
+        }
+    }
+
+    //removes an instance from every mesh group it was added to by addRenderTreeInstance()
+    template<typename InstanceT, typename MeshT, typename GroupT>
+    void removeRenderTreeInstance(InstanceT& instance, std::unordered_map<MeshT const*, GroupT*>& meshGroupReferences)
+    {
+        for(auto& [mesh, group] : meshGroupReferences)
+        {
+            group->removeInstanceMeshes(instance);
+        }
+        meshGroupReferences.clear();
+    }
+
+    //----------INSTANCE MATERIAL DATA PACKING----------//
+
+    struct LODMaterialData
+    {
+        uint32_t meshGroupsOffset;
+    };
+
+    struct MaterialMeshGroup
+    {
+        uint64_t drawCommandAddress = 0;
+        uint64_t matricesBufferAddress = 0;
+    };
+
+    //packs an instance's per render pass data read by the shaders: a LODMaterialData per LOD, followed by each LOD's 8 byte aligned array of MaterialMeshGroup.
+    //getMeshCount(lodIndex) returns a LOD's material mesh count, and getMeshGroup(lodIndex, matIndex) returns its MaterialMeshGroup. data is sized once and overwritten
+    template<typename GetMeshCountFn, typename GetMeshGroupFn>
+    void packLODMaterialData(std::vector<uint8_t>& data, const uint32_t lodCount, GetMeshCountFn&& getMeshCount, GetMeshGroupFn&& getMeshGroup)
+    {
+        const auto align8 = [](const size_t offset) { return (offset + 7) & ~(size_t)7; };
+
+        //size
+        size_t size = sizeof(LODMaterialData) * lodCount;
+        for(uint32_t lodIndex = 0; lodIndex < lodCount; lodIndex++)
+        {
+            size = align8(size) + sizeof(MaterialMeshGroup) * getMeshCount(lodIndex);
+        }
+        data.assign(align8(size), 0);
+
+        //fill
+        size_t meshGroupsOffset = sizeof(LODMaterialData) * lodCount;
+        for(uint32_t lodIndex = 0; lodIndex < lodCount; lodIndex++)
+        {
+            meshGroupsOffset = align8(meshGroupsOffset);
+
+            const LODMaterialData lodMaterialData = {
+                .meshGroupsOffset = (uint32_t)meshGroupsOffset
+            };
+            memcpy(data.data() + sizeof(LODMaterialData) * lodIndex, &lodMaterialData, sizeof(LODMaterialData));
+
+            const uint32_t meshCount = getMeshCount(lodIndex);
+            for(uint32_t matIndex = 0; matIndex < meshCount; matIndex++)
+            {
+                const MaterialMeshGroup materialMeshGroup = getMeshGroup(lodIndex, matIndex);
+                memcpy(data.data() + meshGroupsOffset + sizeof(MaterialMeshGroup) * matIndex, &materialMeshGroup, sizeof(MaterialMeshGroup));
+            }
+
+            meshGroupsOffset += sizeof(MaterialMeshGroup) * meshCount;
+        }
+    }
+}
@@ -29,6 +29,7 @@ namespace PaperRenderer
     void Material::bind(VkCommandBuffer cmdBuffer, const Camera& camera) const
     {
         vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, rasterPipeline.getPipeline());
+        renderer.getDescriptorAllocator().bindDescriptorBuffer(cmdBuffer);
         if(bindFunction) bindFunction(cmdBuffer, camera);
     }
 
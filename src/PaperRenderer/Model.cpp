@@ -35,92 +35,87 @@ namespace PaperRenderer
 		uint32_t iboStride = 0;
 	};
 
-	ModelGeometryData::ModelGeometryData(RenderEngine& renderer, const AABB& aabb, const std::vector<uint8_t>& vertices, Model& parentModel, const bool createBLAS, const VkBuildAccelerationStructureFlagsKHR blasFlags)
-		:aabb(aabb),
-		vbo([&] {
-			// Create buffer
-			const BufferInfo bufferInfo = {
-				.size = vertices.size(),
-				.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-					(renderer.getDevice().getGPUFeaturesAndProperties().rtSupport ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : (VkBufferUsageFlagBits2KHR)0),
-				.allocationFlags = renderer.getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0
-			};
-			Buffer buffer(renderer, bufferInfo);
+	//xxHash64 style hash over 8 byte words, where every word is mixed before it's combined so flipped bits don't cancel out. Geometry is
+	//only shared when two differently seeded hashes match, which treats the pair as a 128 bit hash instead of keeping a copy of the content
+	static uint64_t hashData(void const* data, const size_t size, uint64_t hash)
+	{
+		constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+		constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+		constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+		const auto rotl = [](const uint64_t value, const int shift) { return (value << shift) | (value >> (64 - shift)); };
+
+		const uint8_t* bytes = (const uint8_t*)data;
+		hash += size * prime3;
+		size_t i = 0;
+		for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, bytes + i, sizeof(uint64_t));
+			hash ^= rotl(word * prime2, 31) * prime1;
+			hash = rotl(hash, 27) * prime1 + prime3;
+		}
+		for(; i < size; i++)
+		{
+			hash ^= bytes[i] * prime3;
+			hash = rotl(hash, 11) * prime1;
+		}
 
-			buffer.writeToBuffer({{
-				.offset = 0,
-				.size = vertices.size(),
-				.readData = vertices.data()
-			}});
+		//avalanche
+		hash ^= hash >> 33;
+		hash *= prime2;
+		hash ^= hash >> 29;
+		hash *= prime3;
+		hash ^= hash >> 32;
+		
+		return hash;
+	}
 
-			return buffer;
-		} ()),
+	ModelGeometryData::ModelGeometryData(RenderEngine& renderer, const AABB& aabb, const std::vector<uint8_t>& vertices, const std::vector<uint8_t>& indices, Model& parentModel, const bool createBLAS, const VkBuildAccelerationStructureFlagsKHR blasFlags)
+		:aabb(aabb),
 		blasFlags(blasFlags),
-		blas([&] {
-			if(createBLAS && renderer.getDevice().getGPUFeaturesAndProperties().rtSupport)
-			{
-				std::unique_ptr<BLAS> blas = std::make_unique<BLAS>(renderer, *this);
-				const BLASBuildOp op = {
-					.accelerationStructure = blas.get(),
-					.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-					.flags = blasFlags
-				};
-				renderer.getAsBuilder().queueBLAS(op);
-
-				return blas;
-			}
-
-			return std::unique_ptr<BLAS>();
-		} ()),
-		shaderData(createShaderData(parentModel.getIBO().getBufferDeviceAddress(), vbo.getBufferDeviceAddress(), aabb, parentModel.getLODs())),
+		createBLAS(createBLAS && renderer.getDevice().getGPUFeaturesAndProperties().rtSupport),
 		parentModel(&parentModel),
 		renderer(&renderer)
 	{
+		//hash everything that affects the VBO or BLAS contents
+		const auto hashContent = [&](uint64_t hash)
+		{
+			hash = hashData(vertices.data(), vertices.size(), hash);
+			hash = hashData(indices.data(), indices.size(), hash);
+			for(const LOD& lod : parentModel.getLODs())
+			{
+				hash = hashData(lod.materialMeshes.data(), lod.materialMeshes.size() * sizeof(LODMesh), hash);
+			}
+			hash = hashData(&this->blasFlags, sizeof(VkBuildAccelerationStructureFlagsKHR), hash);
+			return hashData(&this->createBLAS, sizeof(bool), hash);
+		};
+
+		//get or create resources
+		const uint64_t contentHash = hashContent(0);
+		resources = acquireSharedResources(contentHash ? contentHash : 1, hashContent(0x27D4EB2F165667C5ULL), vertices);
+		shaderData = createShaderData(parentModel.getIBO().getBufferDeviceAddress(), getVBO().getBufferDeviceAddress(), aabb, parentModel.getLODs());
+
 		renderer.addModelData(this);
 	}
 
 	ModelGeometryData::ModelGeometryData(RenderEngine& renderer, const ModelGeometryData& geometryData, const bool createBLAS)
 		:aabb(geometryData.aabb),
-		vbo([&] {
-			const BufferInfo bufferInfo = {
-				.size = geometryData.getVBO().getSize(),
-				.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-					(renderer.getDevice().getGPUFeaturesAndProperties().rtSupport ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : (VkBufferUsageFlagBits2KHR)0),
-				.allocationFlags = renderer.getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0
-			};
-			Buffer buffer(renderer, bufferInfo);
-
-			const VkBufferCopy copy = {
-				.srcOffset = 0,
-				.dstOffset = 0,
-				.size = geometryData.getVBO().getSize()
-			};
-			buffer.copyFromBufferRanges(geometryData.vbo, { copy }, {}).idle();
-
-			return buffer;
-		} ()),
 		blasFlags(geometryData.blasFlags),
-		blas([&] {
-			if(createBLAS && renderer.getDevice().getGPUFeaturesAndProperties().rtSupport)
-			{
-				std::unique_ptr<BLAS> blas = std::make_unique<BLAS>(renderer,  *this);
-				const BLASBuildOp op = {
-					.accelerationStructure = blas.get(),
-					.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-					.flags = blasFlags
-				};
-				renderer.getAsBuilder().queueBLAS(op);
-
-				return blas;
-			}
-
-			return std::unique_ptr<BLAS>();
-		} ()),
-		shaderData(createShaderData(geometryData.parentModel->getIBO().getBufferDeviceAddress(), vbo.getBufferDeviceAddress(), aabb, geometryData.parentModel->getLODs())),
+		createBLAS(createBLAS && renderer.getDevice().getGPUFeaturesAndProperties().rtSupport),
+		resources(geometryData.resources), //shared until written to
+		shaderData(createShaderData(geometryData.parentModel->getIBO().getBufferDeviceAddress(), geometryData.getVBO().getBufferDeviceAddress(), aabb, geometryData.parentModel->getLODs())),
 		parentModel(geometryData.parentModel),
 		renderer(&renderer)
 	{
+		{
+			std::lock_guard guard(renderer.sharedGeometryMutex);
+			resources->users.insert(this);
+		}
+
 		renderer.addModelData(this);
+
+		//parent geometry has no BLAS to share
+		if(this->createBLAS && !resources->blas) detachSharedResources();
 	}
 
     ModelGeometryData::~ModelGeometryData()
@@ -128,14 +123,15 @@ namespace PaperRenderer
 		if(renderer)
 		{
 			renderer->removeModelData(this);
+			releaseSharedResources();
 		}
     }
 
     ModelGeometryData::ModelGeometryData(ModelGeometryData&& other) noexcept
 		:aabb(other.aabb),
-		vbo(std::move(other.vbo)),
 		blasFlags(other.blasFlags),
-		blas(std::move(other.blas)),
+		createBLAS(other.createBLAS),
+		resources(std::move(other.resources)),
 		shaderData(std::move(other.shaderData)),
 		shaderDataReference(other.shaderDataReference),
 		parentModel(other.parentModel),
@@ -148,17 +144,26 @@ namespace PaperRenderer
 		other.renderer = NULL;
 
 		renderer->rereferenceModelData(this);
-		if(blas) blas->rereferenceModelData(this);
+		if(resources)
+		{
+			std::lock_guard guard(renderer->sharedGeometryMutex);
+			resources->users.erase(&other);
+			resources->users.insert(this);
+			if(resources->blas && &resources->blas->getModelGeometryData() == &other) resources->blas->rereferenceModelData(this);
+		}
 	}
 
     ModelGeometryData& ModelGeometryData::operator=(ModelGeometryData&& other) noexcept
     {
 		if(this != &other)
 		{
+			//release current resources
+			if(renderer) releaseSharedResources();
+
 			aabb = other.aabb;
-			vbo = std::move(other.vbo);
 			blasFlags = other.blasFlags;
-			blas = std::move(other.blas);
+			createBLAS = other.createBLAS;
+			resources = std::move(other.resources);
 			shaderData = std::move(other.shaderData);
 			parentModel = other.parentModel;
 			renderer = other.renderer;
@@ -169,12 +174,183 @@ namespace PaperRenderer
 			other.renderer = NULL;
 
 			renderer->rereferenceModelData(this);
-			if(blas) blas->rereferenceModelData(this);
+			if(resources)
+			{
+				std::lock_guard guard(renderer->sharedGeometryMutex);
+				resources->users.erase(&other);
+				resources->users.insert(this);
+				if(resources->blas && &resources->blas->getModelGeometryData() == &other) resources->blas->rereferenceModelData(this);
+			}
 		}
 
 		return *this;
     }
 
+	std::shared_ptr<SharedGeometryResources> ModelGeometryData::acquireSharedResources(const uint64_t contentHash, const uint64_t contentCheckHash, const std::vector<uint8_t>& vertices)
+	{
+		//lock mutex
+		std::unique_lock lock(renderer->sharedGeometryMutex);
+
+		//share existing resources if identical geometry is alive; a collision of the first hash alone gets resources that aren't registered for sharing
+		bool registerResources = true;
+		if(renderer->sharedGeometry.count(contentHash))
+		{
+			std::shared_ptr<SharedGeometryResources> existingResources = renderer->sharedGeometry[contentHash].lock();
+			if(existingResources && existingResources->contentCheckHash == contentCheckHash)
+			{
+				existingResources->users.insert(this);
+				return existingResources;
+			}
+			registerResources = !existingResources;
+		}
+
+		//create new VBO
+		const BufferInfo bufferInfo = {
+			.size = vertices.size(),
+			.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+				(renderer->getDevice().getGPUFeaturesAndProperties().rtSupport ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : (VkBufferUsageFlagBits2KHR)0),
+			.allocationFlags = renderer->getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0,
+			.category = MEMORY_GEOMETRY
+		};
+		Buffer buffer(*renderer, bufferInfo);
+
+		buffer.writeToBuffer({{
+			.offset = 0,
+			.size = vertices.size(),
+			.readData = vertices.data()
+		}});
+
+		std::shared_ptr<SharedGeometryResources> newResources = std::make_shared<SharedGeometryResources>(SharedGeometryResources{
+			.vbo = std::move(buffer),
+			.blas = NULL,
+			.contentHash = registerResources ? contentHash : 0,
+			.contentCheckHash = contentCheckHash,
+			.users = { this }
+		});
+
+		//create BLAS
+		if(createBLAS) newResources->blas = std::make_unique<BLAS>(*renderer, *this);
+
+		//register for sharing
+		if(registerResources) renderer->sharedGeometry[contentHash] = newResources;
+		lock.unlock();
+
+		//queue BLAS build; done outside of the lock since the AS builder locks it when updating instances
+		if(newResources->blas)
+		{
+			const BLASBuildOp op = {
+				.accelerationStructure = newResources->blas.get(),
+				.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+				.flags = blasFlags
+			};
+			renderer->getAsBuilder().queueBLAS(op);
+		}
+
+		return newResources;
+	}
+
+	void ModelGeometryData::releaseSharedResources()
+	{
+		if(!resources) return;
+
+		std::shared_ptr<SharedGeometryResources> oldResources = std::move(resources);
+		{
+			std::lock_guard guard(renderer->sharedGeometryMutex);
+
+			//remove self and hand BLAS geometry references to another user
+			oldResources->users.erase(this);
+			if(oldResources->blas && &oldResources->blas->getModelGeometryData() == this && oldResources->users.size())
+			{
+				oldResources->blas->rereferenceModelData(*oldResources->users.begin());
+			}
+
+			//unregister if this was the last user
+			if(!oldResources->users.size() && oldResources->contentHash)
+			{
+				renderer->sharedGeometry.erase(oldResources->contentHash);
+			}
+		}
+
+		//resources (and the BLAS) are destroyed here if this was the last user; done outside of the lock since the BLAS destructor locks the AS builder
+		oldResources.reset();
+	}
+
+	void ModelGeometryData::detachSharedResources()
+	{
+		bool shared = false;
+		{
+			std::lock_guard guard(renderer->sharedGeometryMutex);
+			shared = resources->users.size() > 1;
+
+			//sole user; stop other geometry from sharing it since it's about to be written to
+			if(!shared && resources->contentHash)
+			{
+				renderer->sharedGeometry.erase(resources->contentHash);
+				resources->contentHash = 0;
+			}
+		}
+
+		//nothing else to do if resources are already private
+		if(!shared && (resources->blas || !createBLAS)) return;
+
+		Timer timer(*renderer, "Detach Shared Geometry", IRREGULAR);
+
+		//copy shared VBO into a private one
+		if(shared)
+		{
+			const BufferInfo bufferInfo = {
+				.size = getVBO().getSize(),
+				.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+					(renderer->getDevice().getGPUFeaturesAndProperties().rtSupport ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : (VkBufferUsageFlagBits2KHR)0),
+				.allocationFlags = renderer->getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0,
+				.category = MEMORY_GEOMETRY
+			};
+			Buffer buffer(*renderer, bufferInfo);
+
+			const VkBufferCopy copy = {
+				.srcOffset = 0,
+				.dstOffset = 0,
+				.size = getVBO().getSize()
+			};
+			//the copy waits on the GPU for anything still using the shared VBO; its queue then owns both buffers so the shared one outlives
+			//the copy, and writes to or builds from the private one can wait on it through getVBOOwnerSubmissions()
+			const SynchronizationInfo copySyncInfo = {
+				.timelineWaitPairs = resources->vbo.getOwnerSubmissions()
+			};
+			Queue& copyQueue = buffer.copyFromBufferRanges(getVBO(), { copy }, copySyncInfo);
+			buffer.addOwner(copyQueue);
+			resources->vbo.addOwner(copyQueue);
+
+			std::shared_ptr<SharedGeometryResources> newResources = std::make_shared<SharedGeometryResources>(SharedGeometryResources{
+				.vbo = std::move(buffer),
+				.blas = NULL,
+				.contentHash = 0, //private; never registered for sharing
+				.users = { this }
+			});
+
+			releaseSharedResources();
+			resources = std::move(newResources);
+		}
+
+		//create and queue a private BLAS
+		if(createBLAS)
+		{
+			resources->blas = std::make_unique<BLAS>(*renderer, *this);
+			const BLASBuildOp op = {
+				.accelerationStructure = resources->blas.get(),
+				.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+				.flags = blasFlags
+			};
+			renderer->getAsBuilder().queueBLAS(op);
+		}
+
+		//VBO address changed, so update shader data
+		updateShaderData(parentModel->getIBO().getBufferDeviceAddress(), getVBO().getBufferDeviceAddress(), aabb, parentModel->getLODs());
+
+		std::lock_guard guard(renderer->rendererMutex);
+		renderer->toUpdateModels.insert(this);
+	}
+
     std::vector<uint8_t> ModelGeometryData::createShaderData(const VkDeviceAddress iboAddress, const VkDeviceAddress vboAddress, const AABB& bounds, const std::vector<LOD>& LODs) const
     {
 		//model data
@@ -234,6 +410,21 @@ namespace PaperRenderer
 
     //----------MODEL DEFINITIONS----------//
 
+	//index data of every LOD and material, in IBO order
+	static std::vector<uint8_t> getCreationIndices(const ModelCreateInfo& creationInfo)
+	{
+		std::vector<uint8_t> creationIndicesData = {};
+		for(const ModelLODInfo& lod : creationInfo.LODs)
+		{
+			for(const auto& [matIndex, meshGroup] : lod.lodData)
+			{
+				creationIndicesData.insert(creationIndicesData.end(), meshGroup.indicesData.begin(), meshGroup.indicesData.end());
+			}
+		}
+
+		return creationIndicesData;
+	}
+
     Model::Model(RenderEngine& renderer, const ModelCreateInfo& creationInfo)
         :modelName(creationInfo.modelName),
 		LODs([&] {
@@ -265,10 +456,7 @@ namespace PaperRenderer
 						iboStride = sizeof(uint8_t);
 						break;
 					default:
-						renderer.getLogger().recordLog({
-							.type = CRITICAL_ERROR,
-							.text = "Invalid VkIndexType used for model " + modelName
-						});
+						renderer.getLogger().recordLog(CRITICAL_ERROR, [&] { return "Invalid VkIndexType used for model " + modelName; });
 					}
 
 					//process mesh data
@@ -296,21 +484,15 @@ namespace PaperRenderer
 		} ()),
 		ibo([&] {
 			// Get index data
-			std::vector<uint8_t> creationIndicesData = {};
-			for(const ModelLODInfo& lod : creationInfo.LODs)
-			{
-				for(const auto& [matIndex, meshGroup] : lod.lodData)
-				{
-					creationIndicesData.insert(creationIndicesData.end(), meshGroup.indicesData.begin(), meshGroup.indicesData.end());
-				}
-			}
+			const std::vector<uint8_t> creationIndicesData = getCreationIndices(creationInfo);
 
 			// Create buffer
 			const BufferInfo bufferInfo = {
 				.size = creationIndicesData.size(),
 				.usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
 					(renderer.getDevice().getGPUFeaturesAndProperties().rtSupport ? VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : (VkBufferUsageFlagBits2KHR)0),
-				.allocationFlags = renderer.getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0
+				.allocationFlags = renderer.getDevice().getGPUFeaturesAndProperties().reBAR ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : (VmaAllocationCreateFlags)0,
+				.category = MEMORY_GEOMETRY
 			};
 			Buffer buffer(renderer, bufferInfo);
 
@@ -335,7 +517,7 @@ namespace PaperRenderer
 
 			// Return buffer of vertex data
 			return creationVertices;
-		} (), *this, creationInfo.createBLAS, creationInfo.blasFlags),
+		} (), getCreationIndices(creationInfo), *this, creationInfo.createBLAS, creationInfo.blasFlags),
 		renderer(&renderer)
     {
 	}
@@ -384,17 +566,6 @@ namespace PaperRenderer
 
     //----------MODEL INSTANCE DEFINITIONS----------//
 
-	struct LODMaterialData
-	{
-		uint32_t meshGroupsOffset;
-	};
-
-	struct MaterialMeshGroup
-	{
-		uint64_t drawCommandAddress = 0;
-		uint64_t matricesBufferAddress = 0;
-	};
-
     ModelInstance::ModelInstance(Model& parentModel, const bool uniqueGeometry, const VkBuildAccelerationStructureFlagsKHR flags)
         :uniqueGeometryData(uniqueGeometry ? std::make_unique<ModelGeometryData>(*parentModel.renderer, parentModel.getGeometryData(), true) : NULL),
         parentModel(&parentModel)
@@ -488,69 +659,53 @@ namespace PaperRenderer
 
     void ModelInstance::setRenderPassInstanceData(RenderPass* renderPass)
     {
-		std::vector<uint8_t> newData;
-		newData.reserve(renderPassSelfReferences.at(renderPass).renderPassInstanceData.size());
-		uint32_t dynamicOffset = 0;
-
-		dynamicOffset += sizeof(LODMaterialData) * parentModel->getLODs().size();
-		newData.resize(dynamicOffset);
+		RenderPassData& renderPassData = renderPassSelfReferences.at(renderPass);
+		const std::vector<LOD>& lods = parentModel->getLODs();
+		ModelGeometryData const* geometryData = &getGeometryData();
+
+		//packed in place, reusing the previous data's capacity
+		packLODMaterialData(renderPassData.renderPassInstanceData, lods.size(),
+			[&](uint32_t lodIndex) { return (uint32_t)lods[lodIndex].materialMeshes.size(); },
+			[&](uint32_t lodIndex, uint32_t matIndex) {
+				LODMesh const* lodMeshPtr = &lods[lodIndex].materialMeshes[matIndex];
+				CommonMeshGroup const* meshGroupPtr = renderPassData.meshGroupReferences.at(lodMeshPtr);
+				const auto& meshInstancesData = meshGroupPtr->getMeshInstances().getMeshInstancesData(geometryData, lodMeshPtr);
+
+				return MaterialMeshGroup{
+					.drawCommandAddress = meshGroupPtr->getDrawCommandsBuffer().getBufferDeviceAddress() + (meshInstancesData.drawCommandIndex * sizeof(DrawCommand)),
+					.matricesBufferAddress = meshGroupPtr->getModelMatricesBuffer().getBufferDeviceAddress() + (meshInstancesData.matricesStartIndex * sizeof(ShaderOutputObject))
+				};
+			}
+		);
+    }
 
-		for(uint32_t lodIndex = 0; lodIndex < parentModel->getLODs().size(); lodIndex++)
+	void ModelInstance::queueBLAS(const VkBuildAccelerationStructureFlagsKHR flags, const float deformation)
+    {
+		if(uniqueGeometryData)
 		{
-			dynamicOffset = Device::getAlignment(dynamicOffset, 8);
+			//geometry is about to change, so it can no longer be shared
+			uniqueGeometryData->detachSharedResources();
 
-			const LODMaterialData lodMaterialData = {
-				.meshGroupsOffset = dynamicOffset
-			};
-
-			memcpy(newData.data() + sizeof(LODMaterialData) * lodIndex, &lodMaterialData, sizeof(LODMaterialData));
-			
-			//LOD mesh groups data
-			dynamicOffset += sizeof(MaterialMeshGroup) * parentModel->getLODs().at(lodIndex).materialMeshes.size();
-			newData.resize(dynamicOffset);
-
-			for(uint32_t matIndex = 0; matIndex < parentModel->getLODs().at(lodIndex).materialMeshes.size(); matIndex++)
+			if(parentModel->renderer->getDevice().getGPUFeaturesAndProperties().rtSupport)
 			{
-				dynamicOffset = Device::getAlignment(dynamicOffset, 8);
-				newData.resize(dynamicOffset);
-
-				//pointers
-				LODMesh const* lodMeshPtr = &parentModel->getLODs().at(lodIndex).materialMeshes.at(matIndex);
-				CommonMeshGroup const* meshGroupPtr = renderPassSelfReferences.at(renderPass).meshGroupReferences.at(&parentModel->getLODs().at(lodIndex).materialMeshes.at(matIndex));
-
-				//material mesh group data
-				const MaterialMeshGroup materialMeshGroup = {
-					.drawCommandAddress = 
-						meshGroupPtr->getDrawCommandsBuffer().getBufferDeviceAddress() + 
-						(meshGroupPtr->getInstanceMeshesData().at(&getGeometryData()).at(lodMeshPtr).drawCommandIndex * sizeof(DrawCommand)),
-					.matricesBufferAddress = 
-						meshGroupPtr->getModelMatricesBuffer().getBufferDeviceAddress() + 
-						(meshGroupPtr->getInstanceMeshesData().at(&getGeometryData()).at(lodMeshPtr).matricesStartIndex * sizeof(ShaderOutputObject))
+				//queue a refit; the builder rebuilds instead when the refit isn't possible or enough deformation accumulated
+				const BLASBuildOp op = {
+					.accelerationStructure = uniqueGeometryData->getBlasPtr(),
+					.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR,
+					.flags = flags | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+					.deformation = deformation
 				};
-
-				memcpy(newData.data() + lodMaterialData.meshGroupsOffset + sizeof(MaterialMeshGroup) * matIndex, &materialMeshGroup, sizeof(MaterialMeshGroup));
+				parentModel->renderer->getAsBuilder().queueBLAS(op);
 			}
 		}
-
-		//pad to 8 byte alignment
-		newData.resize(Device::getAlignment(newData.size(), 8));
-
-		renderPassSelfReferences.at(renderPass).renderPassInstanceData = newData;
     }
 
-	void ModelInstance::queueBLAS(const VkBuildAccelerationStructureFlagsKHR flags) const
-    {
-		if(uniqueGeometryData && parentModel->renderer->getDevice().getGPUFeaturesAndProperties().rtSupport)
-		{
-			//queue operation
-			const BLASBuildOp op = {
-				.accelerationStructure = uniqueGeometryData->getBlasPtr(),
-				.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-				.flags = flags
-			};
-			parentModel->renderer->getAsBuilder().queueBLAS(op);
-		}
-    }
+	const ModelGeometryData& ModelInstance::getWritableGeometryData()
+	{
+		if(uniqueGeometryData) uniqueGeometryData->detachSharedResources();
+
+		return getGeometryData();
+	}
 
 	ShaderModelInstance ModelInstance::getShaderInstance() const
     {
@@ -558,8 +713,8 @@ namespace PaperRenderer
 			.position = transform.position,
 			.scale = transform.scale,
 			.qRotation = transform.rotation,
-			.selfModelDataOffset = uniqueGeometryData ? (uint32_t)uniqueGeometryData->getShaderDataReference().shaderDataLocation : 0xFFFFFFFF,
-			.parentModelDataOffset = (uint32_t)parentModel->getGeometryData().getShaderDataReference().shaderDataLocation
+			.selfModelDataHandle = uniqueGeometryData ? uniqueGeometryData->getShaderDataReference().handle : 0xFFFFFFFF,
+			.parentModelDataHandle = parentModel->getGeometryData().getShaderDataReference().handle
 		};
 		return shaderModelInstance;
     }
@@ -83,32 +83,45 @@ namespace PaperRenderer
 
     //----------MODEL DECLARATION----------//
 
+    // VBO and BLAS shared by all geometry with identical content. Instances with unique geometry share their parent's until they write to it (copy-on-write)
+    struct SharedGeometryResources
+    {
+        Buffer vbo;
+        std::unique_ptr<class BLAS> blas = NULL;
+        uint64_t contentHash = 0; //0 if not registered for sharing
+        uint64_t contentCheckHash = 0; //second, independently seeded hash of the same content; together with contentHash forms the 128 bit hash compared before sharing
+        std::set<class ModelGeometryData*> users = {};
+    };
+
     class ModelGeometryData
     {
     private:
         // Generic geometry data
         AABB aabb = {};
-        Buffer vbo;
         VkBuildAccelerationStructureFlagsKHR blasFlags;
-        std::unique_ptr<class BLAS> blas = NULL;
+        bool createBLAS;
+        std::shared_ptr<SharedGeometryResources> resources;
 
         // Buffer and reference data
         std::vector<uint8_t> shaderData = {};
         struct ShaderDataReference
         {
             uint32_t selfIndex = UINT32_MAX;
-            VkDeviceSize shaderDataLocation = UINT64_MAX;
+            uint32_t handle = UINT32_MAX; //stable index into the renderer's model data table, which holds the current location in the model data buffer
         } shaderDataReference = {};
 
         std::vector<uint8_t> createShaderData(const VkDeviceAddress iboAddress, const VkDeviceAddress vboAddress, const AABB& bounds, const std::vector<LOD>& LODs) const;
+        std::shared_ptr<SharedGeometryResources> acquireSharedResources(const uint64_t contentHash, const uint64_t contentCheckHash, const std::vector<uint8_t>& vertices);
+        void releaseSharedResources();
 
         class Model* parentModel;
         RenderEngine* renderer;
 
         friend class RenderEngine;
+        friend class AccelerationStructureBuilder;
 
     public:
-        ModelGeometryData(RenderEngine& renderer, const AABB& aabb, const std::vector<uint8_t>& vertices, Model& parentModel, const bool createBLAS, const VkBuildAccelerationStructureFlagsKHR blasFlags);
+        ModelGeometryData(RenderEngine& renderer, const AABB& aabb, const std::vector<uint8_t>& vertices, const std::vector<uint8_t>& indices, Model& parentModel, const bool createBLAS, const VkBuildAccelerationStructureFlagsKHR blasFlags);
         ModelGeometryData(RenderEngine& renderer, const ModelGeometryData& geometryData, const bool createBLAS);
         ~ModelGeometryData();
         ModelGeometryData(const ModelGeometryData&) = delete;
@@ -117,10 +130,14 @@ namespace PaperRenderer
         
         void updateShaderData(const VkDeviceAddress iboAddress, const VkDeviceAddress vboAddress, const AABB& bounds, const std::vector<LOD>& LODs);
         void rereferenceParentModel(class Model* parentModel) { this->parentModel = parentModel; }
-
-        const Buffer& getVBO() const { return vbo; }
-        BLAS* getBlasPtr() { return blas ? blas.get() : NULL; }
-        BLAS const* getBlasPtr() const { return blas ? blas.get() : NULL; }
+        void detachSharedResources(); //gives this geometry its own VBO and BLAS if they're shared; call before writing to the VBO
+        //the private VBO is filled by a GPU copy, so writes to it must wait on these; BLAS builds already do
+        std::vector<TimelineSemaphorePair> getVBOOwnerSubmissions() const { return resources->vbo.getOwnerSubmissions(); }
+
+        const Buffer& getVBO() const { return resources->vbo; }
+        BLAS* getBlasPtr() { return resources->blas ? resources->blas.get() : NULL; }
+        BLAS const* getBlasPtr() const { return resources->blas ? resources->blas.get() : NULL; }
+        bool isShared() const { return resources->users.size() > 1; }
         const AABB& getAABB() const { return aabb; }
         const std::vector<uint8_t>& getShaderData() const { return shaderData; }
         const ShaderDataReference& getShaderDataReference() const { return shaderDataReference; }
@@ -142,6 +159,7 @@ namespace PaperRenderer
 
         friend ModelGeometryData;
         friend class ModelInstance;
+        friend class AccelerationStructureBuilder;
 
     public:
         Model(RenderEngine& renderer, const ModelCreateInfo& creationInfo);
@@ -163,8 +181,8 @@ namespace PaperRenderer
         glm::vec3 position;
         glm::vec3 scale; 
         glm::quat qRotation;
-        uint32_t selfModelDataOffset = 0xFFFFFFFF;
-        uint32_t parentModelDataOffset = 0xFFFFFFFF;
+        uint32_t selfModelDataHandle = 0xFFFFFFFF;
+        uint32_t parentModelDataHandle = 0xFFFFFFFF;
     };
 
     struct RenderPassInstance
@@ -226,11 +244,15 @@ namespace PaperRenderer
         ModelInstance& operator=(ModelInstance&& other) noexcept;
 
         void setTransformation(const ModelTransformation& newTransformation);
-        void queueBLAS(const VkBuildAccelerationStructureFlagsKHR flags) const; //call this to queue an update of it's acceleration structure for the next AS builder call
+        //call this to queue an update of it's acceleration structure for the next AS builder call. Detaches shared geometry. Refits are used until deformation
+        //(estimated vertex movement relative to the model's size since the last call) or the refit count gets too large, then a rebuild happens instead.
+        //Only the caller knows how its geometry moved, so deformation is required; pass 1.0 or more to force a rebuild
+        void queueBLAS(const VkBuildAccelerationStructureFlagsKHR flags, const float deformation);
         
         ShaderModelInstance getShaderInstance() const;
         const Model& getParentModel() const { return *parentModel; }
         const ModelGeometryData& getGeometryData() const { return uniqueGeometryData ? *uniqueGeometryData : parentModel->getGeometryData(); }
+        const ModelGeometryData& getWritableGeometryData(); //unique geometry is shared with the parent until first written to; call this before writing to the VBO
         const ModelTransformation& getTransformation() const { return transform; };
     };
 }
\ No newline at end of file
@@ -13,9 +13,10 @@
 namespace PaperRenderer
 {
     RenderEngine::RenderEngine(const PaperRendererInfo& creationInfo)
-        :logger(*this, creationInfo.logEventCallbackFunction),
+        :logger(*this, creationInfo.logEventCallbackFunction, creationInfo.minLogLevel, creationInfo.asynchronousLogging),
         device(*this, creationInfo.deviceInstanceInfo),
         swapchain(*this, creationInfo.swapchainRebuildCallbackFunction, creationInfo.windowState),
+        gpuProfiler(*this),
         descriptors(*this),
         defaultDescriptorLayouts({
             DescriptorSetLayout(*this, {{ //INDIRECT_DRAW_MATRICES
@@ -62,32 +63,32 @@ namespace PaperRenderer
         modelDataBuffer(*this, {
             .size = 4096,
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_MODEL_DATA
         }, 8)
     {
         //initialize buffers
         rebuildInstancesbuffer();
+        rebuildModelDataTableBuffer();
+        modelDataBuffer.setCompactionCallback([this](std::vector<CompactionResult> results){ handleModelDataCompaction(results); });
+        modelDataBuffer.setDefragmentationCallback([this](const std::vector<DefragmentationMove>& moves){ handleModelDataMoves(moves); });
 
         //finish up
+        device.getCommands().flushSubmissions();
         vkDeviceWaitIdle(device.getDevice());
         lastFrameTimePoint = std::chrono::high_resolution_clock::now();
 
         //log
-        logger.recordLog({
-            .type = INFO,
-            .text = "----------Renderer initialization finished----------"
-        });
+        logger.recordLog(INFO, "----------Renderer initialization finished----------");
     }
 
     RenderEngine::~RenderEngine()
     {
+        device.getCommands().flushSubmissions();
         vkDeviceWaitIdle(device.getDevice());
 
         //log destructor
-        logger.recordLog({
-            .type = INFO,
-            .text = "----------Renderer destructor initialized----------"
-        });
+        logger.recordLog(INFO, "----------Renderer destructor initialized----------");
     }
 
     void RenderEngine::rebuildModelDataBuffer()
@@ -103,10 +104,12 @@ namespace PaperRenderer
         const BufferInfo modelsBufferInfo = {
             .size = (VkDeviceSize)(newModelDataSize * modelsDataOverhead),
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_MODEL_DATA
         };
         FragmentableBuffer newBuffer(*this, modelsBufferInfo, 8);
         newBuffer.setCompactionCallback([this](std::vector<CompactionResult> results){ handleModelDataCompaction(results); });
+        newBuffer.setDefragmentationCallback([this](const std::vector<DefragmentationMove>& moves){ handleModelDataMoves(moves); });
 
         //copy old data into new if old buffer existed
         if(newWriteSize)
@@ -116,10 +119,13 @@ namespace PaperRenderer
                 .dstOffset = 0,
                 .size = newWriteSize
             };
-            newBuffer.getBuffer().copyFromBufferRanges(instancesDataBuffer, { copyRegion }, {}).idle();
+            const SynchronizationInfo copySyncInfo = {
+                .timelineWaitPairs = modelDataBuffer.getBuffer().getOwnerSubmissions()
+            };
+            newBuffer.getBuffer().copyFromBufferRanges(modelDataBuffer.getBuffer(), { copyRegion }, copySyncInfo).idle();
 
-            //pseudo write
-            newBuffer.newWrite(NULL, newWriteSize, NULL);
+            //same allocations at the same offsets
+            newBuffer.copyAllocations(modelDataBuffer);
         }
 
         //replace old buffer
@@ -128,23 +134,58 @@ namespace PaperRenderer
 
     void RenderEngine::handleModelDataCompaction(const std::vector<CompactionResult>& results)
     {
-        //fix model data first
-        for(const CompactionResult compactionResult : results)
+        relocateModelData([&](VkDeviceSize location) { return FragmentableBuffer::getCompactedLocation(results, location); });
+    }
+
+    void RenderEngine::handleModelDataMoves(const std::vector<DefragmentationMove>& moves)
+    {
+        //the moved data was copied when the moves were recorded, so rewrites queued since then only reached the old locations; moved models are rewritten at their new ones
+        for(ModelGeometryData* modelData : renderingModels)
         {
-            for(ModelGeometryData* modelData : renderingModels)
+            const VkDeviceSize location = modelDataOffsets[modelData->shaderDataReference.handle];
+            if(FragmentableBuffer::getMovedLocation(moves, location) != location)
             {
-                if(modelData->shaderDataReference.shaderDataLocation > compactionResult.location)
-                {
-                    //shift stored location
-                    modelData->shaderDataReference.shaderDataLocation -= compactionResult.shiftSize;
-                }
+                toUpdateModels.insert(modelData);
             }
         }
 
-        //then fix instances data
-        for(ModelInstance* instance : renderingModelInstances)
+        relocateModelData([&](VkDeviceSize location) { return FragmentableBuffer::getMovedLocation(moves, location); });
+    }
+
+    void RenderEngine::relocateModelData(const std::function<VkDeviceSize(VkDeviceSize)>& getNewLocation)
+    {
+        //instances reference model data by handle, so only the moved table entries need updating
+        for(uint32_t handle = 0; handle < modelDataOffsets.size(); handle++)
+        {
+            if(modelDataOffsets[handle] == UINT32_MAX) continue;
+
+            const uint32_t newOffset = (uint32_t)getNewLocation(modelDataOffsets[handle]);
+            if(newOffset != modelDataOffsets[handle])
+            {
+                modelDataOffsets[handle] = newOffset;
+                toUpdateModelDataHandles.insert(handle);
+            }
+        }
+    }
+
+    void RenderEngine::rebuildModelDataTableBuffer()
+    {
+        //timer
+        Timer timer(*this, "Rebuild Model Data Table Buffer", IRREGULAR);
+
+        //new buffer to replace old
+        const BufferInfo bufferInfo = {
+            .size = std::max((VkDeviceSize)(modelDataOffsets.size() * sizeof(uint32_t) * modelsDataOverhead), (VkDeviceSize)sizeof(uint32_t) * 128),
+            .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
+            .allocationFlags = 0,
+            .category = MEMORY_MODEL_DATA
+        };
+        modelDataTableBuffer = Buffer(*this, bufferInfo);
+
+        //the table is small enough to rewrite every entry rather than copy the old buffer
+        for(uint32_t handle = 0; handle < modelDataOffsets.size(); handle++)
         {
-            toUpdateModelInstances.insert(instance);
+            if(modelDataOffsets[handle] != UINT32_MAX) toUpdateModelDataHandles.insert(handle);
         }
     }
 
@@ -157,14 +198,12 @@ namespace PaperRenderer
         const BufferInfo bufferInfo = {
             .size = std::max((VkDeviceSize)(renderingModelInstances.size() * sizeof(ShaderModelInstance) * instancesDataOverhead), (VkDeviceSize)sizeof(ShaderModelInstance) * 128),
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_INSTANCE_DATA
         };
         Buffer newBuffer(*this, bufferInfo);
 
-        //idle old buffer
-        instancesDataBuffer.idleOwners();
-
-        //copy
+        //copy; waits on the old buffer's last uses on the GPU instead of idling its owners
         const VkBufferCopy copyRegion = {
             .srcOffset = 0,
             .dstOffset = 0,
@@ -173,7 +212,10 @@ namespace PaperRenderer
 
         if(copyRegion.size)
         {
-            newBuffer.copyFromBufferRanges(instancesDataBuffer, { copyRegion }, {}).idle();
+            const SynchronizationInfo copySyncInfo = {
+                .timelineWaitPairs = instancesDataBuffer.getOwnerSubmissions()
+            };
+            newBuffer.copyFromBufferRanges(instancesDataBuffer, { copyRegion }, copySyncInfo).idle();
         }
         
         //replace old buffer
@@ -186,7 +228,7 @@ namespace PaperRenderer
                     .infos = { {
                         .buffer = instancesDataBuffer.getBuffer(),
                         .offset = 0,
-                        .range = VK_WHOLE_SIZE
+                        .range = instancesDataBuffer.getSize()
                     } },
                     .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                     .binding = 0
@@ -205,14 +247,29 @@ namespace PaperRenderer
         renderingModels.push_back(modelData);
         
         //"write"
-        if(modelDataBuffer.newWrite(NULL, modelData->getShaderData().size(), &modelData->shaderDataReference.shaderDataLocation) == FragmentableBuffer::WriteResult::OUT_OF_MEMORY)
+        VkDeviceSize shaderDataLocation = UINT64_MAX;
+        if(modelDataBuffer.newWrite(NULL, modelData->getShaderData().size(), &shaderDataLocation) == FragmentableBuffer::WriteResult::OUT_OF_MEMORY)
         {
             rebuildModelDataBuffer();
-            modelDataBuffer.newWrite(NULL, modelData->getShaderData().size(), &modelData->shaderDataReference.shaderDataLocation);
+            modelDataBuffer.newWrite(NULL, modelData->getShaderData().size(), &shaderDataLocation);
+        }
+
+        //stable handle; assigned after the write so a compaction during it can't shift the new location
+        if(freeModelDataHandles.size())
+        {
+            modelData->shaderDataReference.handle = freeModelDataHandles.back();
+            freeModelDataHandles.pop_back();
+        }
+        else
+        {
+            modelData->shaderDataReference.handle = modelDataOffsets.size();
+            modelDataOffsets.push_back(UINT32_MAX);
         }
+        modelDataOffsets[modelData->shaderDataReference.handle] = (uint32_t)shaderDataLocation;
 
         //queue data transfer
         toUpdateModels.insert(modelData);
+        toUpdateModelDataHandles.insert(modelData->shaderDataReference.handle);
     }
 
     void RenderEngine::removeModelData(ModelGeometryData* modelData)
@@ -233,10 +290,16 @@ namespace PaperRenderer
         }
 
         //remove from buffer
-        modelDataBuffer.removeFromRange(modelData->shaderDataReference.shaderDataLocation, modelData->getShaderData().size());
+        modelDataBuffer.removeFromRange(modelDataOffsets[modelData->shaderDataReference.handle], modelData->getShaderData().size());
         toUpdateModels.erase(modelData);
 
+        //release handle
+        modelDataOffsets[modelData->shaderDataReference.handle] = UINT32_MAX;
+        freeModelDataHandles.push_back(modelData->shaderDataReference.handle);
+        toUpdateModelDataHandles.erase(modelData->shaderDataReference.handle);
+
         modelData->shaderDataReference.selfIndex = UINT32_MAX;
+        modelData->shaderDataReference.handle = UINT32_MAX;
     }
 
     void RenderEngine::rereferenceModelData(ModelGeometryData* modelData)
@@ -257,12 +320,8 @@ namespace PaperRenderer
         //lock mutex
         std::lock_guard guard(rendererMutex);
 
-        //self reference
-        object->rendererSelfIndex = renderingModelInstances.size();
-        renderingModelInstances.push_back(object);
-        
-        //queue data transfer
-        toUpdateModelInstances.insert(object);
+        //self reference and queue data transfer
+        addQueuedInstance(renderingModelInstances, toUpdateModelInstances, object, [](ModelInstance* instance) -> uint32_t& { return instance->rendererSelfIndex; });
     }
 
     void RenderEngine::removeObject(ModelInstance* object)
@@ -270,26 +329,8 @@ namespace PaperRenderer
         //lock mutex
         std::lock_guard guard(rendererMutex);
         
-        if(renderingModelInstances.size() > 1)
-        {
-            //new reference for last element and remove
-            renderingModelInstances.at(object->rendererSelfIndex) = renderingModelInstances.back();
-            renderingModelInstances.at(object->rendererSelfIndex)->rendererSelfIndex = object->rendererSelfIndex;
-
-            //queue data transfer
-            toUpdateModelInstances.insert(renderingModelInstances.at(object->rendererSelfIndex));
-
-            //remove last element from instances vector (the one that was moved in the mirrored buffer)
-            renderingModelInstances.pop_back();
-        }
-        else
-        {
-            renderingModelInstances.clear();
-        }
-
-        toUpdateModelInstances.erase(object);
-
-        object->rendererSelfIndex = UINT32_MAX;
+        //the moved instance's data transfer is queued
+        removeQueuedInstance(renderingModelInstances, toUpdateModelInstances, object, [](ModelInstance* instance) -> uint32_t& { return instance->rendererSelfIndex; });
     }
 
     void RenderEngine::rereferenceObject(ModelInstance* object)
@@ -305,7 +346,7 @@ namespace PaperRenderer
         renderingModelInstances.at(object->rendererSelfIndex) = object;
     }
 
-    std::vector<StagingBufferTransfer> RenderEngine::queueModelsAndInstancesTransfers()
+    void RenderEngine::queueModelsAndInstancesTransfers(std::pmr::vector<StagingBufferTransfer>& transfers)
     {
         //timer
         Timer timer(*this, "Queue Models and Instances Transfers", REGULAR);
@@ -313,13 +354,22 @@ namespace PaperRenderer
         //lock mutex
         std::lock_guard guard(rendererMutex);
 
+        //move a bit of model data into fragmented space; published moves update the model data table below. Skipped while model data
+        //is being uploaded, since the defragmentation copy doesn't wait on this frame's transfers
+        if(toUpdateModels.empty())
+        {
+            modelDataBuffer.defragment(modelDataDefragmentationBudget);
+        }
+
         //check buffer sizes
         if(instancesDataBuffer.getSize() / sizeof(ShaderModelInstance) < renderingModelInstances.size() && renderingModelInstances.size() > 128)
         {
             rebuildInstancesbuffer();
         }
-
-        std::vector<StagingBufferTransfer> transfers = {};
+        if(modelDataTableBuffer.getSize() / sizeof(uint32_t) < modelDataOffsets.size())
+        {
+            rebuildModelDataTableBuffer();
+        }
 
         //queue instance data
         for(ModelInstance* instance : toUpdateModelInstances)
@@ -328,15 +378,10 @@ namespace PaperRenderer
             if(!instance) continue;
             
             //write instance data
+            const ShaderModelInstance shaderInstance = instance->getShaderInstance();
             transfers.push_back({
                 .dstOffset = sizeof(ShaderModelInstance) * instance->rendererSelfIndex,
-                .data = [&] {
-                    std::vector<uint8_t> transferData(sizeof(ShaderModelInstance));
-                    const ShaderModelInstance shaderInstance = instance->getShaderInstance();
-                    memcpy(transferData.data(), &shaderInstance, sizeof(ShaderModelInstance));
-
-                    return transferData;
-                } (),
+                .dataView = getFrameMemory().copy(&shaderInstance, sizeof(ShaderModelInstance)),
                 .dstBuffer = &instancesDataBuffer
             });
         }
@@ -349,20 +394,75 @@ namespace PaperRenderer
 
             //write model data
             transfers.push_back({
-                .dstOffset = modelData->shaderDataReference.shaderDataLocation,
-                .data = modelData->getShaderData(),
+                .dstOffset = modelDataOffsets[modelData->shaderDataReference.handle],
+                .dataView = modelData->getShaderData(),
                 .dstBuffer = &modelDataBuffer.getBuffer()
             });
         }
 
+        //queue model data table entries; runs of consecutive handles share a transfer
+        for(auto handleIt = toUpdateModelDataHandles.begin(); handleIt != toUpdateModelDataHandles.end();)
+        {
+            const uint32_t firstHandle = *handleIt;
+            uint32_t lastHandle = firstHandle;
+            while(++handleIt != toUpdateModelDataHandles.end() && *handleIt == lastHandle + 1)
+            {
+                lastHandle++;
+            }
+
+            transfers.push_back({
+                .dstOffset = sizeof(uint32_t) * firstHandle,
+                .dataView = std::span((const uint8_t*)&modelDataOffsets[firstHandle], sizeof(uint32_t) * (lastHandle - firstHandle + 1)),
+                .dstBuffer = &modelDataTableBuffer
+            });
+        }
+
         //clear deques
         toUpdateModelInstances.clear();
         toUpdateModels.clear();
+        toUpdateModelDataHandles.clear();
+    }
+
+    void RenderEngine::updateMemoryBudgets()
+    {
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = NULL;
+        vmaGetMemoryProperties(device.getAllocator(), &memoryProperties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+        vmaGetHeapBudgets(device.getAllocator(), budgets.data());
+
+        heapBudgets.clear();
+        for(uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+        {
+            heapBudgets.push_back({
+                .heapIndex = i,
+                .deviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+                .usage = budgets[i].usage,
+                .budget = budgets[i].budget,
+                .allocationBytes = budgets[i].statistics.blockBytes
+            });
+        }
 
-        return transfers;
+        statisticsTracker.updateHeapBudgets(heapBudgets);
     }
 
-    const VkSemaphore& RenderEngine::beginFrame(std::vector<StagingBufferTransfer>& extraTransfers, const SynchronizationInfo& transferSyncInfo)
+    FrameMemory& RenderEngine::getFrameMemory()
+    {
+        //per-thread cache of registered arenas; keyed by engine ID so a destroyed engine's entry can never be reused
+        thread_local std::unordered_map<uint64_t, std::array<FrameMemory, 2>*> threadMemory;
+
+        auto it = threadMemory.find(engineID);
+        if(it == threadMemory.end())
+        {
+            //first use on this thread; register new arenas
+            std::lock_guard guard(frameMemoryRegistrationMutex);
+            it = threadMemory.emplace(engineID, &threadFrameMemory.emplace_back()).first;
+        }
+
+        return (*it->second)[getBufferIndex()];
+    }
+
+    const VkSemaphore& RenderEngine::beginFrame(std::span<const StagingBufferTransfer> extraTransfers, const SynchronizationInfo& transferSyncInfo)
     {
         //clear previous statistics
         statisticsTracker.clearStatistics();
@@ -370,16 +470,31 @@ namespace PaperRenderer
         //idle staging buffer
         stagingBuffer[getBufferIndex()].resetBuffer();
 
-        //reset command pools
+        //release the previous frame's transient memory on every thread; this frame's may already hold extraTransfers
+        {
+            std::lock_guard guard(frameMemoryRegistrationMutex);
+            for(std::array<FrameMemory, 2>& threadMemory : threadFrameMemory)
+            {
+                threadMemory[!getBufferIndex()].reset();
+            }
+        }
+
+        //reset command pools, sync object pools and transient descriptor pools
         device.getCommands().resetCommandPools();
+        device.getCommands().releaseRetiredSemaphores();
+        device.getCommands().releaseDeferredDestructions();
+        descriptors.resetTransientPools();
+
+        //GPU timings from framesInFlight frames ago
+        gpuProfiler.beginFrame();
 
         //acquire next image
         const VkSemaphore& imageAcquireSemaphore = swapchain.acquireNextImage();
 
-        //queue data transfers
-        std::vector<StagingBufferTransfer> transfers = queueModelsAndInstancesTransfers();
-        transfers.insert(transfers.end(), extraTransfers.begin(), extraTransfers.end());
-        stagingBuffer[getBufferIndex()].submitTransfers(transfers, transferSyncInfo);
+        //queue data transfers; extra transfers are recorded after the renderer's own without being copied
+        std::pmr::vector<StagingBufferTransfer> frameTransfers(getFrameMemory().getResource());
+        queueModelsAndInstancesTransfers(frameTransfers);
+        stagingBuffer[getBufferIndex()].submitTransfers({ frameTransfers, extraTransfers }, transferSyncInfo);
 
         //return image acquire semaphore
         return imageAcquireSemaphore;
@@ -399,7 +514,16 @@ namespace PaperRenderer
         //change delta time
         deltaTime = (std::chrono::high_resolution_clock::now() - lastFrameTimePoint).count() / (1000.0 * 1000.0 * 1000.0);
         lastFrameTimePoint = std::chrono::high_resolution_clock::now();
+        statisticsTracker.recordFrameTime(deltaTime);
+
+        if(!device.isHeadless()) glfwPollEvents();
+
+        //GPU memory budgets; VMA refreshes them when the frame index changes
+        vmaSetCurrentFrameIndex(device.getAllocator(), (uint32_t)frameNumber);
+        updateMemoryBudgets();
 
-        glfwPollEvents();
+        //merge statistics recorded by every thread this frame
+        timer.release();
+        statisticsTracker.mergeStatistics();
     }
 }
@@ -11,6 +11,7 @@
 #include "Model.h"
 #include "Camera.h"
 #include "StagingBuffer.h"
+#include "FrameMemory.h"
 
 #include <string>
 #include <vector>
@@ -32,7 +33,9 @@ namespace PaperRenderer
     //struct for RenderEngine
     struct PaperRendererInfo
     {
-        std::function<void(RenderEngine&, const LogEvent&)> logEventCallbackFunction = NULL;
+        std::function<void(RenderEngine&, const LogEvent&)> logEventCallbackFunction = NULL; //called from a background thread unless asynchronousLogging is false
+        LogType minLogLevel = INFO; //logs below this are discarded before being built; can be changed later with Logger::setMinLogLevel()
+        bool asynchronousLogging = true;
         std::function<void(RenderEngine&, VkExtent2D newExtent)> swapchainRebuildCallbackFunction = NULL;
         std::vector<uint32_t> rasterPreprocessSpirv {}; //takes in compiled IndirectDrawBuild.comp spirv data
         std::vector<uint32_t> rtPreprocessSpirv {}; //takes in compiled TLASInstBuild.comp spirv data
@@ -47,7 +50,8 @@ namespace PaperRenderer
         Logger logger;
         StatisticsTracker statisticsTracker;
         Device device;
-        Swapchain swapchain;
+        Swapchain swapchain; //creates the VkDevice
+        GPUProfiler gpuProfiler;
         DescriptorAllocator descriptors;
         std::array<DescriptorSetLayout, 4> defaultDescriptorLayouts;
         RasterPreprocessPipeline rasterPreprocessPipeline;
@@ -59,22 +63,45 @@ namespace PaperRenderer
         ResourceDescriptor instancesBufferDescriptor;
 
         //frame rendering stuff
-        std::vector<ModelInstance*> renderingModelInstances;
+        SwapRemoveList<ModelInstance*> renderingModelInstances;
         std::set<ModelInstance*> toUpdateModelInstances; //queued instance references that need to have their data in GPU buffers updated
         std::vector<ModelGeometryData*> renderingModels;
         std::set<ModelGeometryData*> toUpdateModels; //queued model references that need to have their data in GPU buffers updated
         std::mutex rendererMutex;
+
+        //transient per frame memory; one arena per thread so recording threads never share one, each double buffered so memory taken
+        //before beginFrame() isn't released by it
+        static inline std::atomic<uint64_t> nextEngineID = 0;
+        const uint64_t engineID = nextEngineID++;
+        std::deque<std::array<FrameMemory, 2>> threadFrameMemory; //deque keeps references stable as threads register
+        std::mutex frameMemoryRegistrationMutex; //only locked on a thread's first use and in beginFrame()
+        std::vector<MemoryHeapBudget> heapBudgets; //reused every frame
+
+        //geometry with identical content shares a VBO and BLAS; keyed by content hash
+        std::unordered_map<uint64_t, std::weak_ptr<SharedGeometryResources>> sharedGeometry;
+        std::mutex sharedGeometryMutex;
         
         //----------BUFFERS----------//
 
         const float instancesDataOverhead = 1.4f;
         const float modelsDataOverhead = 1.2f;
+        const VkDeviceSize modelDataDefragmentationBudget = 1048576; //max bytes of model data moved per frame by incremental defragmentation
         Buffer instancesDataBuffer = Buffer(*this, {});
         FragmentableBuffer modelDataBuffer;
+
+        //model data is referenced through stable handles indexing this table of offsets, so a compaction only rewrites the entries that moved
+        Buffer modelDataTableBuffer = Buffer(*this, {});
+        std::vector<uint32_t> modelDataOffsets; //indexed by ShaderDataReference::handle; UINT32_MAX for unused handles
+        std::vector<uint32_t> freeModelDataHandles;
+        std::set<uint32_t> toUpdateModelDataHandles; //queued table entries that need to be updated in the GPU buffer
         
         void rebuildInstancesbuffer();
         void rebuildModelDataBuffer();
+        void rebuildModelDataTableBuffer();
         void handleModelDataCompaction(const std::vector<CompactionResult>& results);
+        void handleModelDataMoves(const std::vector<DefragmentationMove>& moves);
+        void relocateModelData(const std::function<VkDeviceSize(VkDeviceSize)>& getNewLocation);
+        void updateMemoryBudgets();
 
         //----------MODEL AND INSTANCE FUNCTIONS----------//
 
@@ -84,7 +111,7 @@ namespace PaperRenderer
         void addObject(ModelInstance* object);
         void removeObject(ModelInstance* object);
         void rereferenceObject(ModelInstance* object);
-        std::vector<StagingBufferTransfer> queueModelsAndInstancesTransfers();
+        void queueModelsAndInstancesTransfers(std::pmr::vector<StagingBufferTransfer>& transfers);
 
         //----------MISC----------//
 
@@ -106,7 +133,7 @@ namespace PaperRenderer
         RenderEngine(const RenderEngine&) = delete;
 
         //returns the image acquire semaphore from the swapchain
-        const VkSemaphore& beginFrame(std::vector<StagingBufferTransfer>& extraTransfers, const SynchronizationInfo& transferSyncInfo);
+        const VkSemaphore& beginFrame(std::span<const StagingBufferTransfer> extraTransfers, const SynchronizationInfo& transferSyncInfo);
         void endFrame(const std::vector<VkSemaphore>& waitSemaphores); 
 
         uint32_t getBufferIndex() const { return frameNumber % 2; }
@@ -114,16 +141,22 @@ namespace PaperRenderer
         float getDeltaTime() const { return deltaTime; } //returns in seconds
         Logger& getLogger() { return logger; }
         StatisticsTracker& getStatisticsTracker() { return statisticsTracker; }
+        GPUProfiler& getGPUProfiler() { return gpuProfiler; }
         Device& getDevice() { return device; }
         RasterPreprocessPipeline& getRasterPreprocessPipeline() { return rasterPreprocessPipeline; }
         TLASInstanceBuildPipeline& getTLASPreprocessPipeline() { return tlasInstanceBuildPipeline; }
         DescriptorAllocator& getDescriptorAllocator() { return descriptors; }
         Swapchain& getSwapchain() { return swapchain; }
         RendererStagingBuffer& getStagingBuffer() { return stagingBuffer[getBufferIndex()]; }
+        //transient memory for this frame's containers, such as lists of StagingBufferTransfer and their data. Memory taken after endFrame() counts
+        //towards the next frame, and is released by the beginFrame() after that one. Each thread gets its own arena, so containers using it should
+        //only be grown by the thread that created them. Doesn't lock after a thread's first call
+        FrameMemory& getFrameMemory();
         AccelerationStructureBuilder& getAsBuilder() { return asBuilder; }
         const std::vector<ModelGeometryData*>& getModelGeometryDataReferences() const { return renderingModels; }
-        const std::vector<ModelInstance*>& getModelInstanceReferences() const { return renderingModelInstances; }
+        const std::vector<ModelInstance*>& getModelInstanceReferences() const { return renderingModelInstances.getElements(); }
         Buffer& getModelDataBuffer() { return modelDataBuffer.getBuffer(); }
+        const Buffer& getModelDataTableBuffer() const { return modelDataTableBuffer; } //model data offsets indexed by handle; see getModelDataOffset() in Common.glsl
         const VkDescriptorSetLayout& getDefaultDescriptorSetLayout(const DefaultDescriptors descriptor) const { return defaultDescriptorLayouts[descriptor].getSetLayout(); }
         const ResourceDescriptor& getInstancesBufferDescriptor() const { return instancesBufferDescriptor; }
     };
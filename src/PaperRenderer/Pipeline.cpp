@@ -40,15 +40,17 @@ namespace PaperRenderer
         VkResult result = vkCreatePipelineLayout(renderer.getDevice().getDevice(), &layoutInfo, NULL, &returnLayout);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Pipeline layout creation failed"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Pipeline layout creation failed");
         }
 
         return returnLayout;
     }
 
+    VkPipelineCreateFlags Pipeline::getPipelineCreateFlags() const
+    {
+        return renderer.getDevice().getGPUFeaturesAndProperties().descriptorBuffer ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+    }
+
     //----------COMPUTE PIPELINE DEFINITIONS---------//
 
     ComputePipeline::ComputePipeline(RenderEngine& renderer, const ComputePipelineInfo& creationInfo)
@@ -65,7 +67,7 @@ namespace PaperRenderer
         const VkComputePipelineCreateInfo pipelineInfo = {
             .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
             .pNext = NULL,
-            .flags = 0,
+            .flags = getPipelineCreateFlags(),
             .stage = {
                 .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
                 .pNext = &shaderModuleInfo,
@@ -81,10 +83,7 @@ namespace PaperRenderer
         VkResult result = vkCreateComputePipelines(renderer.getDevice().getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create compute pipeline"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create compute pipeline");
         }
     }
 
@@ -201,7 +200,7 @@ namespace PaperRenderer
         const VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
             .pNext = &renderingInfo,
-            .flags = 0,
+            .flags = getPipelineCreateFlags(),
             .stageCount = (uint32_t)shaderStages.size(),
             .pStages = shaderStages.data(),
             .pVertexInputState = &vertexInputInfo,
@@ -223,10 +222,7 @@ namespace PaperRenderer
         VkResult result = vkCreateGraphicsPipelines(renderer.getDevice().getDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create a graphics pipeline"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create a graphics pipeline");
         }
     }
 
@@ -376,10 +372,7 @@ namespace PaperRenderer
                 }
                 else
                 {
-                    renderer.getLogger().recordLog({
-                        .type = WARNING,
-                        .text = "Invalid ShaderHitGroup shader group must contain either a closest hit or intersection shader"
-                    });
+                    renderer.getLogger().recordLog(WARNING, "Invalid ShaderHitGroup shader group must contain either a closest hit or intersection shader");
                 }
 
                 return shaderGroupInfo;
@@ -397,7 +390,7 @@ namespace PaperRenderer
         const VkRayTracingPipelineCreateInfoKHR pipelineCreateInfo = {
             .sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
             .pNext = NULL,
-            .flags = 0,
+            .flags = getPipelineCreateFlags(),
             .stageCount = (uint32_t)shaderStages.size(),
             .pStages = shaderStages.data(),
             .groupCount = (uint32_t)rtShaderGroups.size(),
@@ -414,10 +407,7 @@ namespace PaperRenderer
         VkResult result = vkCreateRayTracingPipelinesKHR(renderer.getDevice().getDevice(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline);
         if(result != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create a ray tracing pipeline"
-            });
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create a ray tracing pipeline");
         }
 
 
@@ -508,10 +498,7 @@ namespace PaperRenderer
         VkResult result2 = vkGetRayTracingShaderGroupHandlesKHR(renderer.getDevice().getDevice(), pipeline, groupOffset, handleCount, groupHandles.size(), groupHandles.data());
         if(result2 != VK_SUCCESS)
         {
-            renderer.getLogger().recordLog({
-                .type = WARNING,
-                .text = "vkGetRayTracingShaderGroupHandlesKHR failed on RT pipeline creation"
-            });
+            renderer.getLogger().recordLog(WARNING, "vkGetRayTracingShaderGroupHandlesKHR failed on RT pipeline creation");
             return;
         }
 
@@ -534,7 +521,8 @@ namespace PaperRenderer
         const BufferInfo sbtBufferInfo = {
             .size = sbtRawData.size(),
             .usageFlags = VK_BUFFER_USAGE_2_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_DESCRIPTOR
         };
         sbtBuffer = Buffer(renderer, sbtBufferInfo);
 
@@ -23,6 +23,7 @@ namespace PaperRenderer
         VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 
         VkPipelineLayout createPipelineLayout(class RenderEngine& renderer, const std::unordered_map<uint32_t, VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pcRanges) const noexcept;
+        VkPipelineCreateFlags getPipelineCreateFlags() const; //flags required by the active descriptor backend
 
         class RenderEngine& renderer;
         
@@ -56,6 +56,7 @@ namespace PaperRenderer
 
         //bind pipeline
         vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, pipeline->getPipeline());
+        renderer.getDescriptorAllocator().bindDescriptorBuffer(cmdBuffer);
 
         //bind descriptors
         for(const SetBinding& setBinding : rtRenderInfo.descriptorBindings)
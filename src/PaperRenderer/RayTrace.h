@@ -67,6 +67,7 @@ namespace PaperRenderer
         class RenderEngine& renderer;
 
         friend TLAS;
+        friend class AccelerationStructureBuilder;
 
     public:
         RayTraceRender(
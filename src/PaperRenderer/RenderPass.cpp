@@ -37,25 +37,19 @@ namespace PaperRenderer
         renderer(renderer)
     {
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "RasterPreprocessPipeline constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "RasterPreprocessPipeline constructor finished");
     }
     
     RasterPreprocessPipeline::~RasterPreprocessPipeline()
     {
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "RasterPreprocessPipeline destructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "RasterPreprocessPipeline destructor finished");
     }
 
     void RasterPreprocessPipeline::submit(VkCommandBuffer cmdBuffer, const RenderPass& renderPass, const Camera& camera)
     {
         //descriptor bindings
-        const std::vector<SetBinding> descriptorBindings = {
+        const SetBinding descriptorBindings[] = {
             { //set 0 (UBO input data)
                 .set = renderPass.uboDescriptor,
                 .binding = {
@@ -95,6 +89,7 @@ namespace PaperRenderer
         };
 
         //dispatch
+        GPUTimer gpuTimer(renderer, cmdBuffer, GRAPHICS, "Raster Preprocess", REGULAR);
         computeShader.dispatch(cmdBuffer, descriptorBindings, glm::uvec3((renderPass.renderPassInstances.size() / 128) + 1, 1, 1));
     }
 
@@ -105,29 +100,37 @@ namespace PaperRenderer
             .size = sizeof(RasterPreprocessPipeline::UBOInputData),
             .usageFlags = VK_BUFFER_USAGE_2_UNIFORM_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT,
             .allocationFlags = 0, //doesnt need to be host visible since updated via staging buffer
+            .category = MEMORY_RENDER_PASS
         }),
         instancesBuffer(renderer, {
             .size = sizeof(RenderPassInstance) * 64,
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_RENDER_PASS
         }),
         sortedInstancesOutputBuffer(renderer, {
             .size = sizeof(ShaderOutputObject) * 64,
             .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR,
-            .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+            .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
+            .category = MEMORY_RENDER_PASS
         }),
         instancesDataBuffer(renderer, {
             .size = 4096,
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_RENDER_PASS
         }, 8),
         transferSemaphore(renderer.getDevice().getCommands().getTimelineSemaphore(transferSemaphoreValue)),
         uboDescriptor(renderer, renderer.getRasterPreprocessPipeline().getUboDescriptorLayout()),
         ioDescriptor(renderer, renderer.getRasterPreprocessPipeline().getIODescriptorLayout()),
-        sortedMatricesDescriptor(renderer, renderer.getDefaultDescriptorSetLayout(INDIRECT_DRAW_MATRICES)),
+        sortedMatricesDescriptor(renderer, renderer.getDefaultDescriptorSetLayout(INDIRECT_DRAW_MATRICES), true),
         renderer(renderer),
         defaultMaterialInstance(defaultMaterialInstance)
     {
+        // Material data offsets are shifted on compaction and defragmentation
+        instancesDataBuffer.setCompactionCallback([this](std::vector<CompactionResult> results){ handleMaterialDataCompaction(results); });
+        instancesDataBuffer.setDefragmentationCallback([this](const std::vector<DefragmentationMove>& moves){ handleMaterialDataMoves(moves); });
+
         // Update descriptors
         uboDescriptor.updateDescriptorSet({
             .bufferWrites = {
@@ -148,32 +151,18 @@ namespace PaperRenderer
                 .infos = { {
                     .buffer = instancesBuffer.getBuffer(),
                     .offset = 0,
-                    .range = VK_WHOLE_SIZE //actual data range controlled by UBO object count
+                    .range = instancesBuffer.getSize() //actual data range controlled by UBO object count
                 } },
                 .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .binding = 0
             } }
         });
-
-        sortedMatricesDescriptor.updateDescriptorSet({
-            .bufferWrites = {
-                { //binding 0: input objects
-                    .infos = { {
-                        .buffer = sortedInstancesOutputBuffer.getBuffer(),
-                        .offset = 0,
-                        .range = VK_WHOLE_SIZE
-                    } },
-                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    .binding = 0
-                }
-            }
-        });
     }
 
     RenderPass::~RenderPass()
     {
-        //destroy semaphore
-        vkDestroySemaphore(renderer.getDevice().getDevice(), transferSemaphore, nullptr);
+        //recycle semaphore
+        renderer.getDevice().getCommands().recycleTimelineSemaphore(transferSemaphore, transferSemaphoreValue);
 
         //remove references
         for(ModelInstance* instance : renderPassInstances)
@@ -191,7 +180,8 @@ namespace PaperRenderer
         const BufferInfo instancesBufferInfo = {
             .size = (VkDeviceSize)(renderPassInstances.size() * sizeof(RenderPassInstance) * instancesOverhead),
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_RENDER_PASS
         };
         Buffer newInstancesBuffer(renderer, instancesBufferInfo);
 
@@ -219,7 +209,7 @@ namespace PaperRenderer
                 .infos = { {
                     .buffer = instancesBuffer.getBuffer(),
                     .offset = 0,
-                    .range = VK_WHOLE_SIZE //actual data range controlled by UBO object count
+                    .range = instancesBuffer.getSize() //actual data range controlled by UBO object count
                 } },
                 .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .binding = 0
@@ -236,27 +226,13 @@ namespace PaperRenderer
         const BufferInfo sortedInstancesBufferInfo = {
             .size = (VkDeviceSize)(renderPassSortedInstances.size() * sizeof(ShaderOutputObject) * instancesOverhead),
             .usageFlags = VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR,
-            .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+            .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
+            .category = MEMORY_RENDER_PASS
         };
         Buffer newSortedInstancesBuffer(renderer, sortedInstancesBufferInfo);
 
-        //replace old buffer
+        //replace old buffer; the sorted matrices descriptor is written per frame
         sortedInstancesOutputBuffer = std::move(newSortedInstancesBuffer);
-
-        //update descriptors
-        sortedMatricesDescriptor.updateDescriptorSet({
-            .bufferWrites = {
-                { //binding 0: input objects
-                    .infos = { {
-                        .buffer = sortedInstancesOutputBuffer.getBuffer(),
-                        .offset = 0,
-                        .range = VK_WHOLE_SIZE
-                    } },
-                    .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    .binding = 0
-                }
-            }
-        });
     }
 
     void RenderPass::rebuildMaterialDataBuffer()
@@ -271,14 +247,16 @@ namespace PaperRenderer
         const BufferInfo instancesMaterialDataBufferInfo = {
             .size = (VkDeviceSize)(instancesDataBuffer.getDesiredLocation() * instancesOverhead),
             .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR | VK_BUFFER_USAGE_2_TRANSFER_DST_BIT_KHR | VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR,
-            .allocationFlags = 0
+            .allocationFlags = 0,
+            .category = MEMORY_RENDER_PASS
         };
         FragmentableBuffer newInstancesDataBuffer(renderer, instancesMaterialDataBufferInfo, 8);
         newInstancesDataBuffer.setCompactionCallback([this](std::vector<CompactionResult> results){ handleMaterialDataCompaction(results); });
+        newInstancesDataBuffer.setDefragmentationCallback([this](const std::vector<DefragmentationMove>& moves){ handleMaterialDataMoves(moves); });
 
         //copy old data into new
         const VkDeviceSize newMaterialDataWriteSize = instancesDataBuffer.getStackLocation();
-        newInstancesDataBuffer.newWrite(NULL, newMaterialDataWriteSize, NULL);
+        newInstancesDataBuffer.copyAllocations(instancesDataBuffer);
 
         const VkBufferCopy materialDataCopyRegion = {
             .srcOffset = 0,
@@ -295,7 +273,7 @@ namespace PaperRenderer
         instancesDataBuffer = std::move(newInstancesDataBuffer);
     }
 
-    void RenderPass::queueInstanceTransfers(std::vector<StagingBufferTransfer>& stagingBufferTransfers)
+    void RenderPass::queueInstanceTransfers(std::pmr::vector<StagingBufferTransfer>& stagingBufferTransfers)
     {
         //Timer
         Timer timer(renderer, "RenderPass Queue instance Transfers", REGULAR);
@@ -308,7 +286,7 @@ namespace PaperRenderer
         {
             for(auto& [materialInstance, meshGroups] : materialInstanceNode) //material instances
             {
-                const std::vector<ModelInstance*> meshGroupUpdatedInstances = meshGroups.verifyBufferSize(stagingBufferTransfers);
+                const std::pmr::vector<ModelInstance*> meshGroupUpdatedInstances = meshGroups.verifyBufferSize(stagingBufferTransfers);
                 toUpdateInstances.insert(meshGroupUpdatedInstances.begin(), meshGroupUpdatedInstances.end());
             }
         }
@@ -323,6 +301,13 @@ namespace PaperRenderer
             rebuildSortedInstancesBuffer();
         }
 
+        //move a bit of material data into fragmented space; published moves queue their instances' records. Skipped while material data
+        //is being uploaded, since the defragmentation copy doesn't wait on this frame's transfers
+        if(toUpdateInstances.empty())
+        {
+            instancesDataBuffer.defragment(materialDataDefragmentationBudget);
+        }
+
         //material data pseudo writes (this doesn't actually write anything its just to setup the fragmentable buffer)
         for(ModelInstance* instance : toUpdateInstances)
         {
@@ -340,21 +325,28 @@ namespace PaperRenderer
             instance->setRenderPassInstanceData(this);
             const std::vector<uint8_t>& materialData = instance->getRenderPassInstanceData(this);
 
-            //write new
-            FragmentableBuffer::WriteResult writeResult = instancesDataBuffer.newWrite(NULL, materialData.size(), &(instance->renderPassSelfReferences[this].LODsMaterialDataOffset));
-            if(writeResult == FragmentableBuffer::OUT_OF_MEMORY)
+            //write new; a compaction during the write already shifted the offsets of instances written before this one
+            if(instancesDataBuffer.newWrite(NULL, materialData.size(), &(instance->renderPassSelfReferences[this].LODsMaterialDataOffset)) == FragmentableBuffer::OUT_OF_MEMORY)
             {
                 rebuildMaterialDataBuffer();
                 instancesDataBuffer.newWrite(NULL, materialData.size(), &(instance->renderPassSelfReferences[this].LODsMaterialDataOffset));
             }
-            else if(writeResult == FragmentableBuffer::COMPACTED)
-            {
-                //recursive redo (handling compaction resets the instances)
-                queueInstanceTransfers(stagingBufferTransfers);
-                return;
-            }
         }
 
+        //instance records reference material data by offset
+        const auto queueInstanceRecord = [&](ModelInstance* instance) {
+            const RenderPassInstance instanceShaderData = {
+                .modelInstanceIndex = instance->rendererSelfIndex,
+                .LODsMaterialDataOffset = (uint32_t)instance->renderPassSelfReferences[this].LODsMaterialDataOffset,
+                .isVisible = true
+            };
+            stagingBufferTransfers.push_back({
+                .dstOffset = sizeof(RenderPassInstance) * instance->renderPassSelfReferences[this].selfIndex,
+                .dataView = renderer.getFrameMemory().copy(&instanceShaderData, sizeof(RenderPassInstance)),
+                .dstBuffer = &instancesBuffer
+            });
+        };
+
         //queue instance data
         for(ModelInstance* instance : toUpdateInstances)
         {
@@ -364,44 +356,51 @@ namespace PaperRenderer
             //queue material data write
             stagingBufferTransfers.push_back({
                 .dstOffset = instance->renderPassSelfReferences[this].LODsMaterialDataOffset,
-                .data = instance->getRenderPassInstanceData(this),
+                .dataView = instance->getRenderPassInstanceData(this),
                 .dstBuffer = &instancesDataBuffer.getBuffer()
             });
 
             //queue instance data transfer
-            stagingBufferTransfers.push_back({
-                .dstOffset = sizeof(RenderPassInstance) * instance->renderPassSelfReferences[this].selfIndex,
-                .data = [&] {
-                    const RenderPassInstance instanceShaderData = {
-                        .modelInstanceIndex = instance->rendererSelfIndex,
-                        .LODsMaterialDataOffset = (uint32_t)instance->renderPassSelfReferences[this].LODsMaterialDataOffset,
-                        .isVisible = true
-                    };
-                    std::vector<uint8_t> transferData(sizeof(RenderPassInstance));
-                    memcpy(transferData.data(), &instanceShaderData, sizeof(RenderPassInstance));
+            queueInstanceRecord(instance);
+        }
 
-                    return transferData;
-                } (),
-                .dstBuffer = &instancesBuffer
-            });
+        //queue records of instances only moved by compactions
+        for(ModelInstance* instance : toUpdateInstanceRecords)
+        {
+            if(!toUpdateInstances.count(instance))
+            {
+                queueInstanceRecord(instance);
+            }
         }
 
         //clear deques
         toUpdateInstances.clear();
+        toUpdateInstanceRecords.clear();
     }
 
     void RenderPass::handleMaterialDataCompaction(const std::vector<CompactionResult>& results)
     {
-        //fix material data offsets
-        for(const CompactionResult compactionResult : results)
+        relocateMaterialData([&](VkDeviceSize location) { return FragmentableBuffer::getCompactedLocation(results, location); });
+    }
+
+    void RenderPass::handleMaterialDataMoves(const std::vector<DefragmentationMove>& moves)
+    {
+        relocateMaterialData([&](VkDeviceSize location) { return FragmentableBuffer::getMovedLocation(moves, location); });
+    }
+
+    void RenderPass::relocateMaterialData(const std::function<VkDeviceSize(VkDeviceSize)>& getNewLocation)
+    {
+        //fix material data offsets; only instances whose data actually moved need their records rewritten
+        for(ModelInstance* instance : renderPassInstances)
         {
-            for(ModelInstance* instance : renderPassInstances)
+            VkDeviceSize& materialDataOffset = instance->renderPassSelfReferences[this].LODsMaterialDataOffset;
+            if(materialDataOffset != UINT64_MAX)
             {
-                VkDeviceSize& materialDataOffset = instance->renderPassSelfReferences[this].LODsMaterialDataOffset;
-                if(materialDataOffset != UINT64_MAX && materialDataOffset > compactionResult.location)
+                const VkDeviceSize newOffset = getNewLocation(materialDataOffset);
+                if(newOffset != materialDataOffset)
                 {
-                    //shift stored location
-                    materialDataOffset -= compactionResult.shiftSize;
+                    materialDataOffset = newOffset;
+                    toUpdateInstanceRecords.insert(instance);
                 }
             }
         }
@@ -439,6 +438,7 @@ namespace PaperRenderer
 
         //renderer instances
         renderer.instancesDataBuffer.addOwner(queue);
+        renderer.modelDataTableBuffer.addOwner(queue);
     }
 
     Queue& RenderPass::render(const RenderPassInfo& renderPassInfo, SynchronizationInfo syncInfo)
@@ -463,7 +463,7 @@ namespace PaperRenderer
         }
 
         //staging buffer transfer group
-        std::vector<StagingBufferTransfer> stagingBufferTransfers = {};
+        std::pmr::vector<StagingBufferTransfer> stagingBufferTransfers(renderer.getFrameMemory().getResource());
 
         //instance transfers
         queueInstanceTransfers(stagingBufferTransfers);
@@ -475,20 +475,16 @@ namespace PaperRenderer
         if(renderPassInstances.size())
         {
             //queue update of preprocess UBO data
+            const RasterPreprocessPipeline::UBOInputData preprocessUBOData = {
+                .materialDataPtr = instancesDataBuffer.getBuffer().getBufferDeviceAddress(),
+                .modelDataPtr = renderer.modelDataBuffer.getBuffer().getBufferDeviceAddress(),
+                .modelDataTablePtr = renderer.modelDataTableBuffer.getBufferDeviceAddress(),
+                .objectCount = (uint32_t)renderPassInstances.size(),
+                .doCulling = true
+            };
             stagingBufferTransfers.push_back({
                 .dstOffset = 0,
-                .data = [&] {
-                    const RasterPreprocessPipeline::UBOInputData uboInputData = {
-                        .materialDataPtr = instancesDataBuffer.getBuffer().getBufferDeviceAddress(),
-                        .modelDataPtr = renderer.modelDataBuffer.getBuffer().getBufferDeviceAddress(),
-                        .objectCount = (uint32_t)renderPassInstances.size(),
-                        .doCulling = true
-                    };
-                    std::vector<uint8_t> transferData(sizeof(RasterPreprocessPipeline::UBOInputData));
-                    memcpy(transferData.data(), &uboInputData, sizeof(RasterPreprocessPipeline::UBOInputData));
-
-                    return transferData;
-                } (),
+                .dataView = renderer.getFrameMemory().copy(&preprocessUBOData, sizeof(RasterPreprocessPipeline::UBOInputData)),
                 .dstBuffer = &preprocessUniformBuffer
             });
 
@@ -531,6 +527,7 @@ namespace PaperRenderer
             .pDepthAttachment = renderPassInfo.depthAttachment,
             .pStencilAttachment = renderPassInfo.stencilAttachment
         };
+        GPUTimer drawGPUTimer(renderer, cmdBuffer, GRAPHICS, "RenderPass Draw", REGULAR);
         vkCmdBeginRendering(cmdBuffer, &renderInfo);
 
         //scissors and viewports
@@ -567,7 +564,7 @@ namespace PaperRenderer
             Timer timer(renderer, "RenderPass Render Sorted Instances Recording", REGULAR);
 
             //sort sorted instances
-            std::vector<SortedInstance*> sortedInstances;
+            std::pmr::vector<SortedInstance*> sortedInstances(renderer.getFrameMemory().getResource());
             sortedInstances.reserve(renderPassSortedInstances.size());
             for(SortedInstance& instance : renderPassSortedInstances)
             {
@@ -591,7 +588,7 @@ namespace PaperRenderer
             });
 
             //calculate model matrices and transfer them to the sortedInstancesOutputBuffer
-            std::vector<ShaderOutputObject> sortedInstancesMatricesData(sortedInstances.size());
+            std::pmr::vector<ShaderOutputObject> sortedInstancesMatricesData(sortedInstances.size(), renderer.getFrameMemory().getResource());
             for(uint32_t i = 0; i < sortedInstances.size(); i++)
             {
                 ModelTransformation transform = sortedInstances[i]->instance->getTransformation();
@@ -639,6 +636,22 @@ namespace PaperRenderer
             };
             sortedInstancesOutputBuffer.writeToBuffer({ matricesWrite });
 
+            //fresh transient set each frame, so a set still bound by a previous frame's commands is never rewritten
+            sortedMatricesDescriptor = ResourceDescriptor(renderer, renderer.getDefaultDescriptorSetLayout(INDIRECT_DRAW_MATRICES), true);
+            sortedMatricesDescriptor.updateDescriptorSet({
+                .bufferWrites = {
+                    { //binding 0: input objects
+                        .infos = { {
+                            .buffer = sortedInstancesOutputBuffer.getBuffer(),
+                            .offset = 0,
+                            .range = sortedInstancesOutputBuffer.getSize()
+                        } },
+                        .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                        .binding = 0
+                    }
+                }
+            });
+
             //LOD index function (tbh i should really change this whole function)
             auto getLODIndex = [&](ModelInstance* instance)
             {
@@ -671,7 +684,6 @@ namespace PaperRenderer
                     Material* material = ((Material*)(&materialInstance->getBaseMaterial()));
 
                     //bind material
-                    std::unordered_map<uint32_t, PaperRenderer::DescriptorWrites> materialDescriptorWrites;
                     material->bind(cmdBuffer, renderPassInfo.camera);
 
                     //bind material instance
@@ -710,6 +722,7 @@ namespace PaperRenderer
 
         //end rendering
         vkCmdEndRendering(cmdBuffer);
+        drawGPUTimer.release();
 
         //post-render barriers
         if(renderPassInfo.postRenderBarriers)
@@ -750,53 +763,27 @@ namespace PaperRenderer
         if(sorted)
         {
             //add reference
-            instance.renderPassSelfReferences[this].selfIndex = renderPassSortedInstances.size();
+            instance.renderPassSelfReferences[this].selfIndex = renderPassSortedInstances.add({ &instance, materials });
             instance.renderPassSelfReferences[this].sorted = true;
-            renderPassSortedInstances.push_back({ &instance, materials });
         }
         else
         {
             //material data
-            materials.resize(instance.getParentModel().getLODs().size());
-            for(uint32_t lodIndex = 0; lodIndex < instance.getParentModel().getLODs().size(); lodIndex++)
-            {
-                for(uint32_t matIndex = 0; matIndex < instance.getParentModel().getLODs().at(lodIndex).materialMeshes.size(); matIndex++) //iterate materials in LOD
-                {
-                    //get material instance
-                    MaterialInstance* materialInstance;
-                    if(materials.at(lodIndex).count(matIndex) && materials.at(lodIndex).at(matIndex)) //check if slot is initialized and not NULL
-                    {
-                        materialInstance = materials.at(lodIndex).at(matIndex);
-                    }
-                    else //use default material if one isn't selected
-                    {
-                        materialInstance = &defaultMaterialInstance;
-                    }
-
-                    //get mesh using same material
-                    const LODMesh& similarMesh = instance.getParentModel().getLODs().at(lodIndex).materialMeshes.at(matIndex);
-
-                    //check if mesh group class is created
-                    if(!renderTree[(Material*)&materialInstance->getBaseMaterial()].count(materialInstance))
-                    {
-                        renderTree[(Material*)&materialInstance->getBaseMaterial()].emplace(std::piecewise_construct, std::forward_as_tuple(materialInstance), std::forward_as_tuple(renderer, *this, materialInstance->getBaseMaterial()));
-                    }
-
-                    //add references
-                    renderTree[(Material*)&materialInstance->getBaseMaterial()].at(materialInstance).addInstanceMesh(instance, similarMesh);
-
-                    instance.renderPassSelfReferences[this].meshGroupReferences[&instance.getParentModel().getLODs().at(lodIndex).materialMeshes.at(matIndex)] = 
-                        &renderTree.at((Material*)&materialInstance->getBaseMaterial()).at(materialInstance);
-                }
-            }
-
-            //add reference
-            instance.renderPassSelfReferences[this].selfIndex = renderPassInstances.size();
-            instance.renderPassSelfReferences[this].sorted = false;
-            renderPassInstances.push_back(&instance);
+            const std::vector<LOD>& lods = instance.getParentModel().getLODs();
+            ModelInstance::RenderPassData& renderPassData = instance.renderPassSelfReferences[this];
+            materials.resize(lods.size());
+            addRenderTreeInstance(instance, lods, renderPassData.meshGroupReferences, [&](uint32_t lodIndex, uint32_t matIndex) -> CommonMeshGroup& {
+                //get material instance; use default material if one isn't selected or the slot is NULL
+                const auto selectedMaterial = materials[lodIndex].find(matIndex);
+                MaterialInstance* materialInstance = selectedMaterial != materials[lodIndex].end() && selectedMaterial->second ? selectedMaterial->second : &defaultMaterialInstance;
+
+                //get or create mesh group
+                return getRenderTreeGroup(renderTree, (Material*)&materialInstance->getBaseMaterial(), materialInstance, renderer, *this, materialInstance->getBaseMaterial());
+            });
 
-            //add instance to queue
-            toUpdateInstances.insert(&instance);
+            //add reference and add instance to queue
+            addQueuedInstance(renderPassInstances, toUpdateInstances, &instance, [this](ModelInstance* queuedInstance) -> uint32_t& { return queuedInstance->renderPassSelfReferences[this].selfIndex; });
+            renderPassData.sorted = false;
         }
     }
 
@@ -809,47 +796,28 @@ namespace PaperRenderer
         if(instance.renderPassSelfReferences.count(this))
         {
             //remove from mesh groups
-            for(auto& [mesh, reference] : instance.renderPassSelfReferences[this].meshGroupReferences)
-            {
-                reference->removeInstanceMeshes(instance);
-            }
-            instance.renderPassSelfReferences[this].meshGroupReferences.clear();
+            removeRenderTreeInstance(instance, instance.renderPassSelfReferences[this].meshGroupReferences);
 
             //shift instances
             const uint32_t selfReference = instance.renderPassSelfReferences[this].selfIndex;
             if(instance.renderPassSelfReferences[this].sorted)
             {
-                if(renderPassSortedInstances.size() > 1)
+                if(SortedInstance* movedInstance = renderPassSortedInstances.remove(selfReference))
                 {
-                    renderPassSortedInstances[selfReference] = renderPassSortedInstances.back();
-                    renderPassSortedInstances[selfReference].instance->renderPassSelfReferences[this].selfIndex = selfReference;
-
-                    renderPassSortedInstances.pop_back();
-                }
-                else
-                {
-                    renderPassSortedInstances.clear();
+                    movedInstance->instance->renderPassSelfReferences[this].selfIndex = selfReference;
                 }
             }
             else
             {
-                if(renderPassInstances.size() > 1)
-                {
-                    renderPassInstances[selfReference] = renderPassInstances.back();
-                    renderPassInstances[selfReference]->renderPassSelfReferences[this].selfIndex = selfReference;
-
-                    //queue data transfer
-                    toUpdateInstances.erase(&instance);
-                    toUpdateInstances.insert(renderPassInstances[selfReference]);
-                    
-                    renderPassInstances.pop_back();
-                }
-                else
+                //the moved instance's data transfer is queued, and its whole record rewritten
+                if(ModelInstance* movedInstance = removeQueuedInstance(renderPassInstances, toUpdateInstances, &instance, [this](ModelInstance* queuedInstance) -> uint32_t& { return queuedInstance->renderPassSelfReferences[this].selfIndex; }))
                 {
-                    renderPassInstances.clear();
+                    toUpdateInstanceRecords.erase(movedInstance);
                 }
             }
 
+            toUpdateInstanceRecords.erase(&instance);
+
             //remove data from fragmenable buffer if referenced
             if(instance.renderPassSelfReferences[this].LODsMaterialDataOffset != UINT64_MAX)
             {
@@ -879,6 +847,13 @@ namespace PaperRenderer
                     toUpdateInstances.insert(&instance);
                 }
 
+                auto recordIt = toUpdateInstanceRecords.find(renderPassInstances.at(instance.renderPassSelfReferences.at(this).selfIndex));
+                if(recordIt != toUpdateInstanceRecords.end())
+                {
+                    toUpdateInstanceRecords.erase(recordIt);
+                    toUpdateInstanceRecords.insert(&instance);
+                }
+
                 for(auto& [mesh, meshGroup] : instance.renderPassSelfReferences.at(this).meshGroupReferences)
                 {
                     meshGroup->rereferenceInstance(renderPassInstances.at(instance.renderPassSelfReferences.at(this).selfIndex), &instance);
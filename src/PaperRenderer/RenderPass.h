@@ -29,9 +29,10 @@ namespace PaperRenderer
         {
             VkDeviceAddress materialDataPtr = 0;
             VkDeviceAddress modelDataPtr = 0;
+            VkDeviceAddress modelDataTablePtr = 0;
             uint32_t objectCount = 0;
             bool doCulling = true;
-            float padding[9];
+            float padding[7];
         };
 
         void submit(VkCommandBuffer cmdBuffer, const RenderPass& renderPass, const Camera& camera);
@@ -69,17 +70,19 @@ namespace PaperRenderer
     {
     private:
         //render tree and sorted instances
-        std::unordered_map<Material*, std::unordered_map<MaterialInstance*, CommonMeshGroup>> renderTree; //render tree
+        RenderTree<Material, MaterialInstance, CommonMeshGroup> renderTree; //render tree
         struct SortedInstance
         {
             ModelInstance* instance;
             std::vector<std::unordered_map<uint32_t, MaterialInstance*>> materials;
         };
-        std::vector<SortedInstance> renderPassSortedInstances;
+        SwapRemoveList<SortedInstance> renderPassSortedInstances;
 
         static constexpr float instancesOverhead = 1.5f;
-        std::vector<ModelInstance*> renderPassInstances; //doesn't included sorted
+        static constexpr VkDeviceSize materialDataDefragmentationBudget = 262144; //max bytes of material data moved per frame by incremental defragmentation
+        SwapRemoveList<ModelInstance*> renderPassInstances; //doesn't included sorted
         std::set<ModelInstance*> toUpdateInstances; //doesn't included sorted
+        std::set<ModelInstance*> toUpdateInstanceRecords; //instances whose material data was moved by a compaction; only their RenderPassInstance needs rewriting
         std::mutex renderPassMutex;
 
         //buffers
@@ -103,14 +106,16 @@ namespace PaperRenderer
         };
         ResourceDescriptor uboDescriptor;
         ResourceDescriptor ioDescriptor;
-        ResourceDescriptor sortedMatricesDescriptor;
+        ResourceDescriptor sortedMatricesDescriptor; //transient; reallocated each frame in render()
 
         //functions
         void rebuildInstancesBuffer();
         void rebuildSortedInstancesBuffer();
         void rebuildMaterialDataBuffer();
-        void queueInstanceTransfers(std::vector<StagingBufferTransfer>& stagingBufferTransfers);
+        void queueInstanceTransfers(std::pmr::vector<StagingBufferTransfer>& stagingBufferTransfers);
         void handleMaterialDataCompaction(const std::vector<CompactionResult>&);
+        void handleMaterialDataMoves(const std::vector<DefragmentationMove>& moves);
+        void relocateMaterialData(const std::function<VkDeviceSize(VkDeviceSize)>& getNewLocation);
         void clearDrawCounts(VkCommandBuffer cmdBuffer);
         void assignResourceOwner(Queue& queue);
 
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <initializer_list>
+
+namespace PaperRenderer
+{
+    // Vector with room for inlineCapacity elements inside of itself, so the short lists built for every submission or write (semaphores, command
+    // buffers, buffer writes) don't allocate. Elements spill into a heap vector once it outgrows that. T must be default constructible and copyable
+    //** NOT THREAD SAFE **
+    template<typename T, uint32_t inlineCapacity>
+    class SmallVector
+    {
+    private:
+        std::array<T, inlineCapacity> inlineElements = {};
+        std::vector<T> heapElements = {}; //holds every element once count is past inlineCapacity
+        uint32_t count = 0;
+
+    public:
+        SmallVector() = default;
+        SmallVector(std::initializer_list<T> elements)
+        {
+            for(const T& element : elements) push_back(element);
+        }
+        SmallVector(const std::vector<T>& elements)
+        {
+            for(const T& element : elements) push_back(element);
+        }
+
+        void push_back(const T& element)
+        {
+            if(count < inlineCapacity)
+            {
+                inlineElements[count] = element;
+            }
+            else
+            {
+                //move inline elements to the heap on the first overflow
+                if(count == inlineCapacity) heapElements.assign(inlineElements.begin(), inlineElements.end());
+                heapElements.push_back(element);
+            }
+            count++;
+        }
+
+        void clear()
+        {
+            heapElements.clear();
+            count = 0;
+        }
+
+        T* data() { return count > inlineCapacity ? heapElements.data() : inlineElements.data(); }
+        const T* data() const { return count > inlineCapacity ? heapElements.data() : inlineElements.data(); }
+        uint32_t size() const { return count; }
+        bool empty() const { return !count; }
+        T& operator[](const uint32_t index) { return data()[index]; }
+        const T& operator[](const uint32_t index) const { return data()[index]; }
+        T* begin() { return data(); }
+        T* end() { return data() + count; }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + count; }
+    };
+}
@@ -1,6 +1,8 @@
 #include "StagingBuffer.h"
 #include "PaperRenderer.h"
 
+#include <algorithm>
+
 namespace PaperRenderer
 {
     RendererStagingBuffer::RendererStagingBuffer(RenderEngine& renderer, Queue& queue)
@@ -9,19 +11,13 @@ namespace PaperRenderer
         gpuQueue(&queue)
     {
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "A RendererStagingBuffer was created"
-        });
+        renderer.getLogger().recordLog(INFO, "A RendererStagingBuffer was created");
     }
 
     RendererStagingBuffer::~RendererStagingBuffer()
     {
         //log destructor
-        renderer->getLogger().recordLog({
-            .type = INFO,
-            .text = "A RendererStagingBuffer was destroyed"
-        });
+        renderer->getLogger().recordLog(INFO, "A RendererStagingBuffer was destroyed");
     }
 
     RendererStagingBuffer::RendererStagingBuffer(RendererStagingBuffer&& other) noexcept
@@ -32,10 +28,7 @@ namespace PaperRenderer
     {
         std::lock_guard guard(stagingBufferMutex);
         other.stackLocation = 0;
-        renderer->getLogger().recordLog({
-            .type = INFO,
-            .text = "A RendererStagingBuffer was moved"
-        });
+        renderer->getLogger().recordLog(INFO, "A RendererStagingBuffer was moved");
     }
 
     void RendererStagingBuffer::idle()
@@ -48,12 +41,15 @@ namespace PaperRenderer
         stackLocation = 0;
     }
 
-    void RendererStagingBuffer::verifyBufferSize(std::vector<StagingBufferTransfer> &transfers)
+    void RendererStagingBuffer::verifyBufferSize(std::initializer_list<std::span<const StagingBufferTransfer>> transferGroups)
     {
         VkDeviceSize requiredSize = 0;
-        for(const StagingBufferTransfer& transfer : transfers)
+        for(const std::span<const StagingBufferTransfer>& transfers : transferGroups)
         {
-            requiredSize += transfer.data.size();
+            for(const StagingBufferTransfer& transfer : transfers)
+            {
+                requiredSize += transfer.getData().size();
+            }
         }
 
         //rebuild buffer if needed
@@ -64,13 +60,19 @@ namespace PaperRenderer
             const BufferInfo bufferInfo = {
                 .size = (VkDeviceSize)((stackLocation + requiredSize) * bufferOverhead),
                 .usageFlags = VK_BUFFER_USAGE_2_TRANSFER_SRC_BIT_KHR,
-                .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+                .allocationFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
+                .category = MEMORY_STAGING
             };
             stagingBuffer = Buffer(*renderer, bufferInfo);
         }
     }
 
-    Queue& RendererStagingBuffer::submitTransfers(std::vector<StagingBufferTransfer>& transfers, const SynchronizationInfo& syncInfo)
+    Queue& RendererStagingBuffer::submitTransfers(std::span<const StagingBufferTransfer> transfers, const SynchronizationInfo& syncInfo)
+    {
+        return submitTransfers({ transfers }, syncInfo);
+    }
+
+    Queue& RendererStagingBuffer::submitTransfers(std::initializer_list<std::span<const StagingBufferTransfer>> transferGroups, const SynchronizationInfo& syncInfo)
     {
         //timer
         Timer timer(*renderer, "Submit unqueued transfers (StagingBuffer)", REGULAR);
@@ -85,56 +87,66 @@ namespace PaperRenderer
             .pInheritanceInfo = NULL
         };
         vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+        GPUTimer gpuTimer(*renderer, cmdBuffer, TRANSFER, "Staging Buffer Transfers", REGULAR);
 
         //lock mutex
         std::lock_guard guard(stagingBufferMutex);
 
         //rebuild buffer if needed
-        verifyBufferSize(transfers);
+        verifyBufferSize(transferGroups);
 
         //copy to dst
-        std::set<Buffer*> dstBuffers;
-        for(StagingBufferTransfer& transfer : transfers)
+        dstBuffers.clear();
+        for(const std::span<const StagingBufferTransfer>& transfers : transferGroups)
         {
-            //make sure dstBuffer is referenced
-            dstBuffers.insert(transfer.dstBuffer);
-
-            //buffer write
-            const BufferWrite bufferWrite = {
-                .offset = stackLocation,
-                .size = transfer.data.size(),
-                .readData = transfer.data.data()
-            };
-            
-            if(transfer.data.size())
+            for(const StagingBufferTransfer& transfer : transfers)
             {
-                vmaCopyMemoryToAllocation(renderer->getDevice().getAllocator(), bufferWrite.readData, stagingBuffer.getAllocation(), bufferWrite.offset, bufferWrite.size);
-            }
-            
-            //push VkBufferCopy if dstBuffer is set
-            if(transfer.dstBuffer)
-            {
-                const VkBufferCopy copy = {
-                    .srcOffset = bufferWrite.offset,
-                    .dstOffset = transfer.dstOffset,
-                    .size = bufferWrite.size
+                //make sure dstBuffer is referenced
+                if(transfer.dstBuffer) dstBuffers.push_back(transfer.dstBuffer);
+
+                //buffer write
+                const std::span<const uint8_t> data = transfer.getData();
+                const BufferWrite bufferWrite = {
+                    .offset = stackLocation,
+                    .size = data.size(),
+                    .readData = data.data()
                 };
-
-                //record copy command
-                vkCmdCopyBuffer(cmdBuffer, stagingBuffer.getBuffer(), transfer.dstBuffer->getBuffer(), 1, &copy);
+                
+                if(data.size())
+                {
+                    vmaCopyMemoryToAllocation(renderer->getDevice().getAllocator(), bufferWrite.readData, stagingBuffer.getAllocation(), bufferWrite.offset, bufferWrite.size);
+                }
+                
+                //push VkBufferCopy if dstBuffer is set
+                if(transfer.dstBuffer)
+                {
+                    const VkBufferCopy copy = {
+                        .srcOffset = bufferWrite.offset,
+                        .dstOffset = transfer.dstOffset,
+                        .size = bufferWrite.size
+                    };
+
+                    //record copy command
+                    vkCmdCopyBuffer(cmdBuffer, stagingBuffer.getBuffer(), transfer.dstBuffer->getBuffer(), 1, &copy);
+                }
+
+                //call function if set
+                if(transfer.postWriteOp)
+                {
+                    transfer.postWriteOp(stagingBuffer, stackLocation);
+                }
+
+                //increment stack
+                stackLocation += bufferWrite.size;
             }
-
-            //call function if set
-            if(transfer.postWriteOp)
-            {
-                transfer.postWriteOp(stagingBuffer, stackLocation);
-            }
-
-            //increment stack
-            stackLocation += bufferWrite.size;
         }
 
+        //each buffer only needs to be owned once
+        std::sort(dstBuffers.begin(), dstBuffers.end());
+        dstBuffers.erase(std::unique(dstBuffers.begin(), dstBuffers.end()), dstBuffers.end());
+
         //end command buffer
+        gpuTimer.release();
         vkEndCommandBuffer(cmdBuffer);
 
         //submit
@@ -1,14 +1,21 @@
 #pragma once
 #include "VulkanResources.h"
 
+#include <span>
+#include <initializer_list>
+#include <memory_resource>
+
 namespace PaperRenderer
 {
     struct StagingBufferTransfer
     {
         VkDeviceSize dstOffset = 0;
         std::vector<uint8_t> data = {};
+        std::span<const uint8_t> dataView = {}; //used instead of data when set, which avoids copying into a vector. Must stay valid until submitTransfers() returns
         Buffer* dstBuffer = NULL;
         std::function<void(const Buffer& srcBuffer, const VkDeviceSize srcOffset)> postWriteOp = NULL;
+
+        std::span<const uint8_t> getData() const { return dataView.size() ? dataView : std::span<const uint8_t>(data); }
     };
 
     class RendererStagingBuffer
@@ -19,8 +26,9 @@ namespace PaperRenderer
         static constexpr float bufferOverhead = 1.5f;
 
         VkDeviceSize stackLocation = 0;
+        std::vector<Buffer*> dstBuffers; //reused by submitTransfers()
 
-        void verifyBufferSize(std::vector<StagingBufferTransfer>& transfers);
+        void verifyBufferSize(std::initializer_list<std::span<const StagingBufferTransfer>> transferGroups);
 
         class RenderEngine* renderer;
         class Queue* gpuQueue;
@@ -33,6 +41,8 @@ namespace PaperRenderer
         
         void idle();
         void resetBuffer();
-        Queue& submitTransfers(std::vector<StagingBufferTransfer>& transfers, const SynchronizationInfo& syncInfo);
+        Queue& submitTransfers(std::span<const StagingBufferTransfer> transfers, const SynchronizationInfo& syncInfo);
+        //records every group into the same submission, in order; saves joining lists of transfers into one
+        Queue& submitTransfers(std::initializer_list<std::span<const StagingBufferTransfer>> transferGroups, const SynchronizationInfo& syncInfo);
     };
 }
\ No newline at end of file
@@ -1,43 +1,397 @@
 #include "Statistics.h"
 #include "PaperRenderer.h"
 
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
 namespace PaperRenderer
 {
     //----------LOGGING----------//
     
-    Logger::Logger(RenderEngine& renderer, const std::function<void(RenderEngine&, const LogEvent&)>& eventCallbackFunction)
+    Logger::Logger(RenderEngine& renderer, const std::function<void(RenderEngine&, const LogEvent&)>& eventCallbackFunction, LogType minLogLevel, bool asynchronous)
         :eventCallbackFunction(eventCallbackFunction),
+        minLogLevel(minLogLevel),
+        asynchronous(asynchronous && eventCallbackFunction),
         renderer(renderer)
     {
+        //start background thread
+        if(this->asynchronous)
+        {
+            slots = std::make_unique<LogSlot[]>(queueCapacity);
+            for(uint64_t i = 0; i < queueCapacity; i++)
+            {
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            worker = std::thread(&Logger::processEvents, this);
+        }
+
         //hello world!
-        recordLog({
-            .type = INFO,
-            .text = "\n\n   ---------- Hello, PaperRenderer! ----------\n"
-        });
+        recordLog(INFO, "\n\n   ---------- Hello, PaperRenderer! ----------\n");
     }
 
     Logger::~Logger()
     {
         //goodbye!
-        recordLog({
-            .type = INFO,
-            .text = "\n\n   ---------- Goodbye, PaperRenderer ----------\n"
-        });
+        recordLog(INFO, "\n\n   ---------- Goodbye, PaperRenderer ----------\n");
+
+        //remaining events are drained before the thread exits
+        if(worker.joinable())
+        {
+            stopping.store(true, std::memory_order_release);
+            wakeSignal.fetch_add(1, std::memory_order_release);
+            wakeSignal.notify_one();
+            worker.join();
+        }
     }
 
-    void Logger::recordLog(const LogEvent &event)
+    void Logger::recordLog(const LogEvent& event)
     {
-        if(eventCallbackFunction)
+        if(isEnabled(event.type))
+        {
+            submitLog(LogEvent(event));
+        }
+    }
+
+    void Logger::submitLog(LogEvent&& event)
+    {
+        if(asynchronous)
+        {
+            const bool critical = event.type == CRITICAL_ERROR;
+            bool pushed = pushEvent(std::move(event));
+
+            //critical errors are never dropped; wait for the background thread to make room. It can't make room while in a callback, so
+            //critical errors logged from one are delivered directly
+            while(!pushed && critical)
+            {
+                if(std::this_thread::get_id() == worker.get_id())
+                {
+                    eventCallbackFunction(renderer, event);
+                    return;
+                }
+
+                wakeSignal.fetch_add(1, std::memory_order_release);
+                wakeSignal.notify_one();
+                std::this_thread::yield();
+                pushed = pushEvent(std::move(event));
+            }
+
+            if(pushed)
+            {
+                wakeSignal.fetch_add(1, std::memory_order_release);
+                wakeSignal.notify_one();
+
+                //critical errors are often followed by a throw, so they're delivered before returning
+                if(critical) flush();
+            }
+            else
+            {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else
         {
             std::lock_guard<std::mutex> guard(logMutex);
             eventCallbackFunction(renderer, event);
         }
     }
 
+    bool Logger::pushEvent(LogEvent&& event)
+    {
+        uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while(true)
+        {
+            LogSlot& slot = slots[position & (queueCapacity - 1)];
+            const int64_t difference = (int64_t)slot.sequence.load(std::memory_order_acquire) - (int64_t)position;
+
+            if(difference == 0) //slot is free for this position; claim it
+            {
+                if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.event = std::move(event);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(difference < 0) //slot still holds an event from a lap ago; queue is full
+            {
+                return false;
+            }
+            else //another thread claimed the position
+            {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Logger::processEvents()
+    {
+        uint64_t dequeuePosition = 0;
+        while(true)
+        {
+            //read the signal before draining so a push during the drain wakes the wait below
+            const uint32_t signal = wakeSignal.load(std::memory_order_acquire);
+
+            while(true)
+            {
+                LogSlot& slot = slots[dequeuePosition & (queueCapacity - 1)];
+                if(slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) break;
+
+                const LogEvent event = std::move(slot.event);
+                slot.sequence.store(dequeuePosition + queueCapacity, std::memory_order_release);
+                dequeuePosition++;
+
+                eventCallbackFunction(renderer, event);
+                processedPosition.store(dequeuePosition, std::memory_order_release);
+                processedPosition.notify_all();
+            }
+
+            //report drops once there's room again
+            const uint64_t dropped = droppedCount.exchange(0, std::memory_order_relaxed);
+            if(dropped)
+            {
+                eventCallbackFunction(renderer, {
+                    .type = WARNING,
+                    .text = std::to_string(dropped) + " log events were dropped because the log queue was full"
+                });
+            }
+
+            if(stopping.load(std::memory_order_acquire) && dequeuePosition == enqueuePosition.load(std::memory_order_acquire))
+            {
+                break;
+            }
+
+            wakeSignal.wait(signal, std::memory_order_acquire);
+        }
+    }
+
+    void Logger::flush()
+    {
+        if(!asynchronous || std::this_thread::get_id() == worker.get_id()) return;
+
+        const uint64_t target = enqueuePosition.load(std::memory_order_acquire);
+        uint64_t processed = processedPosition.load(std::memory_order_acquire);
+        while(processed < target)
+        {
+            processedPosition.wait(processed, std::memory_order_acquire);
+            processed = processedPosition.load(std::memory_order_acquire);
+        }
+    }
+
     //----------PROFILING AND STATE----------//
     
+    //rolling histogram definitions
+    RollingHistogram::RollingHistogram(uint32_t windowSize)
+        :window(std::max(windowSize, (uint32_t)1))
+    {
+    }
+
+    RollingHistogram::~RollingHistogram()
+    {
+    }
+
+    uint32_t RollingHistogram::getBucket(double seconds)
+    {
+        if(seconds < minValue * 2.0) //first octave is linear from 0
+        {
+            return std::min((uint32_t)(std::max(seconds, 0.0) / (minValue * 2.0) * subBucketCount), subBucketCount - 1);
+        }
+
+        //value = mantissa * 2^exponent with mantissa in [0.5, 1)
+        int exponent = 0;
+        const double mantissa = std::frexp(seconds / minValue, &exponent);
+        const uint32_t octave = (uint32_t)(exponent - 1);
+        const uint32_t subBucket = std::min((uint32_t)((mantissa * 2.0 - 1.0) * subBucketCount), subBucketCount - 1);
+
+        return std::min(octave * subBucketCount + subBucket, octaveCount * subBucketCount - 1);
+    }
+
+    double RollingHistogram::getBucketStart(uint32_t bucket)
+    {
+        const uint32_t octave = bucket / subBucketCount;
+        const uint32_t subBucket = bucket % subBucketCount;
+        if(!octave)
+        {
+            return minValue * 2.0 * subBucket / subBucketCount;
+        }
+
+        return std::ldexp(minValue, octave) * (1.0 + (double)subBucket / subBucketCount);
+    }
+
+    void RollingHistogram::addSample(double seconds)
+    {
+        //evict the oldest sample once full
+        if(windowCount == window.size())
+        {
+            const double oldest = window[windowStart];
+            buckets[getBucket(oldest)]--;
+            windowSum -= oldest;
+            windowStart = (windowStart + 1) % window.size();
+            windowCount--;
+        }
+
+        window[(windowStart + windowCount) % window.size()] = seconds;
+        buckets[getBucket(seconds)]++;
+        windowSum += seconds;
+        windowCount++;
+    }
+
+    double RollingHistogram::getPercentile(double percentile) const
+    {
+        if(!windowCount) return 0.0;
+
+        //find the bucket containing the percentile, then interpolate within it
+        const double target = std::clamp(percentile, 0.0, 1.0) * windowCount;
+        double cumulative = 0.0;
+        for(uint32_t i = 0; i < buckets.size(); i++)
+        {
+            if(buckets[i] && cumulative + buckets[i] >= target)
+            {
+                const double bucketStart = getBucketStart(i);
+                const double bucketEnd = i + 1 < buckets.size() ? getBucketStart(i + 1) : bucketStart * 2.0;
+                const double estimate = bucketStart + (bucketEnd - bucketStart) * ((target - cumulative) / buckets[i]);
+
+                return std::min(estimate, getMax());
+            }
+            cumulative += buckets[i];
+        }
+
+        return getMax();
+    }
+
+    double RollingHistogram::getMax() const
+    {
+        double max = 0.0;
+        for(uint32_t i = 0; i < windowCount; i++)
+        {
+            max = std::max(max, window[(windowStart + i) % window.size()]);
+        }
+
+        return max;
+    }
+
+    //statistics aggregator definitions
+    StatisticsAggregator::StatisticsAggregator(const StatisticsAggregatorInfo& aggregatorInfo)
+        :aggregatorInfo(aggregatorInfo),
+        frameTimes(aggregatorInfo.windowSize)
+    {
+        aggregatedStatistics.reserve(aggregatorInfo.statistics.size());
+        for(const AggregatedStatisticInfo& statisticInfo : aggregatorInfo.statistics)
+        {
+            if(statisticIndices.count(statisticInfo.name.id)) continue;
+
+            statisticIndices[statisticInfo.name.id] = aggregatedStatistics.size();
+            aggregatedStatistics.push_back({
+                .info = statisticInfo,
+                .histogram = RollingHistogram(aggregatorInfo.windowSize)
+            });
+        }
+    }
+
+    StatisticsAggregator::~StatisticsAggregator()
+    {
+    }
+
+    void StatisticsAggregator::queueHitch(const HitchEvent& hitch)
+    {
+        if(pendingHitchCount < pendingHitches.size())
+        {
+            pendingHitches[pendingHitchCount] = hitch;
+            pendingHitchCount++;
+        }
+    }
+
+    void StatisticsAggregator::addTimeSample(const StatisticName& name, double seconds)
+    {
+        const auto statisticIndex = statisticIndices.find(name.id);
+        if(statisticIndex == statisticIndices.end()) return;
+
+        AggregatedStatistic& statistic = aggregatedStatistics[statisticIndex->second];
+        statistic.histogram.addSample(seconds);
+
+        if(statistic.info.hitchThreshold > 0.0 && seconds > statistic.info.hitchThreshold)
+        {
+            statistic.hitchCount++;
+            queueHitch({
+                .name = statistic.info.name.name,
+                .time = seconds,
+                .threshold = statistic.info.hitchThreshold,
+                .frame = frameCount
+            });
+        }
+    }
+
+    void StatisticsAggregator::addFrameTime(double seconds)
+    {
+        //compare against the window before this frame is part of it; the relative threshold waits for a few frames of history
+        double threshold = aggregatorInfo.frameTimeHitchThreshold > 0.0 ? aggregatorInfo.frameTimeHitchThreshold : DBL_MAX;
+        if(aggregatorInfo.frameTimeHitchRatio > 0.0 && frameTimes.getSampleCount() >= 16)
+        {
+            threshold = std::min(threshold, frameTimes.getPercentile(0.5) * aggregatorInfo.frameTimeHitchRatio);
+        }
+
+        if(seconds > threshold)
+        {
+            frameTimeHitchCount++;
+            queueHitch({
+                .name = "Frame Time",
+                .time = seconds,
+                .threshold = threshold,
+                .frame = frameCount
+            });
+        }
+
+        frameTimes.addSample(seconds);
+        frameCount++;
+    }
+
+    uint32_t StatisticsAggregator::takePendingHitches(std::array<HitchEvent, 64>& hitches)
+    {
+        const uint32_t hitchCount = pendingHitchCount;
+        std::copy(pendingHitches.begin(), pendingHitches.begin() + hitchCount, hitches.begin());
+        pendingHitchCount = 0;
+
+        return hitchCount;
+    }
+
+    AggregateStatistic StatisticsAggregator::getAggregate(const char* name, const RollingHistogram& histogram, uint64_t hitchCount)
+    {
+        return {
+            .name = name,
+            .sampleCount = histogram.getSampleCount(),
+            .mean = histogram.getMean(),
+            .p50 = histogram.getPercentile(0.5),
+            .p95 = histogram.getPercentile(0.95),
+            .p99 = histogram.getPercentile(0.99),
+            .max = histogram.getMax(),
+            .hitchCount = hitchCount
+        };
+    }
+
+    AggregateStatistic StatisticsAggregator::getFrameTimeAggregate() const
+    {
+        return getAggregate("Frame Time", frameTimes, frameTimeHitchCount);
+    }
+
+    AggregateStatistic StatisticsAggregator::getStatisticAggregate(const StatisticName& name) const
+    {
+        const auto statisticIndex = statisticIndices.find(name.id);
+        if(statisticIndex == statisticIndices.end()) return { .name = name.name };
+
+        const AggregatedStatistic& statistic = aggregatedStatistics[statisticIndex->second];
+        return getAggregate(statistic.info.name.name, statistic.histogram, statistic.hitchCount);
+    }
+
     //statistics tracker definitions
     StatisticsTracker::StatisticsTracker()
+        :trackerId([] {
+            static std::atomic<uint64_t> nextTrackerId = 1;
+            return nextTrackerId.fetch_add(1, std::memory_order_relaxed);
+        }()),
+        traceEpoch(std::chrono::steady_clock::now())
     {
     }
 
@@ -45,30 +399,438 @@ namespace PaperRenderer
     {
     }
 
-    void StatisticsTracker::insertTimeStatistic(const std::string &name, TimeStatisticInterval interval, std::chrono::duration<double> duration)
+    uint32_t StatisticsTracker::getThreadIndex()
+    {
+        //small sequential indices read better in trace viewers than hashed thread ids
+        static std::atomic<uint32_t> nextThreadIndex = 0;
+        thread_local const uint32_t threadIndex = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        return threadIndex;
+    }
+
+    //trivially destructible, so it can still be read by thread local destructors that run after the owner's
+    static thread_local bool threadSamplesRetired = false;
+
+    StatisticsTracker::ThreadSamplesOwner::~ThreadSamplesOwner()
+    {
+        threadSamplesRetired = true;
+        for(const std::weak_ptr<ThreadSamples>& weakSamples : samples)
+        {
+            if(std::shared_ptr<ThreadSamples> threadSamples = weakSamples.lock()) threadSamples->retired.store(true, std::memory_order_release);
+        }
+    }
+
+    StatisticsTracker::ThreadSamples* StatisticsTracker::getThreadSamples()
+    {
+        if(threadSamplesRetired) return NULL;
+
+        //cache the calling thread's buffer so only its first sample needs the lock
+        thread_local ThreadSamplesOwner owner;
+        if(owner.cachedTrackerId == trackerId)
+        {
+            return owner.cachedSamples;
+        }
+
+        std::lock_guard guard(threadSamplesMutex);
+        std::shared_ptr<ThreadSamples>& samples = threadSamples[std::this_thread::get_id()];
+        if(!samples) samples = std::make_shared<ThreadSamples>();
+        samples->retired.store(false, std::memory_order_relaxed); //ids are reused, so this may be an exited thread's buffer that wasn't freed yet
+
+        //remember the buffer so it's retired on exit; buffers of destroyed trackers are forgotten
+        std::erase_if(owner.samples, [](const std::weak_ptr<ThreadSamples>& weakSamples) { return weakSamples.expired(); });
+        if(std::none_of(owner.samples.begin(), owner.samples.end(), [&](const std::weak_ptr<ThreadSamples>& weakSamples) { return weakSamples.lock() == samples; }))
+        {
+            owner.samples.push_back(samples);
+        }
+
+        owner.cachedTrackerId = trackerId;
+        owner.cachedSamples = samples.get();
+
+        return owner.cachedSamples;
+    }
+
+    void StatisticsTracker::pushSample(const StatisticSample& sample)
+    {
+        ThreadSamples* threadSamples = getThreadSamples();
+        if(!threadSamples) return;
+        ThreadSamples& samples = *threadSamples;
+
+        const uint32_t head = samples.head.load(std::memory_order_relaxed);
+        if(head - samples.tail.load(std::memory_order_acquire) >= ThreadSamples::capacity)
+        {
+            samples.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        samples.samples[head % ThreadSamples::capacity] = sample;
+        samples.head.store(head + 1, std::memory_order_release);
+    }
+
+    void StatisticsTracker::drainThreadSamples(bool discard)
+    {
+        std::lock_guard guard(threadSamplesMutex);
+
+        uint64_t droppedSamples = 0;
+        for(auto it = threadSamples.begin(); it != threadSamples.end();)
+        {
+            //read before head, so everything an exited thread recorded is drained before its buffer is freed
+            std::shared_ptr<ThreadSamples>& samples = it->second;
+            const bool retired = samples->retired.load(std::memory_order_acquire);
+            const uint32_t head = samples->head.load(std::memory_order_acquire);
+            uint32_t tail = samples->tail.load(std::memory_order_relaxed);
+
+            const bool tracing = traceCapture.load(std::memory_order_relaxed);
+            for(; (!discard || tracing || aggregator) && tail != head; tail++)
+            {
+                const StatisticSample& sample = samples->samples[tail % ThreadSamples::capacity];
+                if(sample.type == TIME)
+                {
+                    if(aggregator) aggregator->addTimeSample(sample.name, sample.duration.count());
+                    if(tracing)
+                    {
+                        pushTraceEvent({
+                            .name = sample.name.name,
+                            .startTime = sample.startTime,
+                            .duration = sample.duration,
+                            .threadIndex = sample.threadIndex,
+                            .depth = sample.depth
+                        });
+                    }
+                    if(!discard) statistics.timeStatistics.emplace_back(sample.name.name, sample.interval, sample.duration);
+                }
+                else if(!discard)
+                {
+                    //look counters up by their interned id; strings are only hashed the first time a counter is seen
+                    uint64_t*& counter = counterLookup[sample.name.id];
+                    if(!counter) counter = &statistics.objectCounters[sample.name.name];
+                    *counter += sample.increment;
+                }
+            }
+
+            samples->tail.store(head, std::memory_order_release);
+            droppedSamples += samples->dropped.exchange(0, std::memory_order_relaxed);
+
+            //free the buffers of exited threads
+            if(retired) it = threadSamples.erase(it);
+            else it++;
+        }
+
+        if(!discard && droppedSamples)
+        {
+            statistics.objectCounters["Dropped Statistics Samples"] += droppedSamples;
+        }
+    }
+
+    void StatisticsTracker::insertTimeStatistic(StatisticName name, TimeStatisticInterval interval, std::chrono::duration<double> duration)
+    {
+        //assumed to have just ended
+        pushSample({
+            .name = name,
+            .type = TIME,
+            .interval = interval,
+            .duration = duration,
+            .startTime = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration),
+            .threadIndex = getThreadIndex()
+        });
+    }
+
+    void StatisticsTracker::insertRuntimeTimeStatistic(const std::string& name, TimeStatisticInterval interval, std::chrono::duration<double> duration)
     {
         std::lock_guard<std::mutex> guard(statisticsMutex);
-        if(name.size()) statistics.timeStatistics.emplace_back(name, interval, duration);
+        if(name.empty()) return;
+
+        auto nameIt = runtimeStatisticNames.find(name);
+        if(nameIt == runtimeStatisticNames.end()) nameIt = runtimeStatisticNames.insert(name).first;
+        statistics.timeStatistics.emplace_back(nameIt->c_str(), interval, duration);
     }
 
-    void StatisticsTracker::modifyObjectCounter(const std::string &name, int increment)
+    void StatisticsTracker::insertGPUTimeStatistic(StatisticName name, TimeStatisticInterval interval, std::chrono::duration<double> duration)
     {
         std::lock_guard<std::mutex> guard(statisticsMutex);
-        if(name.size()) statistics.objectCounters[name] += increment;
+
+        auto nameIt = gpuStatisticNames.find(name.id);
+        if(nameIt == gpuStatisticNames.end()) nameIt = gpuStatisticNames.emplace(name.id, std::string(name.name) + " (GPU)").first;
+        statistics.timeStatistics.emplace_back(nameIt->second.c_str(), interval, duration);
+    }
+
+    void StatisticsTracker::modifyObjectCounter(StatisticName name, int increment)
+    {
+        pushSample({
+            .name = name,
+            .type = COUNTER,
+            .increment = increment
+        });
+    }
+
+    void StatisticsTracker::mergeStatistics()
+    {
+        std::array<HitchEvent, 64> hitches = {};
+        uint32_t hitchCount = 0;
+        std::function<void(const HitchEvent&)> hitchCallback = NULL;
+        {
+            std::lock_guard<std::mutex> guard(statisticsMutex);
+            drainThreadSamples(false);
+            drainAllocations(false);
+
+            //memory isn't per frame, so it's a snapshot rather than accumulated
+            for(uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; i++)
+            {
+                statistics.memoryUsage[i] = {
+                    .bytes = (uint64_t)std::max(memoryCategoryBytes[i].load(std::memory_order_relaxed), (int64_t)0),
+                    .allocationCount = (uint64_t)std::max(memoryCategoryAllocations[i].load(std::memory_order_relaxed), (int64_t)0)
+                };
+            }
+            statistics.heapBudgets = heapBudgets;
+
+            if(aggregator)
+            {
+                hitchCount = aggregator->takePendingHitches(hitches);
+                if(hitchCount) hitchCallback = aggregator->getHitchCallback();
+            }
+        }
+
+        //called without the lock so the callback can read statistics
+        if(hitchCallback)
+        {
+            for(uint32_t i = 0; i < hitchCount; i++)
+            {
+                hitchCallback(hitches[i]);
+            }
+        }
     }
 
     void StatisticsTracker::clearStatistics()
     {
-        statistics = {};
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        drainThreadSamples(true);
+        drainAllocations(true);
+
+        //emptied rather than replaced so their storage is reused, which keeps counter lookups valid too
+        statistics.timeStatistics.clear();
+        for(auto& [name, count] : statistics.objectCounters)
+        {
+            count = 0;
+        }
+        statistics.memoryUsage = {};
+        statistics.heapBudgets.clear();
+        statistics.allocations.clear();
+    }
+
+    const Statistics& StatisticsTracker::getStatistics()
+    {
+        mergeStatistics();
+        return statistics;
+    }
+
+    void StatisticsTracker::trackMemory(MemoryCategory category, int64_t bytes, int64_t allocations)
+    {
+        memoryCategoryBytes[category].fetch_add(bytes, std::memory_order_relaxed);
+        memoryCategoryAllocations[category].fetch_add(allocations, std::memory_order_relaxed);
+    }
+
+    void StatisticsTracker::updateHeapBudgets(const std::vector<MemoryHeapBudget>& heapBudgets)
+    {
+        std::vector<MemoryHeapBudget> crossedHeaps = {};
+        std::function<void(const MemoryHeapBudget&)> callback = NULL;
+        {
+            std::lock_guard<std::mutex> guard(statisticsMutex);
+            this->heapBudgets = heapBudgets;
+            heapsOverThreshold.resize(heapBudgets.size(), false);
+
+            //only report heaps that just went over the threshold
+            for(uint32_t i = 0; i < heapBudgets.size(); i++)
+            {
+                const bool overThreshold = heapBudgets[i].budget && heapBudgets[i].usage >= heapBudgets[i].budget * memoryBudgetThreshold;
+                if(overThreshold && !heapsOverThreshold[i])
+                {
+                    crossedHeaps.push_back(heapBudgets[i]);
+                }
+                heapsOverThreshold[i] = overThreshold;
+            }
+            if(crossedHeaps.size()) callback = memoryBudgetCallback;
+        }
+
+        //called without the lock so the callback can read statistics
+        if(callback)
+        {
+            for(const MemoryHeapBudget& heapBudget : crossedHeaps)
+            {
+                callback(heapBudget);
+            }
+        }
+    }
+
+    void StatisticsTracker::setMemoryBudgetCallback(const std::function<void(const MemoryHeapBudget&)>& callback, float threshold)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        memoryBudgetCallback = callback;
+        memoryBudgetThreshold = threshold;
+        heapsOverThreshold.clear(); //re-evaluated against the new threshold
+    }
+
+    void StatisticsTracker::enableAggregation(const StatisticsAggregatorInfo& aggregatorInfo)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+
+        //samples recorded before aggregation started aren't aggregated
+        drainThreadSamples(false);
+        aggregator = std::make_unique<StatisticsAggregator>(aggregatorInfo);
+    }
+
+    void StatisticsTracker::disableAggregation()
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        aggregator.reset();
+    }
+
+    void StatisticsTracker::recordFrameTime(double seconds)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        if(aggregator) aggregator->addFrameTime(seconds);
+    }
+
+    AggregateStatistic StatisticsTracker::getFrameTimeAggregate()
+    {
+        mergeStatistics();
+
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        return aggregator ? aggregator->getFrameTimeAggregate() : AggregateStatistic{ .name = "Frame Time" };
+    }
+
+    AggregateStatistic StatisticsTracker::getStatisticAggregate(StatisticName name)
+    {
+        mergeStatistics();
+
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        return aggregator ? aggregator->getStatisticAggregate(name) : AggregateStatistic{ .name = name.name };
+    }
+
+    const char* getMemoryCategoryName(MemoryCategory category)
+    {
+        switch(category)
+        {
+        case MEMORY_UNCATEGORIZED: return "Uncategorized";
+        case MEMORY_MODEL_DATA: return "Model Data";
+        case MEMORY_INSTANCE_DATA: return "Instance Data";
+        case MEMORY_RENDER_PASS: return "RenderPass";
+        case MEMORY_MESH_GROUP: return "Common Mesh Groups";
+        case MEMORY_GEOMETRY: return "Geometry";
+        case MEMORY_STAGING: return "Staging";
+        case MEMORY_ACCELERATION_STRUCTURE: return "Acceleration Structures";
+        case MEMORY_AS_SCRATCH: return "AS Scratch";
+        case MEMORY_DESCRIPTOR: return "Descriptors";
+        case MEMORY_IMAGES: return "Images";
+        default: return "Unknown";
+        }
+    }
+
+    void StatisticsTracker::pushTraceEvent(const TraceEvent& event)
+    {
+        traceEvents.push_back(event);
+        while(traceEvents.size() > maxTraceEvents)
+        {
+            traceEvents.pop_front();
+        }
+    }
+
+    void StatisticsTracker::startTraceCapture(uint64_t maxEvents)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+
+        //samples recorded before capture started aren't part of the trace
+        drainThreadSamples(false);
+        traceEvents.clear();
+        maxTraceEvents = maxEvents;
+        traceCapture.store(true, std::memory_order_relaxed);
+    }
+
+    void StatisticsTracker::stopTraceCapture()
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+
+        drainThreadSamples(false);
+        traceCapture.store(false, std::memory_order_relaxed);
+    }
+
+    void StatisticsTracker::insertGPUTraceEvent(StatisticName name, QueueType queueType, std::chrono::steady_clock::time_point startTime, std::chrono::duration<double> duration)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+        if(traceCapture.load(std::memory_order_relaxed))
+        {
+            pushTraceEvent({
+                .name = name.name,
+                .startTime = startTime,
+                .duration = duration,
+                .threadIndex = (uint32_t)queueType,
+                .gpu = true
+            });
+        }
+    }
+
+    bool StatisticsTracker::writeChromeTrace(const std::string& filePath)
+    {
+        std::lock_guard<std::mutex> guard(statisticsMutex);
+
+        //include everything recorded up to now
+        drainThreadSamples(false);
+
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+        {
+            return false;
+        }
+
+        const auto writeString = [&](const char* string)
+        {
+            file << '"';
+            for(; *string; string++)
+            {
+                if(*string == '"' || *string == '\\') file << '\\';
+                file << *string;
+            }
+            file << '"';
+        };
+        const auto toMicroseconds = [](std::chrono::duration<double> duration) { return duration.count() * 1000000.0; };
+
+        //CPU threads are pid 1, GPU queues are pid 2 with one track per queue type
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"PaperRenderer CPU\"}},\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"PaperRenderer GPU\"}}";
+        const char* queueNames[] = { "Graphics Queue", "Compute Queue", "Transfer Queue", "Present Queue" };
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":" << i << ",\"args\":{\"name\":\"" << queueNames[i] << "\"}}";
+        }
+
+        file << std::fixed << std::setprecision(3);
+        for(const TraceEvent& event : traceEvents)
+        {
+            file << ",\n{\"name\":";
+            writeString(event.name);
+            file << ",\"cat\":\"" << (event.gpu ? "GPU" : "CPU") << "\",\"ph\":\"X\""
+                << ",\"ts\":" << toMicroseconds(event.startTime - traceEpoch)
+                << ",\"dur\":" << toMicroseconds(event.duration)
+                << ",\"pid\":" << (event.gpu ? 2 : 1)
+                << ",\"tid\":" << event.threadIndex
+                << ",\"args\":{\"depth\":" << event.depth << "}}";
+        }
+        file << "\n]}\n";
+
+        return file.good();
     }
 
     // timer definitions
-    Timer::Timer(RenderEngine& renderer, const std::string& timerName, TimeStatisticInterval interval)
+    thread_local uint32_t timerDepth = 0; //nesting of live timers on the calling thread
+    extern thread_local StatisticName const* allocationScope; //defined with allocation tracking
+
+    Timer::Timer(RenderEngine& renderer, StatisticName timerName, TimeStatisticInterval interval)
         :timerName(timerName),
         interval(interval),
-        startTime(std::chrono::high_resolution_clock::now()),
+        startTime(std::chrono::steady_clock::now()),
+        depth(timerDepth++),
+        parentAllocationScope(allocationScope),
         renderer(renderer)
     {
+        allocationScope = &this->timerName;
     }
 
     Timer::~Timer()
@@ -80,7 +842,17 @@ namespace PaperRenderer
     {
         if(!released)
         {
-            renderer.getStatisticsTracker().insertTimeStatistic(timerName, interval, (std::chrono::high_resolution_clock::now() - startTime));
+            renderer.getStatisticsTracker().pushSample({
+                .name = timerName,
+                .type = StatisticsTracker::TIME,
+                .interval = interval,
+                .duration = std::chrono::steady_clock::now() - startTime,
+                .startTime = startTime,
+                .threadIndex = StatisticsTracker::getThreadIndex(),
+                .depth = depth
+            });
+            timerDepth--;
+            allocationScope = parentAllocationScope;
             released = true;
         }
     }
@@ -89,4 +861,226 @@ namespace PaperRenderer
     {
         tryInsertTimeStatistic();
     }
+
+    //----------GPU PROFILING----------//
+
+    GPUProfiler::GPUProfiler(RenderEngine& renderer)
+        :timestampPeriod(renderer.getDevice().getGPUFeaturesAndProperties().gpuProperties.properties.limits.timestampPeriod),
+        renderer(renderer)
+    {
+        for(FrameQueries& frame : frameQueries)
+        {
+            frame.queryPool = getQueryPool();
+        }
+
+        //GPU timings can only be traced if the device clock can be sampled
+        if(renderer.getDevice().getGPUFeaturesAndProperties().calibratedTimestamps)
+        {
+            uint32_t timeDomainCount = 0;
+            vkGetPhysicalDeviceCalibrateableTimeDomainsKHR(renderer.getDevice().getGPU(), &timeDomainCount, NULL);
+            std::vector<VkTimeDomainKHR> timeDomains(timeDomainCount);
+            vkGetPhysicalDeviceCalibrateableTimeDomainsKHR(renderer.getDevice().getGPU(), &timeDomainCount, timeDomains.data());
+
+            calibratedTimestamps = std::find(timeDomains.begin(), timeDomains.end(), VK_TIME_DOMAIN_DEVICE_KHR) != timeDomains.end();
+        }
+    }
+
+    GPUProfiler::~GPUProfiler()
+    {
+        for(FrameQueries& frame : frameQueries)
+        {
+            vkDestroyQueryPool(renderer.getDevice().getDevice(), frame.queryPool, nullptr);
+        }
+        for(PendingQueries& pending : pendingQueries)
+        {
+            vkDestroyQueryPool(renderer.getDevice().getDevice(), pending.queries.queryPool, nullptr);
+        }
+        for(VkQueryPool queryPool : freeQueryPools)
+        {
+            vkDestroyQueryPool(renderer.getDevice().getDevice(), queryPool, nullptr);
+        }
+    }
+
+    VkQueryPool GPUProfiler::getQueryPool()
+    {
+        if(freeQueryPools.size())
+        {
+            const VkQueryPool queryPool = freeQueryPools.back();
+            freeQueryPools.pop_back();
+
+            return queryPool;
+        }
+
+        const VkQueryPoolCreateInfo queryPoolInfo = {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = NULL,
+            .flags = 0,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = maxQueriesPerFrame
+        };
+
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        vkCreateQueryPool(renderer.getDevice().getDevice(), &queryPoolInfo, nullptr, &queryPool);
+        vkResetQueryPool(renderer.getDevice().getDevice(), queryPool, 0, maxQueriesPerFrame);
+
+        return queryPool;
+    }
+
+    uint32_t GPUProfiler::reserveTimer(StatisticName name, TimeStatisticInterval interval, QueueType queueType, VkQueryPool& queryPool)
+    {
+        if(!enabled || !renderer.getDevice().getQueues().at(queueType).timestampValidBits)
+        {
+            return UINT32_MAX;
+        }
+
+        std::lock_guard guard(profilerMutex);
+
+        FrameQueries& frame = frameQueries[currentFrame];
+        if(frame.queryCount + 2 > maxQueriesPerFrame)
+        {
+            return UINT32_MAX;
+        }
+
+        const uint32_t queryIndex = frame.queryCount;
+        frame.timers.push_back({
+            .name = name,
+            .interval = interval,
+            .queueType = queueType,
+            .queryIndex = queryIndex
+        });
+        frame.queryCount += 2;
+        queryPool = frame.queryPool;
+
+        return queryIndex;
+    }
+
+    bool GPUProfiler::readTimers(FrameQueries& queries)
+    {
+        //read back without waiting
+        queryResults.resize(queries.queryCount * 2); //value and availability per query
+        vkGetQueryPoolResults(renderer.getDevice().getDevice(), queries.queryPool, 0, queries.queryCount, queryResults.size() * sizeof(uint64_t), queryResults.data(), sizeof(uint64_t) * 2,
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+        //sample the device clock between two host clock reads to map timestamps onto the CPU timeline for traces
+        const bool tracing = calibratedTimestamps && renderer.getStatisticsTracker().isCapturingTrace();
+        uint64_t deviceTimestamp = 0;
+        std::chrono::steady_clock::time_point hostTimestamp = {};
+        if(tracing)
+        {
+            const VkCalibratedTimestampInfoKHR timestampInfo = {
+                .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_KHR,
+                .pNext = NULL,
+                .timeDomain = VK_TIME_DOMAIN_DEVICE_KHR
+            };
+            uint64_t maxDeviation = 0;
+
+            const std::chrono::steady_clock::time_point beforeTimestamp = std::chrono::steady_clock::now();
+            vkGetCalibratedTimestampsKHR(renderer.getDevice().getDevice(), 1, &timestampInfo, &deviceTimestamp, &maxDeviation);
+            hostTimestamp = beforeTimestamp + (std::chrono::steady_clock::now() - beforeTimestamp) / 2;
+        }
+
+        //timers that aren't available yet are kept for the next read
+        std::erase_if(queries.timers, [&](const GPUTimerQuery& timer)
+        {
+            const uint64_t* startResult = &queryResults[timer.queryIndex * 2];
+            const uint64_t* endResult = &queryResults[(timer.queryIndex + 1) * 2];
+            if(!startResult[1] || !endResult[1])
+            {
+                return false;
+            }
+
+            if(endResult[0] >= startResult[0])
+            {
+                const std::chrono::duration<double> duration((endResult[0] - startResult[0]) * timestampPeriod * 0.000000001);
+                renderer.getStatisticsTracker().insertGPUTimeStatistic(timer.name, timer.interval, duration);
+
+                if(tracing)
+                {
+                    const std::chrono::duration<double> age((int64_t)(deviceTimestamp - startResult[0]) * timestampPeriod * 0.000000001);
+                    renderer.getStatisticsTracker().insertGPUTraceEvent(timer.name, timer.queueType,
+                        hostTimestamp - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age), duration);
+                }
+            }
+
+            return true;
+        });
+
+        return queries.timers.empty();
+    }
+
+    void GPUProfiler::beginFrame()
+    {
+        std::lock_guard guard(profilerMutex);
+        Commands& commands = renderer.getDevice().getCommands();
+
+        //retry pools set aside by earlier frames. Ones that never finish are given up on once they're old and everything submitted when
+        //they were set aside has completed, which only leaves timers recorded into command buffers that were never submitted
+        for(auto it = pendingQueries.begin(); it != pendingQueries.end();)
+        {
+            const bool abandoned = ++it->age >= maxPendingFrames && commands.submissionsComplete(it->submissions);
+            if(readTimers(it->queries) || abandoned)
+            {
+                vkResetQueryPool(renderer.getDevice().getDevice(), it->queries.queryPool, 0, maxQueriesPerFrame);
+                freeQueryPools.push_back(it->queries.queryPool);
+                it = pendingQueries.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+
+        currentFrame = (currentFrame + 1) % framesInFlight;
+        FrameQueries& frame = frameQueries[currentFrame];
+
+        //read back; the pool is only reset if every timer was available, and is otherwise set aside and replaced
+        if(frame.queryCount)
+        {
+            if(readTimers(frame))
+            {
+                vkResetQueryPool(renderer.getDevice().getDevice(), frame.queryPool, 0, frame.queryCount);
+            }
+            else
+            {
+                std::vector<TimelineSemaphorePair> submissions = {};
+                for(const auto& [queueType, queuesInFamily] : renderer.getDevice().getQueues())
+                {
+                    for(Queue* queue : queuesInFamily.queues)
+                    {
+                        submissions.push_back(commands.getLastSubmission(*queue));
+                    }
+                }
+
+                pendingQueries.push_back({ .queries = std::move(frame), .submissions = std::move(submissions) });
+                frame = { .queryPool = getQueryPool() };
+            }
+        }
+
+        frame.timers.clear();
+        frame.queryCount = 0;
+    }
+
+    GPUTimer::GPUTimer(RenderEngine& renderer, VkCommandBuffer cmdBuffer, QueueType queueType, StatisticName timerName, TimeStatisticInterval interval)
+        :cmdBuffer(cmdBuffer)
+    {
+        queryIndex = renderer.getGPUProfiler().reserveTimer(timerName, interval, queueType, queryPool);
+        if(queryIndex != UINT32_MAX)
+        {
+            vkCmdWriteTimestamp2(cmdBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, queryPool, queryIndex);
+        }
+    }
+
+    GPUTimer::~GPUTimer()
+    {
+        release();
+    }
+
+    void GPUTimer::release()
+    {
+        if(queryIndex != UINT32_MAX)
+        {
+            vkCmdWriteTimestamp2(cmdBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, queryPool, queryIndex + 1);
+            queryIndex = UINT32_MAX;
+        }
+    }
 }
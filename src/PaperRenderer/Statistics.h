@@ -1,9 +1,18 @@
 #pragma once
+#include "Command.h"
 
 #include <functional>
 #include <mutex>
 #include <chrono>
 #include <deque>
+#include <array>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
 
 namespace PaperRenderer
 {
@@ -22,21 +31,70 @@ namespace PaperRenderer
         std::string text = {};
     };
 
-    //thread safe log handling class
+    //lowest level that's compiled in; PAPER_RENDERER_STRIP_INFO_LOGS is defined for release builds by default
+#ifdef PAPER_RENDERER_STRIP_INFO_LOGS
+    constexpr LogType compiledMinLogLevel = WARNING;
+#else
+    constexpr LogType compiledMinLogLevel = INFO;
+#endif
+
+    // Thread safe log handling class. Logs below the minimum level are rejected before their text is built. When asynchronous, events go into a
+    // lock free queue and the callback is called in order from a background thread, so a slow callback never stalls the recording thread; if the
+    // queue is full, events are dropped and counted instead of blocking
     class Logger
     {
     private:
+        static constexpr uint64_t queueCapacity = 4096; //power of 2
+
+        //bounded multi producer, single consumer queue; a slot's sequence says whether it's free for the position being written or holds an event
+        struct LogSlot
+        {
+            std::atomic<uint64_t> sequence = 0;
+            LogEvent event = {};
+        };
+        std::unique_ptr<LogSlot[]> slots = NULL;
+        std::atomic<uint64_t> enqueuePosition = 0;
+        std::atomic<uint64_t> processedPosition = 0; //events the background thread has finished calling back
+        std::atomic<uint64_t> droppedCount = 0;
+        std::atomic<uint32_t> wakeSignal = 0; //bumped after every push, so the background thread can sleep on it
+        std::atomic<bool> stopping = false;
+        std::thread worker;
+
         const std::function<void(class RenderEngine&, const LogEvent&)> eventCallbackFunction;
-        std::mutex logMutex;
+        std::atomic<LogType> minLogLevel;
+        const bool asynchronous;
+        std::mutex logMutex; //synchronous callbacks only
+
+        void submitLog(LogEvent&& event);
+        bool pushEvent(LogEvent&& event); //event is only moved from if it was pushed
+        void processEvents();
 
         class RenderEngine& renderer;
 
     public:
-        Logger(class RenderEngine& renderer, const std::function<void(class RenderEngine&, const LogEvent&)>& eventCallbackFunction);
+        Logger(class RenderEngine& renderer, const std::function<void(class RenderEngine&, const LogEvent&)>& eventCallbackFunction, LogType minLogLevel, bool asynchronous);
         ~Logger();
         Logger(const Logger&) = delete;
 
+        bool isEnabled(LogType type) const { return type >= compiledMinLogLevel && type >= minLogLevel.load(std::memory_order_relaxed) && eventCallbackFunction; }
+
         void recordLog(const LogEvent& event);
+        //text is a string, or a callable returning one which is only called if the log passes the level filter. Use a callable for text that's built
+        //at runtime. Filtered logs cost a comparison, and INFO logs are compiled out entirely when PAPER_RENDERER_STRIP_INFO_LOGS is defined
+        template<typename TextT>
+        void recordLog(LogType type, TextT&& text)
+        {
+            if(!isEnabled(type)) return;
+
+            if constexpr(std::is_invocable_v<TextT>) submitLog({ .type = type, .text = std::string(text()) });
+            else submitLog({ .type = type, .text = std::string(std::forward<TextT>(text)) });
+        }
+
+        void setMinLogLevel(LogType level) { minLogLevel.store(level, std::memory_order_relaxed); }
+        LogType getMinLogLevel() const { return minLogLevel.load(std::memory_order_relaxed); }
+        //blocks until every event recorded before this call has been passed to the callback
+        void flush();
+        uint64_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
     };
 
     //----------PROFILING AND STATE----------//
@@ -47,46 +105,337 @@ namespace PaperRenderer
         IRREGULAR //statistic randomly occurs (e.g. resizing a large buffer)
     };
 
+    // Statistic name interned at compile time; must be constructed from a string literal, which keeps recording a statistic free of allocations and
+    // string hashing. Ids are a 64 bit FNV-1a hash of the name
+    struct StatisticName
+    {
+        const char* name = "";
+        uint64_t id = 0;
+
+        template<std::size_t N>
+        consteval StatisticName(const char (&name)[N])
+            :name(name),
+            id(hash(name))
+        {
+        }
+
+        static constexpr uint64_t hash(const char* name)
+        {
+            uint64_t result = 14695981039346656037ull;
+            for(; *name; name++)
+            {
+                result ^= (uint8_t)*name;
+                result *= 1099511628211ull;
+            }
+            return result;
+        }
+    };
+
     struct TimeStatistic
     {
-        std::string name = {};
+        const char* name = ""; //string literal, or a runtime name interned by the tracker for its lifetime
         TimeStatisticInterval interval = REGULAR;
         std::chrono::duration<double> duration = {};
 
         double getTime() const { return duration.count(); }
     };
 
+    //what a VulkanResource's memory is used for; set through BufferInfo or ImageInfo
+    enum MemoryCategory
+    {
+        MEMORY_UNCATEGORIZED = 0, //default for buffers; typically ones made outside of the renderer
+        MEMORY_MODEL_DATA, //model data buffer and its handle table
+        MEMORY_INSTANCE_DATA, //renderer wide model instances buffer
+        MEMORY_RENDER_PASS, //per RenderPass instance, sorting and material data buffers
+        MEMORY_MESH_GROUP, //CommonMeshGroup matrices and draw commands
+        MEMORY_GEOMETRY, //model vertex and index buffers
+        MEMORY_STAGING,
+        MEMORY_ACCELERATION_STRUCTURE, //BLAS and TLAS storage and TLAS instances
+        MEMORY_AS_SCRATCH,
+        MEMORY_DESCRIPTOR, //descriptor buffers and shader binding tables
+        MEMORY_IMAGES, //default for images
+        MEMORY_CATEGORY_COUNT
+    };
+
+    const char* getMemoryCategoryName(MemoryCategory category);
+
+    struct MemoryCategoryUsage
+    {
+        uint64_t bytes = 0;
+        uint64_t allocationCount = 0;
+    };
+
+    struct MemoryHeapBudget
+    {
+        uint32_t heapIndex = 0;
+        bool deviceLocal = false;
+        uint64_t usage = 0; //bytes used by this process, as estimated by VMA (exact with VK_EXT_memory_budget)
+        uint64_t budget = 0; //bytes this process can use before allocations may fail or degrade performance
+        uint64_t allocationBytes = 0; //bytes allocated through VMA, including unused space in its memory blocks
+    };
+
+    //a timed scope kept by trace capture; names point to string literals
+    struct TraceEvent
+    {
+        const char* name = "";
+        std::chrono::steady_clock::time_point startTime = {};
+        std::chrono::duration<double> duration = {};
+        uint32_t threadIndex = 0; //CPU thread index, or QueueType for GPU events
+        uint32_t depth = 0; //nesting depth of CPU timers on their thread
+        bool gpu = false;
+    };
+
+    //heap allocations are counted per thread and attributed to the innermost live Timer, when built with PAPER_RENDERER_TRACK_ALLOCATIONS. The global
+    //operator new and delete are replaced to do so; over-aligned allocations aren't counted
+#ifdef PAPER_RENDERER_TRACK_ALLOCATIONS
+    constexpr bool allocationTrackingEnabled = true;
+#else
+    constexpr bool allocationTrackingEnabled = false;
+#endif
+
+    struct AllocationStatistic
+    {
+        const char* scope = ""; //Timer name; "Untimed" outside of any timer, and "Untracked" past the per thread scope or thread limits
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
     struct Statistics
     {
-        std::deque<TimeStatistic> timeStatistics = {};
-        std::unordered_map<std::string, uint64_t> objectCounters = {};
+        std::vector<TimeStatistic> timeStatistics = {};
+        std::unordered_map<std::string, uint64_t> objectCounters = {}; //counters stay listed after being cleared to keep their storage, so may be 0
+        std::array<MemoryCategoryUsage, MEMORY_CATEGORY_COUNT> memoryUsage = {}; //live resources, indexed by MemoryCategory
+        std::vector<MemoryHeapBudget> heapBudgets = {};
+        std::vector<AllocationStatistic> allocations = {}; //heap allocations made since the last clear; empty unless allocationTrackingEnabled
+    };
+
+    // Log bucketed histogram of durations over the last windowSize samples. Memory is allocated once on construction, so adding samples and
+    // querying never allocates. Percentiles are accurate to about a bucket's width (1/16th of an octave). ** NOT THREAD SAFE **
+    class RollingHistogram
+    {
+    private:
+        static constexpr uint32_t subBucketCount = 16; //buckets per octave
+        static constexpr uint32_t octaveCount = 28; //1 microsecond to ~4.5 minutes
+        static constexpr double minValue = 0.000001;
+        std::array<uint32_t, octaveCount * subBucketCount> buckets = {};
+        std::vector<double> window; //ring buffer of the samples currently in the histogram
+        uint32_t windowStart = 0;
+        uint32_t windowCount = 0;
+        double windowSum = 0.0;
+
+        static uint32_t getBucket(double seconds);
+        static double getBucketStart(uint32_t bucket);
+
+    public:
+        RollingHistogram(uint32_t windowSize);
+        ~RollingHistogram();
+
+        void addSample(double seconds); //replaces the oldest sample once the window is full
+        double getPercentile(double percentile) const; //percentile is in [0, 1]
+        double getMax() const; //exact; scans the window
+        double getMean() const { return windowCount ? windowSum / windowCount : 0.0; }
+        uint32_t getSampleCount() const { return windowCount; }
+    };
+
+    struct HitchEvent
+    {
+        const char* name = ""; //"Frame Time" or an aggregated statistic's name
+        double time = 0.0; //seconds
+        double threshold = 0.0; //seconds; the threshold it went over
+        uint64_t frame = 0; //frames recorded by the aggregator before this hitch
+    };
+
+    struct AggregatedStatisticInfo
+    {
+        StatisticName name = "";
+        double hitchThreshold = 0.0; //seconds; a sample taking longer is a hitch. 0 disables
+    };
+
+    struct StatisticsAggregatorInfo
+    {
+        uint32_t windowSize = 1000; //samples kept per histogram
+        double frameTimeHitchThreshold = 0.0; //seconds; 0 disables
+        double frameTimeHitchRatio = 2.0; //a frame taking this many times the rolling median is a hitch; 0 disables
+        std::vector<AggregatedStatisticInfo> statistics = {}; //time statistics to keep histograms of, such as "RenderPass Submission"
+        std::function<void(const HitchEvent&)> hitchCallback = NULL; //called from the thread merging statistics, without any lock held
     };
 
+    struct AggregateStatistic
+    {
+        const char* name = "";
+        uint32_t sampleCount = 0;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        uint64_t hitchCount = 0; //since aggregation was enabled
+    };
+
+    //rolling histograms of frame time and chosen time statistics with hitch detection. Owned by StatisticsTracker, and guarded by its mutex
+    class StatisticsAggregator
+    {
+    private:
+        struct AggregatedStatistic
+        {
+            AggregatedStatisticInfo info;
+            RollingHistogram histogram;
+            uint64_t hitchCount = 0;
+        };
+
+        const StatisticsAggregatorInfo aggregatorInfo;
+        RollingHistogram frameTimes;
+        uint64_t frameTimeHitchCount = 0;
+        uint64_t frameCount = 0;
+        std::vector<AggregatedStatistic> aggregatedStatistics;
+        std::unordered_map<uint64_t, uint32_t> statisticIndices; //interned id to index in aggregatedStatistics
+
+        //hitches wait here until they can be reported without a lock held; extra ones in the same merge are only counted
+        std::array<HitchEvent, 64> pendingHitches = {};
+        uint32_t pendingHitchCount = 0;
+
+        void queueHitch(const HitchEvent& hitch);
+        static AggregateStatistic getAggregate(const char* name, const RollingHistogram& histogram, uint64_t hitchCount);
+
+    public:
+        StatisticsAggregator(const StatisticsAggregatorInfo& aggregatorInfo);
+        ~StatisticsAggregator();
+        StatisticsAggregator(const StatisticsAggregator&) = delete;
+
+        void addTimeSample(const StatisticName& name, double seconds); //ignored if the statistic isn't aggregated
+        void addFrameTime(double seconds);
+        //moves out pending hitches; returns the count
+        uint32_t takePendingHitches(std::array<HitchEvent, 64>& hitches);
+
+        AggregateStatistic getFrameTimeAggregate() const;
+        AggregateStatistic getStatisticAggregate(const StatisticName& name) const; //empty if the statistic isn't aggregated
+        const std::function<void(const HitchEvent&)>& getHitchCallback() const { return aggregatorInfo.hitchCallback; }
+    };
+
+    // Statistics are recorded into lock free per thread ring buffers and merged into getStatistics() at the end of each frame (or whenever it's
+    // called), so recording never takes a lock or allocates after a thread's first sample. Thread safe
     class StatisticsTracker
     {
     private:
+        enum SampleType
+        {
+            TIME,
+            COUNTER
+        };
+
+        struct StatisticSample
+        {
+            StatisticName name = "";
+            SampleType type = TIME;
+            TimeStatisticInterval interval = REGULAR;
+            std::chrono::duration<double> duration = {};
+            int64_t increment = 0;
+            std::chrono::steady_clock::time_point startTime = {};
+            uint32_t threadIndex = 0;
+            uint32_t depth = 0;
+        };
+
+        //single producer (the owning thread), single consumer (merging, done under statisticsMutex)
+        struct ThreadSamples
+        {
+            static constexpr uint32_t capacity = 4096; //samples a thread can record between merges before new ones are dropped
+            std::array<StatisticSample, capacity> samples = {};
+            std::atomic<uint32_t> head = 0;
+            std::atomic<uint32_t> tail = 0;
+            std::atomic<uint32_t> dropped = 0;
+            std::atomic<bool> retired = false; //set when the owning thread exits; the next merge frees the buffer once it's drained
+        };
+        //thread local; caches the thread's buffer and retires its buffers in every live tracker when the thread exits
+        struct ThreadSamplesOwner
+        {
+            uint64_t cachedTrackerId = 0;
+            ThreadSamples* cachedSamples = NULL;
+            std::vector<std::weak_ptr<ThreadSamples>> samples = {};
+
+            ~ThreadSamplesOwner();
+        };
+        std::unordered_map<std::thread::id, std::shared_ptr<ThreadSamples>> threadSamples;
+        std::mutex threadSamplesMutex; //only taken on a thread's first sample and when merging
+        const uint64_t trackerId; //unique per tracker so thread local caches can't refer to a destroyed one
+
         Statistics statistics = {};
+        std::unordered_map<uint64_t, uint64_t*> counterLookup; //interned id to its value in statistics.objectCounters
+        std::unordered_set<std::string> runtimeStatisticNames; //interned, so recording a known name again doesn't allocate
+        std::unordered_map<uint64_t, std::string> gpuStatisticNames; //interned " (GPU)" names by the timer name's id
         std::mutex statisticsMutex;
+
+        //trace capture; kept across frames unlike statistics, oldest events are dropped past maxTraceEvents
+        std::deque<TraceEvent> traceEvents;
+        std::atomic<bool> traceCapture = false;
+        uint64_t maxTraceEvents = 0;
+        const std::chrono::steady_clock::time_point traceEpoch;
+
+        //memory accounting; recorded when VulkanResource allocations are created and when they are actually freed
+        std::array<std::atomic<int64_t>, MEMORY_CATEGORY_COUNT> memoryCategoryBytes = {};
+        std::array<std::atomic<int64_t>, MEMORY_CATEGORY_COUNT> memoryCategoryAllocations = {};
+        std::vector<MemoryHeapBudget> heapBudgets = {};
+        std::vector<bool> heapsOverThreshold = {};
+        std::function<void(const MemoryHeapBudget&)> memoryBudgetCallback = NULL;
+        float memoryBudgetThreshold = 0.9f;
+
+        std::unique_ptr<StatisticsAggregator> aggregator = NULL; //opt in
+
+        static uint32_t getThreadIndex();
+        void pushTraceEvent(const TraceEvent& event); //statisticsMutex must be held
+        ThreadSamples* getThreadSamples(); //NULL once the calling thread is exiting
+        void pushSample(const StatisticSample& sample);
+        void drainThreadSamples(bool discard); //statisticsMutex must be held
+        void drainAllocations(bool discard); //statisticsMutex must be held
         
     public:
         StatisticsTracker();
         ~StatisticsTracker();
         StatisticsTracker(const StatisticsTracker&) = delete;
 
-        void insertTimeStatistic(const std::string& name, TimeStatisticInterval interval, std::chrono::duration<double> duration); //insert time statistic (e.g. time for render pass or AS build)
-        void modifyObjectCounter(const std::string& name, int increment); //increment can be positive for incrementing or negative for decrementing
-        void clearStatistics(); //clears all statistical values (times, object counters, etc)
+        void insertTimeStatistic(StatisticName name, TimeStatisticInterval interval, std::chrono::duration<double> duration); //insert time statistic (e.g. time for render pass or AS build)
+        void insertRuntimeTimeStatistic(const std::string& name, TimeStatisticInterval interval, std::chrono::duration<double> duration); //same as above for names built at runtime; takes a lock, and allocates the first time a name is seen
+        void insertGPUTimeStatistic(StatisticName name, TimeStatisticInterval interval, std::chrono::duration<double> duration); //inserted as name + " (GPU)"; takes a lock
+        void modifyObjectCounter(StatisticName name, int increment); //increment can be positive for incrementing or negative for decrementing
+        void mergeStatistics(); //moves recorded samples from every thread into getStatistics(); called by RenderEngine::endFrame()
+        void clearStatistics(); //clears all statistical values (times, object counters, etc), including ones not merged yet
+
+        const Statistics& getStatistics(); //merges before returning
+
+        //starts keeping timer scopes and GPU timings across frames, up to maxEvents of the most recent ones
+        void startTraceCapture(uint64_t maxEvents = 1048576);
+        void stopTraceCapture(); //captured events are kept until the next start
+        bool isCapturingTrace() const { return traceCapture.load(std::memory_order_relaxed); }
+        void insertGPUTraceEvent(StatisticName name, QueueType queueType, std::chrono::steady_clock::time_point startTime, std::chrono::duration<double> duration);
+        //writes captured events in the Chrome trace event JSON format, which chrome://tracing and the Perfetto UI both open. Returns false if the file can't be written
+        bool writeChromeTrace(const std::string& filePath);
+
+        //adds (or removes with negative values) live resource memory of a category. Lock free
+        void trackMemory(MemoryCategory category, int64_t bytes, int64_t allocations);
+        //sets the latest heap budgets; called by RenderEngine::endFrame()
+        void updateHeapBudgets(const std::vector<MemoryHeapBudget>& heapBudgets);
+        //called once each time a heap's usage goes above threshold * budget. Called from the thread ending the frame
+        void setMemoryBudgetCallback(const std::function<void(const MemoryHeapBudget&)>& callback, float threshold = 0.9f);
+
+        //starts keeping rolling histograms of frame times and the chosen time statistics, replacing any previous aggregation. Samples recorded
+        //after this, including ones later cleared by clearStatistics(), are aggregated
+        void enableAggregation(const StatisticsAggregatorInfo& aggregatorInfo);
+        void disableAggregation();
+        void recordFrameTime(double seconds); //called by RenderEngine::endFrame() with the frame's delta time
+        AggregateStatistic getFrameTimeAggregate();
+        AggregateStatistic getStatisticAggregate(StatisticName name);
 
-        const Statistics& getStatistics() const { return statistics; }
+        friend class Timer;
     };
 
     //RAII style timer that inserts time statistic automatically. Can be released early. Ownership limited to one thread
     class Timer
     {
     private:
-        const std::string timerName;
+        const StatisticName timerName;
         const TimeStatisticInterval interval;
-        const std::chrono::time_point<std::chrono::high_resolution_clock> startTime;
+        const std::chrono::steady_clock::time_point startTime;
+        const uint32_t depth;
+        StatisticName const* const parentAllocationScope; //restored on release
         bool released = false;
 
         void tryInsertTimeStatistic();
@@ -94,10 +443,94 @@ namespace PaperRenderer
         class RenderEngine& renderer;
         
     public:
-        Timer(class RenderEngine& renderer, const std::string& timerName, TimeStatisticInterval interval);
+        Timer(class RenderEngine& renderer, StatisticName timerName, TimeStatisticInterval interval);
         ~Timer();
         Timer(const StatisticsTracker&) = delete;
 
         void release(); //Release is typically done when this goes out of scope, but early release can be done to send time statistic now
     };
+
+    //----------GPU PROFILING----------//
+
+    // Times GPU work with timestamp queries. Results are read back framesInFlight frames after they were recorded so reading never stalls, and are
+    // inserted into the statistics as time statistics with " (GPU)" appended to their names. Thread safe
+    class GPUProfiler
+    {
+    private:
+        static constexpr uint32_t framesInFlight = 3;
+        static constexpr uint32_t maxQueriesPerFrame = 512; //2 per timer
+        static constexpr uint32_t maxPendingFrames = 16; //timers still unavailable this long after readback are assumed to never have been submitted
+
+        struct GPUTimerQuery
+        {
+            StatisticName name = "";
+            TimeStatisticInterval interval = REGULAR;
+            QueueType queueType = GRAPHICS;
+            uint32_t queryIndex = 0; //start timestamp; the end timestamp is the query after
+        };
+
+        struct FrameQueries
+        {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            std::vector<GPUTimerQuery> timers = {};
+            uint32_t queryCount = 0;
+        };
+        std::array<FrameQueries, framesInFlight> frameQueries = {};
+
+        //pools with timers that weren't available at readback, such as ones in async BLAS builds. Queries that may still be pending on the GPU
+        //can't be reset from the host, so these are read again every frame and only reset once all of their timers are available
+        struct PendingQueries
+        {
+            FrameQueries queries = {};
+            std::vector<TimelineSemaphorePair> submissions = {}; //everything submitted when the pool was set aside
+            uint32_t age = 0;
+        };
+        std::vector<PendingQueries> pendingQueries = {};
+        std::vector<VkQueryPool> freeQueryPools = {}; //reset and ready for use
+        std::vector<uint64_t> queryResults; //reused by beginFrame()
+        uint32_t currentFrame = 0;
+        double timestampPeriod = 1.0; //nanoseconds per tick
+        bool calibratedTimestamps = false; //device time domain can be sampled, so GPU timings can be traced
+        bool enabled = true;
+        std::mutex profilerMutex;
+
+        VkQueryPool getQueryPool();
+        //inserts the results of available timers and removes them; returns true once none are left
+        bool readTimers(FrameQueries& queries);
+
+        //returns the start query index, or UINT32_MAX if the timer can't be recorded
+        uint32_t reserveTimer(StatisticName name, TimeStatisticInterval interval, QueueType queueType, VkQueryPool& queryPool);
+
+        class RenderEngine& renderer;
+
+        friend class GPUTimer;
+
+    public:
+        GPUProfiler(class RenderEngine& renderer);
+        ~GPUProfiler();
+        GPUProfiler(const GPUProfiler&) = delete;
+
+        //reads back and resets the queries of framesInFlight frames ago, setting aside pools whose timers aren't all available yet; called by RenderEngine::beginFrame()
+        void beginFrame();
+
+        void setEnabled(bool enabled) { this->enabled = enabled; }
+        bool isEnabled() const { return enabled; }
+    };
+
+    //RAII style timer that writes timestamps around the commands recorded into cmdBuffer during its lifetime. Must be released before cmdBuffer ends recording.
+    //Does nothing if the queue type's family doesn't support timestamps. Ownership limited to one thread
+    class GPUTimer
+    {
+    private:
+        const VkCommandBuffer cmdBuffer;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        uint32_t queryIndex = UINT32_MAX;
+
+    public:
+        GPUTimer(class RenderEngine& renderer, VkCommandBuffer cmdBuffer, QueueType queueType, StatisticName timerName, TimeStatisticInterval interval);
+        ~GPUTimer();
+        GPUTimer(const GPUTimer&) = delete;
+
+        void release(); //writes the end timestamp now instead of when this goes out of scope
+    };
 }
\ No newline at end of file
@@ -13,46 +13,13 @@ namespace PaperRenderer
     {
         //----------WINDOW CREATION----------//
 
-        if(glfwVulkanSupported() != GLFW_TRUE) throw std::runtime_error("No vulkan support for GLFW");
-        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-
-        if(windowState.monitor == NULL)
+        if(renderer.getDevice().isHeadless())
         {
-            windowState.monitor = glfwGetPrimaryMonitor();
+            createHeadlessSurface();
         }
-        const GLFWvidmode* mode = glfwGetVideoMode(windowState.monitor);
-
-        switch(windowState.windowMode)
-        {
-            case WINDOWED:
-                window = glfwCreateWindow(windowState.resX, windowState.resY, windowState.windowName.c_str(), NULL, NULL);
-
-                break;
-            case BORDERLESS:
-                glfwWindowHint(GLFW_RED_BITS, mode->redBits);
-                glfwWindowHint(GLFW_GREEN_BITS, mode->greenBits);
-                glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
-                glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
-                window = glfwCreateWindow(mode->width, mode->height, windowState.windowName.c_str(), windowState.monitor, NULL);
-
-                windowState.resX = mode->width;
-                windowState.resY = mode->height;
-
-                break;
-            case FULLSCREEN:
-                window = glfwCreateWindow(windowState.resX, windowState.resY, windowState.windowName.c_str(), windowState.monitor, NULL);
-
-                break;
-        }
-
-        //surface and device creation
-        VkResult result = glfwCreateWindowSurface(renderer.getDevice().getInstance(), window, nullptr, (VkSurfaceKHR*)(&renderer.getDevice().getSurface()));
-        if(result != VK_SUCCESS)
+        else
         {
-            renderer.getLogger().recordLog({
-                .type = CRITICAL_ERROR,
-                .text = "Failed to create window surface"
-            });
+            createWindow();
         }
         renderer.getDevice().createDevice();
 
@@ -63,8 +30,11 @@ namespace PaperRenderer
         buildSwapchain();
 
         //set glfw callback 
-        glfwSetWindowUserPointer(window, this);
-        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+        if(window)
+        {
+            glfwSetWindowUserPointer(window, this);
+            glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+        }
 
         //sync
         imageSemaphores.reserve(imageCount);
@@ -74,10 +44,7 @@ namespace PaperRenderer
         }
 
         //log constructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Swapchain constructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "Swapchain constructor finished");
     }
 
     Swapchain::~Swapchain()
@@ -92,18 +59,72 @@ namespace PaperRenderer
         vkDestroySwapchainKHR(renderer.getDevice().getDevice(), swapchain, nullptr);
         for(VkSemaphore semaphore : imageSemaphores)
         {
-            vkDestroySemaphore(renderer.getDevice().getDevice(), semaphore, nullptr);
+            renderer.getDevice().getCommands().recycleSemaphore(semaphore);
         }
 
         //glfw window and surface
         vkDestroySurfaceKHR(renderer.getDevice().getInstance(), renderer.getDevice().getSurface(), nullptr);
-        glfwDestroyWindow(window);
+        if(window) glfwDestroyWindow(window);
 
         //log destructor
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Swapchain destructor finished"
-        });
+        renderer.getLogger().recordLog(INFO, "Swapchain destructor finished");
+    }
+
+    void Swapchain::createWindow()
+    {
+        if(glfwVulkanSupported() != GLFW_TRUE) throw std::runtime_error("No vulkan support for GLFW");
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+        if(windowState.monitor == NULL)
+        {
+            windowState.monitor = glfwGetPrimaryMonitor();
+        }
+        const GLFWvidmode* mode = glfwGetVideoMode(windowState.monitor);
+
+        switch(windowState.windowMode)
+        {
+            case WINDOWED:
+                window = glfwCreateWindow(windowState.resX, windowState.resY, windowState.windowName.c_str(), NULL, NULL);
+
+                break;
+            case BORDERLESS:
+                glfwWindowHint(GLFW_RED_BITS, mode->redBits);
+                glfwWindowHint(GLFW_GREEN_BITS, mode->greenBits);
+                glfwWindowHint(GLFW_BLUE_BITS, mode->blueBits);
+                glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+                window = glfwCreateWindow(mode->width, mode->height, windowState.windowName.c_str(), windowState.monitor, NULL);
+
+                windowState.resX = mode->width;
+                windowState.resY = mode->height;
+
+                break;
+            case FULLSCREEN:
+                window = glfwCreateWindow(windowState.resX, windowState.resY, windowState.windowName.c_str(), windowState.monitor, NULL);
+
+                break;
+        }
+
+        //surface
+        VkResult result = glfwCreateWindowSurface(renderer.getDevice().getInstance(), window, nullptr, (VkSurfaceKHR*)(&renderer.getDevice().getSurface()));
+        if(result != VK_SUCCESS)
+        {
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create window surface");
+        }
+    }
+
+    void Swapchain::createHeadlessSurface()
+    {
+        //headless surfaces have no extent of their own; the swapchain uses the window state resolution
+        const VkHeadlessSurfaceCreateInfoEXT surfaceInfo = {
+            .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+            .pNext = NULL,
+            .flags = 0
+        };
+        VkResult result = vkCreateHeadlessSurfaceEXT(renderer.getDevice().getInstance(), &surfaceInfo, nullptr, (VkSurfaceKHR*)(&renderer.getDevice().getSurface()));
+        if(result != VK_SUCCESS)
+        {
+            renderer.getLogger().recordLog(CRITICAL_ERROR, "Failed to create headless surface");
+        }
     }
 
     const VkSemaphore& Swapchain::acquireNextImage()
@@ -149,6 +170,9 @@ namespace PaperRenderer
             .pResults = NULL
         };
 
+        //submissions signaling the wait semaphores must reach the GPU before presenting
+        renderer.getDevice().getCommands().flushSubmissions();
+
         //lock queue and present
         std::lock_guard guard(renderer.getDevice().getQueues().at(PRESENT).queues.at(0)->threadLock);
         VkResult presentResult = vkQueuePresentKHR(renderer.getDevice().getQueues().at(QueueType::PRESENT).queues.at(0)->queue, &presentSubmitInfo);
@@ -193,10 +217,7 @@ namespace PaperRenderer
             else
             {
                 //use first
-                renderer.getLogger().recordLog({
-                    .type = WARNING,
-                    .text=  "Selected VkPresentModeKHR for swapchain was not found. Using first found mode"
-                });
+                renderer.getLogger().recordLog(WARNING, "Selected VkPresentModeKHR for swapchain was not found. Using first found mode");
                 windowState.presentMode = presentModes[0];
             }
         }
@@ -233,10 +254,7 @@ namespace PaperRenderer
         if(!formatFound)
         {
             //log warning
-            renderer.getLogger().recordLog({
-                .type = WARNING,
-                .text = "Selected surface format was not found. Auto selecting format instead"
-            });
+            renderer.getLogger().recordLog(WARNING, "Selected surface format was not found. Auto selecting format instead");
             
             //use sRGB if no HDR format is available; use UNORM if sRGB isnt avaliable
             for(const VkSurfaceFormatKHR surfaceFormat : surfaceFormats)
@@ -337,10 +355,7 @@ namespace PaperRenderer
         createImageViews();
 
         //log build
-        renderer.getLogger().recordLog({
-            .type = INFO,
-            .text = "Swapchain built using VkFormat " + std::to_string(windowState.surfaceFormat.format)
-        });
+        renderer.getLogger().recordLog(INFO, [&] { return "Swapchain built using VkFormat " + std::to_string(windowState.surfaceFormat.format); });
     }
 
     void Swapchain::createImageViews()
@@ -377,13 +392,18 @@ namespace PaperRenderer
 
     void Swapchain::recreate()
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(window, &width, &height);
-        while (width == 0 || height == 0) {
-            glfwWaitEvents();
+        //headless swapchains keep the window state resolution
+        if(window)
+        {
+            int width = 0, height = 0;
             glfwGetFramebufferSize(window, &width, &height);
+            while (width == 0 || height == 0) {
+                glfwWaitEvents();
+                glfwGetFramebufferSize(window, &width, &height);
+            }
         }
 
+        renderer.getDevice().getCommands().flushSubmissions();
         vkDeviceWaitIdle(renderer.getDevice().getDevice());
         
         //destruction
@@ -45,6 +45,8 @@ namespace PaperRenderer
 
         class RenderEngine& renderer;
         
+        void createWindow();
+        void createHeadlessSurface();
         void buildSwapchain();
         void createImageViews();
 
@@ -59,7 +61,7 @@ namespace PaperRenderer
         void setWindowState(const WindowState& newState);
         void recreate();
 
-        GLFWwindow* getGLFWwindow() const { return window; }
+        GLFWwindow* getGLFWwindow() const { return window; } //NULL when headless
         const WindowState& getWindowState() const { return windowState; }
         const VkImageView& getCurrentImageView() const { return imageViews[frameIndex]; }
         const VkImage& getCurrentImage() const { return swapchainImages[frameIndex]; }
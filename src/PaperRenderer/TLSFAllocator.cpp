@@ -0,0 +1,406 @@
+#include "TLSFAllocator.h"
+
+#include <bit>
+#include <algorithm>
+
+namespace PaperRenderer
+{
+    //----------TLSF ALLOCATOR DEFINITIONS----------//
+
+    TLSFAllocator::TLSFAllocator(const uint64_t size, const uint64_t granularity)
+        :size(size),
+        granularity(std::max(granularity, (uint64_t)1))
+    {
+        initialize();
+    }
+
+    TLSFAllocator::~TLSFAllocator()
+    {
+    }
+
+    void TLSFAllocator::initialize()
+    {
+        blocks.clear();
+        unusedBlocks.clear();
+        allocatedBlocks.clear();
+        flBitmap = 0;
+        for(uint32_t fl = 0; fl < flCount; fl++)
+        {
+            slBitmaps[fl] = 0;
+            std::fill(std::begin(freeLists[fl]), std::end(freeLists[fl]), nullBlock);
+        }
+        usedSize = 0;
+        firstBlock = nullBlock;
+        lastBlock = nullBlock;
+
+        //whole range starts as one free block
+        if(size >= granularity)
+        {
+            firstBlock = newBlock();
+            lastBlock = firstBlock;
+            blocks[firstBlock] = {
+                .offset = 0,
+                .size = size - (size % granularity),
+                .free = true
+            };
+            insertFreeBlock(firstBlock);
+        }
+    }
+
+    void TLSFAllocator::mapping(const uint64_t units, uint32_t& fl, uint32_t& sl)
+    {
+        //small sizes get an exact bin each in the first level
+        if(units < slCount)
+        {
+            fl = 0;
+            sl = (uint32_t)units;
+        }
+        //otherwise the first level is the power of 2, and the second level linearly subdivides it
+        else
+        {
+            const uint32_t msb = 63 - std::countl_zero(units);
+            fl = msb - slBits + 1;
+            sl = (uint32_t)(units >> (msb - slBits)) - slCount;
+        }
+    }
+
+    uint32_t TLSFAllocator::newBlock()
+    {
+        if(unusedBlocks.size())
+        {
+            const uint32_t blockIndex = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            blocks[blockIndex] = {};
+
+            return blockIndex;
+        }
+
+        blocks.push_back({});
+        return (uint32_t)blocks.size() - 1;
+    }
+
+    void TLSFAllocator::insertFreeBlock(const uint32_t blockIndex)
+    {
+        uint32_t fl, sl;
+        mapping(blocks[blockIndex].size / granularity, fl, sl);
+
+        //push to the front of the bin's list
+        const uint32_t head = freeLists[fl][sl];
+        blocks[blockIndex].free = true;
+        blocks[blockIndex].prevFree = nullBlock;
+        blocks[blockIndex].nextFree = head;
+        if(head != nullBlock) blocks[head].prevFree = blockIndex;
+        freeLists[fl][sl] = blockIndex;
+
+        flBitmap |= (uint64_t)1 << fl;
+        slBitmaps[fl] |= (uint32_t)1 << sl;
+    }
+
+    void TLSFAllocator::removeFreeBlock(const uint32_t blockIndex)
+    {
+        uint32_t fl, sl;
+        mapping(blocks[blockIndex].size / granularity, fl, sl);
+
+        const uint32_t prev = blocks[blockIndex].prevFree;
+        const uint32_t next = blocks[blockIndex].nextFree;
+        if(prev != nullBlock) blocks[prev].nextFree = next;
+        if(next != nullBlock) blocks[next].prevFree = prev;
+
+        //update head and bitmaps if this was the head
+        if(freeLists[fl][sl] == blockIndex)
+        {
+            freeLists[fl][sl] = next;
+            if(next == nullBlock)
+            {
+                slBitmaps[fl] &= ~((uint32_t)1 << sl);
+                if(!slBitmaps[fl]) flBitmap &= ~((uint64_t)1 << fl);
+            }
+        }
+
+        blocks[blockIndex].free = false;
+        blocks[blockIndex].prevFree = nullBlock;
+        blocks[blockIndex].nextFree = nullBlock;
+    }
+
+    void TLSFAllocator::mergeWithNext(const uint32_t blockIndex)
+    {
+        const uint32_t next = blocks[blockIndex].nextPhysical;
+        const uint32_t nextNext = blocks[next].nextPhysical;
+
+        blocks[blockIndex].size += blocks[next].size;
+        blocks[blockIndex].nextPhysical = nextNext;
+        if(nextNext != nullBlock) blocks[nextNext].prevPhysical = blockIndex;
+        else lastBlock = blockIndex;
+
+        unusedBlocks.push_back(next);
+    }
+
+    uint64_t TLSFAllocator::allocate(const uint64_t requestedSize)
+    {
+        //pad size
+        const uint64_t units = std::max((requestedSize + granularity - 1) / granularity, (uint64_t)1);
+        const uint64_t allocationSize = units * granularity;
+
+        //round up to the next bin so any block in the found bin is large enough
+        uint64_t searchUnits = units;
+        if(units >= slCount)
+        {
+            //blocks in the size's own bin may still fit, and using them leaves the larger bins for larger allocations
+            uint32_t fl, sl;
+            mapping(units, fl, sl);
+            uint32_t searchedBlocks = 0;
+            for(uint32_t blockIndex = freeLists[fl][sl]; blockIndex != nullBlock && searchedBlocks < maxBinSearchBlocks; blockIndex = blocks[blockIndex].nextFree)
+            {
+                if(blocks[blockIndex].size >= allocationSize) return useFreeBlock(blockIndex, allocationSize);
+                searchedBlocks++;
+            }
+
+            searchUnits += ((uint64_t)1 << (63 - std::countl_zero(units) - slBits)) - 1;
+        }
+        uint32_t fl, sl;
+        mapping(searchUnits, fl, sl);
+        if(fl >= flCount)
+        {
+            return UINT64_MAX;
+        }
+
+        //find the first non-empty bin at or above the mapped one
+        uint32_t slMap = slBitmaps[fl] & (UINT32_MAX << sl);
+        if(!slMap)
+        {
+            const uint64_t flMap = fl + 1 < 64 ? flBitmap & (UINT64_MAX << (fl + 1)) : 0;
+            if(!flMap)
+            {
+                return UINT64_MAX;
+            }
+
+            fl = std::countr_zero(flMap);
+            slMap = slBitmaps[fl];
+        }
+        sl = std::countr_zero(slMap);
+
+        return useFreeBlock(freeLists[fl][sl], allocationSize);
+    }
+
+    uint64_t TLSFAllocator::allocateBelow(const uint64_t requestedSize, const uint64_t limit)
+    {
+        //pad size
+        const uint64_t units = std::max((requestedSize + granularity - 1) / granularity, (uint64_t)1);
+        const uint64_t allocationSize = units * granularity;
+        if(allocationSize > limit)
+        {
+            return UINT64_MAX;
+        }
+
+        //unlike allocate(), starts at the bin the size maps to since blocks in it may still fit, and checks offsets
+        uint32_t fl, sl;
+        mapping(units, fl, sl);
+        for(; fl < flCount; fl++, sl = 0)
+        {
+            uint32_t slMap = slBitmaps[fl] & (UINT32_MAX << sl);
+            while(slMap)
+            {
+                const uint32_t bin = std::countr_zero(slMap);
+                slMap &= slMap - 1;
+
+                uint32_t searchedBlocks = 0;
+                for(uint32_t blockIndex = freeLists[fl][bin]; blockIndex != nullBlock && searchedBlocks < maxBinSearchBlocks; blockIndex = blocks[blockIndex].nextFree)
+                {
+                    if(blocks[blockIndex].size >= allocationSize && blocks[blockIndex].offset + allocationSize <= limit)
+                    {
+                        return useFreeBlock(blockIndex, allocationSize);
+                    }
+                    searchedBlocks++;
+                }
+            }
+        }
+
+        return UINT64_MAX;
+    }
+
+    uint64_t TLSFAllocator::useFreeBlock(const uint32_t blockIndex, const uint64_t allocationSize)
+    {
+        removeFreeBlock(blockIndex);
+
+        //split off the remainder as a new free block
+        if(blocks[blockIndex].size > allocationSize)
+        {
+            const uint32_t remainderIndex = newBlock(); //may reallocate blocks, so no references are held across this
+            const uint32_t next = blocks[blockIndex].nextPhysical;
+            blocks[remainderIndex] = {
+                .offset = blocks[blockIndex].offset + allocationSize,
+                .size = blocks[blockIndex].size - allocationSize,
+                .prevPhysical = blockIndex,
+                .nextPhysical = next
+            };
+            if(next != nullBlock) blocks[next].prevPhysical = remainderIndex;
+            else lastBlock = remainderIndex;
+
+            blocks[blockIndex].size = allocationSize;
+            blocks[blockIndex].nextPhysical = remainderIndex;
+            insertFreeBlock(remainderIndex);
+        }
+
+        allocatedBlocks[blocks[blockIndex].offset] = blockIndex;
+        usedSize += blocks[blockIndex].size;
+
+        return blocks[blockIndex].offset;
+    }
+
+    void TLSFAllocator::free(const uint64_t offset)
+    {
+        const auto allocatedBlock = allocatedBlocks.find(offset);
+        if(allocatedBlock == allocatedBlocks.end())
+        {
+            return;
+        }
+        uint32_t blockIndex = allocatedBlock->second;
+        allocatedBlocks.erase(allocatedBlock);
+        usedSize -= blocks[blockIndex].size;
+
+        //coalesce with free neighbors
+        const uint32_t next = blocks[blockIndex].nextPhysical;
+        if(next != nullBlock && blocks[next].free)
+        {
+            removeFreeBlock(next);
+            mergeWithNext(blockIndex);
+        }
+
+        const uint32_t prev = blocks[blockIndex].prevPhysical;
+        if(prev != nullBlock && blocks[prev].free)
+        {
+            removeFreeBlock(prev);
+            mergeWithNext(prev);
+            blockIndex = prev;
+        }
+
+        insertFreeBlock(blockIndex);
+    }
+
+    std::vector<TLSFRange> TLSFAllocator::compact()
+    {
+        //walk the blocks in physical order; free blocks with an allocation after them are the gaps
+        std::vector<TLSFRange> gaps = {};
+        std::vector<uint64_t> allocationSizes = {};
+        allocationSizes.reserve(allocatedBlocks.size());
+
+        TLSFRange pendingGap = {};
+        for(uint32_t blockIndex = firstBlock; blockIndex != nullBlock; blockIndex = blocks[blockIndex].nextPhysical)
+        {
+            const Block& block = blocks[blockIndex];
+            if(block.free)
+            {
+                if(!pendingGap.size) pendingGap.offset = block.offset;
+                pendingGap.size += block.size;
+            }
+            else
+            {
+                if(pendingGap.size) gaps.push_back(pendingGap);
+                pendingGap = {};
+
+                allocationSizes.push_back(block.size);
+            }
+        }
+
+        //rebuild with allocations packed from the start; a fresh allocator allocates sequentially
+        if(gaps.size())
+        {
+            initialize();
+            for(const uint64_t allocationSize : allocationSizes)
+            {
+                allocate(allocationSize);
+            }
+        }
+
+        return gaps;
+    }
+
+    void TLSFAllocator::resize(const uint64_t newSize)
+    {
+        const uint64_t usedEnd = getUsedEnd();
+        size = std::max(newSize, usedEnd);
+        const uint64_t newEnd = size - (size % granularity);
+
+        //only the trailing free block changes
+        if(lastBlock != nullBlock && blocks[lastBlock].free)
+        {
+            removeFreeBlock(lastBlock);
+            if(newEnd > blocks[lastBlock].offset)
+            {
+                blocks[lastBlock].size = newEnd - blocks[lastBlock].offset;
+                insertFreeBlock(lastBlock);
+            }
+            else
+            {
+                //nothing is left of it
+                const uint32_t prev = blocks[lastBlock].prevPhysical;
+                unusedBlocks.push_back(lastBlock);
+                if(prev != nullBlock) blocks[prev].nextPhysical = nullBlock;
+                else firstBlock = nullBlock;
+                lastBlock = prev;
+            }
+        }
+        else if(newEnd > usedEnd)
+        {
+            const uint32_t tailIndex = newBlock();
+            blocks[tailIndex] = {
+                .offset = usedEnd,
+                .size = newEnd - usedEnd,
+                .prevPhysical = lastBlock
+            };
+            if(lastBlock != nullBlock) blocks[lastBlock].nextPhysical = tailIndex;
+            else firstBlock = tailIndex;
+            lastBlock = tailIndex;
+            insertFreeBlock(tailIndex);
+        }
+    }
+
+    std::vector<TLSFRange> TLSFAllocator::getTrailingAllocations(const uint64_t maxSize) const
+    {
+        std::vector<TLSFRange> allocations = {};
+        uint64_t totalSize = 0;
+        for(uint32_t blockIndex = lastBlock; blockIndex != nullBlock; blockIndex = blocks[blockIndex].prevPhysical)
+        {
+            if(blocks[blockIndex].free) continue;
+
+            if(allocations.size() && totalSize + blocks[blockIndex].size > maxSize)
+            {
+                break;
+            }
+            allocations.push_back({ blocks[blockIndex].offset, blocks[blockIndex].size });
+            totalSize += blocks[blockIndex].size;
+        }
+
+        return allocations;
+    }
+
+    uint64_t TLSFAllocator::getUsedEnd() const
+    {
+        if(lastBlock == nullBlock)
+        {
+            return 0;
+        }
+
+        return blocks[lastBlock].free ? blocks[lastBlock].offset : blocks[lastBlock].offset + blocks[lastBlock].size;
+    }
+
+    uint64_t TLSFAllocator::getLargestFreeBlock() const
+    {
+        if(!flBitmap)
+        {
+            return 0;
+        }
+
+        //largest block is in the highest non-empty bin
+        const uint32_t fl = 63 - std::countl_zero(flBitmap);
+        const uint32_t sl = 31 - std::countl_zero(slBitmaps[fl]);
+
+        uint64_t largestSize = 0;
+        for(uint32_t blockIndex = freeLists[fl][sl]; blockIndex != nullBlock; blockIndex = blocks[blockIndex].nextFree)
+        {
+            largestSize = std::max(largestSize, blocks[blockIndex].size);
+        }
+
+        return largestSize;
+    }
+}
@@ -14,6 +14,7 @@ namespace PaperRenderer
 
     VulkanResource::~VulkanResource()
     {
+        untrackAllocation();
     }
 
     VulkanResource::VulkanResource(VulkanResource&& other) noexcept
@@ -21,6 +22,8 @@ namespace PaperRenderer
         owners(std::move(other.owners)),
         allocation(other.allocation),
         writable(other.writable),
+        memoryCategory(other.memoryCategory),
+        trackedSize(other.trackedSize),
         renderer(other.renderer)
     {
         std::lock_guard guard(other.resourceMutex); // Constructor should block old mutex
@@ -28,27 +31,67 @@ namespace PaperRenderer
         other.owners = {};
         other.allocation = VK_NULL_HANDLE;
         other.writable = false;
+        other.trackedSize = 0;
     }
 
     VulkanResource& VulkanResource::operator=(VulkanResource&& other) noexcept
     {
         if (this != &other)
         {
+            //the previous allocation and its accounting have already been handed off for destruction by the derived class
+            untrackAllocation();
+
             std::lock_guard guard(other.resourceMutex);
             size = other.size;
             owners = std::move(other.owners);
             allocation = other.allocation;
             writable = other.writable;
+            memoryCategory = other.memoryCategory;
+            trackedSize = other.trackedSize;
 
             other.size = 0;
             other.owners.clear();
             other.allocation = VK_NULL_HANDLE;
             other.writable = false;
+            other.trackedSize = 0;
         }
 
         return *this;
     }
 
+    void VulkanResource::trackAllocation(MemoryCategory category, const VmaAllocationInfo& allocationInfo)
+    {
+        memoryCategory = category;
+        trackedSize = allocationInfo.size;
+        renderer->getStatisticsTracker().trackMemory(memoryCategory, (int64_t)trackedSize, 1);
+    }
+
+    void VulkanResource::untrackAllocation()
+    {
+        if(trackedSize)
+        {
+            renderer->getStatisticsTracker().trackMemory(memoryCategory, -(int64_t)trackedSize, -1);
+            trackedSize = 0;
+        }
+    }
+
+    VulkanResource::TrackedAllocation VulkanResource::takeTrackedAllocation()
+    {
+        const TrackedAllocation trackedAllocation = {
+            .tracker = &renderer->getStatisticsTracker(),
+            .category = memoryCategory,
+            .size = trackedSize
+        };
+        trackedSize = 0;
+
+        return trackedAllocation;
+    }
+
+    void VulkanResource::TrackedAllocation::untrack() const
+    {
+        if(size) tracker->trackMemory(category, -(int64_t)size, -1);
+    }
+
     bool VulkanResource::checkIfWritable(const VmaAllocationInfo& allocationInfo) const
     {
         VkMemoryPropertyFlags memPropertyFlags = 0;
@@ -68,12 +111,22 @@ namespace PaperRenderer
         owners.erase(&queue);
     }
 
-    void VulkanResource::idleOwners()
+    std::vector<TimelineSemaphorePair> VulkanResource::getOwnerSubmissions()
     {
+        std::lock_guard guard(resourceMutex);
+        std::vector<TimelineSemaphorePair> submissions = {};
+        submissions.reserve(owners.size());
         for(Queue* queue : owners)
         {
-            queue->idle();
+            submissions.push_back(renderer->getDevice().getCommands().getLastSubmission(*queue));
         }
+
+        return submissions;
+    }
+
+    void VulkanResource::idleOwners()
+    {
+        renderer->getDevice().getCommands().waitForSubmissions(getOwnerSubmissions());
     }
 
     VkMemoryType VulkanResource::getMemoryType() const
@@ -109,17 +162,21 @@ namespace PaperRenderer
             //log error if detected
             if(!queueFamilyIndices.size())
             {
-                renderer.getLogger().recordLog({
-                    .type = CRITICAL_ERROR,
-                    .text = "Tried to create buffer with no queue family indices referenced"
-                });
+                renderer.getLogger().recordLog(CRITICAL_ERROR, "Tried to create buffer with no queue family indices referenced");
+            }
+
+            //the descriptor buffer backend references uniform and storage buffers by address
+            VkBufferUsageFlags2KHR usageFlags = bufferInfo.usageFlags;
+            if(renderer.getDevice().getGPUFeaturesAndProperties().descriptorBuffer && usageFlags & (VK_BUFFER_USAGE_2_UNIFORM_BUFFER_BIT_KHR | VK_BUFFER_USAGE_2_STORAGE_BUFFER_BIT_KHR))
+            {
+                usageFlags |= VK_BUFFER_USAGE_2_SHADER_DEVICE_ADDRESS_BIT_KHR;
             }
 
             //creation info
             const VkBufferUsageFlags2CreateInfo usageFlagsInfo = {
                 .sType = VK_STRUCTURE_TYPE_BUFFER_USAGE_FLAGS_2_CREATE_INFO,
                 .pNext = NULL,
-                .usage = bufferInfo.usageFlags
+                .usage = usageFlags
             };
 
             const VkBufferCreateInfo bufferCreateInfo = {
@@ -144,8 +201,10 @@ namespace PaperRenderer
             {
                 throw std::runtime_error("Buffer creation failed");
             }
+            DescriptorAllocator::notifyHandleCreated();
 
             writable = checkIfWritable(allocInfo);
+            trackAllocation(bufferInfo.category, allocInfo);
         
             size = bufferInfo.size;
         }
@@ -153,8 +212,14 @@ namespace PaperRenderer
 
     Buffer::~Buffer()
     {
-        idleOwners();
-        if(allocation && buffer) vmaDestroyBuffer(renderer->getDevice().getAllocator(), buffer, allocation);
+        //destroyed once the owners' submissions complete rather than idling them; the memory stays counted until then
+        if(allocation && buffer)
+        {
+            renderer->getDevice().getCommands().deferDestruction(getOwnerSubmissions(), [allocator = renderer->getDevice().getAllocator(), buffer = buffer, allocation = allocation, trackedAllocation = takeTrackedAllocation()] {
+                vmaDestroyBuffer(allocator, buffer, allocation);
+                trackedAllocation.untrack();
+            });
+        }
     }
 
     Buffer::Buffer(Buffer&& other) noexcept
@@ -169,8 +234,13 @@ namespace PaperRenderer
     {
         if(this != &other)
         {
-            idleOwners();
-            if(allocation && buffer) vmaDestroyBuffer(renderer->getDevice().getAllocator(), buffer, allocation);
+            if(allocation && buffer)
+            {
+                renderer->getDevice().getCommands().deferDestruction(getOwnerSubmissions(), [allocator = renderer->getDevice().getAllocator(), buffer = buffer, allocation = allocation, trackedAllocation = takeTrackedAllocation()] {
+                    vmaDestroyBuffer(allocator, buffer, allocation);
+                    trackedAllocation.untrack();
+                });
+            }
 
             VulkanResource::operator=(std::move(other));
             buffer = other.buffer;
@@ -183,7 +253,7 @@ namespace PaperRenderer
         return *this;
     }
 
-    int Buffer::writeToBuffer(const std::vector<BufferWrite>& writes)
+    int Buffer::writeToBuffer(const SmallVector<BufferWrite, 4>& writes)
     {
         // Use GPU to perform transfer if buffer isnt host visible (suboptimal)
         if(!isWritable())
@@ -196,11 +266,7 @@ namespace PaperRenderer
                 {
                     transfers.push_back({
                         .dstOffset = write.offset,
-                        .data = [&write] {
-                            std::vector<uint8_t> data(write.size);
-                            memcpy(data.data(), write.readData, write.size);
-                            return data;
-                        } (),
+                        .dataView = std::span((const uint8_t*)write.readData, write.size),
                         .dstBuffer = this
                     });
                 }
@@ -224,7 +290,7 @@ namespace PaperRenderer
         return 0;
     }
 
-    int Buffer::readFromBuffer(const std::vector<BufferRead> &reads)
+    int Buffer::readFromBuffer(const SmallVector<BufferRead, 4> &reads)
     {
         assert(isWritable());
 
@@ -276,7 +342,7 @@ namespace PaperRenderer
 
     FragmentableBuffer::FragmentableBuffer(RenderEngine& renderer, const BufferInfo& bufferInfo, VkDeviceSize minAlignment)
         :buffer(renderer, bufferInfo),
-        minAlignment(minAlignment),
+        range(bufferInfo.size, minAlignment),
         renderer(&renderer)
     {
     }
@@ -287,20 +353,16 @@ namespace PaperRenderer
 
     FragmentableBuffer::FragmentableBuffer(FragmentableBuffer&& other) noexcept
         :buffer(std::move(other.buffer)),
-        desiredLocation(other.desiredLocation),
-        stackLocation(other.stackLocation),
-        totalDataSize(other.totalDataSize),
-        minAlignment(other.minAlignment),
-        memoryFragments(std::move(other.memoryFragments)),
+        range(std::move(other.range)),
         compactionCallback(other.compactionCallback),
+        pendingMovesSubmission(other.pendingMovesSubmission),
+        pendingFreesSubmissions(std::move(other.pendingFreesSubmissions)),
+        defragmentationCallback(other.defragmentationCallback),
         renderer(other.renderer),
         allocation(other.allocation)
     {
-        other.desiredLocation = 0;
-        other.stackLocation = 0;
-        other.totalDataSize = 0;
-        other.memoryFragments = {};
         other.compactionCallback = NULL;
+        other.defragmentationCallback = NULL;
         other.allocation = VK_NULL_HANDLE;
     }
 
@@ -309,20 +371,16 @@ namespace PaperRenderer
         if(this != &other)
         {
             buffer = std::move(other.buffer);
-            desiredLocation = other.desiredLocation;
-            stackLocation = other.stackLocation;
-            totalDataSize = other.totalDataSize;
-            minAlignment = other.minAlignment;
-            memoryFragments = std::move(other.memoryFragments);
+            range = std::move(other.range);
             compactionCallback = other.compactionCallback;
+            pendingMovesSubmission = other.pendingMovesSubmission;
+            pendingFreesSubmissions = std::move(other.pendingFreesSubmissions);
+            defragmentationCallback = other.defragmentationCallback;
             renderer = other.renderer;
             allocation = other.allocation;
 
-            other.desiredLocation = 0;
-            other.stackLocation = 0;
-            other.totalDataSize = 0;
-            other.memoryFragments = {};
             other.compactionCallback = NULL;
+            other.defragmentationCallback = NULL;
             other.allocation = VK_NULL_HANDLE;
         }
 
@@ -334,52 +392,20 @@ namespace PaperRenderer
         //lock mutex
         std::lock_guard guard(buffer.resourceMutex);
 
-        WriteResult result = SUCCESS;
-        VkDeviceSize writeLocation = UINT64_MAX;
-
-        //pad size
-        size = renderer->getDevice().getAlignment(size, minAlignment);
-
-        //attempt to find a chunk first
-        auto lower = memoryFragments.lower_bound({ 0, size });
-        if(lower != memoryFragments.end())
+        //allocate; size is padded by the range
+        RangeCompaction compaction = {};
+        const VkDeviceSize writeLocation = range.allocate(size, compaction);
+        if(compaction.compacted)
         {
-            //set write location to the start of the fragment
-            writeLocation = lower->location;
-
-            //add new fragment if size is > 0
-            if(lower->size - size > 0)
-            {
-                memoryFragments.insert({ lower->location + size, lower->size - size});
-            }
-
-            //remove old fragment
-            memoryFragments.erase(lower);
+            pendingFreesSubmissions.clear();
+            recordCompaction(compaction);
         }
-        //or just add to the stack if there is no good fragment
-        else
-        {
-            desiredLocation += size;
-            if(stackLocation + size > buffer.getSize())
-            {
-                //if compaction gives back no results then there's no more available memory
-                if(!compact().size() || stackLocation + size > buffer.getSize())
-                {
-                    if(returnLocation) *returnLocation = UINT64_MAX;
-
-                    result = OUT_OF_MEMORY;
-                    return result;
-                }
 
-                //otherwise the compaction succeeded and enough available memory was created;
-                result = COMPACTED;
-            }
-
-            //set write location to the stack pointer
-            writeLocation = stackLocation;
-
-            //change stack location to desired location
-            stackLocation = desiredLocation;
+        //no more available memory
+        if(writeLocation == UINT64_MAX)
+        {
+            if(returnLocation) *returnLocation = UINT64_MAX;
+            return OUT_OF_MEMORY;
         }
 
         //write if host visible
@@ -395,11 +421,8 @@ namespace PaperRenderer
 
         //enumerate write location to ptr if provided
         if(returnLocation) *returnLocation = writeLocation;
-
-        //increment total data size
-        totalDataSize += size;
         
-        return result;
+        return compaction.compacted ? COMPACTED : SUCCESS;
     }
 
     void FragmentableBuffer::removeFromRange(VkDeviceSize offset, VkDeviceSize size)
@@ -407,138 +430,181 @@ namespace PaperRenderer
         //lock mutex
         std::lock_guard guard(buffer.resourceMutex);
 
-        //pad size
-        size = renderer->getDevice().getAlignment(size, minAlignment);
-        
-        //add fragment
-        Chunk memoryFragment = {
-            .location = offset,
-            .size = size
-        };
-        memoryFragments.insert(memoryFragment);
+        //removing an allocation that's being moved leaves the move's new location as a pending free, which can't be reused until the move's copy completes
+        if(range.hasPendingMoves() && (pendingFreesSubmissions.empty() || pendingFreesSubmissions.back().semaphore != pendingMovesSubmission.semaphore ||
+            pendingFreesSubmissions.back().value != pendingMovesSubmission.value))
+        {
+            pendingFreesSubmissions.push_back(pendingMovesSubmission);
+        }
+
+        range.free(offset);
+    }
+
+    void FragmentableBuffer::copyAllocations(const FragmentableBuffer& other)
+    {
+        //lock mutex
+        std::lock_guard guard(buffer.resourceMutex);
 
-        //decrement total data size
-        totalDataSize -= size;
+        range.copyAllocations(other.range);
     }
 
     std::vector<CompactionResult> FragmentableBuffer::compact()
     {
-        std::vector<CompactionResult> compactionLocations;
+        std::lock_guard guard(buffer.resourceMutex);
 
-        //if statement because the compaction callback shouldnt be invoked if no memory fragments exists, which leads to no effective compaction
-        if(memoryFragments.size())
+        const RangeCompaction compaction = range.compact();
+        pendingFreesSubmissions.clear();
+        recordCompaction(compaction);
+
+        return compaction.results;
+    }
+
+    void FragmentableBuffer::recordCompaction(const RangeCompaction& compaction)
+    {
+        //the compaction callback shouldnt be invoked if no memory fragments exists, which leads to no effective compaction
+        if(!compaction.compacted)
         {
-            Timer timer(*renderer, "Fragmentable Buffer Compaction", IRREGULAR);
-            
-            //sort memory fragments by their location
-            std::vector<Chunk> vectorMemoryFragments;
-            vectorMemoryFragments.insert(vectorMemoryFragments.end(), memoryFragments.begin(), memoryFragments.end());
-            std::sort(vectorMemoryFragments.begin(), vectorMemoryFragments.end(), FragmentableBuffer::Chunk::compareByLocation);
+            return;
+        }
 
-            //start a command buffer
-            CommandBuffer cmdBuffer(renderer->getDevice().getCommands(), TRANSFER);
+        Timer timer(*renderer, "Fragmentable Buffer Compaction", IRREGULAR);
 
-            const VkCommandBufferBeginInfo beginInfo = {
-                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        //start a command buffer
+        CommandBuffer cmdBuffer(renderer->getDevice().getCommands(), TRANSFER);
+
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = NULL,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = NULL
+        };
+        vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+
+        //copies are in order, with a barrier after each since the next one may read what this one wrote
+        for(const RangeCopy& copy : compaction.copies)
+        {
+            const VkBufferCopy copyRegion = {
+                .srcOffset = copy.srcOffset,
+                .dstOffset = copy.dstOffset,
+                .size = copy.size
+            };
+            vkCmdCopyBuffer(cmdBuffer, buffer.getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+
+            //insert memory barrier at src offset
+            const VkBufferMemoryBarrier2 memBarrier = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
                 .pNext = NULL,
-                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-                .pInheritanceInfo = NULL
+                .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                .srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = buffer.getBuffer(),
+                .offset = copyRegion.srcOffset,
+                .size = copyRegion.size
             };
-            vkBeginCommandBuffer(cmdBuffer, &beginInfo);
 
-            //dynamic variables
-            VkDeviceSize sizeReduction = 0;
+            const VkDependencyInfo dependencyInfo = {
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = NULL,
+                .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
+                .bufferMemoryBarrierCount = 1,
+                .pBufferMemoryBarriers = &memBarrier
+            };
 
-            //shift data into memory fragment gaps
-            for(uint32_t i = 0; i < vectorMemoryFragments.size(); i++)
-            {
-                //get current and next chunks
-                const Chunk chunk = vectorMemoryFragments[i];
-                const Chunk nextChunk = i < vectorMemoryFragments.size() - 1 ? vectorMemoryFragments[i + 1] : Chunk({ stackLocation, 0 });
+            vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+        }
 
-                //get important sizes
-                const VkDeviceSize totalCopySize = nextChunk.location - std::min(nextChunk.location, (chunk.location + chunk.size)); //copy the size of this chunks location + size all the way to the next chunks location
-                const VkDeviceSize srcOffset = chunk.location + chunk.size; //copy past the fragmentation gap
-                const VkDeviceSize dstOffset = chunk.location - sizeReduction; //copy into the gap
+        //end command buffer
+        vkEndCommandBuffer(cmdBuffer);
 
-                //increment size reduction
-                sizeReduction += chunk.size;
+        //wait on the owners' submissions on the GPU instead of idling them
+        const SynchronizationInfo syncInfo = {
+            .timelineWaitPairs = buffer.getOwnerSubmissions()
+        };
 
-                //perform data moves if total copy size
-                if(totalCopySize)
-                {
-                    //iteration count needed to avoid undefined behavior with overlapping copies
-                    const VkDeviceSize iterations = std::ceil((double)totalCopySize / (double)sizeReduction);
-
-                    //copy over iterations
-                    for(VkDeviceSize j = 0; j < iterations; j++)
-                    {
-                        //get this iteration's copy size
-                        const VkDeviceSize itCopySize = std::min(totalCopySize - (sizeReduction * j), sizeReduction);
-                    
-                        //buffer copy
-                        const VkBufferCopy copyRegion = {
-                            .srcOffset = srcOffset + (itCopySize * j),
-                            .dstOffset = dstOffset + (itCopySize * j),
-                            .size = itCopySize
-                        };
-                        vkCmdCopyBuffer(cmdBuffer, buffer.getBuffer(), buffer.getBuffer(), 1, &copyRegion);
-
-                        //insert memory barrier at src offset
-                        const VkBufferMemoryBarrier2 memBarrier = {
-                            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-                            .pNext = NULL,
-                            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                            .srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
-                            .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .buffer = buffer.getBuffer(),
-                            .offset = copyRegion.srcOffset,
-                            .size = copyRegion.size
-                        };
-
-                        const VkDependencyInfo dependencyInfo = {
-                            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-                            .pNext = NULL,
-                            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT,
-                            .bufferMemoryBarrierCount = 1,
-                            .pBufferMemoryBarriers = &memBarrier
-                        };
-
-                        vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
-                    }
+        //submit
+        buffer.addOwner(renderer->getDevice().getCommands().submitToQueue(TRANSFER, syncInfo, { cmdBuffer }));
 
-                    //create compaction result
-                    compactionLocations.push_back({
-                        .location = chunk.location,
-                        .shiftSize = chunk.size
-                    });
-                }
+        //call callback function
+        if(compactionCallback) compactionCallback(compaction.results);
+    }
+
+    void FragmentableBuffer::defragment(const VkDeviceSize maxMoveSize)
+    {
+        std::lock_guard guard(buffer.resourceMutex);
+        Commands& commands = renderer->getDevice().getCommands();
+
+        //free old locations once nothing can still be reading them
+        if(range.hasPendingFrees() && commands.submissionsComplete(pendingFreesSubmissions))
+        {
+            range.releasePendingFrees();
+            pendingFreesSubmissions.clear();
+        }
+
+        //publish moves once their copies have completed
+        if(range.hasPendingMoves())
+        {
+            if(!commands.submissionsComplete({ pendingMovesSubmission }))
+            {
+                return;
             }
 
-            //modify stack pointers
-            stackLocation -= sizeReduction;
-            desiredLocation -= sizeReduction;
+            //work submitted up to now may still read from the old locations
+            pendingFreesSubmissions = buffer.getOwnerSubmissions();
 
-            //clear memory fragments
-            memoryFragments.clear();
+            const std::vector<DefragmentationMove> moves = range.publishDefragmentation();
+            if(defragmentationCallback) defragmentationCallback(moves);
 
-            //end command buffer
-            vkEndCommandBuffer(cmdBuffer);
+            return;
+        }
 
-            //idle resource owners before submission
-            buffer.idleOwners();
+        //move allocations from the end into the lowest fitting free space below them
+        const std::vector<RangeCopy> copies = range.beginDefragmentation(maxMoveSize);
+        if(copies.empty())
+        {
+            return;
+        }
 
-            //submit
-            renderer->getDevice().getCommands().submitToQueue(TRANSFER, {}, { cmdBuffer });
+        Timer timer(*renderer, "Fragmentable Buffer Defragmentation", REGULAR);
 
-            //call callback function
-            if(compactionCallback) compactionCallback(compactionLocations);
+        std::vector<VkBufferCopy> copyRegions = {};
+        copyRegions.reserve(copies.size());
+        VkDeviceSize movedSize = 0;
+        for(const RangeCopy& copy : copies)
+        {
+            copyRegions.push_back({
+                .srcOffset = copy.srcOffset,
+                .dstOffset = copy.dstOffset,
+                .size = copy.size
+            });
+            movedSize += copy.size;
         }
 
-        return compactionLocations;
+        //source and destination ranges never overlap, so all moves are one copy
+        CommandBuffer cmdBuffer(commands, TRANSFER);
+
+        const VkCommandBufferBeginInfo beginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .pNext = NULL,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = NULL
+        };
+        vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+        vkCmdCopyBuffer(cmdBuffer, buffer.getBuffer(), buffer.getBuffer(), copyRegions.size(), copyRegions.data());
+        vkEndCommandBuffer(cmdBuffer);
+
+        //free space being copied into may have been in use until recently
+        const SynchronizationInfo syncInfo = {
+            .timelineWaitPairs = buffer.getOwnerSubmissions()
+        };
+
+        Queue& queue = commands.submitToQueue(TRANSFER, syncInfo, { cmdBuffer });
+        buffer.addOwner(queue);
+        pendingMovesSubmission = commands.getLastSubmission(queue);
+
+        renderer->getStatisticsTracker().modifyObjectCounter("Defragmentation Bytes Moved", (int)movedSize);
     }
 
     //----------IMAGE DEFINITIONS----------//
@@ -597,6 +663,7 @@ namespace PaperRenderer
             }
 
             writable = checkIfWritable(allocInfo);
+            trackAllocation(imageInfo.category, allocInfo);
 
             size = allocInfo.size;
         }
@@ -604,8 +671,14 @@ namespace PaperRenderer
 
     Image::~Image()
     {
-        idleOwners();
-        if(allocation && image) vmaDestroyImage(renderer->getDevice().getAllocator(), image, allocation);
+        //destroyed once the owners' submissions complete rather than idling them; the memory stays counted until then
+        if(allocation && image)
+        {
+            renderer->getDevice().getCommands().deferDestruction(getOwnerSubmissions(), [allocator = renderer->getDevice().getAllocator(), image = image, allocation = allocation, trackedAllocation = takeTrackedAllocation()] {
+                vmaDestroyImage(allocator, image, allocation);
+                trackedAllocation.untrack();
+            });
+        }
     }
 
     Image::Image(Image&& other) noexcept
@@ -622,8 +695,13 @@ namespace PaperRenderer
     {
         if(this != &other)
         {
-            idleOwners();
-            if(allocation && image) vmaDestroyImage(renderer->getDevice().getAllocator(), image, allocation);
+            if(allocation && image)
+            {
+                renderer->getDevice().getCommands().deferDestruction(getOwnerSubmissions(), [allocator = renderer->getDevice().getAllocator(), image = image, allocation = allocation, trackedAllocation = takeTrackedAllocation()] {
+                    vmaDestroyImage(allocator, image, allocation);
+                    trackedAllocation.untrack();
+                });
+            }
 
             VulkanResource::operator=(std::move(other));
             image = other.image;
@@ -1,5 +1,7 @@
 #pragma once
 #include "Device.h"
+#include "Statistics.h"
+#include "FragmentableRange.h"
 
 #include <cstring> //linux bs
 #include <functional>
@@ -12,6 +14,7 @@ namespace PaperRenderer
         VkDeviceSize size = 0;
         VkBufferUsageFlagBits2KHR usageFlags = 0;
         VmaAllocationCreateFlags allocationFlags = 0;
+        MemoryCategory category = MEMORY_UNCATEGORIZED;
     };
 
     struct BufferWrite
@@ -36,10 +39,25 @@ namespace PaperRenderer
         VkDeviceSize size = 0;
         std::set<Queue*> owners;
         VmaAllocation allocation = VK_NULL_HANDLE;
-        std::mutex resourceMutex;
+        std::recursive_mutex resourceMutex;
         bool writable = false;
+        MemoryCategory memoryCategory = MEMORY_UNCATEGORIZED;
+        VkDeviceSize trackedSize = 0; //allocation size counted in the statistics tracker's memory accounting
 
         bool checkIfWritable(const VmaAllocationInfo& allocationInfo) const;
+        void trackAllocation(MemoryCategory category, const VmaAllocationInfo& allocationInfo);
+        void untrackAllocation();
+
+        //accounting of an allocation handed off to deferred destruction, which untracks it once the memory is actually freed
+        struct TrackedAllocation
+        {
+            StatisticsTracker* tracker = NULL;
+            MemoryCategory category = MEMORY_UNCATEGORIZED;
+            VkDeviceSize size = 0;
+
+            void untrack() const;
+        };
+        TrackedAllocation takeTrackedAllocation(); //the resource no longer counts the allocation after this
 
         friend class FragmentableBuffer;
 
@@ -56,11 +74,15 @@ namespace PaperRenderer
         void addOwner(Queue& queue);
         //thread safe
         void removeOwner(Queue& queue);
+        //latest submission made to each owner queue; wait on these before reusing the resource's memory
+        std::vector<TimelineSemaphorePair> getOwnerSubmissions();
+        //waits on the host for getOwnerSubmissions()
         void idleOwners();
 
         const VmaAllocation& getAllocation() const { return allocation; }
         VkMemoryType getMemoryType() const;
         VkDeviceSize getSize() const { return size; }
+        MemoryCategory getMemoryCategory() const { return memoryCategory; }
     };
 
     //----------BUFFER DECLARATIONS----------//
@@ -77,8 +99,8 @@ namespace PaperRenderer
         Buffer(Buffer&& other) noexcept;
         Buffer& operator=(Buffer&& other) noexcept;
 
-        int writeToBuffer(const std::vector<BufferWrite>& writes); //returns 0 if successful, 1 if unsuccessful (probably because not host visible)
-        int readFromBuffer(const std::vector<BufferRead>& reads);
+        int writeToBuffer(const SmallVector<BufferWrite, 4>& writes); //returns 0 if successful, 1 if unsuccessful (probably because not host visible)
+        int readFromBuffer(const SmallVector<BufferRead, 4>& reads);
         Queue& copyFromBufferRanges(const Buffer &src, const std::vector<VkBufferCopy>& regions, const SynchronizationInfo& synchronizationInfo);
 
         const VkBuffer& getBuffer() const { return buffer; }
@@ -88,46 +110,24 @@ namespace PaperRenderer
 
     //----------FRAGMENTABLE BUFFER DECLARATIONS----------//
 
-    
-
-    /// @brief location represents the location where all data after is to be shifted down by shiftSize
-    struct CompactionResult
-    {
-        VkDeviceSize location;
-        VkDeviceSize shiftSize;
-    };
-
-    /// @brief Fragmentable buffers are host visible and can have memory removed from the middle just like normal buffers, but the difference is that the size of the fragment is stored. Once the size of 
-    ///the fragments reaches the threshold, as defined in the constructor, the buffer gets compacted, which will move all data in the buffer next to each other. After a compaction, 
+    /// @brief Fragmentable buffers are host visible and can have memory removed from the middle just like normal buffers. Space is sub-allocated with a TLSF allocator, so
+    ///writes and removals are O(1) and freed space is reused. Offsets are tracked by a FragmentableRange, while this class performs its copies on the GPU. Only when free space is too fragmented to fit a write does the buffer get compacted, which will move all data in the buffer next to each other. After a compaction, 
     ///any pointers to the data in the buffer should be considered invalid.
     class FragmentableBuffer
     {
     private:
         Buffer buffer;
-        VkDeviceSize desiredLocation = 0;
-        VkDeviceSize stackLocation = 0;
-        VkDeviceSize totalDataSize = 0;
-        VkDeviceSize minAlignment = 0;
-
-        struct Chunk
-        {
-            VkDeviceSize location;
-            VkDeviceSize size;
-
-            static bool compareByLocation(const Chunk &a, const Chunk& b)
-            {
-                return a.location < b.location;
-            }
-
-            bool operator<(const Chunk& other) const
-            {
-                return size < other.size;
-            }
-        };
-        std::multiset<Chunk> memoryFragments;
+        FragmentableRange range;
 
         std::function<void(const std::vector<CompactionResult>&)> compactionCallback = NULL;
 
+        //incremental defragmentation; allocations are copied into free space lower in the buffer, and only published once the copy completes
+        TimelineSemaphorePair pendingMovesSubmission = {};
+        std::vector<TimelineSemaphorePair> pendingFreesSubmissions = {}; //work submitted before publishing may still read published moves' old locations
+        std::function<void(const std::vector<DefragmentationMove>&)> defragmentationCallback = NULL;
+
+        void recordCompaction(const RangeCompaction& compaction);
+
         class RenderEngine* renderer;
         VmaAllocation allocation;
 
@@ -140,6 +140,8 @@ namespace PaperRenderer
 
         //Callback for when a compaction occurs. Extremely useful for re-referencing, with the function taking in a sorted std::vector<CompactionResult>
         void setCompactionCallback(const std::function<void(std::vector<CompactionResult>)>& compactionCallback) { this->compactionCallback = compactionCallback; }
+        //Callback for when defragment() publishes moved allocations, with the function taking in a std::vector<DefragmentationMove> sorted by srcLocation. Until then, the old locations stay valid
+        void setDefragmentationCallback(const std::function<void(const std::vector<DefragmentationMove>&)>& defragmentationCallback) { this->defragmentationCallback = defragmentationCallback; }
 
         enum WriteResult
         {
@@ -152,14 +154,23 @@ namespace PaperRenderer
         WriteResult newWrite(void* data, VkDeviceSize size, VkDeviceSize* returnLocation); 
         //thread safe
         void removeFromRange(VkDeviceSize offset, VkDeviceSize size);
+        //takes on another buffer's allocations at the same offsets; use after copying its data into this one. This buffer must be at least other's getStackLocation() in size
+        void copyAllocations(const FragmentableBuffer& other);
 
         std::vector<CompactionResult> compact(); //inkoves on demand compaction; useful for when recreating an allocation to get the actual current size requirement. results are sorted
+        //returns where a location from before a compaction was moved to, given the compaction's sorted results. O(log n) in the number of results
+        static VkDeviceSize getCompactedLocation(const std::vector<CompactionResult>& results, const VkDeviceSize location) { return FragmentableRange::getCompactedLocation(results, location); }
+        //moves at most maxMoveSize bytes of allocations from the end of the buffer into free space below them with a GPU copy. Moves are published through the
+        //defragmentation callback on a later call, once the copy has completed, so this never blocks. Call once per frame. Thread safe
+        void defragment(const VkDeviceSize maxMoveSize);
+        //returns where a location was moved to, given sorted defragmentation moves. O(log n) in the number of moves
+        static VkDeviceSize getMovedLocation(const std::vector<DefragmentationMove>& moves, const VkDeviceSize location) { return FragmentableRange::getMovedLocation(moves, location); }
         void addOwner(Queue& queue) { buffer.addOwner(queue); }
         void removeOwner(Queue& queue) { buffer.removeOwner(queue); };
 
         Buffer& getBuffer() { return buffer; }
-        const VkDeviceSize& getStackLocation() const { return stackLocation; } //returns the location relative to the start of the buffer (always 0) of where unwritten data is
-        const VkDeviceSize& getDesiredLocation() const { return desiredLocation; } //useful if write failed to give a the stackLocation + (size of last write)
+        VkDeviceSize getStackLocation() const { return range.getStackLocation(); } //returns the location relative to the start of the buffer (always 0) of where unwritten data is
+        VkDeviceSize getDesiredLocation() const { return range.getDesiredLocation(); } //useful if write failed to give a the stackLocation + (size of failed writes)
     };
 
     //----------IMAGE DECLARATIONS----------//
@@ -174,6 +185,7 @@ namespace PaperRenderer
         VkImageUsageFlags usage = 0;
         VkImageAspectFlags imageAspect = 0;
         VkImageLayout desiredLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        MemoryCategory category = MEMORY_IMAGES;
     };
 
     class Image : public VulkanResource